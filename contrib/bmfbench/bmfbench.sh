@@ -0,0 +1,105 @@
+#!/bin/sh
+
+# Measure the multicast forwarding rate of the BMF plugin over veth pairs,
+# once with "CaptureRing" "no" (one recvfrom()/sendto() per packet) and
+# once with "CaptureRing" "yes" (TPACKET_V3 rings).
+#
+#   ns bmfb-src           ns bmfb-rtr (olsrd + BMF)            ns bmfb-dst
+#   bs0 10.77.1.2 ------- bs1 10.77.1.1   bd1 10.77.2.1 ------- bd0 10.77.2.2
+#                         ol0 10.77.3.1 -- ol1 (OLSR interface)
+#
+# bs1 and bd1 are "NonOlsrIf" interfaces of BMF, so every packet that the
+# sender multicasts on bs0 is captured on bs1 and forwarded out of bd1.
+#
+# Must be run as root. Environment variables:
+#   OLSRD    olsrd binary           (default ../../olsrd)
+#   BMF      BMF plugin             (default ../../lib/bmf/olsrd_bmf.so.1.7.0)
+#   SECONDS_ duration of each run   (default 10)
+#   SIZE     UDP payload size       (default 64)
+#   RATE     packets per second     (default 0, as fast as possible)
+
+cd "${0%/*}" || exit 1
+
+OLSRD=${OLSRD:-../../olsrd}
+BMF=${BMF:-../../lib/bmf/olsrd_bmf.so.1.7.0}
+SECONDS_=${SECONDS_:-10}
+SIZE=${SIZE:-64}
+RATE=${RATE:-0}
+BENCH=$PWD/bmfbench
+CONF=$(mktemp /tmp/bmfbench.XXXXXX)
+
+test -x "$OLSRD" || { echo "no olsrd binary at $OLSRD" >&2; exit 1; }
+test -f "$BMF" || { echo "no BMF plugin at $BMF" >&2; exit 1; }
+test -x "$BENCH" || { echo "run make first" >&2; exit 1; }
+BMF=$(cd "${BMF%/*}" && pwd)/${BMF##*/}
+
+teardown() {
+  for ns in bmfb-src bmfb-rtr bmfb-dst; do
+    ip netns del $ns 2>/dev/null
+  done
+}
+
+setup() {
+  teardown
+  for ns in bmfb-src bmfb-rtr bmfb-dst; do
+    ip netns add $ns
+    ip -n $ns link set lo up
+  done
+
+  ip link add bs0 netns bmfb-src type veth peer name bs1 netns bmfb-rtr
+  ip link add bd0 netns bmfb-dst type veth peer name bd1 netns bmfb-rtr
+  ip -n bmfb-rtr link add ol0 type veth peer name ol1
+
+  ip -n bmfb-src addr add 10.77.1.2/24 dev bs0
+  ip -n bmfb-rtr addr add 10.77.1.1/24 dev bs1
+  ip -n bmfb-rtr addr add 10.77.2.1/24 dev bd1
+  ip -n bmfb-rtr addr add 10.77.3.1/24 dev ol0
+  ip -n bmfb-dst addr add 10.77.2.2/24 dev bd0
+  for dev in bs0; do ip -n bmfb-src link set $dev up; done
+  for dev in bs1 bd1 ol0 ol1; do ip -n bmfb-rtr link set $dev up; done
+  for dev in bd0; do ip -n bmfb-dst link set $dev up; done
+
+  # the packets arrive at the receiver from an address it has no route to
+  ip netns exec bmfb-dst sysctl -q -w net.ipv4.conf.all.rp_filter=0 net.ipv4.conf.bd0.rp_filter=0
+}
+
+run() {
+  cat > "$CONF" <<CONFEOF
+DebugLevel 0
+IpVersion 4
+Interface "ol0"
+{
+}
+LoadPlugin "$BMF"
+{
+  PlParam "NonOlsrIf" "bs1"
+  PlParam "NonOlsrIf" "bd1"
+  PlParam "CaptureRing" "$1"
+}
+CONFEOF
+
+  setup
+  ip netns exec bmfb-rtr "$OLSRD" -f "$CONF" -nofork > /dev/null 2>&1 &
+  pid=$!
+  sleep 3
+  if ! kill -0 $pid 2>/dev/null; then
+    echo "olsrd did not start" >&2
+    teardown
+    return 1
+  fi
+
+  echo "CaptureRing $1:"
+  ip netns exec bmfb-dst "$BENCH" recv -t 5 10.77.2.2 &
+  recv=$!
+  sleep 1
+  ip netns exec bmfb-src "$BENCH" send -s $SIZE -r $RATE -t $SECONDS_ 10.77.1.2
+  wait $recv
+
+  kill $pid
+  wait $pid 2>/dev/null
+  teardown
+}
+
+run no
+run yes
+rm -f "$CONF"
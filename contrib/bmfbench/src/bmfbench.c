@@ -0,0 +1,276 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ */
+
+/*
+ * bmfbench - multicast UDP sender and receiver for measuring how many
+ * packets per second the BMF plugin forwards between two interfaces.
+ * Every packet carries a sequence number, so that the duplicate check
+ * of BMF does not drop any of them and the receiver can count losses.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define BENCH_MAXSIZE 1472
+
+static uint64_t
+bench_clock(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void
+usage(const char *name)
+{
+  fprintf(stderr, "usage: %s send [-g group] [-p port] [-s size] [-r pps] [-t seconds] <local address>\n", name);
+  fprintf(stderr, "       %s recv [-g group] [-p port] [-t seconds] <local address>\n", name);
+  exit(EXIT_FAILURE);
+}
+
+static int
+bench_send(int s, const struct sockaddr_in *group, unsigned int size, unsigned int rate, unsigned int seconds)
+{
+  unsigned char buf[BENCH_MAXSIZE];
+  uint64_t start, now, end, seq = 0, errors = 0;
+
+  memset(buf, 0xa5, sizeof(buf));
+
+  start = now = bench_clock();
+  end = start + (uint64_t)seconds * 1000000000;
+  while (now < end) {
+    /* with a rate, hold back until the next packet is due */
+    if (rate != 0 && seq * 1000000000 / rate > now - start) {
+      now = bench_clock();
+      continue;
+    }
+
+    memcpy(buf, &seq, sizeof(seq));
+    if (sendto(s, buf, size, 0, (const struct sockaddr *)group, sizeof(*group)) < 0) {
+      if (errno != ENOBUFS && errno != EAGAIN) {
+        perror("sendto");
+        return EXIT_FAILURE;
+      }
+      errors++;
+    } else {
+      seq++;
+    }
+    now = bench_clock();
+  }
+
+  printf("sent %llu packets of %u bytes in %.3f s: %.0f pps (%llu send errors)\n", (unsigned long long)seq, size,
+         (now - start) / 1e9, seq * 1e9 / (now - start), (unsigned long long)errors);
+  return EXIT_SUCCESS;
+}
+
+static int
+bench_recv(int s, unsigned int seconds)
+{
+  unsigned char buf[BENCH_MAXSIZE];
+  uint64_t first = 0, last = 0, count = 0, bytes = 0, maxseq = 0, seq;
+  struct timeval tv;
+  ssize_t len;
+
+  /* the run is over when nothing came in for a second */
+  tv.tv_sec = 1;
+  tv.tv_usec = 0;
+  setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  for (;;) {
+    len = recv(s, buf, sizeof(buf), 0);
+    if (len < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+#if EAGAIN != EWOULDBLOCK
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+#else
+      if (errno != EAGAIN) {
+#endif
+        perror("recv");
+        return EXIT_FAILURE;
+      }
+      if (count != 0) {
+        break;
+      }
+      /* still waiting for the first packet */
+      if (seconds-- == 0) {
+        break;
+      }
+      continue;
+    }
+
+    last = bench_clock();
+    if (count++ == 0) {
+      first = last;
+    }
+    bytes += len;
+    if ((size_t)len >= sizeof(seq)) {
+      memcpy(&seq, buf, sizeof(seq));
+      if (seq + 1 > maxseq) {
+        maxseq = seq + 1;
+      }
+    }
+  }
+
+  if (count < 2) {
+    printf("received %llu packets\n", (unsigned long long)count);
+    return EXIT_FAILURE;
+  }
+  printf("received %llu packets in %.3f s: %.0f pps, %.1f Mbit/s (%llu lost)\n", (unsigned long long)count,
+         (last - first) / 1e9, (count - 1) * 1e9 / (last - first), bytes * 8e3 / (last - first),
+         (unsigned long long)(maxseq - count));
+  return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char *argv[])
+{
+  unsigned int size = 64, rate = 0, seconds = 10;
+  struct sockaddr_in group;
+  struct in_addr local;
+  int sending, s, opt, on = 1, ttl = 8, off = 0, rcvbuf = 4 * 1024 * 1024;
+
+  if (argc < 2) {
+    usage(argv[0]);
+  }
+  if (strcmp(argv[1], "send") == 0) {
+    sending = 1;
+  } else if (strcmp(argv[1], "recv") == 0) {
+    sending = 0;
+  } else {
+    usage(argv[0]);
+  }
+
+  memset(&group, 0, sizeof(group));
+  group.sin_family = AF_INET;
+  group.sin_port = htons(5000);
+  inet_pton(AF_INET, "239.77.0.1", &group.sin_addr);
+
+  optind = 2;
+  while ((opt = getopt(argc, argv, "g:p:s:r:t:")) != -1) {
+    switch (opt) {
+    case 'g':
+      if (inet_pton(AF_INET, optarg, &group.sin_addr) != 1) {
+        usage(argv[0]);
+      }
+      break;
+    case 'p':
+      group.sin_port = htons(strtoul(optarg, NULL, 10));
+      break;
+    case 's':
+      size = strtoul(optarg, NULL, 10);
+      break;
+    case 'r':
+      rate = strtoul(optarg, NULL, 10);
+      break;
+    case 't':
+      seconds = strtoul(optarg, NULL, 10);
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (optind != argc - 1 || inet_pton(AF_INET, argv[optind], &local) != 1 || size < sizeof(uint64_t)
+      || size > BENCH_MAXSIZE || seconds == 0) {
+    usage(argv[0]);
+  }
+
+  s = socket(AF_INET, SOCK_DGRAM, 0);
+  if (s < 0) {
+    perror("socket");
+    return EXIT_FAILURE;
+  }
+
+  if (sending) {
+    /*
+     * veth hands the captured packets to BMF with the UDP checksum still
+     * to be filled in, and BMF forwards them as they are, so the receiver
+     * would drop them all. Sending without a UDP checksum avoids that.
+     */
+    if (setsockopt(s, SOL_SOCKET, SO_NO_CHECK, &on, sizeof(on)) < 0
+        || setsockopt(s, IPPROTO_IP, IP_MULTICAST_IF, &local, sizeof(local)) < 0
+        || setsockopt(s, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0
+        || setsockopt(s, IPPROTO_IP, IP_MULTICAST_LOOP, &off, sizeof(off)) < 0) {
+      perror("setsockopt");
+      return EXIT_FAILURE;
+    }
+    return bench_send(s, &group, size, rate, seconds);
+  } else {
+    struct sockaddr_in bindto;
+    struct ip_mreq mreq;
+
+    memset(&bindto, 0, sizeof(bindto));
+    bindto.sin_family = AF_INET;
+    bindto.sin_port = group.sin_port;
+    bindto.sin_addr = group.sin_addr;
+
+    mreq.imr_multiaddr = group.sin_addr;
+    mreq.imr_interface = local;
+
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(s, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    if (bind(s, (struct sockaddr *)&bindto, sizeof(bindto)) < 0) {
+      perror("bind");
+      return EXIT_FAILURE;
+    }
+    if (setsockopt(s, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+      perror("IP_ADD_MEMBERSHIP");
+      return EXIT_FAILURE;
+    }
+    return bench_recv(s, seconds);
+  }
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
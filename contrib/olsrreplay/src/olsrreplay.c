@@ -0,0 +1,643 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * olsrreplay - feed a recorded OLSR packet stream into the core
+ * protocol code and measure how long it takes to digest it.
+ *
+ * The capture is read completely into memory first, then every
+ * OLSR datagram is handed to parse_packet() in recorded order.
+ * The scheduler clock is not taken from the system but advanced
+ * in pollrate steps along the capture timestamps, so timers,
+ * hold times and jitter behave exactly the same on every run.
+ * Route export is replaced by no-ops and the only socket is the
+ * send socket of the replay interface.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include "defs.h"
+#include "olsr.h"
+#include "olsr_cfg.h"
+#include "ipcalc.h"
+#include "scheduler.h"
+#include "parser.h"
+#include "link_set.h"
+#include "mpr_selector_set.h"
+#include "process_routes.h"
+#include "routing_table.h"
+#include "interfaces.h"
+#include "net_olsr.h"
+#include "generate_msg.h"
+#include "lq_packet.h"
+
+#define REPLAY_IFNAME           "replay0"
+#define REPLAY_DISCARD_PORT     9
+
+/* normally provided by main.c */
+struct olsr_cookie_info *def_timer_ci = NULL;
+
+/* classic libpcap file format */
+#define PCAP_MAGIC_USEC         0xa1b2c3d4
+#define PCAP_MAGIC_NSEC         0xa1b23c4d
+
+#define PCAP_LINKTYPE_NULL      0
+#define PCAP_LINKTYPE_ETHERNET  1
+#define PCAP_LINKTYPE_RAW       101
+#define PCAP_LINKTYPE_LINUX_SLL 113
+#define PCAP_LINKTYPE_LOOP      108
+#define PCAP_LINKTYPE_IPV4      228
+#define PCAP_LINKTYPE_IPV6      229
+
+#define ETHERTYPE_IPV4          0x0800
+#define ETHERTYPE_IPV6          0x86dd
+#define ETHERTYPE_VLAN          0x8100
+
+/* one OLSR datagram of the capture */
+struct replay_packet {
+  uint32_t time;                       /* ms relative to the first packet */
+  union olsr_ip_addr from;
+  uint16_t len;
+  unsigned char *data;
+};
+
+struct replay_stats {
+  unsigned long packets;
+  unsigned long messages;
+  unsigned long ticks;
+  unsigned long changes;
+  unsigned long spf_runs;
+  double parse_time;
+  double timer_time;
+  double changes_time;
+};
+
+static struct replay_stats stats;
+
+static bool
+replay_count_message(union olsr_message *m __attribute__ ((unused)),
+                     struct interface *in_if __attribute__ ((unused)),
+                     union olsr_ip_addr *from __attribute__ ((unused)))
+{
+  stats.messages++;
+  return true;
+}
+
+static int
+replay_export_route(const struct rt_entry *rt __attribute__ ((unused)))
+{
+  return 0;
+}
+
+static double
+replay_clock(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t
+pcap_u32(const unsigned char *p, bool swapped)
+{
+  if (swapped) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+  }
+  return (uint32_t)p[3] | (uint32_t)p[2] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[0] << 24;
+}
+
+static uint16_t
+net_u16(const unsigned char *p)
+{
+  return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+/**
+ * Strip the link layer, IP and UDP headers off a captured frame.
+ *
+ * @param frame the captured bytes
+ * @param caplen number of captured bytes
+ * @param linktype pcap link type of the capture
+ * @param port UDP destination port carrying OLSR
+ * @param from will be filled with the IP source address
+ * @param len will be filled with the OLSR payload length
+ * @return pointer to the OLSR payload, NULL if the frame is not OLSR
+ */
+static const unsigned char *
+pcap_olsr_payload(const unsigned char *frame, uint32_t caplen, uint32_t linktype, uint16_t port,
+                  union olsr_ip_addr *from, uint16_t *len)
+{
+  const unsigned char *p = frame, *end = frame + caplen;
+  int family;
+  uint16_t udplen;
+
+  switch (linktype) {
+  case PCAP_LINKTYPE_ETHERNET:
+    {
+      uint16_t type;
+
+      if (caplen < 14) {
+        return NULL;
+      }
+      type = net_u16(p + 12);
+      p += 14;
+      while (type == ETHERTYPE_VLAN && end - p >= 4) {
+        type = net_u16(p + 2);
+        p += 4;
+      }
+      if (type != ETHERTYPE_IPV4 && type != ETHERTYPE_IPV6) {
+        return NULL;
+      }
+    }
+    break;
+  case PCAP_LINKTYPE_LINUX_SLL:
+    if (caplen < 16) {
+      return NULL;
+    }
+    p += 16;
+    break;
+  case PCAP_LINKTYPE_NULL:
+  case PCAP_LINKTYPE_LOOP:
+    if (caplen < 4) {
+      return NULL;
+    }
+    p += 4;
+    break;
+  case PCAP_LINKTYPE_RAW:
+  case PCAP_LINKTYPE_IPV4:
+  case PCAP_LINKTYPE_IPV6:
+    break;
+  default:
+    return NULL;
+  }
+
+  if (end - p < 1) {
+    return NULL;
+  }
+
+  family = (p[0] >> 4) == 6 ? AF_INET6 : AF_INET;
+  if (family != olsr_cnf->ip_version) {
+    return NULL;
+  }
+
+  if (family == AF_INET) {
+    size_t ihl;
+
+    if (end - p < 20 || (p[0] >> 4) != 4 || p[9] != IPPROTO_UDP) {
+      return NULL;
+    }
+    /* fragments are not reassembled */
+    if ((net_u16(p + 6) & 0x3fff) != 0) {
+      return NULL;
+    }
+    ihl = (p[0] & 0x0f) * 4;
+    if (ihl < 20 || (size_t)(end - p) < ihl) {
+      return NULL;
+    }
+    memcpy(&from->v4, p + 12, sizeof(from->v4));
+    p += ihl;
+  } else {
+    /* extension headers are not followed */
+    if (end - p < 40 || p[6] != IPPROTO_UDP) {
+      return NULL;
+    }
+    memcpy(&from->v6, p + 8, sizeof(from->v6));
+    p += 40;
+  }
+
+  if (end - p < 8 || net_u16(p + 2) != port) {
+    return NULL;
+  }
+  udplen = net_u16(p + 4);
+  if (udplen < 8 || udplen - 8 > end - p - 8) {
+    return NULL;
+  }
+  *len = udplen - 8;
+  return p + 8;
+}
+
+/**
+ * Load all OLSR datagrams of a pcap file into memory.
+ *
+ * @param filename the capture to read
+ * @param port UDP port carrying OLSR
+ * @param count will be filled with the number of packets
+ * @return array of packets, NULL on error
+ */
+static struct replay_packet *
+pcap_load(const char *filename, uint16_t port, size_t *count)
+{
+  unsigned char hdr[24], rec[16];
+  unsigned char *frame = NULL;
+  struct replay_packet *packets = NULL;
+  size_t used = 0, size = 0;
+  uint32_t linktype, snaplen;
+  uint64_t first = 0;
+  bool swapped, nsec, have_first = false;
+  FILE *f;
+
+  f = fopen(filename, "rb");
+  if (f == NULL) {
+    fprintf(stderr, "Cannot open %s: %s\n", filename, strerror(errno));
+    return NULL;
+  }
+
+  if (fread(hdr, sizeof(hdr), 1, f) != 1) {
+    fprintf(stderr, "%s: truncated pcap header\n", filename);
+    goto fail;
+  }
+
+  swapped = false;
+  nsec = false;
+  switch (pcap_u32(hdr, false)) {
+  case PCAP_MAGIC_USEC:
+    break;
+  case PCAP_MAGIC_NSEC:
+    nsec = true;
+    break;
+  default:
+    swapped = true;
+    if (pcap_u32(hdr, true) == PCAP_MAGIC_NSEC) {
+      nsec = true;
+    } else if (pcap_u32(hdr, true) != PCAP_MAGIC_USEC) {
+      fprintf(stderr, "%s: not a pcap file (pcapng is not supported)\n", filename);
+      goto fail;
+    }
+    break;
+  }
+  snaplen = pcap_u32(hdr + 16, swapped);
+  linktype = pcap_u32(hdr + 20, swapped) & 0x0fffffff;
+
+  if (snaplen == 0 || snaplen > 262144) {
+    snaplen = 262144;
+  }
+  frame = olsr_malloc(snaplen, "olsrreplay frame");
+
+  while (fread(rec, sizeof(rec), 1, f) == 1) {
+    uint32_t caplen = pcap_u32(rec + 8, swapped);
+    uint64_t stamp;
+    const unsigned char *payload;
+    union olsr_ip_addr from;
+    uint16_t len;
+
+    if (caplen > snaplen) {
+      fprintf(stderr, "%s: corrupt record length %u\n", filename, caplen);
+      goto fail;
+    }
+    if (fread(frame, caplen, 1, f) != 1 && caplen > 0) {
+      fprintf(stderr, "%s: truncated record\n", filename);
+      break;
+    }
+
+    stamp = (uint64_t)pcap_u32(rec, swapped) * 1000 + pcap_u32(rec + 4, swapped) / (nsec ? 1000000 : 1000);
+
+    memset(&from, 0, sizeof(from));
+    payload = pcap_olsr_payload(frame, caplen, linktype, port, &from, &len);
+    if (payload == NULL || len < 4) {
+      continue;
+    }
+
+    if (!have_first) {
+      first = stamp;
+      have_first = true;
+    }
+
+    if (used == size) {
+      size = size ? size * 2 : 1024;
+      packets = realloc(packets, size * sizeof(*packets));
+      if (packets == NULL) {
+        fprintf(stderr, "Out of memory after %lu packets\n", (unsigned long)used);
+        exit(EXIT_FAILURE);
+      }
+    }
+    packets[used].time = stamp < first ? 0 : (uint32_t)(stamp - first);
+    packets[used].from = from;
+    packets[used].len = len;
+    packets[used].data = olsr_malloc(len, "olsrreplay packet");
+    memcpy(packets[used].data, payload, len);
+    used++;
+  }
+
+  free(frame);
+  fclose(f);
+  *count = used;
+  return packets;
+
+fail:
+  free(frame);
+  free(packets);
+  fclose(f);
+  return NULL;
+}
+
+/**
+ * One pass of the scheduler loop at the virtual time now,
+ * minus the socket handling.
+ */
+static void
+replay_tick(uint32_t now)
+{
+  double t0, t1, t2;
+  bool changes;
+
+  t0 = replay_clock();
+  olsr_scheduler_advance(now);
+  t1 = replay_clock();
+
+  changes = changes_neighborhood || changes_topology || changes_hna;
+  olsr_process_changes();
+
+  if (link_changes) {
+    increase_local_ansn();
+    link_changes = false;
+  }
+  t2 = replay_clock();
+
+  stats.ticks++;
+  if (changes) {
+    stats.changes++;
+  }
+  stats.timer_time += t1 - t0;
+  stats.changes_time += t2 - t1;
+}
+
+/**
+ * Create the interface the capture is fed through and put it
+ * on ifnet like a configured interface. It generates HELLOs and
+ * TCs on its own timers; everything it sends, including forwarded
+ * messages, goes to the discard port on the loopback address.
+ *
+ * @param addr the interface address, which is also the main address
+ * @return the interface, NULL on error
+ */
+static struct interface *
+replay_add_interface(const union olsr_ip_addr *addr)
+{
+  struct interface *ifp;
+  struct olsr_if *iface;
+
+  ifp = olsr_malloc(sizeof(*ifp), "olsrreplay interface");
+  iface = olsr_malloc(sizeof(*iface), "olsrreplay interface config");
+
+  ifp->int_name = olsr_malloc(sizeof(REPLAY_IFNAME), "olsrreplay interface name");
+  strscpy(ifp->int_name, REPLAY_IFNAME, sizeof(REPLAY_IFNAME));
+  ifp->ip_addr = *addr;
+  ifp->mode = IF_MODE_MESH;
+  ifp->int_mtu = OLSR_DEFAULT_MTU;
+  ifp->olsr_socket = -1;
+
+  if (olsr_cnf->ip_version == AF_INET) {
+    ifp->int_mtu -= UDP_IPV4_HDRSIZE;
+    ifp->int_addr.sin_family = AF_INET;
+    ifp->int_addr.sin_addr = addr->v4;
+    ifp->int_broadaddr.sin_family = AF_INET;
+    ifp->int_broadaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ifp->int_broadaddr.sin_port = htons(REPLAY_DISCARD_PORT);
+  } else {
+    ifp->int_mtu -= UDP_IPV6_HDRSIZE;
+    ifp->int6_addr.sin6_family = AF_INET6;
+    ifp->int6_addr.sin6_addr = addr->v6;
+    ifp->int6_multaddr.sin6_family = AF_INET6;
+    ifp->int6_multaddr.sin6_addr = in6addr_loopback;
+    ifp->int6_multaddr.sin6_port = htons(REPLAY_DISCARD_PORT);
+  }
+
+  ifp->send_socket = socket(olsr_cnf->ip_version, SOCK_DGRAM, 0);
+  if (ifp->send_socket < 0) {
+    fprintf(stderr, "Cannot create send socket: %s\n", strerror(errno));
+    return NULL;
+  }
+
+  net_add_buffer(ifp);
+
+  iface->name = ifp->int_name;
+  iface->configured = true;
+  iface->interf = ifp;
+  iface->cnf = get_default_if_config();
+  iface->cnfi = get_default_if_config();
+  iface->next = olsr_cnf->interfaces;
+  olsr_cnf->interfaces = iface;
+
+  ifp->int_next = ifnet;
+  ifnet = ifp;
+
+  ifp->hello_gen_timer =
+    olsr_start_timer(iface->cnf->hello_params.emission_interval * MSEC_PER_SEC, HELLO_JITTER, OLSR_TIMER_PERIODIC,
+                     olsr_cnf->lq_level == 0 ? &generate_hello : &olsr_output_lq_hello, ifp, NULL);
+  ifp->tc_gen_timer =
+    olsr_start_timer(iface->cnf->tc_params.emission_interval * MSEC_PER_SEC, TC_JITTER, OLSR_TIMER_PERIODIC,
+                     olsr_cnf->lq_level == 0 ? &generate_tc : &olsr_output_lq_tc, ifp, NULL);
+
+  return ifp;
+}
+
+static void
+replay_usage(const char *name)
+{
+  fprintf(stderr,
+          "Usage: %s [-6] [-l lq_level] [-p port] [-d debuglevel] -m main_ip capture.pcap\n"
+          "  -6  replay an IPv6 capture\n"
+          "  -l  link quality level (0, 2), default %d\n"
+          "  -p  OLSR UDP port, default %d\n"
+          "  -d  olsrd debug level, default 0\n"
+          "  -m  main address of the node the capture was taken on\n", name, DEF_LQ_LEVEL, DEF_OLSRPORT);
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct interface *replay_if;
+  union olsr_ip_addr main_addr;
+  struct replay_packet *packets;
+  size_t count, i;
+  uint16_t port = DEF_OLSRPORT;
+  int family = AF_INET, lq_level = DEF_LQ_LEVEL, debug = 0;
+  const char *main_ip = NULL;
+  uint32_t now, step, start;
+  unsigned int spf_start;
+  double t0, wall;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "6l:p:d:m:h")) != -1) {
+    switch (opt) {
+    case '6':
+      family = AF_INET6;
+      break;
+    case 'l':
+      lq_level = atoi(optarg);
+      break;
+    case 'p':
+      port = (uint16_t)atoi(optarg);
+      break;
+    case 'd':
+      debug = atoi(optarg);
+      break;
+    case 'm':
+      main_ip = optarg;
+      break;
+    default:
+      replay_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (main_ip == NULL || optind != argc - 1) {
+    replay_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  memset(&main_addr, 0, sizeof(main_addr));
+  if (inet_pton(family, main_ip, &main_addr) != 1) {
+    fprintf(stderr, "Bad main address %s\n", main_ip);
+    return EXIT_FAILURE;
+  }
+
+  /* configuration, as the daemon would have it after parsing */
+  olsr_cnf = olsrd_get_default_cnf();
+  olsr_cnf->debug_level = debug;
+  debug_handle = stdout;
+  olsr_cnf->lq_level = lq_level;
+  olsr_cnf->ip_version = family;
+  if (family == AF_INET6) {
+    olsr_cnf->ipsize = sizeof(struct in6_addr);
+    olsr_cnf->maxplen = 128;
+  }
+  olsr_cnf->main_addr = main_addr;
+  olsr_cnf->spf_thread = false;
+
+  packets = pcap_load(argv[optind], port, &count);
+  if (packets == NULL) {
+    return EXIT_FAILURE;
+  }
+  if (count == 0) {
+    fprintf(stderr, "No OLSR packets on port %d in %s\n", port, argv[optind]);
+    return EXIT_FAILURE;
+  }
+
+  /* no randomness beyond this seed: every run is the same */
+  srandom(1);
+
+  olsr_init_timers();
+  def_timer_ci = olsr_alloc_cookie("Default Timer Cookie", OLSR_COOKIE_TYPE_TIMER);
+  olsr_init_parser();
+  olsr_init_export_route();
+  olsr_addroute_function = replay_export_route;
+  olsr_addroute6_function = replay_export_route;
+  olsr_delroute_function = replay_export_route;
+  olsr_delroute6_function = replay_export_route;
+  init_msg_seqno();
+  olsr_init_tables();
+  olsr_parser_add_function(&replay_count_message, PROMISCUOUS);
+
+  replay_if = replay_add_interface(&main_addr);
+  if (replay_if == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  step = (uint32_t)(olsr_cnf->pollrate * MSEC_PER_SEC);
+  if (step == 0) {
+    step = 1;
+  }
+  start = now_times;
+  now = start;
+
+  spf_start = routingtree_version;
+  t0 = replay_clock();
+  for (i = 0; i < count; i++) {
+    union olsr_ip_addr from = packets[i].from;
+    double p0;
+
+    /* catch up with the capture, one poll interval at a time */
+    while (now - start + step <= packets[i].time) {
+      now += step;
+      replay_tick(now);
+    }
+    now_times = start + packets[i].time;
+
+    /* are we talking to ourselves? */
+    if (ipequal(&from, &main_addr)) {
+      continue;
+    }
+
+    p0 = replay_clock();
+    parse_packet((struct olsr *)packets[i].data, packets[i].len, replay_if, &from);
+    stats.parse_time += replay_clock() - p0;
+    stats.packets++;
+  }
+
+  /* let the last packets take effect */
+  replay_tick(now_times);
+  wall = replay_clock() - t0;
+
+  /* every SPF run, wherever it was triggered, bumps the version */
+  stats.spf_runs = routingtree_version - spf_start;
+
+  printf("capture:       %lu packets, %u.%03u s\n", (unsigned long)count,
+         packets[count - 1].time / MSEC_PER_SEC, packets[count - 1].time % MSEC_PER_SEC);
+  printf("parsed:        %lu packets, %lu messages\n", stats.packets, stats.messages);
+  printf("scheduler:     %lu ticks, %lu with changes, %lu SPF runs\n", stats.ticks, stats.changes, stats.spf_runs);
+  printf("parse+forward: %10.3f ms\n", stats.parse_time * 1e3);
+  printf("timers:        %10.3f ms\n", stats.timer_time * 1e3);
+  printf("mpr+spf:       %10.3f ms\n", stats.changes_time * 1e3);
+  printf("total:         %10.3f ms\n", wall * 1e3);
+  if (wall > 0) {
+    printf("throughput:    %10.0f messages/s, %.0f packets/s\n", stats.messages / wall, stats.packets / wall);
+  }
+
+  for (i = 0; i < count; i++) {
+    free(packets[i].data);
+  }
+  free(packets);
+  return EXIT_SUCCESS;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,139 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ */
+
+/*
+ * securebench - signing and verification rates of the signature
+ * schemes of the secure plugin for small, medium and full sized
+ * packets.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "olsrd_secure.h"
+#include "secure_mac.h"
+
+/* bytes signed per measurement */
+#define BENCH_BYTES (256 * 1024 * 1024)
+
+#define ARRAYSIZE(a) (sizeof(a) / sizeof(*(a)))
+
+static uint64_t
+bench_clock(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void
+bench_run(const char *name, size_t size)
+{
+  static const uint8_t key[KEYLENGTH] = "securebench key";
+  uint8_t *packet = malloc(size);
+  uint8_t signature[SIGNATURE_SIZE];
+  unsigned int ops = BENCH_BYTES / size, i, good = 0;
+  uint64_t start, sign_time, verify_time;
+
+  if (packet == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  for (i = 0; i < size; i++) {
+    packet[i] = random();
+  }
+  secure_mac->set_key(key, sizeof(key));
+
+  /* the signature of each round goes into the next packet */
+  start = bench_clock();
+  for (i = 0; i < ops; i++) {
+    secure_mac->sign(packet, size, signature);
+    packet[i % size] ^= signature[0];
+  }
+  sign_time = bench_clock() - start;
+
+  secure_mac->sign(packet, size, signature);
+  start = bench_clock();
+  for (i = 0; i < ops; i++) {
+    good += secure_mac_verify(packet, size, signature);
+  }
+  verify_time = bench_clock() - start;
+
+  printf("%s\t%zu\t%.1f\t%.1f\t%.1f\n", name, size, ops * 1000000.0 / sign_time, ops * 1000000.0 / verify_time,
+         (double)ops * size * 1000.0 / sign_time);
+
+  /* keep the compiler from dropping the loops */
+  if (good != ops) {
+    printf("%u of %u signatures did not verify\n", ops - good, ops);
+  }
+  free(packet);
+}
+
+int
+main(int argc __attribute__ ((unused)), char *argv[] __attribute__ ((unused)))
+{
+  /* only one of sha1 and md5 is built */
+  static const char *names[] = { "sha1", "md5", "hmac-sha256", "siphash" };
+  static const size_t sizes[] = { 64, 512, 1500 };
+  unsigned int i, j;
+
+  srandom(1);
+
+  printf("Scheme\tBytes\tSign\tVerify\tMB/s (sign and verify in thousand packets per second)\n");
+  for (i = 0; i < ARRAYSIZE(names); i++) {
+    if (!secure_mac_select(names[i])) {
+      continue;
+    }
+    for (j = 0; j < ARRAYSIZE(sizes); j++) {
+      bench_run(names[i], sizes[j]);
+    }
+  }
+  return 0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
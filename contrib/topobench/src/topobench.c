@@ -0,0 +1,269 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ */
+
+/*
+ * topobench - render a synthetic topology of 20000 TC edges the way
+ * the /topology table of txtinfo does, once with the printf based
+ * olsr_ip_to_string()/abuf_appendf() helpers and once with the direct
+ * autobuf writers, and compare time and output.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "defs.h"
+#include "olsr.h"
+#include "olsr_cfg.h"
+#include "ipcalc.h"
+#include "scheduler.h"
+#include "tc_set.h"
+#include "lq_plugin.h"
+#include "common/autobuf.h"
+
+struct olsr_cookie_info *def_timer_ci = NULL;
+
+static uint64_t
+bench_clock(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void
+bench_addr(union olsr_ip_addr *addr, unsigned int i)
+{
+  memset(addr, 0, sizeof(*addr));
+  if (olsr_cnf->ip_version == AF_INET) {
+    addr->v4.s_addr = htonl(0x0a000000 | ((i + 1) & 0xffffff));
+  } else {
+    addr->v6.s6_addr[0] = 0xfd;
+    addr->v6.s6_addr[13] = (i + 1) >> 16;
+    addr->v6.s6_addr[14] = (i + 1) >> 8;
+    addr->v6.s6_addr[15] = (i + 1);
+  }
+}
+
+/*
+ * every node advertises its degree/2 successors and predecessors on a
+ * ring, so all edges are symmetric and show up in the table
+ */
+static unsigned int
+bench_build(unsigned int nodes, unsigned int degree)
+{
+  struct tc_entry **tc = olsr_malloc(nodes * sizeof(*tc), "topobench");
+  unsigned int i, k, edges = 0;
+
+  for (i = 0; i < nodes; i++) {
+    union olsr_ip_addr addr;
+
+    bench_addr(&addr, i);
+    tc[i] = olsr_locate_tc_entry(&addr);
+  }
+  for (i = 0; i < nodes; i++) {
+    for (k = 1; k <= degree / 2; k++) {
+      unsigned int peer[2] = { (i + k) % nodes, (i + nodes - k) % nodes };
+      unsigned int p;
+
+      for (p = 0; p < 2; p++) {
+        union olsr_ip_addr addr;
+        struct tc_edge_entry *tc_edge;
+        uint8_t lq[4] = { 128 + random() % 128, 128 + random() % 128, 0, 0 };
+        const uint8_t *curr = lq;
+
+        bench_addr(&addr, peer[p]);
+        tc_edge = olsr_add_tc_edge_entry(tc[i], &addr, 0);
+        if (tc_edge != NULL) {
+          olsr_deserialize_tc_lq_pair(&curr, tc_edge);
+          tc_edge->cost = olsr_calc_tc_cost(tc_edge);
+          edges++;
+        }
+      }
+    }
+  }
+  free(tc);
+  return edges;
+}
+
+/* the /topology table as txtinfo printed it with printf */
+static void
+render_printf(struct autobuf *abuf)
+{
+  struct tc_entry *tc;
+
+  OLSR_FOR_ALL_TC_ENTRIES(tc) {
+    struct tc_edge_entry *tc_edge;
+    OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
+      if (tc_edge->edge_inv) {
+        struct ipaddr_str dstbuf, addrbuf;
+        struct lqtextbuffer lqbuffer1, lqbuffer2;
+
+        abuf_appendf(abuf, "%s\t%s\t%s\t%s\n", olsr_ip_to_string(&dstbuf, tc_edge_dest_addr(tc_edge)),
+                     olsr_ip_to_string(&addrbuf, &tc->addr), get_tc_edge_entry_text(tc_edge, '\t', &lqbuffer1),
+                     get_linkcost_text(tc_edge->cost, false, &lqbuffer2));
+      }
+    } OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
+  } OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+}
+
+/* the /topology table as txtinfo prints it now */
+static void
+render_direct(struct autobuf *abuf)
+{
+  struct tc_entry *tc;
+
+  OLSR_FOR_ALL_TC_ENTRIES(tc) {
+    struct tc_edge_entry *tc_edge;
+    OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
+      if (tc_edge->edge_inv) {
+        abuf_append_ip(abuf, tc_edge_dest_addr(tc_edge));
+        abuf_putc(abuf, '\t');
+        abuf_append_ip(abuf, &tc->addr);
+        abuf_putc(abuf, '\t');
+        append_tc_edge_entry_text(abuf, tc_edge, '\t');
+        abuf_putc(abuf, '\t');
+        append_linkcost_text(abuf, tc_edge->cost, false);
+        abuf_putc(abuf, '\n');
+      }
+    } OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
+  } OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+}
+
+/* milliseconds per rendering */
+static double
+bench_render(void (*render) (struct autobuf *), struct autobuf *abuf, unsigned int rounds)
+{
+  uint64_t start;
+  unsigned int i;
+
+  start = bench_clock();
+  for (i = 0; i < rounds; i++) {
+    abuf->len = 0;
+    abuf->buf[0] = '\0';
+    render(abuf);
+  }
+  return (bench_clock() - start) / 1e6 / rounds;
+}
+
+static void
+usage(const char *name)
+{
+  fprintf(stderr, "Usage: %s [-6] [-n nodes] [-d degree] [-r rounds]\n", name);
+  exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char *argv[])
+{
+  unsigned int nodes = 2000, degree = 10, rounds = 50, edges;
+  struct autobuf old_buf, new_buf;
+  double old_ms, new_ms;
+  int family = AF_INET;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "6n:d:r:")) != -1) {
+    switch (opt) {
+    case '6':
+      family = AF_INET6;
+      break;
+    case 'n':
+      nodes = strtoul(optarg, NULL, 10);
+      break;
+    case 'd':
+      degree = strtoul(optarg, NULL, 10);
+      break;
+    case 'r':
+      rounds = strtoul(optarg, NULL, 10);
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (nodes < 2 || degree < 2 || degree >= nodes || rounds == 0) {
+    usage(argv[0]);
+  }
+
+  olsr_cnf = olsrd_get_default_cnf();
+  olsr_cnf->ip_version = family;
+  if (family == AF_INET6) {
+    olsr_cnf->ipsize = sizeof(struct in6_addr);
+    olsr_cnf->maxplen = 128;
+  }
+  /* an address outside of the synthetic nodes, tc_myself has no edges */
+  bench_addr(&olsr_cnf->main_addr, 0xfffffe);
+  srandom(1);
+
+  olsr_init_timers();
+  def_timer_ci = olsr_alloc_cookie("Default Timer Cookie", OLSR_COOKIE_TYPE_TIMER);
+  olsr_init_tables();
+
+  edges = bench_build(nodes, degree);
+
+  abuf_init(&old_buf, AUTOBUFCHUNK);
+  abuf_init(&new_buf, AUTOBUFCHUNK);
+  old_ms = bench_render(&render_printf, &old_buf, rounds);
+  new_ms = bench_render(&render_direct, &new_buf, rounds);
+
+  printf("%s, %u nodes, %u edges, %d bytes of /topology text\n", family == AF_INET ? "IPv4" : "IPv6", nodes, edges,
+         new_buf.len);
+  printf("printf helpers:  %8.3f ms per table\n", old_ms);
+  printf("direct writers:  %8.3f ms per table (%.1fx)\n", new_ms, old_ms / new_ms);
+
+  if (old_buf.len != new_buf.len || memcmp(old_buf.buf, new_buf.buf, new_buf.len) != 0) {
+    printf("OUTPUT DIFFERS\n");
+    return EXIT_FAILURE;
+  }
+  printf("output identical\n");
+
+  abuf_free(&old_buf);
+  abuf_free(&new_buf);
+  return EXIT_SUCCESS;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,235 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * treebench - compare the avl tree and the B+-tree of src/common on
+ * address keys: inserts, lookups, in-order walks and deletes for
+ * trees of 1k to 100k IPv4 and IPv6 addresses.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include "defs.h"
+#include "olsr.h"
+#include "olsr_cfg.h"
+#include "common/avl.h"
+#include "common/btree.h"
+
+/* lookups and visited nodes per measurement */
+#define BENCH_OPS 2000000
+
+struct olsr_cookie_info *def_timer_ci = NULL;
+
+struct bench_entry {
+  struct avl_node avl;
+  struct btree_node btree;
+  union olsr_ip_addr addr;
+  unsigned int value;
+};
+
+static uint64_t
+bench_clock(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/* million operations per second */
+static double
+bench_rate(unsigned int ops, uint64_t start)
+{
+  return ops * 1000.0 / (bench_clock() - start);
+}
+
+/* unique addresses in random order, all in one /8 or /64 like in a mesh */
+static void
+bench_fill(struct bench_entry *entries, unsigned int count, int ipv6)
+{
+  unsigned int i;
+
+  for (i = 0; i < count; i++) {
+    memset(&entries[i], 0, sizeof(entries[i]));
+    if (ipv6) {
+      entries[i].addr.v6.s6_addr[0] = 0xfd;
+      entries[i].addr.v6.s6_addr[12] = i >> 24;
+      entries[i].addr.v6.s6_addr[13] = i >> 16;
+      entries[i].addr.v6.s6_addr[14] = i >> 8;
+      entries[i].addr.v6.s6_addr[15] = i;
+    } else {
+      entries[i].addr.v4.s_addr = htonl(0x0a000000 | i);
+    }
+    entries[i].value = i;
+    entries[i].avl.key = &entries[i].addr;
+    entries[i].btree.key = &entries[i].addr;
+  }
+  for (i = count - 1; i > 0; i--) {
+    unsigned int j = random() % (i + 1);
+    union olsr_ip_addr tmp = entries[i].addr;
+
+    entries[i].addr = entries[j].addr;
+    entries[j].addr = tmp;
+  }
+}
+
+static void
+bench_run(unsigned int count, int ipv6)
+{
+  struct bench_entry *entries = olsr_malloc(count * sizeof(*entries), "treebench entries");
+  unsigned int *order = olsr_malloc(BENCH_OPS * sizeof(*order), "treebench order");
+  struct avl_tree avl;
+  struct btree btree;
+  double avl_rate[4], btree_rate[4];
+  unsigned int i, sum = 0;
+  uint64_t start;
+
+  bench_fill(entries, count, ipv6);
+  for (i = 0; i < BENCH_OPS; i++) {
+    order[i] = random() % count;
+  }
+
+  avl_init(&avl, ipv6 ? avl_comp_ipv6 : avl_comp_ipv4);
+  btree_init(&btree, ipv6 ? BTREE_KEY_IPV6 : BTREE_KEY_IPV4);
+
+  /* insert */
+  start = bench_clock();
+  for (i = 0; i < count; i++) {
+    avl_insert(&avl, &entries[i].avl, AVL_DUP_NO);
+  }
+  avl_rate[0] = bench_rate(count, start);
+
+  start = bench_clock();
+  for (i = 0; i < count; i++) {
+    btree_insert(&btree, &entries[i].btree);
+  }
+  btree_rate[0] = bench_rate(count, start);
+
+  /* lookup */
+  start = bench_clock();
+  for (i = 0; i < BENCH_OPS; i++) {
+    sum += avl_find(&avl, &entries[order[i]].addr) != NULL;
+  }
+  avl_rate[1] = bench_rate(BENCH_OPS, start);
+
+  start = bench_clock();
+  for (i = 0; i < BENCH_OPS; i++) {
+    sum += btree_find(&btree, &entries[order[i]].addr) != NULL;
+  }
+  btree_rate[1] = bench_rate(BENCH_OPS, start);
+
+  /* in-order walk, reading the entries */
+  start = bench_clock();
+  for (i = 0; i < BENCH_OPS; i += count) {
+    struct avl_node *node;
+
+    for (node = avl_walk_first(&avl); node; node = avl_walk_next(node)) {
+      sum += ((struct bench_entry *)((char *)node - offsetof(struct bench_entry, avl)))->value;
+    }
+  }
+  avl_rate[2] = bench_rate(i, start);
+
+  start = bench_clock();
+  for (i = 0; i < BENCH_OPS; i += count) {
+    struct btree_node *node;
+
+    for (node = btree_walk_first(&btree); node; node = btree_walk_next(node)) {
+      sum += ((struct bench_entry *)((char *)node - offsetof(struct bench_entry, btree)))->value;
+    }
+  }
+  btree_rate[2] = bench_rate(i, start);
+
+  /* delete */
+  start = bench_clock();
+  for (i = 0; i < count; i++) {
+    avl_delete(&avl, &entries[i].avl);
+  }
+  avl_rate[3] = bench_rate(count, start);
+
+  start = bench_clock();
+  for (i = 0; i < count; i++) {
+    btree_delete(&btree, &entries[i].btree);
+  }
+  btree_rate[3] = bench_rate(count, start);
+
+  printf("%s\t%u\tavl\t%.2f\t%.2f\t%.2f\t%.2f\n", ipv6 ? "IPv6" : "IPv4", count, avl_rate[0], avl_rate[1], avl_rate[2],
+         avl_rate[3]);
+  printf("%s\t%u\tbtree\t%.2f\t%.2f\t%.2f\t%.2f\n", ipv6 ? "IPv6" : "IPv4", count, btree_rate[0], btree_rate[1],
+         btree_rate[2], btree_rate[3]);
+
+  /* keep the compiler from dropping the loops */
+  if (sum == 0) {
+    printf("nothing found\n");
+  }
+
+  free(order);
+  free(entries);
+}
+
+int
+main(int argc __attribute__ ((unused)), char *argv[] __attribute__ ((unused)))
+{
+  static const unsigned int sizes[] = { 1000, 10000, 100000 };
+  unsigned int i;
+  int ipv6;
+
+  olsr_cnf = olsrd_get_default_cnf();
+  srandom(1);
+
+  printf("Family\tEntries\tTree\tInsert\tLookup\tWalk\tDelete (million per second)\n");
+  for (ipv6 = 0; ipv6 < 2; ipv6++) {
+    for (i = 0; i < ARRAYSIZE(sizes); i++) {
+      bench_run(sizes[i], ipv6);
+    }
+  }
+  return 0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -154,7 +154,6 @@ static void ForwardPacket(
   const char* debugInfo)
 {
   int nBytesWritten;
-  struct sockaddr_ll dest;
 
   int pollret;
   struct pollfd guard;
@@ -166,19 +165,20 @@ static void ForwardPacket(
    * interface on which the packet is being sent. */
   CheckAndUpdateLocalBroadcast(ipPacket, &intf->broadAddr);
 
-  memset(&dest, 0, sizeof(dest));
-  dest.sll_family = AF_PACKET;
-  dest.sll_protocol = htons(ETH_P_IP);
-  dest.sll_ifindex = if_nametoindex(intf->ifName);
-  dest.sll_halen = IFHWADDRLEN;
+  /* Queue the packet in the TX ring, if there is one. The queued packets
+   * are sent in one go when the current batch of input is done. */
+  if (QueueTxRingFrame(intf, ipPacket, ipPacketLen))
+  {
+    intf->nBmfPacketsTx++;
 
-  /* Use all-ones as destination MAC address. When the IP destination is
-   * a multicast address, the destination MAC address should normally also
-   * be a multicast address. E.g., when the destination IP is 224.0.0.1,
-   * the destination MAC should be 01:00:5e:00:00:01. However, it does not
-   * seem to matter when the destination MAC address is set to all-ones
-   * in that case. */
-  memset(dest.sll_addr, 0xFF, IFHWADDRLEN);
+    OLSR_PRINTF(
+      8,
+      "%s: --> %s \"%s\" (queued)\n",
+      PLUGIN_NAME_SHORT,
+      debugInfo,
+      intf->ifName);
+    return;
+  }
 
   /* Daniele Lacamera: poll guard to avoid locking in sendto().
    * Wait at most 2 polling periods. Since we're running in the context of the main
@@ -199,8 +199,8 @@ static void ForwardPacket(
     ipPacket,
     ipPacketLen,
     0,
-    (struct sockaddr*) &dest,
-    sizeof(dest));
+    (struct sockaddr*) &intf->forwardTo,
+    sizeof(intf->forwardTo));
   if (nBytesWritten != ipPacketLen)
   {
     BmfPError("sendto() error forwarding pkt on \"%s\"", intf->ifName);
@@ -886,13 +886,120 @@ static void BmfTunPacketCaptured(unsigned char* encapsulationUdpData)
 } /* BmfTunPacketCaptured */
 
 /* -------------------------------------------------------------------------
- * Function   : DoBmf
- * Description: Wait (blocking) for IP packets, then call the handler for each
- *              received packet
- * Input      : none
+ * Function   : BmfFrameCaptured
+ * Description: Check a frame captured on a capturing socket and handle it
+ *              if it is a multicast or broadcast packet
+ * Input      : intf - the network interface on which the frame was captured
+ *              sllPkttype - the type of packet (PACKET_MULTICAST etc.)
+ *              encapsulationUdpData - space for the encapsulation header,
+ *                followed by the captured IP packet
+ *              nBytes - the number of bytes captured
  * Output     : none
  * Return     : none
- * Data Used  : BmfInterfaces
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static void BmfFrameCaptured(
+  struct TBmfInterface* intf,
+  unsigned char sllPkttype,
+  unsigned char* encapsulationUdpData,
+  int nBytes)
+{
+  /* Check if the number of received bytes is large enough for an IP
+   * packet which contains at least a minimum-size IP header.
+   * Note: There is an apparent bug in the packet socket implementation in
+   * combination with VLAN interfaces. On a VLAN interface, the value returned
+   * by 'recvfrom' may (but need not) be 4 (bytes) larger than the value
+   * returned on a non-VLAN interface, for the same ethernet frame. */
+  if (nBytes < (int)sizeof(struct ip))
+  {
+    olsr_printf(
+      1,
+      "%s: captured frame too short (%d bytes) on \"%s\"\n",
+      PLUGIN_NAME,
+      nBytes,
+      intf->ifName);
+    return;
+  }
+
+  if (sllPkttype == PACKET_OUTGOING ||
+      sllPkttype == PACKET_MULTICAST ||
+      sllPkttype == PACKET_BROADCAST)
+  {
+    /* A multicast or broadcast packet was captured */
+
+    BmfPacketCaptured(intf, sllPkttype, encapsulationUdpData);
+
+  } /* if (sllPkttype == ...) */
+} /* BmfFrameCaptured */
+
+/* -------------------------------------------------------------------------
+ * Function   : BmfRxRingCaptured
+ * Description: Handle the frames in the blocks of the RX ring of a
+ *              capturing socket that the kernel has handed over
+ * Input      : intf - the network interface
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * Notes      : The frames are processed in place; the kernel has reserved
+ *              room for the encapsulation header in front of each packet
+ * ------------------------------------------------------------------------- */
+static void BmfRxRingCaptured(struct TBmfInterface* intf)
+{
+  struct TBmfRing* ring = &intf->rxRing;
+  unsigned int nBlocks;
+
+  /* Handle at most one round of blocks, to not starve the other sockets */
+  for (nBlocks = 0; nBlocks < ring->blockNr; nBlocks++)
+  {
+    struct tpacket_block_desc* block;
+    unsigned char* frame;
+    unsigned int i;
+
+    block = (struct tpacket_block_desc*) ARM_NOWARN_ALIGN(ring->mem + ring->current * BMF_RING_BLOCK_SIZE);
+    if ((block->hdr.bh1.block_status & TP_STATUS_USER) == 0)
+    {
+      /* Block still owned by the kernel */
+      break;
+    }
+
+    /* Read the block status before the frames in it */
+    __sync_synchronize();
+
+    frame = (unsigned char*)block + block->hdr.bh1.offset_to_first_pkt;
+    for (i = 0; i < block->hdr.bh1.num_pkts; i++)
+    {
+      struct tpacket3_hdr* hdr = (struct tpacket3_hdr*) ARM_NOWARN_ALIGN(frame);
+      struct sockaddr_ll* pktAddr =
+        (struct sockaddr_ll*) ARM_NOWARN_ALIGN(frame + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+
+      BmfFrameCaptured(
+        intf,
+        pktAddr->sll_pkttype,
+        frame + hdr->tp_mac - ENCAP_HDR_LEN,
+        hdr->tp_snaplen);
+
+      frame += hdr->tp_next_offset;
+    }
+
+    /* Hand the block back to the kernel */
+    __sync_synchronize();
+    block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+
+    ring->current = (ring->current + 1) % ring->blockNr;
+  }
+} /* BmfRxRingCaptured */
+
+/* -------------------------------------------------------------------------
+ * Function   : BMF_handle_captureFd
+ * Description: Socket handler of a capturing socket: handle the captured
+ *              frames, from the RX ring if the socket has one, else the
+ *              one frame that can be received
+ * Input      : skfd - the capturing socket
+ *              data - the network interface of the socket
+ *              flags - unused
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
  * ------------------------------------------------------------------------- */
 void
 BMF_handle_captureFd(int skfd, void *data, unsigned int flags __attribute__ ((unused))) {
@@ -903,6 +1010,13 @@ BMF_handle_captureFd(int skfd, void *data, unsigned int flags __attribute__ ((un
   int nBytes;
   unsigned char* ipPacket;
 
+  if (walker->rxRing.mem != NULL)
+  {
+    BmfRxRingCaptured(walker);
+    FlushTxRings();
+    return;
+  }
+
   /* Receive the captured Ethernet frame, leaving space for the BMF
    * encapsulation header */
   ipPacket = GetIpPacket(rxBuffer);
@@ -919,32 +1033,8 @@ BMF_handle_captureFd(int skfd, void *data, unsigned int flags __attribute__ ((un
     return;
   } /* if (nBytes < 0) */
 
-  /* Check if the number of received bytes is large enough for an IP
-   * packet which contains at least a minimum-size IP header.
-   * Note: There is an apparent bug in the packet socket implementation in
-   * combination with VLAN interfaces. On a VLAN interface, the value returned
-   * by 'recvfrom' may (but need not) be 4 (bytes) larger than the value
-   * returned on a non-VLAN interface, for the same ethernet frame. */
-  if (nBytes < (int)sizeof(struct ip))
-  {
-    olsr_printf(
-      1,
-      "%s: captured frame too short (%d bytes) on \"%s\"\n",
-      PLUGIN_NAME,
-      nBytes,
-      walker->ifName);
-    return;
-  }
-
-  if (pktAddr.sll_pkttype == PACKET_OUTGOING ||
-      pktAddr.sll_pkttype == PACKET_MULTICAST ||
-      pktAddr.sll_pkttype == PACKET_BROADCAST)
-  {
-    /* A multicast or broadcast packet was captured */
-
-    BmfPacketCaptured(walker, pktAddr.sll_pkttype, rxBuffer);
-
-  } /* if (pktAddr.sll_pkttype == ...) */
+  BmfFrameCaptured(walker, pktAddr.sll_pkttype, rxBuffer, nBytes);
+  FlushTxRings();
 }
 
 void
@@ -1042,6 +1132,7 @@ BMF_handle_listeningFd(int skfd, void *data, unsigned int flags __attribute__ ((
     &forwardedBy,
     &forwardedTo,
     rxBuffer + headerLength + sizeof(struct udphdr));
+  FlushTxRings();
 
 }
 
@@ -1097,6 +1188,7 @@ BMF_handle_encapsulatingFd(int skfd, void *data, unsigned int flags __attribute_
    * my unicast or my local broadcast address). Therefore we fill in 'NULL'
    * for the 'forwardedTo' parameter. */
   BmfEncapsulationPacketReceived(walker, &forwardedBy, NULL, rxBuffer);
+  FlushTxRings();
 }
 
 void
@@ -1135,6 +1227,7 @@ BMF_handle_tuntapFd(int skfd __attribute__ ((unused)),
   }
 
   BmfTunPacketCaptured(rxBuffer);
+  FlushTxRings();
 }
 
 /* -------------------------------------------------------------------------
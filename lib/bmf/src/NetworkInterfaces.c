@@ -46,6 +46,7 @@
 #include <errno.h> /* errno */
 #include <unistd.h> /* close() */
 #include <sys/ioctl.h> /* ioctl() */
+#include <sys/mman.h> /* mmap(), munmap() */
 #include <fcntl.h> /* fcntl() */
 #include <assert.h> /* assert() */
 #include <net/if.h> /* socket(), ifreq, if_indextoname(), if_nametoindex() */
@@ -121,6 +122,11 @@ int TunTapIpOverruled = 0;
  * parameter "CapturePacketsOnOlsrInterfaces" to "yes". */
 int CapturePacketsOnOlsrInterfaces = 0;
 
+/* Whether or not to receive and send captured packets via memory mapped
+ * rings on the capturing sockets. May be overruled by setting the plugin
+ * parameter "CaptureRing" to "yes". */
+int CaptureRing = 0;
+
 /* -------------------------------------------------------------------------
  * Function   : SetBmfInterfaceName
  * Description: Overrule the default network interface name ("bmf0") of the
@@ -273,6 +279,37 @@ int SetCapturePacketsOnOlsrInterfaces(
   return 1;
 } /* SetCapturePacketsOnOlsrInterfaces */
 
+/* -------------------------------------------------------------------------
+ * Function   : SetCaptureRing
+ * Description: Overrule the default setting, enabling or disabling the
+ *              use of memory mapped rings on the capturing sockets.
+ * Input      : enable - either "yes" or "no"
+ *              data - not used
+ *              addon - not used
+ * Output     : none
+ * Return     : success (0) or fail (1)
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+int SetCaptureRing(
+  const char* enable,
+  void* data __attribute__((unused)),
+  set_plugin_parameter_addon addon __attribute__((unused)))
+{
+  if (strcmp(enable, "yes") == 0)
+  {
+    CaptureRing = 1;
+    return 0;
+  }
+  else if (strcmp(enable, "no") == 0)
+  {
+    CaptureRing = 0;
+    return 0;
+  }
+
+  /* Value not recognized */
+  return 1;
+} /* SetCaptureRing */
+
 /* -------------------------------------------------------------------------
  * Function   : SetBmfMechanism
  * Description: Overrule the default BMF mechanism to either BM_BROADCAST or
@@ -1042,6 +1079,208 @@ static int CreateCaptureSocket(const char* ifName)
   return skfd;
 } /* CreateCaptureSocket */
 
+/* -------------------------------------------------------------------------
+ * Function   : SetupCaptureRings
+ * Description: Set up a memory mapped TPACKET_V3 RX ring and, if the kernel
+ *              supports it, a TX ring on a capturing socket
+ * Input      : intf - the network interface
+ *              skfd - the capturing socket of the network interface
+ * Output     : none
+ * Return     : success (0) or fail (-1)
+ * Data Used  : none
+ * Notes      : On failure, the socket can still be used with recvfrom() and
+ *              sendto(). Room for the BMF encapsulation header is reserved
+ *              in front of each received packet, so that captured packets
+ *              can be processed in place.
+ * ------------------------------------------------------------------------- */
+static int SetupCaptureRings(struct TBmfInterface* intf, int skfd)
+{
+  int version = TPACKET_V3;
+  unsigned int reserve = ENCAP_HDR_LEN;
+  struct tpacket_req3 req;
+  size_t rxSize;
+  size_t txSize = 0;
+  void* mem;
+
+  if (setsockopt(skfd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+  {
+    BmfPError("setsockopt(PACKET_VERSION) error on \"%s\"", intf->ifName);
+    return -1;
+  }
+
+  if (setsockopt(skfd, SOL_PACKET, PACKET_RESERVE, &reserve, sizeof(reserve)) < 0)
+  {
+    BmfPError("setsockopt(PACKET_RESERVE) error on \"%s\"", intf->ifName);
+    return -1;
+  }
+
+  memset(&req, 0, sizeof(req));
+  req.tp_block_size = BMF_RING_BLOCK_SIZE;
+  req.tp_block_nr = BMF_RX_RING_BLOCKS;
+  req.tp_frame_size = BMF_RING_FRAME_SIZE;
+  req.tp_frame_nr = (BMF_RING_BLOCK_SIZE / BMF_RING_FRAME_SIZE) * BMF_RX_RING_BLOCKS;
+  req.tp_retire_blk_tov = BMF_RING_BLOCK_TIMEOUT;
+  if (setsockopt(skfd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0)
+  {
+    BmfPError("setsockopt(PACKET_RX_RING) error on \"%s\"", intf->ifName);
+    return -1;
+  }
+  rxSize = (size_t)BMF_RING_BLOCK_SIZE * BMF_RX_RING_BLOCKS;
+
+  /* A TPACKET_V3 TX ring needs Linux 4.11 or later; without it, packets
+   * are sent with sendto() */
+  memset(&req, 0, sizeof(req));
+  req.tp_block_size = BMF_RING_BLOCK_SIZE;
+  req.tp_block_nr = BMF_TX_RING_BLOCKS;
+  req.tp_frame_size = BMF_RING_FRAME_SIZE;
+  req.tp_frame_nr = (BMF_RING_BLOCK_SIZE / BMF_RING_FRAME_SIZE) * BMF_TX_RING_BLOCKS;
+  if (setsockopt(skfd, SOL_PACKET, PACKET_TX_RING, &req, sizeof(req)) == 0)
+  {
+    txSize = (size_t)BMF_RING_BLOCK_SIZE * BMF_TX_RING_BLOCKS;
+  }
+
+  /* The RX ring comes first in the mapped area, followed by the TX ring */
+  mem = mmap(NULL, rxSize + txSize, PROT_READ | PROT_WRITE, MAP_SHARED, skfd, 0);
+  if (mem == MAP_FAILED)
+  {
+    BmfPError("mmap() error on \"%s\"", intf->ifName);
+
+    /* Release the rings again */
+    memset(&req, 0, sizeof(req));
+    setsockopt(skfd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+    if (txSize > 0)
+    {
+      setsockopt(skfd, SOL_PACKET, PACKET_TX_RING, &req, sizeof(req));
+    }
+    return -1;
+  }
+
+  intf->ringMem = mem;
+  intf->ringMemSize = rxSize + txSize;
+
+  intf->rxRing.mem = mem;
+  intf->rxRing.blockNr = BMF_RX_RING_BLOCKS;
+  intf->rxRing.frameNr = 0;
+  intf->rxRing.current = 0;
+
+  if (txSize > 0)
+  {
+    intf->txRing.mem = intf->ringMem + rxSize;
+    intf->txRing.blockNr = BMF_TX_RING_BLOCKS;
+    intf->txRing.frameNr = (BMF_RING_BLOCK_SIZE / BMF_RING_FRAME_SIZE) * BMF_TX_RING_BLOCKS;
+    intf->txRing.current = 0;
+  }
+
+  OLSR_PRINTF(
+    8,
+    "%s: memory mapped RX%s ring on \"%s\"\n",
+    PLUGIN_NAME_SHORT,
+    txSize > 0 ? " and TX" : "",
+    intf->ifName);
+
+  return 0;
+} /* SetupCaptureRings */
+
+/* -------------------------------------------------------------------------
+ * Function   : FlushTxRing
+ * Description: Have the kernel send the frames queued in the TX ring of a
+ *              network interface
+ * Input      : intf - the network interface
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static void FlushTxRing(struct TBmfInterface* intf)
+{
+  if (intf->nTxPending == 0)
+  {
+    return;
+  }
+
+  /* Do not wait for the frames to be sent: the TX ring frames become
+   * available again as soon as the kernel is done with them */
+  if (sendto(
+        intf->capturingSkfd,
+        NULL,
+        0,
+        MSG_DONTWAIT,
+        (struct sockaddr*) &intf->forwardTo,
+        sizeof(intf->forwardTo)) < 0 && errno != EAGAIN)
+  {
+    BmfPError("sendto() error flushing TX ring on \"%s\"", intf->ifName);
+  }
+
+  intf->nTxPending = 0;
+} /* FlushTxRing */
+
+/* -------------------------------------------------------------------------
+ * Function   : QueueTxRingFrame
+ * Description: Copy an IP packet into the TX ring of a network interface.
+ *              The packet is sent at the next call to FlushTxRings().
+ * Input      : intf - the network interface
+ *              ipPacket - the IP packet
+ *              ipPacketLen - the length of the IP packet
+ * Output     : none
+ * Return     : queued (1) or not (0), in which case the caller must send
+ *              the packet itself
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+int QueueTxRingFrame(
+  struct TBmfInterface* intf,
+  unsigned char* ipPacket,
+  u_int16_t ipPacketLen)
+{
+  struct TBmfRing* ring = &intf->txRing;
+  struct tpacket3_hdr* frame;
+  const unsigned int dataOffset = TPACKET3_HDRLEN - sizeof(struct sockaddr_ll);
+
+  if (ring->mem == NULL || dataOffset + ipPacketLen > BMF_RING_FRAME_SIZE)
+  {
+    return 0;
+  }
+
+  frame = (struct tpacket3_hdr*) ARM_NOWARN_ALIGN(ring->mem + ring->current * BMF_RING_FRAME_SIZE);
+  if (frame->tp_status != TP_STATUS_AVAILABLE && frame->tp_status != TP_STATUS_WRONG_FORMAT)
+  {
+    /* The ring is full. Send what is queued, so that the packet the caller
+     * is about to send does not overtake the queued ones. */
+    FlushTxRing(intf);
+    return 0;
+  }
+
+  memcpy((unsigned char*)frame + dataOffset, ipPacket, ipPacketLen);
+  frame->tp_len = ipPacketLen;
+  frame->tp_next_offset = 0;
+
+  /* Make sure the kernel sees the packet before the status */
+  __sync_synchronize();
+  frame->tp_status = TP_STATUS_SEND_REQUEST;
+
+  ring->current = (ring->current + 1) % ring->frameNr;
+  intf->nTxPending++;
+
+  return 1;
+} /* QueueTxRingFrame */
+
+/* -------------------------------------------------------------------------
+ * Function   : FlushTxRings
+ * Description: Send the frames queued in the TX rings of all network
+ *              interfaces
+ * Input      : none
+ * Output     : none
+ * Return     : none
+ * Data Used  : BmfInterfaces
+ * ------------------------------------------------------------------------- */
+void FlushTxRings(void)
+{
+  struct TBmfInterface* walker;
+
+  for (walker = BmfInterfaces; walker != NULL; walker = walker->next)
+  {
+    FlushTxRing(walker);
+  }
+} /* FlushTxRings */
+
 /* -------------------------------------------------------------------------
  * Function   : CreateListeningSocket
  * Description: Create socket for promiscuously listening to BMF packets.
@@ -1453,6 +1692,43 @@ static int CreateInterface(
     return 0;
   }
 
+  /* Cache the interface index and the link-layer destination of packets
+   * forwarded on the capturing socket */
+  newIf->ifIndex = if_nametoindex(ifName);
+
+  memset(&newIf->forwardTo, 0, sizeof(newIf->forwardTo));
+  newIf->forwardTo.sll_family = AF_PACKET;
+  newIf->forwardTo.sll_protocol = htons(ETH_P_IP);
+  newIf->forwardTo.sll_ifindex = newIf->ifIndex;
+  newIf->forwardTo.sll_halen = IFHWADDRLEN;
+
+  /* Use all-ones as destination MAC address. When the IP destination is
+   * a multicast address, the destination MAC address should normally also
+   * be a multicast address. E.g., when the destination IP is 224.0.0.1,
+   * the destination MAC should be 01:00:5e:00:00:01. However, it does not
+   * seem to matter when the destination MAC address is set to all-ones
+   * in that case. */
+  memset(newIf->forwardTo.sll_addr, 0xFF, IFHWADDRLEN);
+
+  newIf->ringMem = NULL;
+  newIf->ringMemSize = 0;
+  memset(&newIf->rxRing, 0, sizeof(newIf->rxRing));
+  memset(&newIf->txRing, 0, sizeof(newIf->txRing));
+  newIf->nTxPending = 0;
+  memcpy(newIf->ifName, ifName, IFNAMSIZ);
+
+  if (capturingSkfd >= 0 && CaptureRing != 0)
+  {
+    if (SetupCaptureRings(newIf, capturingSkfd) < 0)
+    {
+      olsr_printf(
+        1,
+        "%s: no memory mapped ring on \"%s\", using recvfrom()\n",
+        PLUGIN_NAME,
+        ifName);
+    }
+  }
+
   /* add listeners to sockets */
   if (capturingSkfd != -1) {
     add_olsr_socket(capturingSkfd, NULL, BMF_handle_captureFd, newIf, SP_IMM_READ);
@@ -1468,7 +1744,6 @@ static int CreateInterface(
   newIf->encapsulatingSkfd = encapsulatingSkfd;
   newIf->listeningSkfd = listeningSkfd;
   memcpy(newIf->macAddr, ifr.ifr_hwaddr.sa_data, IFHWADDRLEN);
-  memcpy(newIf->ifName, ifName, IFNAMSIZ);
   newIf->olsrIntf = olsrIntf;
   if (olsrIntf != NULL)
   {
@@ -1697,6 +1972,10 @@ void CloseBmfNetworkInterfaces(void)
 
     if (bmfIf->capturingSkfd >= 0)
     {
+      if (bmfIf->ringMem != NULL)
+      {
+        munmap(bmfIf->ringMem, bmfIf->ringMemSize);
+      }
       close(bmfIf->capturingSkfd);
       remove_olsr_socket(bmfIf->capturingSkfd, NULL, BMF_handle_captureFd);
       nClosed++;
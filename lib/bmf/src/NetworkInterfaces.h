@@ -42,6 +42,7 @@
 
 /* System includes */
 #include <netinet/in.h> /* struct in_addr */
+#include <linux/if_packet.h> /* struct sockaddr_ll */
 
 /* OLSR includes */
 #include "olsr_types.h" /* olsr_ip_addr */
@@ -53,6 +54,28 @@
 /* Size of buffer in which packets are received */
 #define BMF_BUFFER_SIZE 2048
 
+/* Geometry of the memory mapped (PACKET_MMAP) rings of a capturing socket.
+ * The RX ring is a TPACKET_V3 ring of variable-size frames in blocks; the
+ * kernel hands over a block when it is full or after BMF_RING_BLOCK_TIMEOUT
+ * milliseconds. The TX ring consists of fixed-size frames. */
+#define BMF_RING_BLOCK_SIZE (1 << 16)
+#define BMF_RX_RING_BLOCKS 32
+#define BMF_TX_RING_BLOCKS 8
+#define BMF_RING_FRAME_SIZE BMF_BUFFER_SIZE
+#define BMF_RING_BLOCK_TIMEOUT 4
+
+struct TBmfRing
+{
+  /* Start of the ring in the memory mapped area; NULL if the ring is not used */
+  unsigned char* mem;
+
+  unsigned int blockNr;
+  unsigned int frameNr;
+
+  /* Next block (RX) or frame (TX) to look at */
+  unsigned int current;
+};
+
 struct TBmfInterface
 {
   /* File descriptor of raw packet socket, used for capturing multicast packets */
@@ -70,6 +93,22 @@ struct TBmfInterface
 
   char ifName[IFNAMSIZ];
 
+  /* Index of this network interface */
+  int ifIndex;
+
+  /* Link-layer destination of packets forwarded on the capturing socket */
+  struct sockaddr_ll forwardTo;
+
+  /* Memory mapped rings of the capturing socket. Only used if the
+   * plugin parameter "CaptureRing" is set to "yes". */
+  unsigned char* ringMem;
+  size_t ringMemSize;
+  struct TBmfRing rxRing;
+  struct TBmfRing txRing;
+
+  /* Number of frames in the TX ring that have not been flushed yet */
+  int nTxPending;
+
   /* OLSRs idea of this network interface. NULL if this interface is not
    * OLSR-enabled. */
   struct interface* olsrIntf;
@@ -107,6 +146,8 @@ extern u_int32_t EtherTunTapIpBroadcast;
 
 extern int CapturePacketsOnOlsrInterfaces;
 
+extern int CaptureRing;
+
 enum TBmfMechanism { BM_BROADCAST = 0, BM_UNICAST_PROMISCUOUS };
 extern enum TBmfMechanism BmfMechanism;
 
@@ -114,6 +155,7 @@ int SetBmfInterfaceName(const char* ifname, void* data, set_plugin_parameter_add
 int SetBmfInterfaceIp(const char* ip, void* data, set_plugin_parameter_addon addon);
 int SetBmfInterfacePersistent(const char* value, void* data, set_plugin_parameter_addon addon);
 int SetCapturePacketsOnOlsrInterfaces(const char* enable, void* data, set_plugin_parameter_addon addon);
+int SetCaptureRing(const char* enable, void* data, set_plugin_parameter_addon addon);
 int SetBmfMechanism(const char* mechanism, void* data, set_plugin_parameter_addon addon);
 int DeactivateSpoofFilter(void);
 void RestoreSpoofFilter(void);
@@ -138,6 +180,8 @@ void CloseBmfNetworkInterfaces(void);
 int AddNonOlsrBmfIf(const char* ifName, void* data, set_plugin_parameter_addon addon);
 int IsNonOlsrBmfIf(const char* ifName);
 void CheckAndUpdateLocalBroadcast(unsigned char* ipPacket, union olsr_ip_addr* broadAddr);
+int QueueTxRingFrame(struct TBmfInterface* intf, unsigned char* ipPacket, u_int16_t ipPacketLen);
+void FlushTxRings(void);
 void AddMulticastRoute(void);
 void DeleteMulticastRoute(void);
 
@@ -97,9 +97,9 @@ int olsrd_plugin_init(void)
   /* Register ifchange function */
   olsr_add_ifchange_handler(&InterfaceChange);
 
-  /* Register the duplicate registration pruning process */
-  olsr_start_timer(3 * MSEC_PER_SEC, 0, OLSR_TIMER_PERIODIC,
-                   &PrunePacketHistory, NULL, 0);
+  /* Register the packet history expiry and statistics report */
+  olsr_start_timer(HISTORY_HOLD_TIME, 0, OLSR_TIMER_PERIODIC,
+                   &ReportPacketHistory, NULL, 0);
 
 
   return InitBmf(NULL);
@@ -126,6 +126,7 @@ static const struct olsrd_plugin_parameters plugin_parameters[] = {
     { .name = "BmfInterfaceIp", .set_plugin_parameter = &SetBmfInterfaceIp, .data = NULL },
     { .name = "BmfInterfacePersistent", .set_plugin_parameter = &SetBmfInterfacePersistent, .data = NULL },
     { .name = "CapturePacketsOnOlsrInterfaces", .set_plugin_parameter = &SetCapturePacketsOnOlsrInterfaces, .data = NULL },
+    { .name = "CaptureRing", .set_plugin_parameter = &SetCaptureRing, .data = NULL },
     { .name = "BmfMechanism", .set_plugin_parameter = &SetBmfMechanism, .data = NULL },
     { .name = "FanOutLimit", .set_plugin_parameter = &SetFanOutLimit, .data = NULL },
     { .name = "BroadcastRetransmitCount", .set_plugin_parameter = &set_plugin_int, .data = &BroadcastRetransmitCount},
@@ -389,11 +389,13 @@ pcf_event(int my_changes_neighborhood, int my_changes_topology, int my_changes_h
 static void
 ipc_print_tc_link(struct autobuf *abuf, const struct tc_entry *entry, const struct tc_edge_entry *dst_entry)
 {
-  struct ipaddr_str strbuf1, strbuf2;
-  struct lqtextbuffer lqbuffer;
-
-  abuf_appendf(abuf, "\"%s\" -> \"%s\"[label=\"%s\"];\n", olsr_ip_to_string(&strbuf1, &entry->addr),
-               olsr_ip_to_string(&strbuf2, &dst_entry->T_dest_addr), get_linkcost_text(dst_entry->cost, false, &lqbuffer));
+  abuf_putc(abuf, '"');
+  abuf_append_ip(abuf, &entry->addr);
+  abuf_puts(abuf, "\" -> \"");
+  abuf_append_ip(abuf, tc_edge_dest_addr(dst_entry));
+  abuf_puts(abuf, "\"[label=\"");
+  append_linkcost_text(abuf, dst_entry->cost, false);
+  abuf_puts(abuf, "\"];\n");
 }
 
 static void
@@ -779,15 +779,15 @@ build_ipaddr_link(struct autobuf *abuf, const bool want_link, const union olsr_i
 static void
 build_route(struct autobuf *abuf, const struct rt_entry *rt)
 {
-  struct lqtextbuffer lqbuffer;
-
   abuf_puts(abuf, "<tr>");
   build_ipaddr_with_link(abuf, &rt->rt_dst.prefix, rt->rt_dst.prefix_len);
   build_ipaddr_with_link(abuf, &rt->rt_best->rtp_nexthop.gateway, -1);
 
-  abuf_appendf(abuf, "<td>%d</td>", rt->rt_best->rtp_metric.hops);
-  abuf_appendf(abuf, "<td>%s</td>",
-             get_linkcost_text(rt->rt_best->rtp_metric.cost, true, &lqbuffer));
+  abuf_puts(abuf, "<td>");
+  abuf_append_int(abuf, rt->rt_best->rtp_metric.hops);
+  abuf_puts(abuf, "</td><td>");
+  append_linkcost_text(abuf, rt->rt_best->rtp_metric.cost, true);
+  abuf_puts(abuf, "</td>");
   abuf_appendf(abuf, "<td>%s</td></tr>\n",
              if_ifwithindex_name(rt->rt_best->rtp_nexthop.iif_index));
 }
@@ -1038,12 +1038,14 @@ build_topo_body(struct autobuf *abuf)
     OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
       if (tc_edge->edge_inv) {
         abuf_puts(abuf, "<tr>");
-        build_ipaddr_with_link(abuf, &tc_edge->T_dest_addr, -1);
+        build_ipaddr_with_link(abuf, tc_edge_dest_addr(tc_edge), -1);
         build_ipaddr_with_link(abuf, &tc->addr, -1);
         if (olsr_cnf->lq_level > 0) {
-          struct lqtextbuffer lqbuffer1, lqbuffer2;
-          abuf_appendf(abuf, "<td>(%s) %s</td>\n",
-                     get_tc_edge_entry_text(tc_edge, '/', &lqbuffer1), get_linkcost_text(tc_edge->cost, false, &lqbuffer2));
+          abuf_puts(abuf, "<td>(");
+          append_tc_edge_entry_text(abuf, tc_edge, '/');
+          abuf_puts(abuf, ") ");
+          append_linkcost_text(abuf, tc_edge->cost, false);
+          abuf_puts(abuf, "</td>\n");
         }
         abuf_puts(abuf, "</tr>\n");
       }
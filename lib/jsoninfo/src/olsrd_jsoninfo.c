@@ -86,6 +86,10 @@
 #include "lq_plugin.h"
 #include "common/autobuf.h"
 #include "gateway.h"
+#include "olsr_profile.h"
+#include "olsr_admit.h"
+#include "olsr_cookie.h"
+#include "olsr_node_id.h"
 
 #include "olsrd_jsoninfo.h"
 #include "olsrd_plugin.h"
@@ -111,6 +115,7 @@ static void abuf_json_boolean(struct autobuf *abuf, const char* key, int value);
 static void abuf_json_string(struct autobuf *abuf, const char* key, const char* value);
 static void abuf_json_int(struct autobuf *abuf, const char* key, long value);
 static void abuf_json_float(struct autobuf *abuf, const char* key, float value);
+static void abuf_json_ip(struct autobuf *abuf, const char* key, const union olsr_ip_addr *value);
 
 static void send_info(unsigned int /*send_what*/, int /*socket*/);
 static void ipc_action(int, void *, unsigned int);
@@ -124,6 +129,9 @@ static void ipc_print_gateways(struct autobuf *);
 static void ipc_print_config(struct autobuf *);
 static void ipc_print_interfaces(struct autobuf *);
 static void ipc_print_plugins(struct autobuf *);
+static void ipc_print_profile(struct autobuf *);
+static void ipc_print_admission(struct autobuf *);
+static void ipc_print_memory(struct autobuf *);
 static void ipc_print_olsrd_conf(struct autobuf *abuf);
 
 #define TXT_IPC_BUFSIZE 256
@@ -150,6 +158,18 @@ static void ipc_print_olsrd_conf(struct autobuf *abuf);
 /* this data is not JSON format but olsrd.conf format */
 #define SIW_OLSRD_CONF 0x1000
 
+/* the latency histograms of the core, only sent on request */
+#define SIW_PROFILE 0x2000
+
+/* the admission control of received messages, only sent on request */
+#define SIW_ADMISSION 0x4000
+
+/* the memory and timer usage of the core by cookie, only sent on request */
+#define SIW_MEMORY 0x8000
+
+/* all of the JSON formatted data */
+#define SIW_JSON (SIW_ALL | SIW_PROFILE | SIW_ADMISSION | SIW_MEMORY)
+
 #define MAX_CLIENTS 3
 
 static char *outbuffer[MAX_CLIENTS];
@@ -185,7 +205,7 @@ abuf_json_open_object(struct autobuf *abuf, const char* header)
 static void
 abuf_json_close_object(struct autobuf *abuf)
 {
-  abuf_appendf(abuf, "\t}\n");
+  abuf_puts(abuf, "\t}\n");
   currentjsondepth--;
 }
 
@@ -193,7 +213,7 @@ static void
 abuf_json_open_array(struct autobuf *abuf, const char* header)
 {
   if (entrynumber[currentjsondepth])
-    abuf_appendf(abuf, ",\n\t");
+    abuf_puts(abuf, ",\n\t");
   abuf_appendf(abuf, "\"%s\": [\n", header);
   entrynumber[currentjsondepth]++;
   currentjsondepth++;
@@ -203,7 +223,7 @@ abuf_json_open_array(struct autobuf *abuf, const char* header)
 static void
 abuf_json_close_array(struct autobuf *abuf)
 {
-  abuf_appendf(abuf, "]\n");
+  abuf_puts(abuf, "]\n");
   entrynumber[currentjsondepth] = 0;
   currentjsondepth--;
 }
@@ -212,9 +232,9 @@ static void
 abuf_json_open_array_entry(struct autobuf *abuf)
 {
   if (entrynumber[currentjsondepth])
-    abuf_appendf(abuf, ",\n{");
+    abuf_puts(abuf, ",\n{");
   else
-    abuf_appendf(abuf, "{");
+    abuf_putc(abuf, '{');
   entrynumber[currentjsondepth]++;
   currentjsondepth++;
   entrynumber[currentjsondepth] = 0;
@@ -223,7 +243,7 @@ abuf_json_open_array_entry(struct autobuf *abuf)
 static void
 abuf_json_close_array_entry(struct autobuf *abuf)
 {
-  abuf_appendf(abuf, "}");
+  abuf_putc(abuf, '}');
   entrynumber[currentjsondepth] = 0;
   currentjsondepth--;
 }
@@ -232,9 +252,9 @@ static void
 abuf_json_insert_comma(struct autobuf *abuf)
 {
   if (entrynumber[currentjsondepth])
-    abuf_appendf(abuf, ",\n");
+    abuf_puts(abuf, ",\n");
   else
-    abuf_appendf(abuf, "\n");
+    abuf_putc(abuf, '\n');
   entrynumber[currentjsondepth]++;
 }
 
@@ -242,21 +262,30 @@ static void
 abuf_json_boolean(struct autobuf *abuf, const char* key, int value)
 {
   abuf_json_insert_comma(abuf);
-  abuf_appendf(abuf, "\t\"%s\": %s", key, value ? "true" : "false");
+  abuf_puts(abuf, "\t\"");
+  abuf_puts(abuf, key);
+  abuf_puts(abuf, value ? "\": true" : "\": false");
 }
 
 static void
 abuf_json_string(struct autobuf *abuf, const char* key, const char* value)
 {
   abuf_json_insert_comma(abuf);
-  abuf_appendf(abuf, "\t\"%s\": \"%s\"", key, value);
+  abuf_puts(abuf, "\t\"");
+  abuf_puts(abuf, key);
+  abuf_puts(abuf, "\": \"");
+  abuf_puts(abuf, value);
+  abuf_putc(abuf, '"');
 }
 
 static void
 abuf_json_int(struct autobuf *abuf, const char* key, long value)
 {
   abuf_json_insert_comma(abuf);
-  abuf_appendf(abuf, "\t\"%s\": %li", key, value);
+  abuf_puts(abuf, "\t\"");
+  abuf_puts(abuf, key);
+  abuf_puts(abuf, "\": ");
+  abuf_append_int(abuf, value);
 }
 
 static void
@@ -266,6 +295,64 @@ abuf_json_float(struct autobuf *abuf, const char* key, float value)
   abuf_appendf(abuf, "\t\"%s\": %.03f", key, (double)value);
 }
 
+/*
+ * "linkQuality" and "neighborLinkQuality" of a link or (if link is NULL)
+ * of a tc edge, written as the lq plugin prints them, without printf
+ */
+static void
+abuf_json_link_quality(struct autobuf *abuf, struct link_entry *link, struct tc_edge_entry *tc_edge)
+{
+  char nlq[sizeof(struct lqtextbuffer)];
+  char *sep;
+  int start, len;
+
+  abuf_json_insert_comma(abuf);
+  abuf_puts(abuf, "\t\"linkQuality\": ");
+  start = abuf->len;
+  if (link != NULL) {
+    append_link_entry_text(abuf, link, '\t');
+  } else {
+    append_tc_edge_entry_text(abuf, tc_edge, '\t');
+  }
+
+  /* the text is "LQ<tab>NLQ", move NLQ into its own field */
+  sep = memchr(abuf->buf + start, '\t', abuf->len - start);
+  if (sep == NULL) {
+    strcpy(nlq, "0");
+  } else {
+    len = abuf->len - (sep + 1 - abuf->buf);
+    if (len >= (int)sizeof(nlq)) {
+      len = sizeof(nlq) - 1;
+    }
+    memcpy(nlq, sep + 1, len);
+    nlq[len] = '\0';
+    abuf->len = sep - abuf->buf;
+    *sep = '\0';
+  }
+
+  abuf_json_insert_comma(abuf);
+  abuf_puts(abuf, "\t\"neighborLinkQuality\": ");
+  abuf_puts(abuf, nlq);
+}
+
+static void
+abuf_json_u64(struct autobuf *abuf, const char* key, uint64_t value)
+{
+  abuf_json_insert_comma(abuf);
+  abuf_appendf(abuf, "\t\"%s\": %llu", key, (unsigned long long)value);
+}
+
+static void
+abuf_json_ip(struct autobuf *abuf, const char* key, const union olsr_ip_addr *value)
+{
+  abuf_json_insert_comma(abuf);
+  abuf_puts(abuf, "\t\"");
+  abuf_puts(abuf, key);
+  abuf_puts(abuf, "\": \"");
+  abuf_append_ip(abuf, value);
+  abuf_putc(abuf, '"');
+}
+
 
 
 /* Linux specific functions for getting system info */
@@ -532,6 +619,9 @@ ipc_action(int fd, void *data __attribute__ ((unused)), unsigned int flags __att
         if (0 != strstr(requ, "/interfaces")) send_what |= SIW_INTERFACES;
         if (0 != strstr(requ, "/config")) send_what |= SIW_CONFIG;
         if (0 != strstr(requ, "/plugins")) send_what |= SIW_PLUGINS;
+        if (0 != strstr(requ, "/profile")) send_what |= SIW_PROFILE;
+        if (0 != strstr(requ, "/admission")) send_what |= SIW_ADMISSION;
+        if (0 != strstr(requ, "/memory")) send_what |= SIW_MEMORY;
       }
     }
     if ( send_what == 0 ) send_what = SIW_ALL;
@@ -543,7 +633,6 @@ ipc_action(int fd, void *data __attribute__ ((unused)), unsigned int flags __att
 static void
 ipc_print_neighbors(struct autobuf *abuf)
 {
-  struct ipaddr_str buf1;
   struct neighbor_entry *neigh;
   struct neighbor_2_list_entry *list_2;
   int thop_cnt;
@@ -553,8 +642,7 @@ ipc_print_neighbors(struct autobuf *abuf)
   /* Neighbors */
   OLSR_FOR_ALL_NBR_ENTRIES(neigh) {
     abuf_json_open_array_entry(abuf);
-    abuf_json_string(abuf, "ipv4Address",
-                     olsr_ip_to_string(&buf1, &neigh->neighbor_main_addr));
+    abuf_json_ip(abuf, "ipv4Address", &neigh->neighbor_main_addr);
     abuf_json_boolean(abuf, "symmetric", (neigh->status == SYM));
     abuf_json_boolean(abuf, "multiPointRelay", neigh->is_mpr);
     abuf_json_boolean(abuf, "multiPointRelaySelector",
@@ -567,10 +655,10 @@ ipc_print_neighbors(struct autobuf *abuf)
       abuf_appendf(abuf, "\t\"twoHopNeighbors\": [");
       for (list_2 = neigh->neighbor_2_list.next; list_2 != &neigh->neighbor_2_list; list_2 = list_2->next) {
         if (thop_cnt)
-          abuf_appendf(abuf, ", ");
-        abuf_appendf(abuf,
-                     "\"%s\"",
-                     olsr_ip_to_string(&buf1, &list_2->neighbor_2->neighbor_2_addr));
+          abuf_puts(abuf, ", ");
+        abuf_putc(abuf, '"');
+        abuf_append_ip(abuf, &list_2->neighbor_2->neighbor_2_addr);
+        abuf_putc(abuf, '"');
         thop_cnt++;
       }
     }
@@ -585,25 +673,17 @@ ipc_print_neighbors(struct autobuf *abuf)
 static void
 ipc_print_links(struct autobuf *abuf)
 {
-  struct ipaddr_str buf1, buf2;
-  struct lqtextbuffer lqbuffer1;
-
   struct link_entry *my_link = NULL;
 
   abuf_json_open_array(abuf, "links");
   OLSR_FOR_ALL_LINK_ENTRIES(my_link) {
-    const char* lqs;
     int diff = (unsigned int)(my_link->link_timer->timer_clock - now_times);
 
     abuf_json_open_array_entry(abuf);
-    abuf_json_string(abuf, "localIP",
-                     olsr_ip_to_string(&buf1, &my_link->local_iface_addr));
-    abuf_json_string(abuf, "remoteIP",
-                     olsr_ip_to_string(&buf2, &my_link->neighbor_iface_addr));
+    abuf_json_ip(abuf, "localIP", &my_link->local_iface_addr);
+    abuf_json_ip(abuf, "remoteIP", &my_link->neighbor_iface_addr);
     abuf_json_int(abuf, "validityTime", diff);
-    lqs = get_link_entry_text(my_link, '\t', &lqbuffer1);
-    abuf_json_float(abuf, "linkQuality", atof(lqs));
-    abuf_json_float(abuf, "neighborLinkQuality", atof(strrchr(lqs, '\t')));
+    abuf_json_link_quality(abuf, my_link, NULL);
     if (my_link->linkcost >= LINK_COST_BROKEN)
       abuf_json_int(abuf, "linkCost", LINK_COST_BROKEN);
     else
@@ -617,7 +697,6 @@ ipc_print_links(struct autobuf *abuf)
 static void
 ipc_print_routes(struct autobuf *abuf)
 {
-  struct ipaddr_str buf1, buf2;
   struct rt_entry *rt;
 
   abuf_json_open_array(abuf, "routes");
@@ -625,11 +704,9 @@ ipc_print_routes(struct autobuf *abuf)
   /* Walk the route table */
   OLSR_FOR_ALL_RT_ENTRIES(rt) {
     abuf_json_open_array_entry(abuf);
-    abuf_json_string(abuf, "destination",
-                     olsr_ip_to_string(&buf1, &rt->rt_dst.prefix));
+    abuf_json_ip(abuf, "destination", &rt->rt_dst.prefix);
     abuf_json_int(abuf, "genmask", rt->rt_dst.prefix_len);
-    abuf_json_string(abuf, "gateway",
-                     olsr_ip_to_string(&buf2, &rt->rt_best->rtp_nexthop.gateway));
+    abuf_json_ip(abuf, "gateway", &rt->rt_best->rtp_nexthop.gateway);
     abuf_json_int(abuf, "metric", rt->rt_best->rtp_metric.hops);
     if (rt->rt_best->rtp_metric.cost >= ROUTE_COST_BROKEN)
       abuf_json_int(abuf, "rtpMetricCost", ROUTE_COST_BROKEN);
@@ -656,19 +733,12 @@ ipc_print_topology(struct autobuf *abuf)
     struct tc_edge_entry *tc_edge;
     OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
       if (tc_edge->edge_inv) {
-        struct ipaddr_str dstbuf, addrbuf;
-        struct lqtextbuffer lqbuffer1;
         uint32_t vt = tc->validity_timer != NULL ? (tc->validity_timer->timer_clock - now_times) : 0;
         int diff = (int)(vt);
-        const char* lqs;
         abuf_json_open_array_entry(abuf);
-        abuf_json_string(abuf, "destinationIP",
-                         olsr_ip_to_string(&dstbuf, &tc_edge->T_dest_addr));
-        abuf_json_string(abuf, "lastHopIP",
-                         olsr_ip_to_string(&addrbuf, &tc->addr));
-        lqs = get_tc_edge_entry_text(tc_edge, '\t', &lqbuffer1);
-        abuf_json_float(abuf, "linkQuality", atof(lqs));
-        abuf_json_float(abuf, "neighborLinkQuality", atof(strrchr(lqs, '\t')));
+        abuf_json_ip(abuf, "destinationIP", tc_edge_dest_addr(tc_edge));
+        abuf_json_ip(abuf, "lastHopIP", &tc->addr);
+        abuf_json_link_quality(abuf, NULL, tc_edge);
         if (tc_edge->cost >= LINK_COST_BROKEN)
           abuf_json_int(abuf, "tcEdgeCost", LINK_COST_BROKEN);
         else
@@ -689,7 +759,6 @@ ipc_print_hna(struct autobuf *abuf)
 {
   struct hna_entry *tmp_hna;
   struct hna_net *tmp_net;
-  struct ipaddr_str buf, mainaddrbuf;
 
   abuf_json_open_array(abuf, "hna");
 
@@ -700,11 +769,9 @@ ipc_print_hna(struct autobuf *abuf)
       uint32_t vt = tmp_net->hna_net_timer != NULL ? (tmp_net->hna_net_timer->timer_clock - now_times) : 0;
       int diff = (int)(vt);
       abuf_json_open_array_entry(abuf);
-      abuf_json_string(abuf, "destination",
-                       olsr_ip_to_string(&buf, &tmp_net->hna_prefix.prefix)),
+      abuf_json_ip(abuf, "destination", &tmp_net->hna_prefix.prefix);
       abuf_json_int(abuf, "genmask", tmp_net->hna_prefix.prefix_len);
-      abuf_json_string(abuf, "gateway",
-                       olsr_ip_to_string(&mainaddrbuf, &tmp_hna->A_gateway_addr));
+      abuf_json_ip(abuf, "gateway", &tmp_hna->A_gateway_addr);
       abuf_json_int(abuf, "validityTime", diff);
       abuf_json_close_array_entry(abuf);
     }
@@ -1119,6 +1186,12 @@ ipc_print_interfaces(struct autobuf *abuf)
       abuf_json_boolean(abuf, "sendTcImmediately", rifs->immediate_send_tc);
       abuf_json_int(abuf, "fishEyeTtlIndex", rifs->ttl_index);
       abuf_json_int(abuf, "olsrForwardingTimeout", rifs->fwdtimer);
+      abuf_json_int(abuf, "forwardQueueLength", rifs->fwdq.count);
+      abuf_json_int(abuf, "forwardQueueBytes", rifs->fwdq.bytes);
+      abuf_json_int(abuf, "forwardQueueMaxLength", rifs->fwdq.max_count);
+      abuf_json_int(abuf, "forwardedMessages", rifs->fwdq.sent);
+      abuf_json_int(abuf, "forwardDropsQueueFull", rifs->fwdq.dropped_full);
+      abuf_json_int(abuf, "forwardDropsRateLimit", rifs->fwdq.dropped_rate);
       abuf_json_int(abuf, "olsrMessageSequenceNumber", rifs->olsr_seqnum);
       abuf_json_int(abuf, "olsrInterfaceMetric", rifs->int_metric);
       abuf_json_int(abuf, "olsrMTU", rifs->int_mtu);
@@ -1207,6 +1280,110 @@ ipc_print_interfaces(struct autobuf *abuf)
   abuf_json_close_array(abuf);
 }
 
+static void
+ipc_print_histogram(void *ctx, enum olsr_prof_group group, const char *name, const struct olsr_histogram *hist)
+{
+  static const char *const groups[] = { "core", "timer", "message", "socket" };
+  struct autobuf *abuf = ctx;
+  unsigned int i;
+  int buckets = 0;
+
+  abuf_json_open_array_entry(abuf);
+  abuf_json_string(abuf, "group", groups[group]);
+  abuf_json_string(abuf, "name", name);
+  abuf_json_u64(abuf, "count", hist->count);
+  abuf_json_u64(abuf, "sum", hist->sum);
+  abuf_json_u64(abuf, "max", hist->max);
+  abuf_json_u64(abuf, "p50", olsr_hist_percentile(hist, 500));
+  abuf_json_u64(abuf, "p90", olsr_hist_percentile(hist, 900));
+  abuf_json_u64(abuf, "p99", olsr_hist_percentile(hist, 990));
+
+  /* [upper limit, samples] of every bucket in use */
+  abuf_json_open_array(abuf, "buckets");
+  for (i = 0; i < OLSR_HIST_BUCKETS; i++) {
+    if (hist->bucket[i]) {
+      abuf_appendf(abuf, "%s[%llu, %u]", buckets++ ? ", " : "", (unsigned long long)olsr_hist_bucket_limit(i), hist->bucket[i]);
+    }
+  }
+  abuf_json_close_array(abuf);
+  abuf_json_close_array_entry(abuf);
+}
+
+static void
+ipc_print_profile(struct autobuf *abuf)
+{
+  /* all times are in nanoseconds */
+  abuf_json_open_array(abuf, "profile");
+  olsr_prof_walk(ipc_print_histogram, abuf);
+  abuf_json_close_array(abuf);
+}
+
+static void
+ipc_print_admit_bucket(void *ctx, enum olsr_admit_table table, const struct olsr_admit_bucket *bucket)
+{
+  struct autobuf *abuf = ctx;
+
+  abuf_json_open_array_entry(abuf);
+  abuf_json_string(abuf, "type", table == OLSR_ADMIT_SENDER ? "sender" : "originator");
+  abuf_json_ip(abuf, "ipAddress", &bucket->addr);
+  abuf_json_float(abuf, "tokens", bucket->tokens / 1000.0);
+  abuf_json_int(abuf, "admitted", bucket->admitted);
+  abuf_json_int(abuf, "dropped", bucket->dropped);
+  abuf_json_close_array_entry(abuf);
+}
+
+static void
+ipc_print_admission(struct autobuf *abuf)
+{
+  abuf_json_open_array(abuf, "admissionTotals");
+  abuf_json_open_array_entry(abuf);
+  abuf_json_int(abuf, "admitted", olsr_admit_stats.admitted);
+  abuf_json_int(abuf, "droppedDuplicate", olsr_admit_stats.dropped_duplicate);
+  abuf_json_int(abuf, "droppedSender", olsr_admit_stats.dropped_sender);
+  abuf_json_int(abuf, "droppedOriginator", olsr_admit_stats.dropped_originator);
+  abuf_json_close_array_entry(abuf);
+  abuf_json_close_array(abuf);
+
+  /* the token buckets in use, tokens are in weight units */
+  abuf_json_open_array(abuf, "admission");
+  olsr_admit_walk(ipc_print_admit_bucket, abuf);
+  abuf_json_close_array(abuf);
+}
+
+static void
+ipc_print_cookie(void *ctx, const struct olsr_cookie_info *ci)
+{
+  struct autobuf *abuf = ctx;
+  size_t block_size = olsr_cookie_block_size(ci);
+
+  abuf_json_open_array_entry(abuf);
+  abuf_json_string(abuf, "name", ci->ci_name ? ci->ci_name : "");
+  abuf_json_string(abuf, "type", ci->ci_type == OLSR_COOKIE_TYPE_MEMORY ? "memory" : "timer");
+  abuf_json_int(abuf, "usage", ci->ci_usage);
+  abuf_json_int(abuf, "changes", ci->ci_changes);
+  if (ci->ci_type == OLSR_COOKIE_TYPE_MEMORY) {
+    abuf_json_int(abuf, "blockSize", block_size);
+    abuf_json_int(abuf, "freeList", ci->ci_free_list_usage);
+    abuf_json_int(abuf, "bytes", block_size * (ci->ci_usage + ci->ci_free_list_usage));
+  }
+  abuf_json_close_array_entry(abuf);
+}
+
+static void
+ipc_print_memory(struct autobuf *abuf)
+{
+  /* blockSize is the memory of one node, edge, route, ... in bytes */
+  abuf_json_open_array(abuf, "memory");
+  olsr_cookie_walk(ipc_print_cookie, abuf);
+  abuf_json_close_array(abuf);
+
+  abuf_json_open_array(abuf, "memoryTotals");
+  abuf_json_open_array_entry(abuf);
+  abuf_json_int(abuf, "internedNodes", olsr_node_id_count());
+  abuf_json_close_array_entry(abuf);
+  abuf_json_close_array(abuf);
+}
+
 
 static void
 ipc_print_olsrd_conf(struct autobuf *abuf)
@@ -1283,7 +1460,7 @@ send_info(unsigned int send_what, int the_socket)
   abuf_init(&abuf, 32768);
 
  // only add if outputing JSON
-  if (send_what & SIW_ALL) abuf_puts(&abuf, "{\n");
+  if (send_what & SIW_JSON) abuf_puts(&abuf, "{\n");
 
   if ((send_what & SIW_LINKS) == SIW_LINKS) ipc_print_links(&abuf);
   if ((send_what & SIW_NEIGHBORS) == SIW_NEIGHBORS) ipc_print_neighbors(&abuf);
@@ -1298,9 +1475,12 @@ send_info(unsigned int send_what, int the_socket)
     ipc_print_config(&abuf);
   }
   if ((send_what & SIW_PLUGINS) == SIW_PLUGINS) ipc_print_plugins(&abuf);
+  if ((send_what & SIW_PROFILE) == SIW_PROFILE) ipc_print_profile(&abuf);
+  if ((send_what & SIW_ADMISSION) == SIW_ADMISSION) ipc_print_admission(&abuf);
+  if ((send_what & SIW_MEMORY) == SIW_MEMORY) ipc_print_memory(&abuf);
 
   /* output overarching meta data last so we can use abuf_json_* functions, they add a comma at the beginning */
-  if (send_what & SIW_ALL) {
+  if (send_what & SIW_JSON) {
     abuf_json_int(&abuf, "systemTime", time(NULL));
     abuf_json_int(&abuf, "timeSinceStartup", now_times);
     if(*uuid != 0)
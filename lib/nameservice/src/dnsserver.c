@@ -0,0 +1,828 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Embedded DNS responder for the nameservice plugin
+ *
+ * Answers A/AAAA, PTR and SRV queries straight from the name and service
+ * tables the plugin already keeps in memory, so resolving a mesh name does
+ * not have to go through a hosts file and a SIGHUPed dnsmasq. Queries for
+ * names outside of the mesh are relayed to an upstream DNS server.
+ */
+
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "olsr.h"
+#include "ipcalc.h"
+#include "scheduler.h"
+
+#include "nameservice.h"
+#include "dnsserver.h"
+
+#define DNS_PORT            53
+#define DNS_HEADER_LEN      12
+#define DNS_MAX_UDP         512         /* we never answer with more than this */
+#define DNS_MAX_PACKET      4096        /* relayed EDNS answers may be larger */
+#define DNS_MAX_NAME        255
+#define DNS_MAX_LABEL       63
+#define DNS_POLL_BUDGET     16          /* datagrams handled per socket wakeup */
+#define DNS_TTL             EMISSION_INTERVAL
+
+#define DNS_FLAG_QR         0x8000
+#define DNS_OPCODE_MASK     0x7800
+#define DNS_FLAG_AA         0x0400
+#define DNS_FLAG_TC         0x0200
+#define DNS_FLAG_RD         0x0100
+#define DNS_FLAG_RA         0x0080
+
+#define DNS_RCODE_NOERROR   0
+#define DNS_RCODE_FORMERR   1
+#define DNS_RCODE_SERVFAIL  2
+#define DNS_RCODE_NXDOMAIN  3
+#define DNS_RCODE_NOTIMP    4
+
+#define DNS_TYPE_A          1
+#define DNS_TYPE_PTR        12
+#define DNS_TYPE_AAAA       28
+#define DNS_TYPE_SRV        33
+#define DNS_TYPE_ANY        255
+#define DNS_CLASS_IN        1
+
+#define DNS_PENDING_SIZE    64
+#define DNS_PENDING_TIMEOUT 5000        /* ms */
+#define DNS_RANDOM_CACHE    32          /* ids read from the random device at once */
+
+/* a query relayed to the upstream server */
+struct dns_pending {
+  int sock;                             /* own socket, so the source port is random too */
+  uint16_t id;                          /* id used towards the upstream */
+  uint16_t client_id;                   /* id the client used */
+  uint32_t timeout;
+  union olsr_ip_addr upstream;
+  union olsr_sockaddr client;
+  socklen_t client_len;
+};
+
+struct dns_question {
+  char name[DNS_MAX_NAME + 1];          /* lower case, dotted, without the root dot */
+  size_t end;                           /* offset of the first byte after the question */
+  uint16_t type;
+  uint16_t class;
+};
+
+struct dns_reply {
+  uint8_t buf[DNS_MAX_UDP];
+  size_t len;
+  uint16_t ancount;
+  bool truncated;
+  bool found;                           /* the name exists, maybe without records of the asked type */
+  const struct dns_question *q;
+  union olsr_ip_addr ptr_addr;          /* address of a reverse lookup */
+};
+
+static int dns_sock = -1;
+static int random_fd = -1;
+static union olsr_ip_addr dns_upstream;
+
+static struct dns_pending dns_pending[DNS_PENDING_SIZE];
+static unsigned int dns_pending_next = 0;
+
+static uint16_t dns_random_cache[DNS_RANDOM_CACHE];
+static unsigned int dns_random_left = 0;
+
+static uint8_t dns_buffer[DNS_MAX_PACKET];
+
+static void dns_upstream_received(int fd, void *data, unsigned int flags);
+static int dns_open_socket(const union olsr_ip_addr *addr, int port);
+
+static uint16_t
+dns_get_u16(const uint8_t *p)
+{
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void
+dns_set_u16(uint8_t *p, uint16_t v)
+{
+  p[0] = v >> 8;
+  p[1] = v & 0xff;
+}
+
+static void
+dns_fill_sockaddr(union olsr_sockaddr *sa, socklen_t *salen, const union olsr_ip_addr *ip, int port)
+{
+  memset(sa, 0, sizeof(*sa));
+  if (olsr_cnf->ip_version == AF_INET) {
+    sa->in4.sin_family = AF_INET;
+    sa->in4.sin_port = htons(port);
+    sa->in4.sin_addr = ip->v4;
+    *salen = sizeof(sa->in4);
+  } else {
+    sa->in6.sin6_family = AF_INET6;
+    sa->in6.sin6_port = htons(port);
+    sa->in6.sin6_addr = ip->v6;
+    *salen = sizeof(sa->in6);
+  }
+}
+
+static bool
+dns_sockaddr_is(const union olsr_sockaddr *sa, const union olsr_ip_addr *ip, int port)
+{
+  if (olsr_cnf->ip_version == AF_INET) {
+    return sa->in4.sin_family == AF_INET && sa->in4.sin_port == htons(port) && sa->in4.sin_addr.s_addr == ip->v4.s_addr;
+  }
+  return sa->in6.sin6_family == AF_INET6 && sa->in6.sin6_port == htons(port)
+    && memcmp(&sa->in6.sin6_addr, &ip->v6, sizeof(ip->v6)) == 0;
+}
+
+/**
+ * 16 unpredictable bits for the id of a relayed query,
+ * random() is only used if there is no random device
+ */
+static uint16_t
+dns_random_u16(void)
+{
+  if (dns_random_left == 0 && random_fd >= 0) {
+    ssize_t n = read(random_fd, dns_random_cache, sizeof(dns_random_cache));
+
+    if (n > 0) {
+      dns_random_left = n / sizeof(dns_random_cache[0]);
+    }
+  }
+  if (dns_random_left > 0) {
+    return dns_random_cache[--dns_random_left];
+  }
+  return random() & 0xffff;
+}
+
+/**
+ * parse the (single) question of a query
+ */
+static bool
+dns_parse_question(const uint8_t *pkt, size_t len, struct dns_question *q)
+{
+  size_t pos = DNS_HEADER_LEN;
+  size_t n = 0;
+
+  while (pos < len && pkt[pos] != 0) {
+    size_t label = pkt[pos++];
+    size_t i;
+
+    /* this also rejects compression pointers, they make no sense here */
+    if (label > DNS_MAX_LABEL || pos + label > len || n + label + 1 > DNS_MAX_NAME) {
+      return false;
+    }
+    if (n > 0) {
+      q->name[n++] = '.';
+    }
+    for (i = 0; i < label; i++) {
+      uint8_t c = pkt[pos++];
+      if (c == '.' || c == '\0') {
+        return false;
+      }
+      q->name[n++] = tolower(c);
+    }
+  }
+  q->name[n] = '\0';
+
+  /* root label, type and class */
+  if (pos + 5 > len) {
+    return false;
+  }
+  q->type = dns_get_u16(&pkt[pos + 1]);
+  q->class = dns_get_u16(&pkt[pos + 3]);
+  q->end = pos + 5;
+  return true;
+}
+
+/**
+ * parse a reverse lookup name (in-addr.arpa or ip6.arpa) of our
+ * address family
+ */
+static bool
+dns_parse_reverse(const char *qname, union olsr_ip_addr *addr)
+{
+  memset(addr, 0, sizeof(*addr));
+
+  if (olsr_cnf->ip_version == AF_INET) {
+    unsigned int o[4];
+    int n = 0;
+
+    if (sscanf(qname, "%u.%u.%u.%u.in-addr.arpa%n", &o[3], &o[2], &o[1], &o[0], &n) != 4 || n == 0 || qname[n] != '\0') {
+      return false;
+    }
+    if (o[0] > 255 || o[1] > 255 || o[2] > 255 || o[3] > 255) {
+      return false;
+    }
+    addr->v4.s_addr = htonl((o[0] << 24) | (o[1] << 16) | (o[2] << 8) | o[3]);
+    return true;
+  } else {
+    const char *p = qname;
+    int i;
+
+    /* 32 nibbles, least significant first */
+    for (i = 31; i >= 0; i--) {
+      int v;
+
+      if (!isxdigit((unsigned char)p[0]) || p[1] != '.') {
+        return false;
+      }
+      v = isdigit((unsigned char)p[0]) ? p[0] - '0' : p[0] - 'a' + 10;
+      addr->v6.s6_addr[i / 2] |= (i & 1) ? v : v << 4;
+      p += 2;
+    }
+    return strcmp(p, "ip6.arpa") == 0;
+  }
+}
+
+/**
+ * true if qname is inside the zone given by the suffix, that is
+ * a name we are authoritative for
+ */
+static bool
+dns_in_zone(const char *qname)
+{
+  const char *zone = get_name_suffix();
+  size_t qlen, zlen;
+
+  if (*zone == '.') {
+    zone++;
+  }
+  zlen = strlen(zone);
+  qlen = strlen(qname);
+  if (zlen == 0 || qlen <= zlen) {
+    return false;
+  }
+  return qname[qlen - zlen - 1] == '.' && strcasecmp(qname + qlen - zlen, zone) == 0;
+}
+
+/**
+ * true if qname is name with the suffix appended
+ */
+static bool
+dns_match_name(const char *qname, const char *name, const char *suffix)
+{
+  size_t len = strlen(name);
+
+  return strncasecmp(qname, name, len) == 0 && strcasecmp(qname + len, suffix) == 0;
+}
+
+static bool
+dns_put(struct dns_reply *r, const void *data, size_t n)
+{
+  if (r->len + n > sizeof(r->buf)) {
+    return false;
+  }
+  memcpy(r->buf + r->len, data, n);
+  r->len += n;
+  return true;
+}
+
+static bool
+dns_put_u16(struct dns_reply *r, uint16_t v)
+{
+  uint8_t b[2];
+
+  dns_set_u16(b, v);
+  return dns_put(r, b, sizeof(b));
+}
+
+/**
+ * put name + suffix in wire format (uncompressed)
+ */
+static bool
+dns_put_name(struct dns_reply *r, const char *name, const char *suffix)
+{
+  char fqdn[DNS_MAX_NAME + 1];
+  const char *label, *dot;
+
+  if (snprintf(fqdn, sizeof(fqdn), "%s%s", name, suffix) >= (int)sizeof(fqdn)) {
+    return false;
+  }
+  for (label = fqdn; *label != '\0'; label = *dot ? dot + 1 : dot) {
+    uint8_t len;
+
+    dot = strchr(label, '.');
+    if (dot == NULL) {
+      dot = label + strlen(label);
+    }
+    if (dot - label > DNS_MAX_LABEL) {
+      return false;
+    }
+    len = dot - label;
+    if (len > 0 && (!dns_put(r, &len, 1) || !dns_put(r, label, len))) {
+      return false;
+    }
+  }
+  return dns_put(r, "", 1);
+}
+
+/**
+ * start a resource record for the question name,
+ * returns the offset of the record
+ */
+static size_t
+dns_begin_rr(struct dns_reply *r, uint16_t type)
+{
+  static const uint8_t ttl[4] = { DNS_TTL >> 24, (DNS_TTL >> 16) & 0xff, (DNS_TTL >> 8) & 0xff, DNS_TTL & 0xff };
+  size_t mark = r->len;
+
+  /* the owner is a pointer back to the question */
+  if (dns_put_u16(r, 0xc000 | DNS_HEADER_LEN) && dns_put_u16(r, type) && dns_put_u16(r, DNS_CLASS_IN) && dns_put(r, ttl, sizeof(ttl))
+      && dns_put_u16(r, 0)) {
+    return mark;
+  }
+  r->len = mark;
+  return 0;
+}
+
+/**
+ * finish the record started at mark, or drop it and flag
+ * the answer as truncated if the rdata did not fit
+ */
+static void
+dns_end_rr(struct dns_reply *r, size_t mark, bool ok)
+{
+  if (mark == 0 || !ok) {
+    if (mark != 0) {
+      r->len = mark;
+    }
+    r->truncated = true;
+    return;
+  }
+  dns_set_u16(&r->buf[mark + 10], r->len - mark - 12);
+  r->ancount++;
+}
+
+static void
+dns_answer_host(void *data, const struct name_entry *name)
+{
+  struct dns_reply *r = data;
+  uint16_t type = olsr_cnf->ip_version == AF_INET ? DNS_TYPE_A : DNS_TYPE_AAAA;
+  size_t mark;
+
+  if (!dns_match_name(r->q->name, name->name, get_name_suffix())) {
+    return;
+  }
+  r->found = true;
+  if (r->truncated || (r->q->type != type && r->q->type != DNS_TYPE_ANY)) {
+    return;
+  }
+  mark = dns_begin_rr(r, type);
+  dns_end_rr(r, mark, mark != 0 && dns_put(r, &name->ip, olsr_cnf->ipsize));
+}
+
+static void
+dns_answer_ptr(void *data, const struct name_entry *name)
+{
+  struct dns_reply *r = data;
+  size_t mark;
+
+  if (!ipequal(&name->ip, &r->ptr_addr)) {
+    return;
+  }
+  r->found = true;
+  if (r->truncated || (r->q->type != DNS_TYPE_PTR && r->q->type != DNS_TYPE_ANY)) {
+    return;
+  }
+  mark = dns_begin_rr(r, DNS_TYPE_PTR);
+  dns_end_rr(r, mark, mark != 0 && dns_put_name(r, name->name, get_name_suffix()));
+}
+
+/**
+ * a service line like "http://router.olsr:80|tcp|my homepage" is
+ * published as SRV record "_http._tcp<suffix>" -> router.olsr:80
+ */
+static void
+dns_answer_service(void *data, const struct name_entry *name)
+{
+  struct dns_reply *r = data;
+  const char *scheme_end, *host, *host_end, *proto, *proto_end;
+  char owner[DNS_MAX_NAME + 1];
+  char target[DNS_MAX_NAME + 1];
+  struct in6_addr dummy;
+  unsigned long port;
+  size_t mark;
+  bool ok;
+
+  scheme_end = strstr(name->name, "://");
+  if (scheme_end == NULL) {
+    return;
+  }
+  host = scheme_end + 3;
+  proto = strchr(host, '|');
+  if (proto == NULL) {
+    return;
+  }
+  /* the port follows the last colon, an IPv6 address has colons itself */
+  for (host_end = proto; host_end != host && *host_end != ':'; host_end--);
+  if (host_end == host || (size_t)(host_end - host) >= sizeof(target)) {
+    return;
+  }
+  port = strtoul(host_end + 1, NULL, 10);
+  if (port > 65535) {
+    return;
+  }
+  proto++;
+  proto_end = strchr(proto, '|');
+  if (proto_end == NULL) {
+    return;
+  }
+  snprintf(owner, sizeof(owner), "_%.*s._%.*s", (int)(scheme_end - name->name), name->name, (int)(proto_end - proto), proto);
+  if (!dns_match_name(r->q->name, owner, get_name_suffix())) {
+    return;
+  }
+  r->found = true;
+  if (r->truncated || (r->q->type != DNS_TYPE_SRV && r->q->type != DNS_TYPE_ANY)) {
+    return;
+  }
+
+  /* SRV targets must be names, services given by address are skipped */
+  if (*host == '[') {
+    return;
+  }
+  memcpy(target, host, host_end - host);
+  target[host_end - host] = '\0';
+  if (inet_pton(AF_INET, target, &dummy) > 0 || inet_pton(AF_INET6, target, &dummy) > 0) {
+    return;
+  }
+
+  mark = dns_begin_rr(r, DNS_TYPE_SRV);
+  ok = mark != 0 && dns_put_u16(r, 0) && dns_put_u16(r, 0) && dns_put_u16(r, port) && dns_put_name(r, target, "");
+  dns_end_rr(r, mark, ok);
+}
+
+/**
+ * start the reply: header placeholder and the question copied
+ * from the query
+ */
+static void
+dns_reply_init(struct dns_reply *r, const uint8_t *query, const struct dns_question *q)
+{
+  memcpy(r->buf, query, DNS_HEADER_LEN);
+  r->len = DNS_HEADER_LEN;
+  r->ancount = 0;
+  r->truncated = false;
+  r->found = false;
+  r->q = q;
+  if (q != NULL) {
+    memcpy(r->buf + DNS_HEADER_LEN, query + DNS_HEADER_LEN, q->end - DNS_HEADER_LEN);
+    r->len = q->end;
+  }
+}
+
+static void
+dns_reply_send(struct dns_reply *r, int rcode, bool authoritative, const union olsr_sockaddr *to, socklen_t tolen)
+{
+  uint16_t flags = DNS_FLAG_QR | (dns_get_u16(&r->buf[2]) & (DNS_OPCODE_MASK | DNS_FLAG_RD)) | rcode;
+
+  if (authoritative) {
+    flags |= DNS_FLAG_AA;
+  }
+  if (r->truncated) {
+    flags |= DNS_FLAG_TC;
+  }
+  /* queries outside the zone are relayed */
+  flags |= DNS_FLAG_RA;
+  dns_set_u16(&r->buf[2], flags);
+  dns_set_u16(&r->buf[4], r->q != NULL ? 1 : 0);
+  dns_set_u16(&r->buf[6], r->ancount);
+  dns_set_u16(&r->buf[8], 0);
+  dns_set_u16(&r->buf[10], 0);
+
+  if (sendto(dns_sock, r->buf, r->len, 0, &to->in, tolen) < 0) {
+    OLSR_PRINTF(2, "NAME PLUGIN: DNS reply: %s\n", strerror(errno));
+  }
+}
+
+/**
+ * select the upstream server: the configured one or else the
+ * nearest dns-server announced in the mesh
+ */
+static bool
+dns_get_upstream(union olsr_ip_addr *ip)
+{
+  if (!ipequal(&dns_upstream, &olsr_ip_zero)) {
+    *ip = dns_upstream;
+    return true;
+  }
+  return get_best_nameserver(ip);
+}
+
+/**
+ * forget a relayed query and close its socket
+ */
+static void
+dns_pending_release(struct dns_pending *p)
+{
+  if (p->sock >= 0) {
+    remove_olsr_socket(p->sock, NULL, &dns_upstream_received);
+    close(p->sock);
+    p->sock = -1;
+  }
+}
+
+/**
+ * relay a query we can not answer to the upstream server,
+ * remembering the client under a fresh id.
+ * Every relayed query gets its own socket on an ephemeral port,
+ * so a spoofed answer has to guess the port and the id.
+ */
+static bool
+dns_forward_query(uint8_t *pkt, size_t len, const union olsr_sockaddr *from, socklen_t fromlen)
+{
+  struct dns_pending *p = NULL;
+  union olsr_sockaddr to;
+  socklen_t tolen;
+  unsigned int i;
+
+  /* take a free or expired slot, else recycle the oldest, that client will retry */
+  for (i = 0; i < DNS_PENDING_SIZE; i++) {
+    p = &dns_pending[dns_pending_next++ % DNS_PENDING_SIZE];
+    if (p->sock < 0 || TIMED_OUT(p->timeout)) {
+      break;
+    }
+  }
+  dns_pending_release(p);
+
+  if (!dns_get_upstream(&p->upstream)) {
+    return false;
+  }
+  p->sock = dns_open_socket(&olsr_ip_zero, 0);
+  if (p->sock < 0) {
+    return false;
+  }
+
+  p->id = dns_random_u16();
+  p->client_id = dns_get_u16(pkt);
+  p->timeout = GET_TIMESTAMP(DNS_PENDING_TIMEOUT);
+  memcpy(&p->client, from, fromlen);
+  p->client_len = fromlen;
+
+  dns_set_u16(pkt, p->id);
+  dns_fill_sockaddr(&to, &tolen, &p->upstream, DNS_PORT);
+  if (sendto(p->sock, pkt, len, 0, &to.in, tolen) < 0) {
+    OLSR_PRINTF(2, "NAME PLUGIN: DNS forward: %s\n", strerror(errno));
+    close(p->sock);
+    p->sock = -1;
+    return false;
+  }
+  add_olsr_socket(p->sock, NULL, &dns_upstream_received, p, SP_IMM_READ);
+  return true;
+}
+
+static void
+dns_handle_query(uint8_t *pkt, size_t len, const union olsr_sockaddr *from, socklen_t fromlen)
+{
+  struct dns_question q;
+  struct dns_reply r;
+  uint16_t flags;
+
+  if (len < DNS_HEADER_LEN) {
+    return;
+  }
+  flags = dns_get_u16(&pkt[2]);
+  if (flags & DNS_FLAG_QR) {
+    /* never answer answers */
+    return;
+  }
+  if ((flags & DNS_OPCODE_MASK) != 0) {
+    dns_reply_init(&r, pkt, NULL);
+    dns_reply_send(&r, DNS_RCODE_NOTIMP, false, from, fromlen);
+    return;
+  }
+  if (dns_get_u16(&pkt[4]) != 1 || !dns_parse_question(pkt, len, &q)) {
+    dns_reply_init(&r, pkt, NULL);
+    dns_reply_send(&r, DNS_RCODE_FORMERR, false, from, fromlen);
+    return;
+  }
+
+  dns_reply_init(&r, pkt, &q);
+  if (q.class == DNS_CLASS_IN) {
+    if (dns_parse_reverse(q.name, &r.ptr_addr)) {
+      name_foreach_entry(NAME_HOST, &dns_answer_ptr, &r);
+    } else {
+      name_foreach_entry(NAME_HOST, &dns_answer_host, &r);
+      name_foreach_entry(NAME_SERVICE, &dns_answer_service, &r);
+    }
+  }
+
+  OLSR_PRINTF(4, "NAME PLUGIN: DNS query %s type %u: %s\n", q.name, q.type,
+              r.found ? "local" : dns_in_zone(q.name) ? "nxdomain" : "forward");
+
+  if (r.found) {
+    dns_reply_send(&r, DNS_RCODE_NOERROR, true, from, fromlen);
+  } else if (dns_in_zone(q.name)) {
+    dns_reply_send(&r, DNS_RCODE_NXDOMAIN, true, from, fromlen);
+  } else if (!dns_forward_query(pkt, len, from, fromlen)) {
+    dns_reply_send(&r, DNS_RCODE_SERVFAIL, false, from, fromlen);
+  }
+}
+
+/**
+ * a client sent us queries
+ */
+static void
+dns_query_received(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+  int i;
+
+  for (i = 0; i < DNS_POLL_BUDGET; i++) {
+    union olsr_sockaddr from;
+    socklen_t fromlen = sizeof(from);
+    ssize_t n = recvfrom(fd, dns_buffer, sizeof(dns_buffer), 0, &from.in, &fromlen);
+
+    if (n < 0) {
+#if EAGAIN != EWOULDBLOCK
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+#else
+      if (errno != EAGAIN) {
+#endif
+        OLSR_PRINTF(2, "NAME PLUGIN: DNS recvfrom: %s\n", strerror(errno));
+      }
+      return;
+    }
+    dns_handle_query(dns_buffer, n, &from, fromlen);
+  }
+}
+
+/**
+ * the upstream server answered a relayed query
+ * (data is the dns_pending slot owning the socket)
+ */
+static void
+dns_upstream_received(int fd, void *data, unsigned int flags __attribute__ ((unused)))
+{
+  struct dns_pending *p = data;
+  int i;
+
+  for (i = 0; i < DNS_POLL_BUDGET; i++) {
+    union olsr_sockaddr from;
+    socklen_t fromlen = sizeof(from);
+    ssize_t n = recvfrom(fd, dns_buffer, sizeof(dns_buffer), 0, &from.in, &fromlen);
+
+    if (n < 0) {
+#if EAGAIN != EWOULDBLOCK
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+#else
+      if (errno != EAGAIN) {
+#endif
+        OLSR_PRINTF(2, "NAME PLUGIN: DNS upstream recvfrom: %s\n", strerror(errno));
+      }
+      return;
+    }
+    if (TIMED_OUT(p->timeout)) {
+      dns_pending_release(p);
+      return;
+    }
+    if (n < DNS_HEADER_LEN || dns_get_u16(dns_buffer) != p->id || !dns_sockaddr_is(&from, &p->upstream, DNS_PORT)) {
+      continue;
+    }
+
+    dns_set_u16(dns_buffer, p->client_id);
+    if (sendto(dns_sock, dns_buffer, n, 0, &p->client.in, p->client_len) < 0) {
+      OLSR_PRINTF(2, "NAME PLUGIN: DNS relay: %s\n", strerror(errno));
+    }
+    dns_pending_release(p);
+    return;
+  }
+}
+
+static int
+dns_open_socket(const union olsr_ip_addr *addr, int port)
+{
+  union olsr_sockaddr sa;
+  socklen_t salen;
+  int on = 1;
+  int fd;
+
+  fd = socket(olsr_cnf->ip_version, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    OLSR_PRINTF(1, "NAME PLUGIN: DNS socket: %s\n", strerror(errno));
+    return -1;
+  }
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0) {
+    OLSR_PRINTF(1, "NAME PLUGIN: DNS SO_REUSEADDR: %s\n", strerror(errno));
+  }
+
+  dns_fill_sockaddr(&sa, &salen, addr, port);
+  if (bind(fd, &sa.in, salen) < 0) {
+    OLSR_PRINTF(1, "NAME PLUGIN: DNS bind to port %d: %s\n", port, strerror(errno));
+    close(fd);
+    return -1;
+  }
+  if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0) {
+    OLSR_PRINTF(1, "NAME PLUGIN: DNS O_NONBLOCK: %s\n", strerror(errno));
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * start the responder on port (0 leaves it disabled)
+ */
+int
+dnsserver_init(int port, const union olsr_ip_addr *listen_addr, const union olsr_ip_addr *upstream)
+{
+  unsigned int i;
+
+  memset(dns_pending, 0, sizeof(dns_pending));
+  for (i = 0; i < DNS_PENDING_SIZE; i++) {
+    dns_pending[i].sock = -1;
+  }
+  if (port <= 0) {
+    return 1;
+  }
+
+  dns_upstream = *upstream;
+
+  dns_sock = dns_open_socket(listen_addr, port);
+  if (dns_sock < 0) {
+    return 0;
+  }
+  add_olsr_socket(dns_sock, NULL, &dns_query_received, NULL, SP_IMM_READ);
+
+  random_fd = open("/dev/urandom", O_RDONLY);
+  if (random_fd < 0) {
+    OLSR_PRINTF(1, "NAME PLUGIN: DNS /dev/urandom: %s, relay ids are weak\n", strerror(errno));
+  }
+
+  OLSR_PRINTF(1, "NAME PLUGIN: DNS responder listening on port %d\n", port);
+  return 1;
+}
+
+void
+dnsserver_exit(void)
+{
+  unsigned int i;
+
+  for (i = 0; i < DNS_PENDING_SIZE; i++) {
+    dns_pending_release(&dns_pending[i]);
+  }
+  if (random_fd >= 0) {
+    close(random_fd);
+    random_fd = -1;
+  }
+  if (dns_sock >= 0) {
+    remove_olsr_socket(dns_sock, NULL, &dns_query_received);
+    close(dns_sock);
+    dns_sock = -1;
+  }
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -78,10 +78,23 @@ lookup_position_latlon(union olsr_ip_addr *ip)
 }
 
 /**
- * write latlon positions to a file
+ * render a Mid() line
+ */
+static void
+mapwrite_mid(struct autobuf *abuf, const union olsr_ip_addr *main_addr, const union olsr_ip_addr *alias)
+{
+  abuf_puts(abuf, "Mid('");
+  abuf_append_ip(abuf, main_addr);
+  abuf_puts(abuf, "','");
+  abuf_append_ip(abuf, alias);
+  abuf_puts(abuf, "');\n");
+}
+
+/**
+ * render latlon positions
  */
 void
-mapwrite_work(FILE * fmap)
+mapwrite_work(struct autobuf *abuf)
 {
   int hash;
   struct olsr_if *ifs;
@@ -90,25 +103,17 @@ mapwrite_work(FILE * fmap)
   struct tc_entry *tc;
   struct tc_edge_entry *tc_edge;
 
-  if (!my_names || !fmap)
+  if (!my_names)
     return;
 
   for (ifs = olsr_cnf->interfaces; ifs; ifs = ifs->next) {
     if (0 != ifs->interf) {
       if (olsr_cnf->ip_version == AF_INET) {
         if (!(ip4equal((struct in_addr *)&olsr_cnf->main_addr, &ifs->interf->int_addr.sin_addr))) {
-          if (0 >
-              fprintf(fmap, "Mid('%s','%s');\n", olsr_ip_to_string(&strbuf1, &olsr_cnf->main_addr),
-                      olsr_ip_to_string(&strbuf2, (union olsr_ip_addr *)&ifs->interf->int_addr.sin_addr))) {
-            return;
-          }
+          mapwrite_mid(abuf, &olsr_cnf->main_addr, (union olsr_ip_addr *)&ifs->interf->int_addr.sin_addr);
         }
       } else if (!(ip6equal((struct in6_addr *)&olsr_cnf->main_addr, &ifs->interf->int6_addr.sin6_addr))) {
-        if (0 >
-            fprintf(fmap, "Mid('%s','%s');\n", olsr_ip_to_string(&strbuf1, &olsr_cnf->main_addr),
-                    olsr_ip_to_string(&strbuf2, (union olsr_ip_addr *)&ifs->interf->int6_addr.sin6_addr))) {
-          return;
-        }
+        mapwrite_mid(abuf, &olsr_cnf->main_addr, (union olsr_ip_addr *)&ifs->interf->int6_addr.sin6_addr);
       }
     }
   }
@@ -118,11 +123,7 @@ mapwrite_work(FILE * fmap)
     while (entry != &mid_set[hash]) {
       struct mid_address *alias = entry->aliases;
       while (alias) {
-        if (0 >
-            fprintf(fmap, "Mid('%s','%s');\n", olsr_ip_to_string(&strbuf1, &entry->main_addr),
-                    olsr_ip_to_string(&strbuf2, &alias->alias))) {
-          return;
-        }
+        mapwrite_mid(abuf, &entry->main_addr, &alias->alias);
         alias = alias->next_alias;
       }
       entry = entry->next;
@@ -130,11 +131,8 @@ mapwrite_work(FILE * fmap)
   }
   lookup_defhna_latlon(&ip);
   sprintf(my_latlon_str, "%f,%f,%d", (double)my_lat, (double)my_lon, get_isdefhna_latlon());
-  if (0 >
-      fprintf(fmap, "Self('%s',%s,'%s','%s');\n", olsr_ip_to_string(&strbuf1, &olsr_cnf->main_addr), my_latlon_str,
-              olsr_ip_to_string(&strbuf2, &ip), my_names->name)) {
-    return;
-  }
+  abuf_appendf(abuf, "Self('%s',%s,'%s','%s');\n", olsr_ip_to_string(&strbuf1, &olsr_cnf->main_addr), my_latlon_str,
+               olsr_ip_to_string(&strbuf2, &ip), my_names->name);
   for (hash = 0; hash < HASHSIZE; hash++) {
     struct db_entry *entry;
     struct list_node *list_head, *list_node;
@@ -145,11 +143,8 @@ mapwrite_work(FILE * fmap)
       entry = list2db(list_node);
 
       if (NULL != entry->names) {
-        if (0 >
-            fprintf(fmap, "Node('%s',%s,'%s','%s');\n", olsr_ip_to_string(&strbuf1, &entry->originator), entry->names->name,
-                    olsr_ip_to_string(&strbuf2, &entry->names->ip), lookup_name_latlon(&entry->originator))) {
-          return;
-        }
+        abuf_appendf(abuf, "Node('%s',%s,'%s','%s');\n", olsr_ip_to_string(&strbuf1, &entry->originator), entry->names->name,
+                     olsr_ip_to_string(&strbuf2, &entry->names->ip), lookup_name_latlon(&entry->originator));
       }
     }
   }
@@ -157,31 +152,25 @@ mapwrite_work(FILE * fmap)
   OLSR_FOR_ALL_TC_ENTRIES(tc) {
     OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
       char *lla = lookup_position_latlon(&tc->addr);
-      char *llb = lookup_position_latlon(&tc_edge->T_dest_addr);
+      char *llb = lookup_position_latlon(tc_edge_dest_addr(tc_edge));
       if (NULL != lla && NULL != llb) {
         struct lqtextbuffer lqbuffer, lqbuffer2;
 
         /*
          * To speed up processing, Links with both positions are named PLink()
          */
-        if (0 >
-            fprintf(fmap, "PLink('%s','%s',%s,%s,%s,%s);\n", olsr_ip_to_string(&strbuf1, &tc_edge->T_dest_addr),
-                    olsr_ip_to_string(&strbuf2, &tc->addr), get_tc_edge_entry_text(tc_edge, ',', &lqbuffer2),
-                    get_linkcost_text(tc_edge->cost, false, &lqbuffer), lla, llb)) {
-          return;
-        }
+        abuf_appendf(abuf, "PLink('%s','%s',%s,%s,%s,%s);\n", olsr_ip_to_string(&strbuf1, tc_edge_dest_addr(tc_edge)),
+                     olsr_ip_to_string(&strbuf2, &tc->addr), get_tc_edge_entry_text(tc_edge, ',', &lqbuffer2),
+                     get_linkcost_text(tc_edge->cost, false, &lqbuffer), lla, llb);
       } else {
         struct lqtextbuffer lqbuffer, lqbuffer2;
 
         /*
          * If one link end pos is unkown, only send Link()
          */
-        if (0 >
-            fprintf(fmap, "Link('%s','%s',%s,%s);\n", olsr_ip_to_string(&strbuf1, &tc_edge->T_dest_addr),
-                    olsr_ip_to_string(&strbuf2, &tc->addr), get_tc_edge_entry_text(tc_edge, ',', &lqbuffer2),
-                    get_linkcost_text(tc_edge->cost, false, &lqbuffer))) {
-          return;
-        }
+        abuf_appendf(abuf, "Link('%s','%s',%s,%s);\n", olsr_ip_to_string(&strbuf1, tc_edge_dest_addr(tc_edge)),
+                     olsr_ip_to_string(&strbuf2, &tc->addr), get_tc_edge_entry_text(tc_edge, ',', &lqbuffer2),
+                     get_linkcost_text(tc_edge->cost, false, &lqbuffer));
       }
     }
     OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
@@ -204,25 +193,34 @@ mapwrite_poll(void *context __attribute__ ((unused)))
 {
   fifopolltime++;
   if (0 == (fifopolltime & 7) && 0 != the_fifoname) {
-    FILE *fout;
     /* Non-blocking means: fail open if no pipe reader */
     int fd = open(the_fifoname, O_WRONLY | O_NONBLOCK);
     if (0 <= fd) {
       /*
-       * Change to blocking, otherwise expect fprintf errors
+       * Change to blocking, otherwise expect write errors
        */
       if (fcntl(fd, F_SETFL, O_WRONLY) == -1) {
         close(fd);
       } else {
-        fout = fdopen(fd, "w");
-        if (0 != fout) {
-          mapwrite_work(fout);
-          fclose(fout);
-          /* Give pipe reader cpu slot to detect EOF */
-          usleep(1);
-        } else {
-          close(fd);
+        struct autobuf abuf;
+        int done = 0;
+
+        abuf_init(&abuf, 4096);
+        mapwrite_work(&abuf);
+        while (done < abuf.len) {
+          ssize_t result = write(fd, abuf.buf + done, abuf.len - done);
+          if (result < 0) {
+            if (errno == EINTR) {
+              continue;
+            }
+            break;
+          }
+          done += result;
         }
+        abuf_free(&abuf);
+        close(fd);
+        /* Give pipe reader cpu slot to detect EOF */
+        usleep(1);
       }
     }
   }
@@ -32,8 +32,10 @@
 #ifndef _MAPWRITE_H
 #define _MAPWRITE_H
 
+#include "common/autobuf.h"
+
 int mapwrite_init(const char *fifoname);
-void mapwrite_work(FILE * fmap);
+void mapwrite_work(struct autobuf *abuf);
 void mapwrite_exit(void);
 
 #endif /* _MAPWRITE_H */
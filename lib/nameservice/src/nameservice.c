@@ -63,8 +63,11 @@
 #include "link_set.h"
 
 #include "plugin_util.h"
+#include "common/autobuf.h"
+#include "common/crc32.h"
 #include "nameservice.h"
 #include "mapwrite.h"
+#include "dnsserver.h"
 #include "compat.h"
 
 /* true if plugin has been configured */
@@ -72,6 +75,7 @@ static bool nameservice_configured = false;
 
 /* config parameters */
 static char my_hosts_file[MAX_FILE + 1];
+static char my_hosts_dir[MAX_FILE + 1];
 static char my_sighup_pid_file[MAX_FILE + 1];
 
 static char my_add_hosts[MAX_FILE + 1];
@@ -86,6 +90,9 @@ static char my_services_change_script[MAX_FILE + 1];
 static char my_macs_change_script[MAX_FILE + 1];
 static char latlon_in_file[MAX_FILE + 1];
 static char my_latlon_file[MAX_FILE + 1];
+static int my_dns_port = 0;
+static union olsr_ip_addr my_dns_listen;
+static union olsr_ip_addr my_dns_upstream;
 float my_lat = 0.0, my_lon = 0.0;
 
 /* the databases (using hashing)
@@ -117,6 +124,16 @@ static bool latlon_table_changed = true;
 /* backoff timer for writing changes into a file */
 struct timer_entry *write_file_timer = NULL;
 
+/* content hashes of the files as last written, 0 if not written yet */
+static uint32_t hosts_file_hash = 0;
+static uint32_t hosts_dir_hash[HASHSIZE + 1];
+static uint32_t services_file_hash = 0;
+static uint32_t macs_file_hash = 0;
+static uint32_t resolv_file_hash = 0;
+#ifdef _WIN32
+static uint32_t latlon_file_hash = 0;
+#endif /* _WIN32 */
+
 /* periodic message generation */
 struct timer_entry *msg_gen_timer = NULL;
 
@@ -172,6 +189,7 @@ name_constructor(void)
   *my_sighup_pid_file = 0;
 #endif /* _WIN32 */
 
+  my_hosts_dir[0] = '\0';
   my_suffix[0] = '\0';
   my_add_hosts[0] = '\0';
   my_latlon_file[0] = '\0';
@@ -258,6 +276,7 @@ static const struct olsrd_plugin_parameters plugin_parameters[] = {
   { .name = "timeout",                .set_plugin_parameter = &set_nameservice_float,  .data = &my_timeout },
   { .name = "sighup-pid-file",        .set_plugin_parameter = &set_plugin_string,      .data = &my_sighup_pid_file,        .addon = {sizeof(my_sighup_pid_file)} },
   { .name = "hosts-file",             .set_plugin_parameter = &set_plugin_string,      .data = &my_hosts_file,             .addon = {sizeof(my_hosts_file)} },
+  { .name = "hosts-dir",              .set_plugin_parameter = &set_plugin_string,      .data = &my_hosts_dir,              .addon = {sizeof(my_hosts_dir)} },
   { .name = "name-change-script",     .set_plugin_parameter = &set_plugin_string,      .data = &my_name_change_script,     .addon = {sizeof(my_name_change_script)} },
   { .name = "services-change-script", .set_plugin_parameter = &set_plugin_string,      .data = &my_services_change_script, .addon = {sizeof(my_services_change_script)} },
   { .name = "macs-change-script",     .set_plugin_parameter = &set_plugin_string,      .data = &my_macs_change_script,     .addon = {sizeof(my_macs_change_script)} },
@@ -270,6 +289,9 @@ static const struct olsrd_plugin_parameters plugin_parameters[] = {
   { .name = "lon",                    .set_plugin_parameter = &set_nameservice_float,  .data = &my_lon },
   { .name = "latlon-file",            .set_plugin_parameter = &set_plugin_string,      .data = &my_latlon_file,            .addon = {sizeof(my_latlon_file)} },
   { .name = "latlon-infile",          .set_plugin_parameter = &set_plugin_string,      .data = &latlon_in_file,            .addon = {sizeof(latlon_in_file)} },
+  { .name = "dns-port",               .set_plugin_parameter = &set_plugin_port,        .data = &my_dns_port },
+  { .name = "dns-listen",             .set_plugin_parameter = &set_plugin_ipaddress,   .data = &my_dns_listen },
+  { .name = "dns-upstream",           .set_plugin_parameter = &set_plugin_ipaddress,   .data = &my_dns_upstream },
   { .name = "dns-server",             .set_plugin_parameter = &set_nameservice_server, .data = &my_forwarders,             .addon = {NAME_FORWARDER} },
   { .name = "name",                   .set_plugin_parameter = &set_nameservice_name,   .data = &my_names,                  .addon = {NAME_HOST} },
   { .name = "service",                .set_plugin_parameter = &set_nameservice_name,   .data = &my_services,               .addon = {NAME_SERVICE} },
@@ -325,6 +347,9 @@ name_init(void)
   /* register functions with olsrd */
   olsr_parser_add_function(&olsr_parser, PARSER_TYPE);
 
+  /* for the content hashes of the written files */
+  crc32_init();
+
   /* periodic message generation */
   msg_gen_timer = olsr_start_timer(my_interval * MSEC_PER_SEC, EMISSION_JITTER, OLSR_TIMER_PERIODIC, &olsr_namesvc_gen, NULL, 0);
 
@@ -419,6 +444,7 @@ static void name_lazy_init(void) {
   my_macs = remove_nonvalid_names_from_list(my_macs, NAME_MACADDR);
 
   mapwrite_init(my_latlon_file);
+  dnsserver_init(my_dns_port, &my_dns_listen, &my_dns_upstream);
 
   return;
 }
@@ -498,6 +524,7 @@ name_destructor(void)
   regfree(&regex_t_name);
   regfree(&regex_t_service);
   mapwrite_exit();
+  dnsserver_exit();
 }
 
 /* free all list entries */
@@ -1048,40 +1075,240 @@ send_sighup_to_pidfile(char *pid_file)
 #endif /* _WIN32 */
 
 /**
- * write names to a file in /etc/hosts compatible format
+ * Write the content of a buffer to a file, unless it is the same as
+ * the last time. The content is written to a temporary file in the same
+ * directory first, which is then renamed over the file, so readers never
+ * see a partially written file. The temporary file name starts with a dot,
+ * so that dnsmasq ignores it when it watches the directory.
+ *
+ * @param filename the file
+ * @param abuf the content, a time stamp line is appended to it if
+ *   timestamp is set (it does not count as a change)
+ * @param last_hash the hash of the content as last written, it is
+ *   updated when the file is written
+ * @param timestamp true to append a time stamp line
+ * @return 1 if the file was written, 0 if it did not change and -1
+ *   if it could not be written
  */
-void
-write_hosts_file(void)
+static int
+write_file_if_changed(const char *filename, struct autobuf *abuf, uint32_t *last_hash, bool timestamp)
+{
+  char tmpname[MAX_HOSTS_DIR_FILE + 8];
+  const char *base;
+  uint32_t hash;
+  time_t currtime;
+  FILE *file;
+  size_t written;
+
+  hash = crc32_ieee(abuf->buf, abuf->len);
+  if (hash == 0) {
+    hash = 1;
+  }
+  if (hash == *last_hash) {
+    OLSR_PRINTF(3, "NAME PLUGIN: %s did not change\n", filename);
+    return 0;
+  }
+
+  if (timestamp && time(&currtime)) {
+    abuf_appendf(abuf, "\n### written by olsrd at %s", ctime(&currtime));
+  }
+
+  base = strrchr(filename, '/');
+#ifdef _WIN32
+  if (strrchr(filename, '\\') > base) {
+    base = strrchr(filename, '\\');
+  }
+#endif /* _WIN32 */
+  base = base != NULL ? base + 1 : filename;
+  if ((size_t)snprintf(tmpname, sizeof(tmpname), "%.*s.%s.tmp", (int)(base - filename), filename, base) >= sizeof(tmpname)) {
+    OLSR_PRINTF(2, "NAME PLUGIN: file name %s is too long\n", filename);
+    return -1;
+  }
+
+  file = fopen(tmpname, "w");
+  if (file == NULL) {
+    OLSR_PRINTF(2, "NAME PLUGIN: cant write %s\n", tmpname);
+    return -1;
+  }
+  written = fwrite(abuf->buf, 1, abuf->len, file);
+  if (fclose(file) != 0 || written != (size_t)abuf->len) {
+    OLSR_PRINTF(2, "NAME PLUGIN: cant write %s\n", tmpname);
+    unlink(tmpname);
+    return -1;
+  }
+
+#ifdef _WIN32
+  /* rename() does not replace an existing file */
+  remove(filename);
+#endif /* _WIN32 */
+  if (rename(tmpname, filename) != 0) {
+    OLSR_PRINTF(2, "NAME PLUGIN: cant rename %s to %s\n", tmpname, filename);
+    unlink(tmpname);
+    return -1;
+  }
+
+  *last_hash = hash;
+  return 1;
+}
+
+/**
+ * render the received names of one hash bucket in /etc/hosts format
+ */
+static void
+render_host_names(struct autobuf *abuf, struct list_node *list_head)
 {
-  int hash;
   struct name_entry *name;
   struct db_entry *entry;
-  struct list_node *list_head, *list_node;
-  FILE *hosts;
-  FILE *add_hosts;
-  int c = 0;
-  time_t currtime;
+  struct list_node *list_node;
 
 #ifdef MID_ENTRIES
   struct mid_address *alias;
 #endif /* MID_ENTRIES */
 
+  for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
+
+    entry = list2db(list_node);
+
+    for (name = entry->names; name != NULL; name = name->next) {
+#ifndef NODEBUG
+      struct ipaddr_str strbuf1, strbuf2;
+#endif /* NODEBUG */
+      OLSR_PRINTF(6, "%s\t%s%s\t#%s\n", olsr_ip_to_string(&strbuf1, &name->ip), name->name, my_suffix,
+                  olsr_ip_to_string(&strbuf2, &entry->originator));
+
+      abuf_append_ip(abuf, &name->ip);
+      abuf_putc(abuf, '\t');
+      abuf_puts(abuf, name->name);
+      abuf_puts(abuf, my_suffix);
+      abuf_puts(abuf, "\t# ");
+      abuf_append_ip(abuf, &entry->originator);
+      abuf_putc(abuf, '\n');
+
+#ifdef MID_ENTRIES
+      // write mid entries
+      if ((alias = mid_lookup_aliases(&name->ip)) != NULL) {
+        unsigned short mid_num = 1;
+        char mid_prefix[MID_MAXLEN];
+
+        while (alias != NULL) {
+          // generate mid prefix
+          sprintf(mid_prefix, MID_PREFIX, mid_num);
+
+          OLSR_PRINTF(6, "%s\t%s%s%s\t# %s (mid #%i)\n", olsr_ip_to_string(&strbuf1, &alias->alias), mid_prefix, name->name,
+                      my_suffix, olsr_ip_to_string(&strbuf2, &entry->originator), mid_num);
+
+          abuf_append_ip(abuf, &alias->alias);
+          abuf_putc(abuf, '\t');
+          abuf_puts(abuf, mid_prefix);
+          abuf_puts(abuf, name->name);
+          abuf_puts(abuf, my_suffix);
+          abuf_puts(abuf, "\t# ");
+          abuf_append_ip(abuf, &entry->originator);
+          abuf_appendf(abuf, " (mid #%i)\n", mid_num);
+
+          alias = alias->next_alias;
+          mid_num++;
+        }
+      }
+#endif /* MID_ENTRIES */
+    }
+  }
+}
+
+/**
+ * render my own names in /etc/hosts format
+ */
+static void
+render_own_host_names(struct autobuf *abuf)
+{
+  struct name_entry *name;
+
+  for (name = my_names; name != NULL; name = name->next) {
+    abuf_append_ip(abuf, &name->ip);
+    abuf_putc(abuf, '\t');
+    abuf_puts(abuf, name->name);
+    abuf_puts(abuf, my_suffix);
+    abuf_puts(abuf, "\t# myself\n");
+  }
+}
+
+/**
+ * Write the names into a directory, one file per hash bucket, for
+ * dnsmasq's --hostsdir option. dnsmasq notices changed files by itself
+ * and only reads those again, so it needs no SIGHUP.
+ *
+ * @param changed set to true if any file changed
+ * @return false if a file could not be written
+ */
+static bool
+write_hosts_dir(bool *changed)
+{
+  char filename[MAX_HOSTS_DIR_FILE];
+  struct autobuf abuf;
+  bool ok = true;
+  int hash, len, result;
+
+  abuf_init(&abuf, 1024);
+
+  /* index HASHSIZE is the file with my own names */
+  for (hash = 0; hash <= HASHSIZE; hash++) {
+    abuf.len = 0;
+    abuf.buf[0] = '\0';
+
+    abuf_puts(&abuf, "### this file is overwritten regularly by olsrd\n");
+    if (hash == HASHSIZE) {
+      len = snprintf(filename, sizeof(filename), "%s/olsr-hosts-self", my_hosts_dir);
+      render_own_host_names(&abuf);
+    } else {
+      len = snprintf(filename, sizeof(filename), "%s/olsr-hosts-%03d", my_hosts_dir, hash);
+      render_host_names(&abuf, &name_list[hash]);
+    }
+    if (len < 0 || (size_t)len >= sizeof(filename)) {
+      ok = false;
+      continue;
+    }
+
+    result = write_file_if_changed(filename, &abuf, &hosts_dir_hash[hash], false);
+    if (result > 0) {
+      *changed = true;
+    } else if (result < 0) {
+      ok = false;
+    }
+  }
+
+  abuf_free(&abuf);
+  return ok;
+}
+
+/**
+ * write names to a file in /etc/hosts compatible format
+ */
+void
+write_hosts_file(void)
+{
+  int hash;
+  struct autobuf abuf;
+  FILE *add_hosts;
+  bool changed = false;
+  bool dir_ok = true;
+  int result;
+
   if (!name_table_changed)
     return;
 
   OLSR_PRINTF(2, "NAME PLUGIN: writing hosts file\n");
 
-  hosts = fopen(my_hosts_file, "w");
-  if (hosts == NULL) {
-    OLSR_PRINTF(2, "NAME PLUGIN: cant write hosts file\n");
-    return;
+  if (my_hosts_dir[0] != '\0') {
+    dir_ok = write_hosts_dir(&changed);
   }
 
-  fprintf(hosts, "### this /etc/hosts file is overwritten regularly by olsrd\n");
-  fprintf(hosts, "### do not edit\n\n");
+  abuf_init(&abuf, 4096);
 
-  fprintf(hosts, "127.0.0.1\tlocalhost\n");
-  fprintf(hosts, "::1\t\tlocalhost\n\n");
+  abuf_puts(&abuf, "### this /etc/hosts file is overwritten regularly by olsrd\n");
+  abuf_puts(&abuf, "### do not edit\n\n");
+
+  abuf_puts(&abuf, "127.0.0.1\tlocalhost\n");
+  abuf_puts(&abuf, "::1\t\tlocalhost\n\n");
 
   // copy content from additional hosts filename
   if (my_add_hosts[0] != '\0') {
@@ -1089,73 +1316,45 @@ write_hosts_file(void)
     if (add_hosts == NULL) {
       OLSR_PRINTF(2, "NAME PLUGIN: cant open additional hosts file\n");
     } else {
-      fprintf(hosts, "### contents from '%s' ###\n\n", my_add_hosts);
-      while ((c = getc(add_hosts)) != EOF)
-        putc(c, hosts);
+      char buffer[4096];
+      size_t len;
+
+      abuf_appendf(&abuf, "### contents from '%s' ###\n\n", my_add_hosts);
+      while ((len = fread(buffer, 1, sizeof(buffer), add_hosts)) > 0) {
+        abuf_memcpy(&abuf, buffer, len);
+      }
       fclose(add_hosts);
     }
-    fprintf(hosts, "\n### olsr names ###\n\n");
+    abuf_puts(&abuf, "\n### olsr names ###\n\n");
   }
   // write own names
-  for (name = my_names; name != NULL; name = name->next) {
-    struct ipaddr_str strbuf;
-    fprintf(hosts, "%s\t%s%s\t# myself\n", olsr_ip_to_string(&strbuf, &name->ip), name->name, my_suffix);
-  }
+  render_own_host_names(&abuf);
 
   // write received names
   for (hash = 0; hash < HASHSIZE; hash++) {
-    list_head = &name_list[hash];
-    for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
-
-      entry = list2db(list_node);
-
-      for (name = entry->names; name != NULL; name = name->next) {
-        struct ipaddr_str strbuf1, strbuf2;
-        OLSR_PRINTF(6, "%s\t%s%s\t#%s\n", olsr_ip_to_string(&strbuf1, &name->ip), name->name, my_suffix,
-                    olsr_ip_to_string(&strbuf2, &entry->originator));
-
-        fprintf(hosts, "%s\t%s%s\t# %s\n", olsr_ip_to_string(&strbuf1, &name->ip), name->name, my_suffix,
-                olsr_ip_to_string(&strbuf2, &entry->originator));
-
-#ifdef MID_ENTRIES
-        // write mid entries
-        if ((alias = mid_lookup_aliases(&name->ip)) != NULL) {
-          unsigned short mid_num = 1;
-          char mid_prefix[MID_MAXLEN];
-
-          while (alias != NULL) {
-            // generate mid prefix
-            sprintf(mid_prefix, MID_PREFIX, mid_num);
-
-            OLSR_PRINTF(6, "%s\t%s%s%s\t# %s (mid #%i)\n", olsr_ip_to_string(&strbuf1, &alias->alias), mid_prefix, name->name,
-                        my_suffix, olsr_ip_to_string(&strbuf2, &entry->originator), mid_num);
-
-            fprintf(hosts, "%s\t%s%s%s\t# %s (mid #%i)\n", olsr_ip_to_string(&strbuf1, &alias->alias), mid_prefix, name->name,
-                    my_suffix, olsr_ip_to_string(&strbuf2, &entry->originator), mid_num);
-
-            alias = alias->next_alias;
-            mid_num++;
-          }
-        }
-#endif /* MID_ENTRIES */
-      }
-    }
+    render_host_names(&abuf, &name_list[hash]);
   }
 
-  if (time(&currtime)) {
-    fprintf(hosts, "\n### written by olsrd at %s", ctime(&currtime));
+  result = write_file_if_changed(my_hosts_file, &abuf, &hosts_file_hash, true);
+  abuf_free(&abuf);
+  if (result < 0) {
+    /* name_table_changed stays set, try again later */
+    olsr_start_write_file_timer();
+    return;
   }
 
-  fclose(hosts);
-
 #ifndef _WIN32
-  if (*my_sighup_pid_file)
+  if (result > 0 && *my_sighup_pid_file)
     send_sighup_to_pidfile(my_sighup_pid_file);
 #endif /* _WIN32 */
-  name_table_changed = false;
+  /* try again if the hosts dir is incomplete, the files already written are skipped then */
+  name_table_changed = !dir_ok;
+  if (!dir_ok) {
+    olsr_start_write_file_timer();
+  }
 
   // Executes my_name_change_script after writing the hosts file
-  if (my_name_change_script[0] != '\0') {
+  if ((result > 0 || changed) && my_name_change_script[0] != '\0') {
     if (system(my_name_change_script) != -1) {
       OLSR_PRINTF(2, "NAME PLUGIN: Name changed, %s executed\n", my_name_change_script);
     } else {
@@ -1181,26 +1380,22 @@ write_services_file(bool writemacs)
   struct name_entry *name;
   struct db_entry *entry;
   struct list_node *list_head, *list_node;
-  FILE *file;
-  time_t currtime;
+  struct autobuf abuf;
+  int result;
 
   if ((writemacs && !mac_table_changed) || (!writemacs && !service_table_changed))
     return;
 
   OLSR_PRINTF(2, "NAME PLUGIN: writing %s file\n", writemacs ? "macs" : "services");
 
-  file = fopen(writemacs ? my_macs_file : my_services_file, "w");
-  if (file == NULL) {
-    OLSR_PRINTF(2, "NAME PLUGIN: cant write %s\n", writemacs ? my_macs_file : my_services_file);
-    return;
-  }
+  abuf_init(&abuf, 1024);
 
-  fprintf(file, "### this file is overwritten regularly by olsrd\n");
-  fprintf(file, "### do not edit\n\n");
+  abuf_puts(&abuf, "### this file is overwritten regularly by olsrd\n");
+  abuf_puts(&abuf, "### do not edit\n\n");
 
   // write own services or macs
   for (name = writemacs ? my_macs : my_services; name != NULL; name = name->next) {
-    fprintf(file, "%s\t# my own %s\n", name->name, writemacs ? "mac" : "service");
+    abuf_appendf(&abuf, "%s\t# my own %s\n", name->name, writemacs ? "mac" : "service");
   }
 
   // write received services or macs
@@ -1211,24 +1406,33 @@ write_services_file(bool writemacs)
       entry = list2db(list_node);
 
       for (name = entry->names; name != NULL; name = name->next) {
+#ifndef NODEBUG
         struct ipaddr_str strbuf;
+#endif /* NODEBUG */
         OLSR_PRINTF(6, "%s\t", name->name);
         OLSR_PRINTF(6, "\t#%s\n", olsr_ip_to_string(&strbuf, &entry->originator));
 
-        fprintf(file, "%s\t", name->name);
-        fprintf(file, "\t#%s\n", olsr_ip_to_string(&strbuf, &entry->originator));
+        abuf_puts(&abuf, name->name);
+        abuf_puts(&abuf, "\t\t#");
+        abuf_append_ip(&abuf, &entry->originator);
+        abuf_putc(&abuf, '\n');
       }
     }
   }
 
-  if (time(&currtime)) {
-    fprintf(file, "\n### written by olsrd at %s", ctime(&currtime));
+  if (writemacs) {
+    result = write_file_if_changed(my_macs_file, &abuf, &macs_file_hash, true);
+  } else {
+    result = write_file_if_changed(my_services_file, &abuf, &services_file_hash, true);
+  }
+  abuf_free(&abuf);
+  if (result < 0) {
+    return;
   }
 
-  fclose(file);
   if (writemacs) {
     // Executes my_macs_change_script after writing the macs file
-    if (my_macs_change_script[0] != '\0') {
+    if (result > 0 && my_macs_change_script[0] != '\0') {
       if (system(my_macs_change_script) != -1) {
         OLSR_PRINTF(2, "NAME PLUGIN: Service changed, %s executed\n", my_macs_change_script);
       } else {
@@ -1239,7 +1443,7 @@ write_services_file(bool writemacs)
   }
   else {
     // Executes my_services_change_script after writing the services file
-    if (my_services_change_script[0] != '\0') {
+    if (result > 0 && my_services_change_script[0] != '\0') {
       if (system(my_services_change_script) != -1) {
         OLSR_PRINTF(2, "NAME PLUGIN: Service changed, %s executed\n", my_services_change_script);
       } else {
@@ -1251,21 +1455,40 @@ write_services_file(bool writemacs)
 }
 
 /**
- * Sort the nameserver pointer array.
+ * Find the most specific route to a nameserver, which may sit in an
+ * announced network. A default route matches every address and says
+ * nothing about the nameserver, so it does not count.
+ */
+static struct rt_entry *
+lookup_nameserver_route(const union olsr_ip_addr *ip)
+{
+  struct rt_entry *rt = olsr_lookup_routing_table_best(ip);
+
+  return rt != NULL && rt->rt_dst.prefix_len > 0 ? rt : NULL;
+}
+
+/* an upstream nameserver and the most specific route which covers it */
+struct nameserver_route {
+  struct rt_entry *rt;
+  union olsr_ip_addr ip;
+};
+
+/**
+ * Sort the nameserver array.
  *
  * fresh entries are at the beginning of the array and
  * the best entry is at the end of the array.
  */
 static void
-select_best_nameserver(struct rt_entry **rt)
+select_best_nameserver(struct nameserver_route *ns)
 {
   int nameserver_idx;
   struct rt_entry *rt1, *rt2;
 
   for (nameserver_idx = 0; nameserver_idx < NAMESERVER_COUNT; nameserver_idx++) {
 
-    rt1 = rt[nameserver_idx];
-    rt2 = rt[nameserver_idx + 1];
+    rt1 = ns[nameserver_idx].rt;
+    rt2 = ns[nameserver_idx + 1].rt;
 
     /*
      * compare the next two pointers in the array.
@@ -1279,15 +1502,89 @@ select_best_nameserver(struct rt_entry **rt)
       /*
        * first is better, swap the pointers.
        */
-      OLSR_PRINTF(6, "NAME PLUGIN: nameserver %s, cost %s\n", olsr_ip_to_string(&strbuf, &rt1->rt_dst.prefix),
+      struct nameserver_route tmp = ns[nameserver_idx];
+
+      OLSR_PRINTF(6, "NAME PLUGIN: nameserver %s, cost %s\n", olsr_ip_to_string(&strbuf, &tmp.ip),
                   get_linkcost_text(rt1->rt_best->rtp_metric.cost, true, &lqbuffer));
 
-      rt[nameserver_idx] = rt2;
-      rt[nameserver_idx + 1] = rt1;
+      ns[nameserver_idx] = ns[nameserver_idx + 1];
+      ns[nameserver_idx + 1] = tmp;
     }
   }
 }
 
+/**
+ * @return the suffix appended to all mesh host names
+ */
+const char *
+get_name_suffix(void)
+{
+  return my_suffix;
+}
+
+/**
+ * call func for our own host or service entries
+ * and for all of that type learned from the mesh
+ *
+ * @param type NAME_HOST or NAME_SERVICE
+ * @param func called once per entry
+ * @param data passed through to func
+ */
+void
+name_foreach_entry(int type, void (*func) (void *, const struct name_entry *), void *data)
+{
+  const struct name_entry *name;
+  struct list_node *list, *list_head, *list_node;
+  int hash;
+
+  if (type == NAME_SERVICE) {
+    name = my_services;
+    list = service_list;
+  } else {
+    name = my_names;
+    list = name_list;
+  }
+
+  for (; name != NULL; name = name->next) {
+    func(data, name);
+  }
+  for (hash = 0; hash < HASHSIZE; hash++) {
+    list_head = &list[hash];
+    for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
+      for (name = list2db(list_node)->names; name != NULL; name = name->next) {
+        func(data, name);
+      }
+    }
+  }
+}
+
+/**
+ * find the announced DNS server with the best route
+ */
+bool
+get_best_nameserver(union olsr_ip_addr *ip)
+{
+  int hash;
+  struct name_entry *name;
+  struct list_node *list_head, *list_node;
+  struct rt_entry *route, *best = NULL;
+
+  for (hash = 0; hash < HASHSIZE; hash++) {
+    list_head = &forwarder_list[hash];
+    for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
+      for (name = list2db(list_node)->names; name != NULL; name = name->next) {
+        route = lookup_nameserver_route(&name->ip);
+        if (route != NULL && (best == NULL || olsr_cmp_rt(route, best))) {
+          best = route;
+          *ip = name->ip;
+        }
+      }
+    }
+  }
+
+  return best != NULL;
+}
+
 /**
  * write the 3 best upstream DNS servers to resolv.conf file
  * best means the 3 with the best etx value in routing table
@@ -1300,10 +1597,9 @@ write_resolv_file(void)
   struct db_entry *entry;
   struct list_node *list_head, *list_node;
   struct rt_entry *route;
-  static struct rt_entry *nameserver_routes[NAMESERVER_COUNT + 1];
-  FILE *resolv;
+  static struct nameserver_route nameserver_routes[NAMESERVER_COUNT + 1];
+  struct autobuf abuf;
   int i = 0;
-  time_t currtime;
 
   if (!forwarder_table_changed || my_forwarders != NULL || my_resolv_file[0] == '\0')
     return;
@@ -1322,7 +1618,7 @@ write_resolv_file(void)
         struct ipaddr_str strbuf;
         struct lqtextbuffer lqbuffer;
 #endif /* NODEBUG */
-        route = olsr_lookup_routing_table(&name->ip);
+        route = lookup_nameserver_route(&name->ip);
 
         OLSR_PRINTF(6, "NAME PLUGIN: check route for nameserver %s %s", olsr_ip_to_string(&strbuf, &name->ip),
                     route ? "suceeded" : "failed");
@@ -1331,7 +1627,8 @@ write_resolv_file(void)
           continue;
 
         /* enqueue it on the head of list */
-        *nameserver_routes = route;
+        nameserver_routes[0].rt = route;
+        nameserver_routes[0].ip = name->ip;
         OLSR_PRINTF(6, "NAME PLUGIN: found nameserver %s, cost %s", olsr_ip_to_string(&strbuf, &name->ip),
                     get_linkcost_text(route->rt_best->rtp_metric.cost, true, &lqbuffer));
 
@@ -1342,23 +1639,21 @@ write_resolv_file(void)
   }
 
   /* if there is no best route we are done */
-  if (nameserver_routes[NAMESERVER_COUNT] == NULL)
+  if (nameserver_routes[NAMESERVER_COUNT].rt == NULL)
     return;
 
   /* write to file */
   OLSR_PRINTF(2, "NAME PLUGIN: try to write to resolv file\n");
-  resolv = fopen(my_resolv_file, "w");
-  if (resolv == NULL) {
-    OLSR_PRINTF(2, "NAME PLUGIN: can't write resolv file\n");
-    return;
-  }
-  fprintf(resolv, "### this file is overwritten regularly by olsrd\n");
-  fprintf(resolv, "### do not edit\n\n");
+  abuf_init(&abuf, 256);
+  abuf_puts(&abuf, "### this file is overwritten regularly by olsrd\n");
+  abuf_puts(&abuf, "### do not edit\n\n");
 
   for (i = NAMESERVER_COUNT; i >= 0; i--) {
+#ifndef NODEBUG
     struct ipaddr_str strbuf;
+#endif /* NODEBUG */
 
-    route = nameserver_routes[i];
+    route = nameserver_routes[i].rt;
 
     OLSR_PRINTF(2, "NAME PLUGIN: nameserver_routes #%d %p\n", i, route);
 
@@ -1366,13 +1661,16 @@ write_resolv_file(void)
       continue;
     }
 
-    OLSR_PRINTF(2, "NAME PLUGIN: nameserver %s\n", olsr_ip_to_string(&strbuf, &route->rt_dst.prefix));
-    fprintf(resolv, "nameserver %s\n", olsr_ip_to_string(&strbuf, &route->rt_dst.prefix));
+    OLSR_PRINTF(2, "NAME PLUGIN: nameserver %s\n", olsr_ip_to_string(&strbuf, &nameserver_routes[i].ip));
+    abuf_puts(&abuf, "nameserver ");
+    abuf_append_ip(&abuf, &nameserver_routes[i].ip);
+    abuf_putc(&abuf, '\n');
   }
-  if (time(&currtime)) {
-    fprintf(resolv, "\n### written by olsrd at %s", ctime(&currtime));
+  i = write_file_if_changed(my_resolv_file, &abuf, &resolv_file_hash, true);
+  abuf_free(&abuf);
+  if (i < 0) {
+    return;
   }
-  fclose(resolv);
   forwarder_table_changed = false;
 }
 
@@ -1648,20 +1946,23 @@ lookup_name_latlon(union olsr_ip_addr *ip)
 void
 write_latlon_file(void)
 {
-  FILE *fmap;
+  struct autobuf abuf;
+  int result;
 
   if (!my_names || !latlon_table_changed)
     return;
 
   OLSR_PRINTF(2, "NAME PLUGIN: writing latlon file\n");
 
-  if (NULL == (fmap = fopen(my_latlon_file, "w"))) {
+  abuf_init(&abuf, 4096);
+  abuf_puts(&abuf, "/* This file is overwritten regularly by olsrd */\n");
+  mapwrite_work(&abuf);
+  result = write_file_if_changed(my_latlon_file, &abuf, &latlon_file_hash, false);
+  abuf_free(&abuf);
+  if (result < 0) {
     OLSR_PRINTF(0, "NAME PLUGIN: cant write latlon file\n");
     return;
   }
-  fprintf(fmap, "/* This file is overwritten regularly by olsrd */\n");
-  mapwrite_work(fmap);
-  fclose(fmap);
   latlon_table_changed = false;
 }
 #endif /* _WIN32 */
@@ -70,6 +70,7 @@
 
 #define MAX_NAME 127
 #define MAX_FILE 255
+#define MAX_HOSTS_DIR_FILE (MAX_FILE + 32)  /* hosts-dir and "/olsr-hosts-NNN" */
 #define MAX_SUFFIX 63
 
 #define MID_ENTRIES 1
@@ -149,6 +150,12 @@ void write_services_file(bool writemacs);
 
 void write_resolv_file(void);
 
+bool get_best_nameserver(union olsr_ip_addr *ip);
+
+const char *get_name_suffix(void);
+
+void name_foreach_entry(int type, void (*func) (void *, const struct name_entry *), void *data);
+
 int register_olsr_param(char *key, char *value);
 
 void free_name_entry_list(struct name_entry **list);
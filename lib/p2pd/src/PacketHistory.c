@@ -46,74 +46,22 @@
 #include <string.h> /* memset */
 #include <sys/types.h> /* u_int16_t, u_int32_t */
 #include <netinet/ip.h> /* struct iphdr */
-#include <stdlib.h> /* free() */
 
 /* OLSRD includes */
-#include "olsr.h" /* olsr_printf */
-#include "scheduler.h" /* GET_TIMESTAMP, TIMED_OUT */
+#include "defs.h" /* olsr_cnf, OLSR_PRINTF */
+#include "common/crc32.h" /* crc32_ieee() */
+#include "common/dupfilter.h" /* struct dupfilter */
 
 /* Plugin includes */
 #include "Packet.h"
+#include "p2pd.h" /* PLUGIN_NAME_SHORT */
 
-static struct TDupEntry* PacketHistory[HISTORY_HASH_SIZE];
+static struct dupfilter PacketHistory;
 
-#define CRC_UPTO_NBYTES 256
-
-/* -------------------------------------------------------------------------
- * Function   : GenerateCrc32Table
- * Description: Generate the table of CRC remainders for all possible bytes,
- *              according to CRC-32-IEEE 802.3
- * Input      : none
- * Output     : none
- * Return     : none
- * Data Used  : none
- * ------------------------------------------------------------------------- */
-#define CRC32_POLYNOMIAL 0xedb88320UL /* bit-inverse of 0x04c11db7UL */
-
-static unsigned long CrcTable[256];
-
-static void GenerateCrc32Table(void)
-{
-  int i, j;
-  u_int32_t crc;
-  for (i = 0; i < 256; i++)
-  {
-    crc = (u_int32_t) i;
-    for (j = 0; j < 8; j++)
-    {
-      if (crc & 1)
-      {
-        crc = (crc >> 1) ^ CRC32_POLYNOMIAL;
-      }
-      else
-      {
-        crc = (crc >> 1);
-      }
-    }
-    CrcTable[i] = crc;
-  } /* for */
-} /* GenerateCrc32Table */
+/* Number of lookups at the time of the previous report */
+static u_int32_t LastReportLookups = 0;
 
-/* -------------------------------------------------------------------------
- * Function   : CalcCrc32
- * Description: Calculate CRC-32 according to CRC-32-IEEE 802.3
- * Input      : buffer - the bytes to calculate the CRC value over
- *              len - the number of bytes to calculate the CRC value over
- * Output     : none
- * Return     : CRC-32 value
- * Data Used  : none
- * ------------------------------------------------------------------------- */
-static u_int32_t CalcCrc32(unsigned char* buffer, ssize_t len)
-{
-  int i, j;
-  u_int32_t crc = 0xffffffffUL;
-  for (i = 0; i < len; i++)
-  {
-    j = ((int) (crc & 0xFF) ^ *buffer++);
-    crc = (crc >> 8) ^ CrcTable[j];
-  }
-  return crc ^ 0xffffffffUL;
-} /* CalcCrc32 */
+#define CRC_UPTO_NBYTES 256
 
 /* -------------------------------------------------------------------------
  * Function   : PacketCrc32
@@ -153,28 +101,15 @@ u_int32_t PacketCrc32(unsigned char* ipPacket, ssize_t len)
   ipHeader->ip_ttl = 0xFF; /* fixed value of TTL for CRC-32 calculation */
   ipHeader->ip_sum = 0x5A5A; /* fixed value of IP header checksum for CRC-32 calculation */
 
-  result = CalcCrc32(ipPacket, len);
+  result = crc32_ieee(ipPacket, len);
 
   RestoreTtlAndChecksum(ipPacket, &sttl);
   return result;
 } /* PacketCrc32 */
 
-/* -------------------------------------------------------------------------
- * Function   : Hash
- * Description: Calculates a hash value from a 32-bit value
- * Input      : from32 - 32-bit value
- * Output     : none
- * Return     : hash value
- * Data Used  : none
- * ------------------------------------------------------------------------- */
-u_int32_t Hash(u_int32_t from32)
-{
-  return ((from32 >> N_HASH_BITS) + from32) & ((1 << N_HASH_BITS) - 1);
-} /* Hash */
-
 /* -------------------------------------------------------------------------
  * Function   : InitPacketHistory
- * Description: Initialize the packet history table and CRC-32 table
+ * Description: Initialize the packet history table and CRC-32 calculation
  * Input      : none
  * Output     : none
  * Return     : none
@@ -182,14 +117,9 @@ u_int32_t Hash(u_int32_t from32)
  * ------------------------------------------------------------------------- */
 void InitPacketHistory(void)
 {
-  int i;
-
-  GenerateCrc32Table();
+  crc32_init();
 
-  for(i = 0; i < HISTORY_HASH_SIZE; i++)
-  {
-    PacketHistory[i] = NULL;
-  }
+  dupfilter_init(&PacketHistory, HISTORY_SIZE, HISTORY_HOLD_TIME);
 } /* InitPacketHistory */
 
 /* -------------------------------------------------------------------------
@@ -200,86 +130,50 @@ void InitPacketHistory(void)
  * Output     : none
  * Return     : not recently seen (0), recently seen (1)
  * Data Used  : PacketHistory
+ * Notes      : Entries expire by themselves; when the history is full, the
+ *              entry that would expire first is overwritten.
  * ------------------------------------------------------------------------- */
 int CheckAndMarkRecentPacket(u_int32_t crc32)
 {
-  u_int32_t idx;
-  struct TDupEntry* walker;
-  struct TDupEntry* newEntry;
-
-  idx = Hash(crc32);
-  assert(idx < HISTORY_HASH_SIZE);
-
-  for (walker = PacketHistory[idx]; walker != NULL; walker = walker->next)
-  {
-    if (walker->crc32 == crc32)
-    {
-      /* Found duplicate entry */
-
-      /* Always mark as "seen recently": refresh time-out */
-      walker->timeOut = olsr_getTimestamp(HISTORY_HOLD_TIME);
-
-      return 1;
-    } /* if */
-  } /* for */
-
-  /* No duplicate entry found: create one */
-  newEntry = olsr_malloc(sizeof(struct TDupEntry), "OLSRD P2PD: TDupEntry");
-  if (newEntry != NULL)
-  {
-    newEntry->crc32 = crc32;
-    newEntry->timeOut = olsr_getTimestamp(HISTORY_HOLD_TIME);
-
-    /* Add new entry at the front of the list */
-    newEntry->next = PacketHistory[idx];
-    PacketHistory[idx] = newEntry;
-  }
-
-  return 0;
+  return dupfilter_check_and_mark(&PacketHistory, crc32) ? 1 : 0;
 } /* CheckAndMarkRecentPacket */
-  
+
 /* -------------------------------------------------------------------------
- * Function   : PrunePacketHistory
- * Description: Prune the packet history table.
+ * Function   : ReportPacketHistory
+ * Description: Clear expired entries, print the statistics of the packet
+ *              history
  * Input      : useless - not used
  * Output     : none
  * Return     : none
  * Data Used  : PacketHistory
+ * Notes      : Called every HISTORY_HOLD_TIME milliseconds
  * ------------------------------------------------------------------------- */
-void PrunePacketHistory(void* useless __attribute__ ((unused)))
+void ReportPacketHistory(void* useless __attribute__((unused)))
 {
-  uint i;
-  for (i = 0; i < HISTORY_HASH_SIZE; i++)
-  {
-    if (PacketHistory[i] != NULL)
-    {
-      struct TDupEntry* nextEntry = PacketHistory[i];
-      struct TDupEntry* prevEntry = NULL;
-      while (nextEntry != NULL) 
-      {
-        struct TDupEntry* entry = nextEntry;
-        nextEntry = entry->next;
+  struct dupfilter_stats stats;
+
+  /* Clear expired entries before their time stamps wrap */
+  dupfilter_expire(&PacketHistory);
 
-        if (olsr_isTimedOut(entry->timeOut))
-        {
-          /* De-queue */
-          if (prevEntry != NULL)
-          {
-            prevEntry->next = entry->next;
-          }
-          else
-          {
-            PacketHistory[i] = entry->next;
-          } /* if */
+  /* Collecting the statistics walks the whole history */
+  if (olsr_cnf->debug_level < 7)
+  {
+    return;
+  }
 
-          /* De-allocate memory */
-          free(entry); 
-	      }
-	      else
-	      {
-	        prevEntry = entry;
-	      } /* if */
-      } /* while */
-    } /* if (PacketHistory[i] != NULL) */
-  } /* for (i = ...) */
-} /* PrunePacketHistory */
+  dupfilter_get_stats(&PacketHistory, &stats);
+
+  OLSR_PRINTF(
+    7,
+    "%s: packet history: %u/%u entries, %u lookups/s, %u duplicates, %u evictions,"
+    " false positive rate %.1e\n",
+    PLUGIN_NAME_SHORT,
+    stats.entries,
+    stats.capacity,
+    (stats.lookups - LastReportLookups) / (HISTORY_HOLD_TIME / 1000),
+    stats.duplicates,
+    stats.evictions,
+    stats.false_positive_rate);
+
+  LastReportLookups = stats.lookups;
+} /* ReportPacketHistory */
@@ -71,6 +71,7 @@
 #include "link_set.h"           /* get_best_link_to_neighbor() */
 #include "net_olsr.h"           /* ipequal */
 #include "parser.h"
+#include "scheduler.h"          /* olsr_start_timer() */
 
 /* plugin includes */
 #include "NetworkInterfaces.h"  /* NonOlsrInterface,
@@ -795,6 +796,10 @@ InitP2pd(struct interface *skipThisIntf)
   if (P2pdUseHash) {
     // Initialize hash table for hash based duplicate IP packet check
     InitPacketHistory();
+
+    // Expire the duplicate IP packet check and report its statistics now and then
+    olsr_start_timer(HISTORY_HOLD_TIME, 0, OLSR_TIMER_PERIODIC,
+                     &ReportPacketHistory, NULL, 0);
   }
 
   //Tells OLSR to launch olsr_parser when the packets for this plugin arrive
@@ -1071,9 +1076,7 @@ check_and_mark_recent_packet(unsigned char *data,
   /* If we don't use this filter bail out here */
   if (!P2pdUseHash)
     return false;
-    
-  /* Clean up the hash table each time before we check it */
-  PrunePacketHistory(NULL);
+
 
   /* Check for duplicate IP packets now based on a hash */
   ipPacket = GetIpPacket(data);
@@ -374,7 +374,7 @@ ipc_print_tc_link(struct tc_entry *entry, struct tc_edge_entry *dst_entry)
 //  double etx = olsr_calc_tc_etx(dst_entry);
 
   len =
-    sprintf(buf, "add link %s %s\n", olsr_ip_to_string(&main_adr, &entry->addr), olsr_ip_to_string(&adr, &dst_entry->T_dest_addr));
+    sprintf(buf, "add link %s %s\n", olsr_ip_to_string(&main_adr, &entry->addr), olsr_ip_to_string(&adr, tc_edge_dest_addr(dst_entry)));
   ipc_send(buf, len);
 }
 
@@ -7,6 +7,7 @@
 
 /* System includes */
 #include <assert.h>
+#include <limits.h>
 
 /* Defines */
 
@@ -15,6 +16,99 @@
 #define WRAPINDEX(x, i)		((i) % LISTSIZE(x)) /* always valid for i>=0 */
 #define INCOMINGINDEX(x)	WRAPINDEX(x, (NEWESTINDEX(x) + LISTSIZE(x) - 1)) /* always valid */
 
+/** marks the end of a hash bucket chain */
+#define NO_ENTRY			ULLONG_MAX
+
+/**
+ Fill a de-duplication entry from a message
+
+ @param entry
+ The entry to fill
+ @param olsrMessage
+ The message
+ */
+static void fillDeDupEntry(DeDupEntry * entry, union olsr_message *olsrMessage) {
+	memset(entry, 0, sizeof(DeDupEntry));
+	if (olsr_cnf->ip_version == AF_INET) {
+		entry->seqno = olsrMessage->v4.seqno;
+		entry->originator.v4.s_addr = olsrMessage->v4.originator;
+	} else {
+		entry->seqno = olsrMessage->v6.seqno;
+		entry->originator.v6 = olsrMessage->v6.originator;
+	}
+}
+
+/**
+ Compare two de-duplication entries
+
+ @return
+ - true when seqno and originator are equal
+ - false otherwise
+ */
+static bool isSameDeDupEntry(DeDupEntry * a, DeDupEntry * b) {
+	if (a->seqno != b->seqno) {
+		return false;
+	}
+	if (olsr_cnf->ip_version == AF_INET) {
+		return (a->originator.v4.s_addr == b->originator.v4.s_addr);
+	}
+	return (memcmp(&a->originator.v6, &b->originator.v6, sizeof(a->originator.v6)) == 0);
+}
+
+/**
+ Determine the hash bucket of a de-duplication entry
+
+ @param deDupList
+ The de-duplication list
+ @param entry
+ The entry
+
+ @return
+ The hash bucket index
+ */
+static unsigned long long getDeDupBucket(DeDupList * deDupList, DeDupEntry * entry) {
+	uint32_t hash = entry->seqno;
+
+	if (olsr_cnf->ip_version == AF_INET) {
+		hash ^= entry->originator.v4.s_addr;
+	} else {
+		uint32_t words[4];
+		memcpy(words, &entry->originator.v6, sizeof(words));
+		hash ^= words[0] ^ words[1] ^ words[2] ^ words[3];
+	}
+
+	/* mix, the seqno and the low address bits must reach all bucket bits */
+	hash ^= hash >> 16;
+	hash *= 0x7feb352dU;
+	hash ^= hash >> 15;
+	hash *= 0x846ca68bU;
+	hash ^= hash >> 16;
+
+	return (hash & deDupList->hashMask);
+}
+
+/**
+ Remove an entry from the hash index
+
+ @param deDupList
+ The de-duplication list
+ @param index
+ The index of the entry in the list
+ */
+static void unhashDeDupEntry(DeDupList * deDupList, unsigned long long index) {
+	unsigned long long * link = &deDupList->hashBuckets[getDeDupBucket(deDupList, &deDupList->entries[index])];
+
+	while (*link != NO_ENTRY) {
+		if (*link == index) {
+			*link = deDupList->entries[index].hashNext;
+			return;
+		}
+		link = &deDupList->entries[*link].hashNext;
+	}
+
+	assert(false);
+}
+
 /**
  Initialise the de-duplication list: allocate memory for the entries and
  reset fields.
@@ -31,6 +125,8 @@
  */
 bool initDeDupList(DeDupList * deDupList, unsigned long long maxEntries) {
 	void * p;
+	unsigned long long bucketCount;
+	unsigned long long i;
 
 	if (deDupList == NULL) {
 		return false;
@@ -39,6 +135,12 @@ bool initDeDupList(DeDupList * deDupList, unsigned long long maxEntries) {
 		return false;
 	}
 
+	/* at least as many buckets as entries, a power of 2 */
+	bucketCount = 1;
+	while (bucketCount < maxEntries) {
+		bucketCount <<= 1;
+	}
+
 	p = olsr_malloc(maxEntries * sizeof(DeDupEntry),
 			"DeDupEntry entries for DeDupList (PUD)");
 	if (p == NULL) {
@@ -51,6 +153,20 @@ bool initDeDupList(DeDupList * deDupList, unsigned long long maxEntries) {
 	deDupList->entriesCount = 0;
 	deDupList->newestEntryIndex = 0;
 
+	p = olsr_malloc(bucketCount * sizeof(unsigned long long),
+			"hash buckets for DeDupList (PUD)");
+	if (p == NULL) {
+		free(deDupList->entries);
+		deDupList->entries = NULL;
+		return false;
+	}
+
+	deDupList->hashBuckets = p;
+	deDupList->hashMask = bucketCount - 1;
+	for (i = 0; i < bucketCount; i++) {
+		deDupList->hashBuckets[i] = NO_ENTRY;
+	}
+
 	return true;
 }
 
@@ -68,10 +184,17 @@ void destroyDeDupList(DeDupList * deDupList) {
 		deDupList->entries = NULL;
 	}
 
+	if (deDupList->hashBuckets != NULL) {
+		free(deDupList->hashBuckets);
+		deDupList->hashBuckets = NULL;
+	}
+
 	deDupList->entriesMaxCount = 0;
 
 	deDupList->entriesCount = 0;
 	deDupList->newestEntryIndex = 0;
+
+	deDupList->hashMask = 0;
 }
 
 /**
@@ -84,6 +207,7 @@ void destroyDeDupList(DeDupList * deDupList) {
  */
 void addToDeDup(DeDupList * deDupList, union olsr_message *olsrMessage) {
 	unsigned long long incomingIndex;
+	unsigned long long bucket;
 	DeDupEntry * newEntry;
 
 	assert (deDupList != NULL);
@@ -91,15 +215,18 @@ void addToDeDup(DeDupList * deDupList, union olsr_message *olsrMessage) {
 	incomingIndex = INCOMINGINDEX(deDupList);
 	newEntry = &deDupList->entries[incomingIndex];
 
-	memset(newEntry, 0, sizeof(DeDupEntry));
-	if (olsr_cnf->ip_version == AF_INET) {
-		newEntry->seqno = olsrMessage->v4.seqno;
-		newEntry->originator.v4.s_addr = olsrMessage->v4.originator;
-	} else {
-		newEntry->seqno = olsrMessage->v6.seqno;
-		newEntry->originator.v6 = olsrMessage->v6.originator;
+	/* when the list is full the incoming entry overwrites the oldest one,
+	 * which then has to leave the hash index as well */
+	if (deDupList->entriesCount >= deDupList->entriesMaxCount) {
+		unhashDeDupEntry(deDupList, incomingIndex);
 	}
 
+	fillDeDupEntry(newEntry, olsrMessage);
+
+	bucket = getDeDupBucket(deDupList, newEntry);
+	newEntry->hashNext = deDupList->hashBuckets[bucket];
+	deDupList->hashBuckets[bucket] = incomingIndex;
+
 	deDupList->newestEntryIndex = incomingIndex;
 	if (deDupList->entriesCount < deDupList->entriesMaxCount) {
 		deDupList ->entriesCount++;
@@ -120,37 +247,24 @@ void addToDeDup(DeDupList * deDupList, union olsr_message *olsrMessage) {
  - false otherwise
  */
 bool isInDeDupList(DeDupList * deDupList, union olsr_message *olsrMessage) {
-	bool retval = false;
+	DeDupEntry key;
 	unsigned long long iteratedIndex;
-	unsigned long long count;
 
-	iteratedIndex = NEWESTINDEX(deDupList);
-	count = deDupList->entriesCount;
+	fillDeDupEntry(&key, olsrMessage);
 
-	/* we iterate from newest until oldest: we have a higher probability to
-	 * match on the newest entries */
+	/* entries are pushed on the front of their bucket, so we iterate from
+	 * newest until oldest: we have a higher probability to match on the
+	 * newest entries */
 
-	while (count > 0) {
+	iteratedIndex = deDupList->hashBuckets[getDeDupBucket(deDupList, &key)];
+	while (iteratedIndex != NO_ENTRY) {
 		DeDupEntry * iteratedEntry = &deDupList->entries[iteratedIndex];
-		if (olsr_cnf->ip_version == AF_INET) {
-			if ((iteratedEntry->seqno == olsrMessage->v4.seqno) && (memcmp(
-					&iteratedEntry->originator.v4, &olsrMessage->v4.originator,
-					sizeof(iteratedEntry->originator.v4))) == 0) {
-				retval = true;
-				break;
-			}
-		} else {
-			if ((iteratedEntry->seqno == olsrMessage->v6.seqno) && (memcmp(
-					&iteratedEntry->originator.v6, &olsrMessage->v6.originator,
-					sizeof(iteratedEntry->originator.v6)) == 0)) {
-				retval = true;
-				break;
-			}
+		if (isSameDeDupEntry(iteratedEntry, &key)) {
+			return true;
 		}
 
-		iteratedIndex = WRAPINDEX(deDupList, iteratedIndex + 1); /* go the the next older entry */
-		count--;
+		iteratedIndex = iteratedEntry->hashNext;
 	}
 
-	return retval;
+	return false;
 }
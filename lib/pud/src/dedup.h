@@ -11,17 +11,20 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-/* A de-duplication entry holding the information to compare, 18 bytes */
+/* A de-duplication entry holding the information to compare */
 typedef struct _DeDupEntry {
 		uint16_t seqno;
 		union olsr_ip_addr originator;
+		unsigned long long hashNext; /**< index of the next entry in the same hash bucket */
 } DeDupEntry;
 
 /**
  A list of de-duplication entries that are used to determine whether a received
  OLSR message was already seen.
 
- The list is a circular list.
+ The list is a circular list. A hash index over the entries (chained through
+ the entries themselves) makes lookups independent of the list size; entries
+ leave the index when the list overwrites them.
  */
 typedef struct _DeDupList {
 	unsigned long long entriesMaxCount; /**< the maximum number of entries in the list */
@@ -29,6 +32,9 @@ typedef struct _DeDupList {
 
 	unsigned long long entriesCount; /**< the number of entries in the list */
 	unsigned long long newestEntryIndex; /**< index of the newest entry in the list (zero-based) */
+
+	unsigned long long * hashBuckets; /**< index of the first entry per hash bucket */
+	unsigned long long hashMask; /**< the number of hash buckets minus one */
 } DeDupList;
 
 bool initDeDupList(DeDupList * deDupList, unsigned long long maxEntries);
@@ -34,6 +34,8 @@ void flushPositionAverageList(PositionAverageList * positionAverageList) {
 	memset(&positionAverageList->counters, 0,
 			sizeof(positionAverageList->counters));
 
+	memset(&positionAverageList->sums, 0, sizeof(positionAverageList->sums));
+
 	nmea_zero_INFO(&positionAverageList->positionAverageCumulative.nmeaInfo);
 	memset(&positionAverageList->positionAverageCumulative.track, 0, sizeof(positionAverageList->positionAverageCumulative.track));
 	memset(&positionAverageList->positionAverageCumulative.mtrack, 0, sizeof(positionAverageList->positionAverageCumulative.mtrack));
@@ -421,54 +423,80 @@ static void determineCumulativePresentSmaskSigFix(
 	}
 }
 
+/**
+ The largest absolute value that is converted to fixed-point. No GPS value comes
+ anywhere near it; it only guards the sums against overflow on garbage input.
+ */
+#define FIXEDPOINT_VALUE_MAX 1.0e6
+
+/**
+ * Convert a value to fixed-point
+ *
+ * @param value the value
+ * @return the value in fixed-point
+ */
+static int64_t toFixedPoint(double value) {
+	if (value > FIXEDPOINT_VALUE_MAX) {
+		value = FIXEDPOINT_VALUE_MAX;
+	} else if (value < -FIXEDPOINT_VALUE_MAX) {
+		value = -FIXEDPOINT_VALUE_MAX;
+	}
+
+	return llround(value * POSAVG_FIXEDPOINT_SCALE);
+}
+
+/**
+ * Calculate the average of a fixed-point sum
+ *
+ * @param sum the fixed-point sum
+ * @param count the number of values in the sum
+ * @return the average value
+ */
+static double fromFixedPointSum(int64_t sum, unsigned long long count) {
+	return ((double) sum / (double) count) / POSAVG_FIXEDPOINT_SCALE;
+}
+
 /**
  * Calculate angle components
  *
  * @param components a pointer to the components structure
  * @param angle a pointer to the angle (in degrees) from which to calculate
  * the components. Set to NULL when the angle is not present in the input data.
- *
+ * @param previous a pointer to the angle components of the previous entry.
+ * Set to NULL when there is no previous entry.
+ * @param previousAngle a pointer to the angle of the previous entry. When it
+ * equals the angle, the components are copied instead of recalculated. Set to
+ * NULL when there is no previous entry or when its angle is not present.
  */
-static void calculateAngleComponents(AngleComponents * components, double * angle) {
+static void calculateAngleComponents(AngleComponents * components, double * angle,
+		AngleComponents * previous, double * previousAngle) {
 	if (!components)
 		return;
 
 	if (!angle) {
-		components->x = 0.0;
-		components->y = 0.0;
+		components->x = 0;
+		components->y = 0;
 		return;
 	}
 
-	components->x = cos(nmea_degree2radian(*angle));
-	components->y = sin(nmea_degree2radian(*angle));
-}
-
-/**
- * Calculate angle from its components
- *
- * @param components a pointer to the components structure
- * @return angle the angle (in degrees)
- */
-static double calculateAngle(AngleComponents * components) {
-	if (!components)
-		return 0;
+	if (previous && previousAngle && (*previousAngle == *angle)) {
+		*components = *previous;
+		return;
+	}
 
-	return nmea_radian2degree(atan2(components->y, components->x));
+	components->x = (int32_t) toFixedPoint(cos(nmea_degree2radian(*angle)));
+	components->y = (int32_t) toFixedPoint(sin(nmea_degree2radian(*angle)));
 }
 
 /**
- * Add the src angle components to the dst angle components (accumulate)
+ * Calculate angle from its summed components
  *
- * @param dst a pointer to the destination components structure
- * @param src a pointer to the source components structure
- * @param add true to add, false to subtract
+ * @param x the sum of the x components
+ * @param y the sum of the y components
+ * @return angle the angle (in degrees)
  */
-static void addAngleComponents(AngleComponents * dst, AngleComponents * src, bool add) {
-	if (!dst || !src)
-		return;
-
-	dst->x += add ? src->x : -src->x;
-	dst->y += add ? src->y : -src->y;
+static double calculateAngle(int64_t x, int64_t y) {
+	return nmea_radian2degree(atan2((double) y, (double) x));
 }
 
 /**
@@ -488,6 +516,8 @@ static void addOrRemoveEntryToFromCumulativeAverage(
 		bool add) {
 	PositionUpdateEntry * cumulative =
 			&positionAverageList->positionAverageCumulative;
+	PositionAverageSums * sums = &positionAverageList->sums;
+	int64_t sign = (add ? 1 : -1);
 
 	if (!add) {
 		assert(positionAverageList->entriesCount >= positionAverageList->entriesMaxCount);
@@ -500,8 +530,6 @@ static void addOrRemoveEntryToFromCumulativeAverage(
 
 		/* do not touch sig */
 		/* do not touch fix */
-
-		/* do not touch satinfo */
 	} else {
 		assert(positionAverageList->entriesCount < positionAverageList->entriesMaxCount);
 		assert(entry == getPositionAverageEntry(positionAverageList, INCOMING));
@@ -515,39 +543,29 @@ static void addOrRemoveEntryToFromCumulativeAverage(
 		/* sig at the end */
 		/* fix at the end */
 
-		/* use the latest satinfo */
-		cumulative->nmeaInfo.satinfo = entry->nmeaInfo.satinfo;
+		/* satinfo: the average uses the one of the newest entry */
 	}
 
 	/* PDOP, HDOP, VDOP */
-	cumulative->nmeaInfo.PDOP += add ? entry->nmeaInfo.PDOP
-			: -entry->nmeaInfo.PDOP;
-	cumulative->nmeaInfo.HDOP += add ? entry->nmeaInfo.HDOP
-			: -entry->nmeaInfo.HDOP;
-	cumulative->nmeaInfo.VDOP += add ? entry->nmeaInfo.VDOP
-			: -entry->nmeaInfo.VDOP;
+	sums->PDOP += sign * toFixedPoint(entry->nmeaInfo.PDOP);
+	sums->HDOP += sign * toFixedPoint(entry->nmeaInfo.HDOP);
+	sums->VDOP += sign * toFixedPoint(entry->nmeaInfo.VDOP);
 
 	/* lat, lon */
-	cumulative->nmeaInfo.lat += add ? entry->nmeaInfo.lat
-			: -entry->nmeaInfo.lat;
-	cumulative->nmeaInfo.lon += add ? entry->nmeaInfo.lon
-			: -entry->nmeaInfo.lon;
+	sums->lat += sign * toFixedPoint(entry->nmeaInfo.lat);
+	sums->lon += sign * toFixedPoint(entry->nmeaInfo.lon);
 
 	/* elv, speed */
-	cumulative->nmeaInfo.elv += add ? entry->nmeaInfo.elv
-			: -entry->nmeaInfo.elv;
-	cumulative->nmeaInfo.speed += add ? entry->nmeaInfo.speed
-			: -entry->nmeaInfo.speed;
+	sums->elv += sign * toFixedPoint(entry->nmeaInfo.elv);
+	sums->speed += sign * toFixedPoint(entry->nmeaInfo.speed);
 
 	/* track, mtrack, magvar */
-	cumulative->nmeaInfo.track += add ? entry->nmeaInfo.track : -entry->nmeaInfo.track;
-	addAngleComponents(&cumulative->track, &entry->track, add);
-
-	cumulative->nmeaInfo.mtrack += add ? entry->nmeaInfo.mtrack : -entry->nmeaInfo.mtrack;
-	addAngleComponents(&cumulative->mtrack, &entry->mtrack, add);
-
-	cumulative->nmeaInfo.magvar += add ? entry->nmeaInfo.magvar : -entry->nmeaInfo.magvar;
-	addAngleComponents(&cumulative->magvar, &entry->magvar, add);
+	sums->trackX += sign * entry->track.x;
+	sums->trackY += sign * entry->track.y;
+	sums->mtrackX += sign * entry->mtrack.x;
+	sums->mtrackY += sign * entry->mtrack.y;
+	sums->magvarX += sign * entry->magvar.x;
+	sums->magvarY += sign * entry->magvar.y;
 
 	/* adjust list count */
 	positionAverageList->entriesCount += (add ? 1 : -1);
@@ -558,41 +576,64 @@ static void addOrRemoveEntryToFromCumulativeAverage(
 
 /**
  Update the average position from the cumulative average position. Basically
- divide all relevant cumulative values by the number of entries in the list.
+ divide all relevant sums by the number of entries in the list.
+
+ Only the fields of the average are written: the average is not rebuilt from
+ a copy of the cumulative entry, which would drag the (large) satinfo along
+ for every sample.
 
  @param positionAverageList
  The position average list
+ @param newest
+ The newest entry in the list
  */
 static void updatePositionAverageFromCumulative(
-		PositionAverageList * positionAverageList) {
-	double divider = positionAverageList->entriesCount;
+		PositionAverageList * positionAverageList, PositionUpdateEntry * newest) {
+	nmeaINFO * average = &positionAverageList->positionAverage.nmeaInfo;
+	nmeaINFO * cumulative = &positionAverageList->positionAverageCumulative.nmeaInfo;
+	PositionAverageSums * sums = &positionAverageList->sums;
+	unsigned long long count = positionAverageList->entriesCount;
 
-	positionAverageList->positionAverage = positionAverageList->positionAverageCumulative;
+	/* present, smask, utc, sig, fix: use from cumulative average */
+	average->present = cumulative->present;
+	average->smask = cumulative->smask;
+	average->utc = cumulative->utc;
+	average->sig = cumulative->sig;
+	average->fix = cumulative->fix;
 
-	/* smask: use from cumulative average */
+	if (count > 1) {
+		average->PDOP = fromFixedPointSum(sums->PDOP, count);
+		average->HDOP = fromFixedPointSum(sums->HDOP, count);
+		average->VDOP = fromFixedPointSum(sums->VDOP, count);
 
-	/* utc: use from cumulative average */
+		average->lat = fromFixedPointSum(sums->lat, count);
+		average->lon = fromFixedPointSum(sums->lon, count);
 
-	/* sig: use from cumulative average */
-	/* fix: use from cumulative average */
+		average->elv = fromFixedPointSum(sums->elv, count);
+		average->speed = fromFixedPointSum(sums->speed, count);
 
-	if (divider > 1.0) {
-		positionAverageList->positionAverage.nmeaInfo.PDOP /= divider;
-		positionAverageList->positionAverage.nmeaInfo.HDOP /= divider;
-		positionAverageList->positionAverage.nmeaInfo.VDOP /= divider;
+		average->track = calculateAngle(sums->trackX, sums->trackY);
+		average->mtrack = calculateAngle(sums->mtrackX, sums->mtrackY);
+		average->magvar = calculateAngle(sums->magvarX, sums->magvarY);
+	} else {
+		/* a single entry is its own average: use its exact values */
+		average->PDOP = newest->nmeaInfo.PDOP;
+		average->HDOP = newest->nmeaInfo.HDOP;
+		average->VDOP = newest->nmeaInfo.VDOP;
 
-		positionAverageList->positionAverage.nmeaInfo.lat /= divider;
-		positionAverageList->positionAverage.nmeaInfo.lon /= divider;
+		average->lat = newest->nmeaInfo.lat;
+		average->lon = newest->nmeaInfo.lon;
 
-		positionAverageList->positionAverage.nmeaInfo.elv /= divider;
-		positionAverageList->positionAverage.nmeaInfo.speed /= divider;
+		average->elv = newest->nmeaInfo.elv;
+		average->speed = newest->nmeaInfo.speed;
 
-		positionAverageList->positionAverage.nmeaInfo.track = calculateAngle(&positionAverageList->positionAverageCumulative.track);
-		positionAverageList->positionAverage.nmeaInfo.mtrack = calculateAngle(&positionAverageList->positionAverageCumulative.mtrack);
-		positionAverageList->positionAverage.nmeaInfo.magvar = calculateAngle(&positionAverageList->positionAverageCumulative.magvar);
+		average->track = newest->nmeaInfo.track;
+		average->mtrack = newest->nmeaInfo.mtrack;
+		average->magvar = newest->nmeaInfo.magvar;
 	}
 
-	/* satinfo: use from average */
+	/* satinfo: use the latest */
+	average->satinfo = newest->nmeaInfo.satinfo;
 }
 
 /**
@@ -606,9 +647,14 @@ static void updatePositionAverageFromCumulative(
  */
 void addNewPositionToAverage(PositionAverageList * positionAverageList,
 		PositionUpdateEntry * newEntry) {
+	PositionUpdateEntry * previous;
+
 	assert (positionAverageList != NULL);
 	assert (newEntry == getPositionAverageEntry(positionAverageList, INCOMING));
 
+	/* the components of unchanged angles are copied from the newest entry */
+	previous = (positionAverageList->entriesCount > 0) ? getPositionAverageEntry(positionAverageList, NEWEST) : NULL;
+
 	if (positionAverageList->entriesCount
 			>= positionAverageList->entriesMaxCount) {
 		/* list is full, so first remove the oldest from the average */
@@ -617,9 +663,18 @@ void addNewPositionToAverage(PositionAverageList * positionAverageList,
 	}
 
 	/* calculate the angle components */
-	calculateAngleComponents(&newEntry->track, nmea_INFO_is_present(newEntry->nmeaInfo.present, TRACK) ? &newEntry->nmeaInfo.track : NULL);
-	calculateAngleComponents(&newEntry->mtrack, nmea_INFO_is_present(newEntry->nmeaInfo.present, MTRACK) ? &newEntry->nmeaInfo.mtrack : NULL);
-	calculateAngleComponents(&newEntry->magvar, nmea_INFO_is_present(newEntry->nmeaInfo.present, MAGVAR) ? &newEntry->nmeaInfo.magvar : NULL);
+	calculateAngleComponents(&newEntry->track,
+			nmea_INFO_is_present(newEntry->nmeaInfo.present, TRACK) ? &newEntry->nmeaInfo.track : NULL,
+			previous ? &previous->track : NULL,
+			(previous && nmea_INFO_is_present(previous->nmeaInfo.present, TRACK)) ? &previous->nmeaInfo.track : NULL);
+	calculateAngleComponents(&newEntry->mtrack,
+			nmea_INFO_is_present(newEntry->nmeaInfo.present, MTRACK) ? &newEntry->nmeaInfo.mtrack : NULL,
+			previous ? &previous->mtrack : NULL,
+			(previous && nmea_INFO_is_present(previous->nmeaInfo.present, MTRACK)) ? &previous->nmeaInfo.mtrack : NULL);
+	calculateAngleComponents(&newEntry->magvar,
+			nmea_INFO_is_present(newEntry->nmeaInfo.present, MAGVAR) ? &newEntry->nmeaInfo.magvar : NULL,
+			previous ? &previous->magvar : NULL,
+			(previous && nmea_INFO_is_present(previous->nmeaInfo.present, MAGVAR)) ? &previous->nmeaInfo.magvar : NULL);
 
 	/* now just add the new position */
 	addOrRemoveEntryToFromCumulativeAverage(positionAverageList, newEntry, true);
@@ -629,5 +684,5 @@ void addNewPositionToAverage(PositionAverageList * positionAverageList,
 			= WRAPINDEX(positionAverageList, NEWESTINDEX(positionAverageList) + 1);
 
 	/* update average position */
-	updatePositionAverageFromCumulative(positionAverageList);
+	updatePositionAverageFromCumulative(positionAverageList, newEntry);
 }
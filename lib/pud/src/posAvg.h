@@ -8,11 +8,19 @@
 /* System includes */
 #include <nmea/info.h>
 #include <stdbool.h>
+#include <stdint.h>
 
-/** Stores angle components */
+/**
+ The scale of the fixed-point values in which the averaging is done: a value v
+ is stored as v * POSAVG_FIXEDPOINT_SCALE, rounded. For latitude/longitude this
+ is a resolution of about 7 mm, for angle components about 3.5e-6 degrees.
+ */
+#define POSAVG_FIXEDPOINT_SCALE (1 << 24)
+
+/** Stores angle components, in fixed-point */
 typedef struct _AngleComponents {
-		double x; /**< cos of the angle (in radians) */
-		double y; /**< sin of the angle (in radians) */
+		int32_t x; /**< cos of the angle (in radians) */
+		int32_t y; /**< sin of the angle (in radians) */
 } AngleComponents;
 
 /** Stores an nmeaINFO entry, used in the averaging */
@@ -71,6 +79,28 @@ typedef struct _PositionUpdateCounters {
 		unsigned long long fix3d; /**< the number of entries with a 3D fix */
 } PositionUpdateCounters;
 
+/**
+ The running sums of the averaged values, in fixed-point. Integer sums are
+ exact: removing an entry takes off exactly what adding it put on, so the sums
+ never drift no matter how long the window runs.
+ */
+typedef struct _PositionAverageSums {
+		int64_t PDOP; /**< the sum of the PDOP values */
+		int64_t HDOP; /**< the sum of the HDOP values */
+		int64_t VDOP; /**< the sum of the VDOP values */
+		int64_t lat; /**< the sum of the latitudes */
+		int64_t lon; /**< the sum of the longitudes */
+		int64_t elv; /**< the sum of the elevations */
+		int64_t speed; /**< the sum of the speeds */
+
+		int64_t trackX; /**< the sum of the track x components */
+		int64_t trackY; /**< the sum of the track y components */
+		int64_t mtrackX; /**< the sum of the mtrack x components */
+		int64_t mtrackY; /**< the sum of the mtrack y components */
+		int64_t magvarX; /**< the sum of the magvar x components */
+		int64_t magvarY; /**< the sum of the magvar y components */
+} PositionAverageSums;
+
 /**
  A list of position updates that are used to determine the average position.
 
@@ -84,9 +114,10 @@ typedef struct _PositionUpdateCounters {
  This means that there is a gap/unused entry in the list between the
  newest entry and the oldest entry, which is the 'incoming entry'.
 
- Note that 'positionAverageCumulative' stores cumulative values for parameters
- for which an average is calculated. The reason is to minimise the number of
- calculations to be performed.
+ Note that 'sums' stores cumulative values for parameters for which an average
+ is calculated. The reason is to minimise the number of calculations to be
+ performed. 'positionAverageCumulative' only holds the present, smask, utc, sig
+ and fix that are determined for the average.
  */
 typedef struct _PositionAverageList {
 		unsigned long long entriesMaxCount; /**< the maximum number of entries in the list */
@@ -95,6 +126,7 @@ typedef struct _PositionAverageList {
 		unsigned long long entriesCount; /**< the number of entries in the list */
 		unsigned long long newestEntryIndex; /**< index of the newest entry in the list (zero-based) */
 		PositionUpdateCounters counters; /**< the counters */
+		PositionAverageSums sums; /**< the fixed-point running sums */
 
 		PositionUpdateEntry positionAverageCumulative; /**< the average position with cumulative values */
 		PositionUpdateEntry positionAverage; /**< the average position */
@@ -14,19 +14,14 @@
 #include "net_olsr.h"
 
 /* System includes */
-#include <nmea/parser.h>
+#include <string.h>
+#include <nmea/parse.h>
+#include <nmea/conversions.h>
 #include <nmea/gmath.h>
 #include <nmea/sentence.h>
 #include <nmea/context.h>
 #include <OlsrdPudWireFormat/wireFormat.h>
 
-/*
- * NMEA parser
- */
-
-/** The NMEA string parser */
-static nmeaPARSER nmeaParser;
-
 /*
  * State
  */
@@ -643,6 +638,127 @@ static void detemineMovingFromPosition(PositionUpdateEntry * avg, PositionUpdate
 	return;
 }
 
+/*
+ * NMEA parsing
+ */
+
+/**
+ Parse a single NMEA sentence, in place, into an nmeaINFO structure. The
+ sentence is not copied: it is tokenized directly from the receive buffer and
+ the parsed packet lives on the stack.
+
+ @param s
+ the sentence, starting at its '$'
+ @param len
+ the length of the sentence, including its tail
+ @param info
+ the nmeaINFO structure to merge the sentence into
+
+ @return
+ - false when the sentence is of an unknown type or could not be parsed
+ - true otherwise
+ */
+static bool parseNmeaSentence(const char * s, int len, nmeaINFO * info) {
+	union {
+		nmeaGPGGA gpgga;
+		nmeaGPGSA gpgsa;
+		nmeaGPGSV gpgsv;
+		nmeaGPRMC gprmc;
+		nmeaGPVTG gpvtg;
+	} packet;
+
+	switch (nmea_parse_get_sentence_type(s + 1, len - 1)) {
+		case GPGGA:
+			if (!nmea_parse_GPGGA(s, len, &packet.gpgga)) {
+				return false;
+			}
+			nmea_GPGGA2info(&packet.gpgga, info);
+			return true;
+
+		case GPGSA:
+			if (!nmea_parse_GPGSA(s, len, &packet.gpgsa)) {
+				return false;
+			}
+			nmea_GPGSA2info(&packet.gpgsa, info);
+			return true;
+
+		case GPGSV:
+			if (!nmea_parse_GPGSV(s, len, &packet.gpgsv)) {
+				return false;
+			}
+			nmea_GPGSV2info(&packet.gpgsv, info);
+			return true;
+
+		case GPRMC:
+			if (!nmea_parse_GPRMC(s, len, &packet.gprmc)) {
+				return false;
+			}
+			nmea_GPRMC2info(&packet.gprmc, info);
+			return true;
+
+		case GPVTG:
+			if (!nmea_parse_GPVTG(s, len, &packet.gpvtg)) {
+				return false;
+			}
+			nmea_GPVTG2info(&packet.gpvtg, info);
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ Parse all NMEA sentences in a receive buffer into an nmeaINFO structure.
+
+ The buffer is walked once: sentence boundaries and checksums are determined
+ in place and every complete sentence with a valid checksum is handed to
+ parseNmeaSentence. Nothing is buffered between calls: every datagram carries
+ complete sentences, and a sentence that is cut off at the end of a datagram
+ could not be completed by the next one anyway (that one must start with a new
+ sentence), so it is dropped.
+
+ @param s
+ the receive buffer
+ @param len
+ the number of bytes in the receive buffer
+ @param info
+ the nmeaINFO structure to fill
+
+ @return
+ the number of sentences that were parsed
+ */
+static int parseNmeaBuffer(const char * s, size_t len, nmeaINFO * info) {
+	const char * end = s + len;
+	int sentences = 0;
+
+	while (s < end) {
+		int sentenceLength;
+		int checksum;
+
+		if (*s != '$') {
+			s = memchr(s, '$', end - s);
+			if (!s) {
+				break;
+			}
+		}
+
+		sentenceLength = nmea_parse_get_sentence_length(s, end - s, &checksum);
+		if (!sentenceLength) {
+			/* incomplete sentence at the end of the buffer */
+			break;
+		}
+
+		if ((checksum >= 0) && parseNmeaSentence(s, sentenceLength, info)) {
+			sentences++;
+		}
+
+		s += sentenceLength;
+	}
+
+	return sentences;
+}
+
 /**
  Update the latest GPS information. This function is called when a packet is
  received from a rxNonOlsr interface, containing one or more NMEA strings with
@@ -679,8 +795,7 @@ bool receiverUpdateGpsInformation(unsigned char * rxBuffer, size_t rxCount) {
 	/* parse all NMEA strings in the rxBuffer into the incoming entry */
 	incomingEntry = getPositionAverageEntry(&positionAverageList, INCOMING);
 	nmea_zero_INFO(&incomingEntry->nmeaInfo);
-	nmea_parse(&nmeaParser, (char *) rxBuffer, rxCount,
-			&incomingEntry->nmeaInfo);
+	(void) parseNmeaBuffer((char *) rxBuffer, rxCount, &incomingEntry->nmeaInfo);
 
 	/* ignore when no useful information */
 	if (incomingEntry->nmeaInfo.smask == GPNON) {
@@ -782,11 +897,6 @@ void updatePositionFromFile(void) {
 bool startReceiver(void) {
 	MovementState externalState;
 
-	if (!nmea_parser_init(&nmeaParser)) {
-		pudError(false, "Could not initialise NMEA parser");
-		return false;
-	}
-
 	/* hook up the NMEA library error callback */
 	nmea_context_set_error_func(&nmea_errors);
 
@@ -842,6 +952,4 @@ void stopReceiver(void) {
 	nmea_zero_INFO(&transmitGpsInformation.txPosition.nmeaInfo);
 	transmitGpsInformation.txGateway = olsr_cnf->main_addr;
 	transmitGpsInformation.positionUpdated = false;
-
-	nmea_parser_destroy(&nmeaParser);
 }
@@ -20,20 +20,57 @@
 #define HAVE_SOCKLEN_T
 
 #include <sys/un.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include "defs.h"
 #include "olsr.h"
 #include "log.h"
 #include "routing_table.h"
+#include "scheduler.h"
+#include "hashing.h"
 
 #include "common.h"
 #include "quagga.h"
 #include "packet.h"
 #include "client.h"
 
+/*
+ * Write queue
+ *
+ * Packets for zebra are not written one by one: they are queued and the
+ * queue is written with a single sendmsg() (a writev() that does not block)
+ * when the socket becomes writable, which the scheduler reports in the same
+ * run in which the packets were queued. Route packets are keyed by prefix, so
+ * that a change of a route that is still queued is coalesced into the queued
+ * message instead of being appended. Only the run of route messages after the
+ * last other packet is coalesced into, so zebra sees all packets in order.
+ */
+struct zmessage {
+  struct zmessage *next;               /* queue order */
+  struct zmessage *hash_next;          /* hash chain, keyed messages only */
+  bool keyed;                          /* is a route message, hashed by prefix */
+  struct olsr_ip_prefix prefix;        /* the prefix of a route message */
+  unsigned char *add;                  /* the packet, or the route add */
+  unsigned char *del;                  /* the route delete */
+};
+
+static struct {
+  struct zmessage *head;
+  struct zmessage **tail;
+  struct zmessage *hash[HASHSIZE];
+  size_t offset;                       /* bytes of the head already written */
+  size_t bytes;                        /* bytes queued */
+  size_t bytes_max;                    /* high-water mark of bytes queued */
+  unsigned int coalesced;              /* route packets absorbed by coalescing */
+  unsigned int blocked;                /* writes that would have blocked */
+  unsigned int forced;                 /* blocking flushes at ZCLIENT_QUEUE_MAX */
+  bool armed;                          /* waiting for the socket to be writable */
+} zqueue = { NULL, &zqueue.head, {NULL}, 0, 0, 0, 0, 0, 0, false };
+
 static void *my_realloc(void *, size_t, const char *);
 static void zclient_connect(void);
+static void zclient_writable(int, void *, unsigned int);
 
 static void *
 my_realloc(void *buf, size_t s, const char *c)
@@ -59,6 +96,11 @@ zclient_connect(void)
     struct sockaddr_un sun;
   } sockaddr;
 
+  zclient_clear();
+  if (zebra.status & STATUS_REGISTERED) {
+    remove_olsr_socket(zebra.sock, NULL, &zclient_writable);
+    zebra.status &= ~STATUS_REGISTERED;
+  }
   if (close(zebra.sock) < 0)
     olsr_exit("(QUAGGA) Could not close socket!", EXIT_FAILURE);
   zebra.sock = socket(zebra.port ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
@@ -81,9 +123,256 @@ zclient_connect(void)
 
   if (ret < 0)
     zebra.status &= ~STATUS_CONNECTED;
+  else {
+    zebra.status |= STATUS_CONNECTED | STATUS_REGISTERED;
+    add_olsr_socket(zebra.sock, NULL, &zclient_writable, NULL, 0);
+  }
+
+}
+
+static size_t
+zpacket_length(const unsigned char *packet)
+{
+  uint16_t len;
+
+  memcpy(&len, packet, sizeof len);
+
+  return ntohs(len);
+}
+
+static unsigned char *
+zmessage_packet(const struct zmessage *m)
+{
+
+  /* an add replaces a route of the same type in zebra, so it supersedes a delete */
+  return m->add ? m->add : m->del;
+}
+
+static void
+zqueue_unhash(struct zmessage *m)
+{
+  struct zmessage **p;
+
+  if (!m->keyed)
+    return;
+
+  for (p = &zqueue.hash[olsr_ip_hashing(&m->prefix.prefix)]; *p; p = &(*p)->hash_next) {
+    if (*p == m) {
+      *p = m->hash_next;
+      break;
+    }
+  }
+  m->keyed = false;
+}
+
+static void
+zqueue_pop(void)
+{
+  struct zmessage *m = zqueue.head;
+
+  zqueue_unhash(m);
+  zqueue.bytes -= zpacket_length(zmessage_packet(m));
+  zqueue.head = m->next;
+  if (!zqueue.head)
+    zqueue.tail = &zqueue.head;
+  zqueue.offset = 0;
+
+  free(m->add);
+  free(m->del);
+  free(m);
+}
+
+static void
+zqueue_arm(bool arm)
+{
+
+  if (arm == zqueue.armed || !(zebra.status & STATUS_REGISTERED))
+    return;
+
+  if (arm)
+    enable_olsr_socket(zebra.sock, NULL, &zclient_writable, SP_IMM_WRITE);
   else
-    zebra.status |= STATUS_CONNECTED;
+    disable_olsr_socket(zebra.sock, NULL, &zclient_writable, SP_IMM_WRITE);
+  zqueue.armed = arm;
+}
+
+static void
+zqueue_append(struct zmessage *m)
+{
+
+  m->next = NULL;
+  *zqueue.tail = m;
+  zqueue.tail = &m->next;
+
+  zqueue.bytes += zpacket_length(zmessage_packet(m));
+  if (zqueue.bytes > zqueue.bytes_max)
+    zqueue.bytes_max = zqueue.bytes;
+}
+
+/* Account a packet that replaces a packet of a queued message */
+static void
+zqueue_replace(struct zmessage *m, unsigned char **slot, unsigned char *packet)
+{
+  size_t before = zpacket_length(zmessage_packet(m));
+
+  free(*slot);
+  *slot = packet;
+  zqueue.bytes = zqueue.bytes - before + zpacket_length(zmessage_packet(m));
+  if (zqueue.bytes > zqueue.bytes_max)
+    zqueue.bytes_max = zqueue.bytes;
+}
+
+/* No queued route message may be coalesced into any more */
+static void
+zqueue_seal(void)
+{
+  struct zmessage *m;
+
+  for (m = zqueue.head; m; m = m->next)
+    zqueue_unhash(m);
+}
+
+static void
+zqueue_enqueued(void)
+{
+
+  if (zqueue.bytes >= ZCLIENT_QUEUE_MAX) {
+    /* backpressure: do not let the queue grow further, wait for zebra */
+    zqueue.forced++;
+    zclient_flush(true);
+  } else
+    zqueue_arm(true);
+}
+
+void
+zclient_clear(void)
+{
 
+  while (zqueue.head)
+    zqueue_pop();
+  zqueue_arm(false);
+}
+
+void
+zclient_flush(bool block)
+{
+  struct iovec iov[ZCLIENT_IOV_MAX];
+  struct msghdr msg;
+  struct zmessage *m;
+  ssize_t ret;
+  size_t len;
+  int n;
+
+  if (!(zebra.status & STATUS_CONNECTED)) {
+    /* reconnecting resends the whole table */
+    zclient_clear();
+    return;
+  }
+
+  while (zqueue.head) {
+    for (m = zqueue.head, n = 0; m && n < ZCLIENT_IOV_MAX; m = m->next, n++) {
+      iov[n].iov_base = zmessage_packet(m);
+      iov[n].iov_len = zpacket_length(zmessage_packet(m));
+    }
+    iov[0].iov_base = (unsigned char *)iov[0].iov_base + zqueue.offset;
+    iov[0].iov_len -= zqueue.offset;
+
+    memset(&msg, 0, sizeof msg);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = n;
+
+    ret = sendmsg(zebra.sock, &msg, block ? 0 : MSG_DONTWAIT);
+    if (ret < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN) {
+        zqueue.blocked++;
+        break;
+      }
+      OLSR_PRINTF(1, "(QUAGGA) Disconnected from zebra.\n");
+      zebra.status &= ~STATUS_CONNECTED;
+      /* TODO: Remove HNAs added from redistribution */
+      zclient_clear();
+      return;
+    }
+
+    while (ret > 0) {
+      len = zpacket_length(zmessage_packet(zqueue.head)) - zqueue.offset;
+      if ((size_t)ret < len) {
+        /* the head is on its way: it can no longer be coalesced into */
+        zqueue.offset += ret;
+        zqueue_unhash(zqueue.head);
+        break;
+      }
+      ret -= len;
+      zqueue_pop();
+    }
+  }
+
+  if (!zqueue.head && zqueue.blocked) {
+    OLSR_PRINTF(3, "(QUAGGA) Write queue drained: %lu bytes max, %u coalesced, %u blocked, %u forced\n",
+                (unsigned long)zqueue.bytes_max, zqueue.coalesced, zqueue.blocked, zqueue.forced);
+  }
+
+  zqueue_arm(zqueue.head != NULL);
+}
+
+static void
+zclient_writable(int fd __attribute__ ((unused)), void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+
+  zclient_flush(false);
+}
+
+int
+zclient_queue_route(const struct olsr_ip_prefix *prefix, unsigned char *packet, bool add)
+{
+  struct zmessage *m;
+  uint32_t hash;
+
+  if (!(zebra.status & STATUS_CONNECTED)) {
+    free(packet);
+    return 0;
+  }
+
+  packet = my_realloc(packet, zpacket_length(packet), "QUAGGA: Shrink route packet");
+
+  hash = olsr_ip_hashing(&prefix->prefix);
+  for (m = zqueue.hash[hash]; m; m = m->hash_next) {
+    if (m->prefix.prefix_len == prefix->prefix_len && ipequal(&m->prefix.prefix, &prefix->prefix))
+      break;
+  }
+
+  if (m) {
+    zqueue.coalesced++;
+    if (add) {
+      /* the newest add wins, a queued delete stays for a later delete */
+      zqueue_replace(m, &m->add, packet);
+    } else if (m->add) {
+      /* withdraw the queued add: only the route zebra has (if any) remains */
+      if (m->del)
+        free(packet);
+      else
+        m->del = packet;
+      zqueue_replace(m, &m->add, NULL);
+    } else {
+      /* delete of a route that is already being deleted */
+      free(packet);
+    }
+    return 0;
+  }
+
+  m = olsr_malloc(sizeof *m, "QUAGGA: New queued message");
+  m->keyed = true;
+  m->prefix = *prefix;
+  m->add = add ? packet : NULL;
+  m->del = add ? NULL : packet;
+  m->hash_next = zqueue.hash[hash];
+  zqueue.hash[hash] = m;
+  zqueue_append(m);
+  zqueue_enqueued();
+
+  return 0;
 }
 
 void
@@ -109,37 +398,21 @@ zclient_reconnect(void)
 int
 zclient_write(unsigned char *options)
 {
-  unsigned char *pnt;
-  uint16_t len;
-  int ret;
+  struct zmessage *m;
 
-  if (!(zebra.status & STATUS_CONNECTED))
+  if (!(zebra.status & STATUS_CONNECTED)) {
+    free(options);
     return 0;
-
-  pnt = options;
-  memcpy(&len, pnt, sizeof len);
-
-  len = ntohs(len);
-
-  do {
-    ret = write(zebra.sock, pnt, len);
-    if (ret < 0) {
-      if ((errno == EINTR) || (errno == EAGAIN)) {
-        errno = 0;
-        ret = 0;
-        continue;
-      } else {
-        OLSR_PRINTF(1, "(QUAGGA) Disconnected from zebra.\n");
-        zebra.status &= ~STATUS_CONNECTED;
-        /* TODO: Remove HNAs added from redistribution */
-        free(options);
-        return -1;
-      }
-    }
-    pnt = pnt + ret;
   }
-  while ((len -= ret));
-  free(options);
+
+  m = olsr_malloc(sizeof *m, "QUAGGA: New queued message");
+  m->keyed = false;
+  m->add = my_realloc(options, zpacket_length(options), "QUAGGA: Shrink packet");
+  m->del = NULL;
+  /* later route packets must go after this one */
+  zqueue_seal();
+  zqueue_append(m);
+  zqueue_enqueued();
 
   return 0;
 }
@@ -175,6 +448,7 @@ zclient_read(ssize_t * size)
     bytes = read(zebra.sock, buf + *size, bufsize - *size);
     /* handle broken packet */
     if (!bytes) {
+      (void)fcntl(zebra.sock, F_SETFL, sockstatus);
       free(buf);
       return NULL;
     }
@@ -186,6 +460,7 @@ zclient_read(ssize_t * size)
         zebra.status &= ~STATUS_CONNECTED;
         /* TODO: Remove HNAs added from redistribution */
       }
+      (void)fcntl(zebra.sock, F_SETFL, sockstatus);
       free(buf);
       return NULL;
     }
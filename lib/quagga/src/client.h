@@ -18,12 +18,20 @@
  * ------------------------------------------------------------------------- */
 
 #define STATUS_CONNECTED 1
+#define STATUS_REGISTERED 2
 
 /* Buffer size */
 #define BUFSIZE 1024
 
+/* Write queue: packets per sendmsg() and bytes queued before writes block */
+#define ZCLIENT_IOV_MAX 64
+#define ZCLIENT_QUEUE_MAX (256 * 1024)
+
 void zclient_reconnect(void);
 int zclient_write(unsigned char *);
+int zclient_queue_route(const struct olsr_ip_prefix *, unsigned char *, bool);
+void zclient_flush(bool);
+void zclient_clear(void);
 unsigned char *zclient_read(ssize_t *);
 
 /*
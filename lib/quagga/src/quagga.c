@@ -50,6 +50,7 @@ zebra_fini(void)
     OLSR_FOR_ALL_RT_ENTRIES_END(tmp);
   }
   zebra_redistribute(ZEBRA_REDISTRIBUTE_DELETE);
+  zclient_flush(true);
 
 }
 
@@ -98,7 +99,7 @@ zebra_addroute(const struct rt_entry *r)
     route.distance = zebra.distance;
   }
 
-  retval = zclient_write(zpacket_route(olsr_cnf->ip_version == AF_INET ? ZEBRA_IPV4_ROUTE_ADD : ZEBRA_IPV6_ROUTE_ADD, &route));
+  retval = zclient_queue_route(&r->rt_dst, zpacket_route(olsr_cnf->ip_version == AF_INET ? ZEBRA_IPV4_ROUTE_ADD : ZEBRA_IPV6_ROUTE_ADD, &route), true);
   if(!retval && zebra.options & OPTION_ROUTE_ADDITIONAL)
     retval = olsr_cnf->ip_version == AF_INET ? zebra.orig_addroute_function(r) : zebra.orig_addroute6_function(r);
 
@@ -153,7 +154,7 @@ zebra_delroute(const struct rt_entry *r)
     route.distance = zebra.distance;
   }
 
-  retval = zclient_write(zpacket_route(olsr_cnf->ip_version == AF_INET ? ZEBRA_IPV4_ROUTE_DELETE : ZEBRA_IPV6_ROUTE_DELETE, &route));
+  retval = zclient_queue_route(&r->rt_dst, zpacket_route(olsr_cnf->ip_version == AF_INET ? ZEBRA_IPV4_ROUTE_DELETE : ZEBRA_IPV6_ROUTE_DELETE, &route), false);
   if(!retval && zebra.options & OPTION_ROUTE_ADDITIONAL)
     retval = olsr_cnf->ip_version == AF_INET ? zebra.orig_delroute_function(r) : zebra.orig_delroute6_function(r);
 
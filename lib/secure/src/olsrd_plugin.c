@@ -37,6 +37,7 @@
 
 #include "olsrd_plugin.h"
 #include "olsrd_secure.h"
+#include "secure_mac.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -69,7 +70,7 @@ my_init(void)
   /* Print plugin info to stdout */
   /* We cannot use olsr_printf yet! */
   printf("%s\n", MOD_DESC);
-  printf("[ENC]Accepted parameter pairs: (\"Keyfile\" <FILENAME>)\n");
+  printf("[ENC]Accepted parameter pairs: (\"Keyfile\" <FILENAME>) (\"Mac\" <md5|sha1|hmac-sha256|siphash>)\n");
 }
 
 /**
@@ -96,8 +97,19 @@ store_string(const char *value, void *data, set_plugin_parameter_addon addon __a
   return 0;
 }
 
+static int
+set_mac(const char *value, void *data __attribute__ ((unused)), set_plugin_parameter_addon addon __attribute__ ((unused)))
+{
+  if (!secure_mac_select(value)) {
+    fprintf(stderr, "[ENC]Unknown signature scheme \"%s\"\n", value);
+    return 1;
+  }
+  return 0;
+}
+
 static const struct olsrd_plugin_parameters plugin_parameters[] = {
   {.name = "keyfile",.set_plugin_parameter = &store_string,.data = keyfile},
+  {.name = "mac",.set_plugin_parameter = &set_mac,.data = NULL},
 };
 
 void
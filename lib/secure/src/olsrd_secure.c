@@ -62,13 +62,14 @@
 #include "scheduler.h"
 #include "net_olsr.h"
 
+#include "secure_mac.h"
+
 #ifdef USE_OPENSSL
 
 /* OpenSSL stuff */
 #include <openssl/sha.h>
 
 #define CHECKSUM SHA1
-#define SCHEME   SHA1_INCLUDING_KEY
 
 #else /* USE_OPENSSL */
 
@@ -86,7 +87,6 @@ MD5_checksum(const uint8_t * data, const uint16_t data_len, uint8_t * hashbuf)
 }
 
 #define CHECKSUM MD5_checksum
-#define SCHEME   MD5_INCLUDING_KEY
 
 #endif /* USE_OPENSSL */
 
@@ -116,14 +116,14 @@ static struct timeval now;
 /* Timestamp node */
 struct stamp {
   union olsr_ip_addr addr;
+  uint8_t used;
   /* Timestamp difference */
   int diff;
   uint32_t challenge;
   uint8_t validated;
   uint32_t valtime;                     /* Validity time */
   uint32_t conftime;                    /* Reconfiguration time */
-  struct stamp *prev;
-  struct stamp *next;
+  uint32_t challenge_time;              /* When our last challenge/response went out */
 };
 
 /* Seconds to cache a valid timestamp entry */
@@ -132,7 +132,33 @@ struct stamp {
 /* Seconds to cache a not verified timestamp entry */
 #define EXCHANGE_HOLD_TIME 5
 
-static struct stamp timestamps[HASHSIZE];
+/*
+ * Open addressed (linear probing) timestamp table.
+ * The size must be a power of 2, it is never filled beyond
+ * 3/4 to keep the probe sequences short. A full table makes
+ * room by evicting the entry that expires first.
+ */
+#define STAMP_TABLE_BITS  10
+#define STAMP_TABLE_SIZE  (1 << STAMP_TABLE_BITS)
+#define STAMP_TABLE_LIMIT (STAMP_TABLE_SIZE / 4 * 3)
+
+/* Slots aged per timer run */
+#define STAMP_AGING_BATCH 256
+
+static struct stamp timestamps[STAMP_TABLE_SIZE];
+static unsigned int stamp_count;
+static unsigned int stamp_aging_cursor;
+
+/* Challenge/response counters, reported after every aging round */
+static struct {
+  uint32_t challenges;                  /* challenges sent */
+  uint32_t limited;                     /* challenges suppressed, exchange in progress */
+  uint32_t evicted;                     /* entries evicted from a full table */
+  uint32_t responses;                   /* completed exchanges */
+  uint32_t latency_min;                 /* ms */
+  uint32_t latency_max;                 /* ms */
+  uint64_t latency_sum;                 /* ms */
+} secure_stats;
 
 char keyfile[FILENAME_MAX + 1];
 char aes_key[16];
@@ -151,6 +177,9 @@ static char *secure_preprocessor(char *packet, struct interface *olsr_if, union
 static void timeout_timestamps(void *);
 static int check_timestamp(struct interface *olsr_if, const union olsr_ip_addr *, time_t);
 static struct stamp *lookup_timestamp_entry(const union olsr_ip_addr *);
+static struct stamp *create_timestamp_entry(const union olsr_ip_addr *);
+static void delete_timestamp_entry(uint32_t);
+static void exchange_completed(struct stamp *);
 static int read_key_from_file(const char *);
 
 /**
@@ -166,10 +195,10 @@ secure_plugin_init(void)
   int i;
 
   /* Initialize the timestamp database */
-  for (i = 0; i < HASHSIZE; i++) {
-    timestamps[i].next = &timestamps[i];
-    timestamps[i].prev = &timestamps[i];
-  }
+  memset(timestamps, 0, sizeof(timestamps));
+  stamp_count = 0;
+  stamp_aging_cursor = 0;
+  memset(&secure_stats, 0, sizeof(secure_stats));
   olsr_printf(1, "Timestamp database initialized\n");
 
   if (!strlen(keyfile))
@@ -186,6 +215,10 @@ secure_plugin_init(void)
     exit(1);
   }
 
+  /* Expand the key once for the signature scheme */
+  secure_mac->set_key((const uint8_t *)aes_key, KEYLENGTH);
+  olsr_printf(1, "[ENC]Signing with %s\n", secure_mac->name);
+
   /* Register the packet transform function */
   add_ptf(&add_signature);
 
@@ -274,8 +307,8 @@ check_auth(struct interface *olsr_if, char *pck, int *size __attribute__ ((unuse
 
 /**
  * Packet transform function
- * Build a SHA-1/MD5 hash of the original message
- * + the signature message(-digest) + key
+ * Sign the original message + the signature
+ * message(-digest) with the configured scheme
  *
  * Then add the signature message to the packet and
  * increase the size
@@ -308,7 +341,7 @@ add_signature(uint8_t * pck, int *size)
 
   /* Fill subheader */
   msg->sig.type = ONE_CHECKSUM;
-  msg->sig.algorithm = SCHEME;
+  msg->sig.algorithm = secure_mac->algorithm;
   memset(&msg->sig.reserved, 0, 2);
 
   /* Add timestamp */
@@ -319,17 +352,8 @@ add_signature(uint8_t * pck, int *size)
   /* Set the new size */
   *size += sizeof(struct s_olsrmsg);
 
-  {
-    uint8_t checksum_cache[1512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, pck, *size - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[*size - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (*size - SIGNATURE_SIZE) + KEYLENGTH, &pck[*size - SIGNATURE_SIZE]);
-  }
+  /* Sign the message in place */
+  secure_mac->sign(pck, *size - SIGNATURE_SIZE, &pck[*size - SIGNATURE_SIZE]);
 
 #ifdef DEBUG
   olsr_printf(1, "Signature message:\n");
@@ -356,11 +380,11 @@ static int
 validate_packet(struct interface *olsr_if, const char *pck, int *size)
 {
   int packetsize;
-  uint8_t sha1_hash[SIGNATURE_SIZE];
   const struct s_olsrmsg *sig;
   time_t rec_time;
 
 #ifdef DEBUG
+  uint8_t sha1_hash[SIGNATURE_SIZE];
   unsigned int i;
   int j;
   const uint8_t *sigmsg;
@@ -400,37 +424,12 @@ validate_packet(struct interface *olsr_if, const char *pck, int *size)
   }
 
   /* Check scheme and type */
-  switch (sig->sig.type) {
-  case (ONE_CHECKSUM):
-    switch (sig->sig.algorithm) {
-    case (SCHEME):
-      goto one_checksum_SHA;    /* Ahhh... fix this */
-      break;
-    default:
-    	break;
-    }
-    break;
-
-  default:
+  if (sig->sig.type != ONE_CHECKSUM || sig->sig.algorithm != secure_mac->algorithm) {
     olsr_printf(1, "[ENC]Unsupported sceme: %d enc: %d!\n", sig->sig.type, sig->sig.algorithm);
     return 0;
   }
   //olsr_printf(1, "Packet sane...\n");
 
-one_checksum_SHA:
-
-  {
-    uint8_t checksum_cache[1512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, pck, *size - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[*size - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* generate SHA-1 */
-    CHECKSUM(checksum_cache, *size - SIGNATURE_SIZE + KEYLENGTH, sha1_hash);
-  }
-
 #ifdef DEBUG
   olsr_printf(1, "Recevied hash:\n");
 
@@ -443,6 +442,7 @@ one_checksum_SHA:
 
   olsr_printf(1, "Calculated hash:\n");
 
+  secure_mac->sign((const uint8_t *)pck, *size - SIGNATURE_SIZE, sha1_hash);
   sigmsg = sha1_hash;
 
   for (i = 0; i < SIGNATURE_SIZE; i++) {
@@ -451,7 +451,8 @@ one_checksum_SHA:
   olsr_printf(1, "\n");
 #endif /* DEBUG */
 
-  if (memcmp(sha1_hash, sig->sig.signature, SIGNATURE_SIZE) != 0) {
+  /* Verify in place, the packet is not copied */
+  if (!secure_mac_verify((const uint8_t *)pck, *size - SIGNATURE_SIZE, sig->sig.signature)) {
     olsr_printf(1, "[ENC]Signature missmatch\n");
     return 0;
   }
@@ -491,6 +492,9 @@ check_timestamp(struct interface *olsr_if, const union olsr_ip_addr *originator,
 
   if (!entry->validated) {
     olsr_printf(1, "[ENC]Message from non-validated host!\n");
+
+    /* Our challenge or their response may have been lost */
+    send_challenge(olsr_if, originator);
     return 0;
   }
 
@@ -528,9 +532,19 @@ send_challenge(struct interface *olsr_if, const union olsr_ip_addr *new_host)
 {
   struct challengemsg cmsg;
   struct stamp *entry;
-  uint32_t challenge, hash;
+  uint32_t challenge;
   struct ipaddr_str buf;
 
+  /* Only one exchange per node at a time */
+  entry = lookup_timestamp_entry(new_host);
+  if (entry != NULL && !TIMED_OUT(entry->conftime)) {
+    secure_stats.limited++;
+    return 0;
+  }
+  if (entry == NULL) {
+    entry = create_timestamp_entry(new_host);
+  }
+
   olsr_printf(1, "[ENC]Building CHALLENGE message\n");
 
   /* Set the size including OLSR packet size */
@@ -555,17 +569,8 @@ send_challenge(struct interface *olsr_if, const union olsr_ip_addr *new_host)
 
   olsr_printf(3, "[ENC]Size: %lu\n", (unsigned long)sizeof(struct challengemsg));
 
-  {
-    uint8_t checksum_cache[(sizeof(cmsg) - sizeof(cmsg.signature)) + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, &cmsg, sizeof(cmsg) - sizeof(cmsg.signature));
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(cmsg) - sizeof(cmsg.signature)], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(cmsg) - sizeof(cmsg.signature)) + KEYLENGTH, cmsg.signature);
-  }
+  /* Sign the message in place */
+  secure_mac->sign((const uint8_t *)&cmsg, sizeof(cmsg) - sizeof(cmsg.signature), cmsg.signature);
   olsr_printf(3, "[ENC]Sending timestamp request to %s challenge 0x%x\n",
 	      olsr_ip_to_string(&buf, new_host), challenge);
 
@@ -575,25 +580,15 @@ send_challenge(struct interface *olsr_if, const union olsr_ip_addr *new_host)
   /* Send the request */
   net_output(olsr_if);
 
-  /* Create new entry */
-  entry = malloc(sizeof(struct stamp));
-
   entry->diff = 0;
   entry->validated = 0;
   entry->challenge = challenge;
-
-  memcpy(&entry->addr, new_host, olsr_cnf->ipsize);
+  entry->challenge_time = now_times;
 
   /* update validtime - not validated */
   entry->conftime = GET_TIMESTAMP(EXCHANGE_HOLD_TIME * 1000);
 
-  hash = olsr_ip_hashing(new_host);
-
-  /* Queue */
-  timestamps[hash].next->prev = entry;
-  entry->next = timestamps[hash].next;
-  timestamps[hash].next = entry;
-  entry->prev = &timestamps[hash];
+  secure_stats.challenges++;
 
   return 1;
 
@@ -621,19 +616,7 @@ parse_cres(struct interface *olsr_if, char *in_msg)
 
   /* Check signature */
 
-  {
-    uint8_t checksum_cache[1512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, msg, sizeof(struct c_respmsg) - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(struct c_respmsg) - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(struct c_respmsg) - SIGNATURE_SIZE) + KEYLENGTH, sha1_hash);
-  }
-
-  if (memcmp(sha1_hash, &msg->signature, SIGNATURE_SIZE) != 0) {
+  if (!secure_mac_verify((const uint8_t *)msg, sizeof(struct c_respmsg) - SIGNATURE_SIZE, msg->signature)) {
     olsr_printf(1, "[ENC]Signature missmatch in challenge-response!\n");
     return 0;
   }
@@ -681,6 +664,7 @@ parse_cres(struct interface *olsr_if, char *in_msg)
 
   entry->challenge = 0;
   entry->validated = 1;
+  exchange_completed(entry);
 
   /* Bring timestamp to host order before arith. 2011/05/31 AE5AE */
   entry->diff = now.tv_sec - ntohl(msg->timestamp);
@@ -722,19 +706,7 @@ parse_rres(char *in_msg)
 
   /* Check signature */
 
-  {
-    uint8_t checksum_cache[1512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, msg, sizeof(struct r_respmsg) - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(struct r_respmsg) - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(struct r_respmsg) - SIGNATURE_SIZE) + KEYLENGTH, sha1_hash);
-  }
-
-  if (memcmp(sha1_hash, &msg->signature, SIGNATURE_SIZE) != 0) {
+  if (!secure_mac_verify((const uint8_t *)msg, sizeof(struct r_respmsg) - SIGNATURE_SIZE, msg->signature)) {
     olsr_printf(1, "[ENC]Signature missmatch in response-response!\n");
     return 0;
   }
@@ -780,6 +752,7 @@ parse_rres(char *in_msg)
 
   entry->challenge = 0;
   entry->validated = 1;
+  exchange_completed(entry);
 
   /* Bring timestamp to host order before arith. 2011/05/31 AE5AE */
   entry->diff = now.tv_sec - ntohl(msg->timestamp);
@@ -798,9 +771,7 @@ int
 parse_challenge(struct interface *olsr_if, char *in_msg)
 {
   struct challengemsg *msg;
-  uint8_t sha1_hash[SIGNATURE_SIZE];
   struct stamp *entry;
-  uint32_t hash;
   struct ipaddr_str buf;
 
   msg = (struct challengemsg *)ARM_NOWARN_ALIGN(in_msg);
@@ -813,19 +784,7 @@ parse_challenge(struct interface *olsr_if, char *in_msg)
     return 0;
   }
 
-  /* Create entry if not registered */
-  if ((entry = lookup_timestamp_entry((const union olsr_ip_addr *)&msg->originator)) == NULL) {
-    entry = malloc(sizeof(struct stamp));
-    memcpy(&entry->addr, &msg->originator, olsr_cnf->ipsize);
-
-    hash = olsr_ip_hashing((union olsr_ip_addr *)&msg->originator);
-
-    /* Queue */
-    timestamps[hash].next->prev = entry;
-    entry->next = timestamps[hash].next;
-    timestamps[hash].next = entry;
-    entry->prev = &timestamps[hash];
-  } else {
+  if ((entry = lookup_timestamp_entry((const union olsr_ip_addr *)&msg->originator)) != NULL) {
     /* Check configuration timeout */
     if (!TIMED_OUT(entry->conftime)) {
       /* If registered - do not accept! */
@@ -840,24 +799,18 @@ parse_challenge(struct interface *olsr_if, char *in_msg)
 
   /* Check signature */
 
-  {
-    uint8_t checksum_cache[1512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, msg, sizeof(struct challengemsg) - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(struct challengemsg) - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(struct challengemsg) - SIGNATURE_SIZE) + KEYLENGTH, sha1_hash);
-  }
-  if (memcmp(sha1_hash, &msg->signature, SIGNATURE_SIZE) != 0) {
+  if (!secure_mac_verify((const uint8_t *)msg, sizeof(struct challengemsg) - SIGNATURE_SIZE, msg->signature)) {
     olsr_printf(1, "[ENC]Signature missmatch in challenge!\n");
     return 0;
   }
 
   olsr_printf(3, "[ENC]Signature verified\n");
 
+  /* Create entry if not registered, only now that the challenge is authentic */
+  if (entry == NULL) {
+    entry = create_timestamp_entry((const union olsr_ip_addr *)&msg->originator);
+  }
+
   entry->diff = 0;
   entry->validated = 0;
 
@@ -893,6 +846,7 @@ send_cres(struct interface *olsr_if, union olsr_ip_addr *to, union olsr_ip_addr
   challenge |= rand();
 
   entry->challenge = challenge;
+  entry->challenge_time = now_times;
 
   olsr_printf(3, "[ENC]Challenge-response: 0x%x\n", challenge);
 
@@ -936,17 +890,8 @@ send_cres(struct interface *olsr_if, union olsr_ip_addr *to, union olsr_ip_addr
 
   /* Now create the digest of the message and the key */
 
-  {
-    uint8_t checksum_cache[(sizeof(crmsg) - sizeof(crmsg.signature)) + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, &crmsg, sizeof(crmsg) - sizeof(crmsg.signature));
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(crmsg) - sizeof(crmsg.signature)], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(crmsg) - sizeof(crmsg.signature)) + KEYLENGTH, crmsg.signature);
-  }
+  /* Sign the message in place */
+  secure_mac->sign((const uint8_t *)&crmsg, sizeof(crmsg) - sizeof(crmsg.signature), crmsg.signature);
 
   olsr_printf(3, "[ENC]Sending challenge response to %s challenge 0x%x\n", olsr_ip_to_string(&buf, to), challenge);
 
@@ -1010,17 +955,8 @@ send_rres(struct interface *olsr_if, union olsr_ip_addr *to, union olsr_ip_addr
 
   /* Now create the digest of the message and the key */
 
-  {
-    uint8_t checksum_cache[(sizeof(rrmsg) - sizeof(rrmsg.signature)) + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, &rrmsg, sizeof(rrmsg) - sizeof(rrmsg.signature));
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(rrmsg) - sizeof(rrmsg.signature)], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(rrmsg) - sizeof(rrmsg.signature)) + KEYLENGTH, rrmsg.signature);
-  }
+  /* Sign the message in place */
+  secure_mac->sign((const uint8_t *)&rrmsg, sizeof(rrmsg) - sizeof(rrmsg.signature), rrmsg.signature);
 
   olsr_printf(3, "[ENC]Sending response response to %s\n", olsr_ip_to_string(&buf, to));
 
@@ -1033,66 +969,184 @@ send_rres(struct interface *olsr_if, union olsr_ip_addr *to, union olsr_ip_addr
   return 1;
 }
 
+static uint32_t
+stamp_hash(const union olsr_ip_addr *adr)
+{
+  uint32_t key = adr->v4.s_addr;
+
+  if (olsr_cnf->ip_version == AF_INET6) {
+    uint32_t w[4];
+
+    memcpy(w, &adr->v6, sizeof(w));
+    key = w[0] ^ w[1] ^ w[2] ^ w[3];
+  }
+
+  /* Fibonacci hashing, the top bits are the well mixed ones */
+  return (key * 0x9e3779b9U) >> (32 - STAMP_TABLE_BITS);
+}
+
 static struct stamp *
 lookup_timestamp_entry(const union olsr_ip_addr *adr)
 {
-  uint32_t hash;
-  struct stamp *entry;
+  uint32_t idx;
+
+  for (idx = stamp_hash(adr); timestamps[idx].used; idx = (idx + 1) & (STAMP_TABLE_SIZE - 1)) {
+    if (memcmp(&timestamps[idx].addr, adr, olsr_cnf->ipsize) == 0) {
+      return &timestamps[idx];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * Milliseconds until an entry times out, negative once it has
+ */
+static int32_t
+stamp_time_left(const struct stamp *entry)
+{
+  int32_t val = (int32_t)(entry->valtime - now_times);
+  int32_t conf = (int32_t)(entry->conftime - now_times);
+
+  return val > conf ? val : conf;
+}
+
+/**
+ * Make room in a full table: delete the entry that times
+ * out first, or any one that already has
+ */
+static void
+evict_timestamp_entry(void)
+{
+  uint32_t idx, victim = 0;
+  int32_t left, victim_left = INT32_MAX;
   struct ipaddr_str buf;
 
-  hash = olsr_ip_hashing(adr);
+  for (idx = 0; idx < STAMP_TABLE_SIZE && victim_left >= 0; idx++) {
+    if (timestamps[idx].used && (left = stamp_time_left(&timestamps[idx])) < victim_left) {
+      victim = idx;
+      victim_left = left;
+    }
+  }
+
+  secure_stats.evicted++;
+  olsr_printf(1, "[ENC]Timestamp table full (%u entries), evicting %s\n", stamp_count,
+              olsr_ip_to_string(&buf, &timestamps[victim].addr));
+  delete_timestamp_entry(victim);
+}
+
+/**
+ * Claim a slot for a new node, evicting another one if the table is full
+ */
+static struct stamp *
+create_timestamp_entry(const union olsr_ip_addr *adr)
+{
+  struct stamp *entry;
+  uint32_t idx;
+
+  if (stamp_count >= STAMP_TABLE_LIMIT) {
+    evict_timestamp_entry();
+  }
+
+  idx = stamp_hash(adr);
+  while (timestamps[idx].used) {
+    idx = (idx + 1) & (STAMP_TABLE_SIZE - 1);
+  }
+
+  entry = &timestamps[idx];
+  memset(entry, 0, sizeof(*entry));
+  memcpy(&entry->addr, adr, olsr_cnf->ipsize);
+  entry->used = 1;
+  entry->valtime = GET_TIMESTAMP(0);
+  entry->conftime = GET_TIMESTAMP(0);
+  stamp_count++;
+
+  return entry;
+}
+
+/**
+ * Free a slot. Later members of its probe sequence are
+ * shifted back so lookups never need tombstones.
+ */
+static void
+delete_timestamp_entry(uint32_t hole)
+{
+  uint32_t idx, home;
+
+  timestamps[hole].used = 0;
+  stamp_count--;
 
-  for (entry = timestamps[hash].next; entry != &timestamps[hash]; entry = entry->next) {
-    if (memcmp(&entry->addr, adr, olsr_cnf->ipsize) == 0) {
-      olsr_printf(3, "[ENC]Match for %s\n", olsr_ip_to_string(&buf, adr));
-      return entry;
+  for (idx = (hole + 1) & (STAMP_TABLE_SIZE - 1); timestamps[idx].used; idx = (idx + 1) & (STAMP_TABLE_SIZE - 1)) {
+    home = stamp_hash(&timestamps[idx].addr);
+
+    /* Can the entry move back to the hole without leaving its probe sequence? */
+    if (((idx - home) & (STAMP_TABLE_SIZE - 1)) >= ((idx - hole) & (STAMP_TABLE_SIZE - 1))) {
+      timestamps[hole] = timestamps[idx];
+      timestamps[idx].used = 0;
+      hole = idx;
     }
   }
+}
 
-  olsr_printf(1, "[ENC]No match for %s\n", olsr_ip_to_string(&buf, adr));
+/**
+ * Account the round trip of a finished challenge/response exchange
+ */
+static void
+exchange_completed(struct stamp *entry)
+{
+  uint32_t latency = now_times - entry->challenge_time;
 
-  return NULL;
+  if (secure_stats.responses == 0 || latency < secure_stats.latency_min) {
+    secure_stats.latency_min = latency;
+  }
+  if (latency > secure_stats.latency_max) {
+    secure_stats.latency_max = latency;
+  }
+  secure_stats.latency_sum += latency;
+  secure_stats.responses++;
 }
 
 /**
  *Find timed out entries and delete them
  *
+ *Only a batch of the table is aged per run, a full
+ *round takes STAMP_TABLE_SIZE / STAMP_AGING_BATCH runs.
+ *
  *@return nada
  */
 void
 timeout_timestamps(void *foo __attribute__ ((unused)))
 {
-  struct stamp *tmp_list;
-  struct stamp *entry_to_delete;
-  int idx;
+  unsigned int n;
 
   /* Update our local timestamp */
   gettimeofday(&now, NULL);
 
-  for (idx = 0; idx < HASHSIZE; idx++) {
-    tmp_list = timestamps[idx].next;
-    /*Traverse MID list */
-    while (tmp_list != &timestamps[idx]) {
-      /*Check if the entry is timed out */
-      if ((TIMED_OUT(tmp_list->valtime)) && (TIMED_OUT(tmp_list->conftime))) {
-        struct ipaddr_str buf;
-        entry_to_delete = tmp_list;
-        tmp_list = tmp_list->next;
-
-        olsr_printf(1, "[ENC]timestamp info for %s timed out.. deleting it\n",
-		    olsr_ip_to_string(&buf, &entry_to_delete->addr));
-
-        /*Delete it */
-        entry_to_delete->next->prev = entry_to_delete->prev;
-        entry_to_delete->prev->next = entry_to_delete->next;
-
-        free(entry_to_delete);
-      } else
-        tmp_list = tmp_list->next;
+  for (n = 0; n < STAMP_AGING_BATCH; n++) {
+    struct stamp *entry = &timestamps[stamp_aging_cursor];
+
+    /*Check if the entry is timed out */
+    if (entry->used && TIMED_OUT(entry->valtime) && TIMED_OUT(entry->conftime)) {
+      struct ipaddr_str buf;
+
+      olsr_printf(1, "[ENC]timestamp info for %s timed out.. deleting it\n", olsr_ip_to_string(&buf, &entry->addr));
+
+      /*Delete it, the slot may be refilled by the shift so look again */
+      delete_timestamp_entry(stamp_aging_cursor);
+      if (entry->used) {
+        continue;
+      }
     }
+    stamp_aging_cursor = (stamp_aging_cursor + 1) & (STAMP_TABLE_SIZE - 1);
   }
 
-  return;
+  if (stamp_aging_cursor == 0) {
+    olsr_printf(2, "[ENC]%u timestamps (%u evicted), challenges: %u sent %u limited, %u exchanges"
+                " latency min/avg/max %u/%u/%u ms\n", stamp_count, secure_stats.evicted, secure_stats.challenges,
+                secure_stats.limited, secure_stats.responses, secure_stats.latency_min,
+                secure_stats.responses ? (uint32_t) (secure_stats.latency_sum / secure_stats.responses) : 0,
+                secure_stats.latency_max);
+  }
 }
 
 static int
@@ -54,6 +54,8 @@
 /* Algorithm definitions */
 #define SHA1_INCLUDING_KEY   1
 #define MD5_INCLUDING_KEY   2
+#define HMAC_SHA256         3
+#define SIPHASH_2_4         4
 
 #ifdef USE_OPENSSL
 #define SIGNATURE_SIZE 20
@@ -0,0 +1,297 @@
+
+/*
+ * Secure OLSR plugin
+ * http://www.olsr.org
+ *
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsrd, olsr.org nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Keyed signature schemes of the secure plugin
+ *
+ * The legacy scheme hashes packet + key, so it can not precompute
+ * anything for the key but at least hashes the packet in place. The
+ * HMAC-SHA256 and SipHash schemes keep the expanded key state from
+ * the time the key was read, signing a packet only costs the packet.
+ */
+
+#include "secure_mac.h"
+
+#include <string.h>
+#include <strings.h>
+
+#include "olsrd_secure.h"
+#include "sha256.h"
+
+#ifdef USE_OPENSSL
+#include <openssl/sha.h>
+#else /* USE_OPENSSL */
+#include "md5.h"
+#endif /* USE_OPENSSL */
+
+/*
+ * legacy: SHA-1 or MD5 over packet + key
+ */
+
+static uint8_t legacy_key[KEYLENGTH];
+
+static void
+legacy_set_key(const uint8_t * key, size_t len)
+{
+  memset(legacy_key, 0, sizeof(legacy_key));
+  memcpy(legacy_key, key, len < sizeof(legacy_key) ? len : sizeof(legacy_key));
+}
+
+static void
+legacy_sign(const uint8_t * data, size_t len, uint8_t * signature)
+{
+#ifdef USE_OPENSSL
+  SHA_CTX context;
+
+  SHA1_Init(&context);
+  SHA1_Update(&context, data, len);
+  SHA1_Update(&context, legacy_key, sizeof(legacy_key));
+  SHA1_Final(signature, &context);
+#else /* USE_OPENSSL */
+  MD5_CTX context;
+
+  MD5Init(&context);
+  MD5Update(&context, data, len);
+  MD5Update(&context, legacy_key, sizeof(legacy_key));
+  MD5Final(signature, &context);
+#endif /* USE_OPENSSL */
+}
+
+/*
+ * HMAC-SHA256 (RFC 2104), truncated to SIGNATURE_SIZE
+ */
+
+static struct sha256_ctx hmac_inner, hmac_outer;
+
+static void
+hmac_sha256_set_key(const uint8_t * key, size_t len)
+{
+  uint8_t pad[SHA256_BLOCK_SIZE];
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  size_t i;
+
+  /* keys longer than a block are hashed first */
+  if (len > SHA256_BLOCK_SIZE) {
+    sha256_init(&hmac_inner);
+    sha256_update(&hmac_inner, key, len);
+    sha256_final(&hmac_inner, digest);
+    key = digest;
+    len = sizeof(digest);
+  }
+
+  memset(pad, 0x36, sizeof(pad));
+  for (i = 0; i < len; i++) {
+    pad[i] ^= key[i];
+  }
+  sha256_init(&hmac_inner);
+  sha256_update(&hmac_inner, pad, sizeof(pad));
+
+  memset(pad, 0x5c, sizeof(pad));
+  for (i = 0; i < len; i++) {
+    pad[i] ^= key[i];
+  }
+  sha256_init(&hmac_outer);
+  sha256_update(&hmac_outer, pad, sizeof(pad));
+
+  memset(pad, 0, sizeof(pad));
+}
+
+static void
+hmac_sha256_sign(const uint8_t * data, size_t len, uint8_t * signature)
+{
+  struct sha256_ctx context;
+  uint8_t digest[SHA256_DIGEST_SIZE];
+
+  context = hmac_inner;
+  sha256_update(&context, data, len);
+  sha256_final(&context, digest);
+
+  context = hmac_outer;
+  sha256_update(&context, digest, sizeof(digest));
+  sha256_final(&context, digest);
+
+  memcpy(signature, digest, SIGNATURE_SIZE);
+}
+
+/*
+ * SipHash-2-4 with 128 bit output
+ */
+
+static uint64_t sip_k0, sip_k1;
+
+#define ROTL64(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+#define SIPROUND do {                                                   \
+    v0 += v1; v1 = ROTL64(v1, 13); v1 ^= v0; v0 = ROTL64(v0, 32);       \
+    v2 += v3; v3 = ROTL64(v3, 16); v3 ^= v2;                            \
+    v0 += v3; v3 = ROTL64(v3, 21); v3 ^= v0;                            \
+    v2 += v1; v1 = ROTL64(v1, 17); v1 ^= v2; v2 = ROTL64(v2, 32);       \
+  } while (0)
+
+static uint64_t
+load_le64(const uint8_t * p)
+{
+  uint64_t v = 0;
+  int i;
+
+  for (i = 7; i >= 0; i--) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+static void
+store_le64(uint8_t * p, uint64_t v)
+{
+  int i;
+
+  for (i = 0; i < 8; i++) {
+    p[i] = v >> (8 * i);
+  }
+}
+
+static void
+siphash_set_key(const uint8_t * key, size_t len)
+{
+  uint8_t k[16];
+
+  memset(k, 0, sizeof(k));
+  memcpy(k, key, len < sizeof(k) ? len : sizeof(k));
+  sip_k0 = load_le64(k);
+  sip_k1 = load_le64(k + 8);
+  memset(k, 0, sizeof(k));
+}
+
+static void
+siphash_sign(const uint8_t * data, size_t len, uint8_t * signature)
+{
+  uint64_t v0 = sip_k0 ^ 0x736f6d6570736575ULL;
+  uint64_t v1 = sip_k1 ^ 0x646f72616e646f6dULL ^ 0xee;
+  uint64_t v2 = sip_k0 ^ 0x6c7967656e657261ULL;
+  uint64_t v3 = sip_k1 ^ 0x7465646279746573ULL;
+  const uint8_t *end = data + (len & ~(size_t)7);
+  uint64_t m, b = (uint64_t) len << 56;
+  int i;
+
+  for (; data != end; data += 8) {
+    m = load_le64(data);
+    v3 ^= m;
+    SIPROUND;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  for (i = (int)(len & 7) - 1; i >= 0; i--) {
+    b |= (uint64_t) data[i] << (8 * i);
+  }
+  v3 ^= b;
+  SIPROUND;
+  SIPROUND;
+  v0 ^= b;
+
+  v2 ^= 0xee;
+  SIPROUND;
+  SIPROUND;
+  SIPROUND;
+  SIPROUND;
+  store_le64(signature, v0 ^ v1 ^ v2 ^ v3);
+
+  v1 ^= 0xdd;
+  SIPROUND;
+  SIPROUND;
+  SIPROUND;
+  SIPROUND;
+  store_le64(signature + 8, v0 ^ v1 ^ v2 ^ v3);
+
+  /* the SHA-1 build has a longer signature field */
+  memset(signature + 16, 0, SIGNATURE_SIZE - 16);
+}
+
+/* *INDENT-OFF* */
+static const struct secure_mac secure_macs[] = {
+#ifdef USE_OPENSSL
+  { .name = "sha1",        .algorithm = SHA1_INCLUDING_KEY, .set_key = &legacy_set_key,      .sign = &legacy_sign },
+#else /* USE_OPENSSL */
+  { .name = "md5",         .algorithm = MD5_INCLUDING_KEY,  .set_key = &legacy_set_key,      .sign = &legacy_sign },
+#endif /* USE_OPENSSL */
+  { .name = "hmac-sha256", .algorithm = HMAC_SHA256,        .set_key = &hmac_sha256_set_key, .sign = &hmac_sha256_sign },
+  { .name = "siphash",     .algorithm = SIPHASH_2_4,        .set_key = &siphash_set_key,     .sign = &siphash_sign },
+};
+/* *INDENT-ON* */
+
+const struct secure_mac *secure_mac = &secure_macs[0];
+
+/**
+ * select the signature scheme by name
+ */
+bool
+secure_mac_select(const char *name)
+{
+  size_t i;
+
+  for (i = 0; i < sizeof(secure_macs) / sizeof(*secure_macs); i++) {
+    if (strcasecmp(secure_macs[i].name, name) == 0) {
+      secure_mac = &secure_macs[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * check the signature of data in place, in constant time
+ */
+bool
+secure_mac_verify(const uint8_t * data, size_t len, const uint8_t * signature)
+{
+  uint8_t expected[SIGNATURE_SIZE];
+  uint8_t diff = 0;
+  size_t i;
+
+  secure_mac->sign(data, len, expected);
+  for (i = 0; i < SIGNATURE_SIZE; i++) {
+    diff |= expected[i] ^ signature[i];
+  }
+  return diff == 0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -81,6 +81,10 @@
 #include "lq_plugin.h"
 #include "common/autobuf.h"
 #include "gateway.h"
+#include "olsr_profile.h"
+#include "olsr_admit.h"
+#include "olsr_cookie.h"
+#include "olsr_node_id.h"
 
 #include "olsrd_txtinfo.h"
 #include "olsrd_plugin.h"
@@ -116,6 +120,11 @@ static void ipc_print_config(struct autobuf *);
 
 static void ipc_print_interface(struct autobuf *);
 
+static void ipc_print_profile(struct autobuf *);
+
+static void ipc_print_admission(struct autobuf *);
+static void ipc_print_memory(struct autobuf *);
+
 #define TXT_IPC_BUFSIZE 256
 
 #define SIW_NEIGH 0x0001
@@ -129,6 +138,9 @@ static void ipc_print_interface(struct autobuf *);
 #define SIW_CONFIG 0x0100
 #define SIW_2HOP 0x0200
 #define SIW_VERSION 0x0400
+#define SIW_PROFILE 0x0800
+#define SIW_ADMISSION 0x1000
+#define SIW_MEMORY 0x2000
 
 /* ALL = neigh link route hna mid topo */
 #define SIW_ALL 0x003F
@@ -327,6 +339,9 @@ ipc_action(int fd, void *data __attribute__ ((unused)), unsigned int flags __att
         if (0 != strstr(requ, "/int")) send_what |= SIW_INTERFACE;
         if (0 != strstr(requ, "/2ho")) send_what |= SIW_2HOP;
         if (0 != strstr(requ, "/ver")) send_what |= SIW_VERSION;
+        if (0 != strstr(requ, "/pro")) send_what |= SIW_PROFILE;
+        if (0 != strstr(requ, "/adm")) send_what |= SIW_ADMISSION;
+        if (0 != strstr(requ, "/mem")) send_what |= SIW_MEMORY;
       }
     }
     if ( send_what == 0 ) send_what = SIW_ALL;
@@ -354,11 +369,16 @@ ipc_print_neigh(struct autobuf *abuf, bool list_2hop)
     thop_cnt = 0;
 
     for (list_2 = neigh->neighbor_2_list.next; list_2 != &neigh->neighbor_2_list; list_2 = list_2->next) {
-      if (list_2hop) abuf_appendf(abuf, "\t%s\n", olsr_ip_to_string(&buf1, &list_2->neighbor_2->neighbor_2_addr));
+      if (list_2hop) {
+        abuf_putc(abuf, '\t');
+        abuf_append_ip(abuf, &list_2->neighbor_2->neighbor_2_addr);
+        abuf_putc(abuf, '\n');
+      }
       else thop_cnt++;
     }
     if (!list_2hop) {
-      abuf_appendf(abuf, "%d\n", thop_cnt);
+      abuf_append_int(abuf, thop_cnt);
+      abuf_putc(abuf, '\n');
     }
   }
   OLSR_FOR_ALL_NBR_ENTRIES_END(neigh);
@@ -368,8 +388,10 @@ ipc_print_neigh(struct autobuf *abuf, bool list_2hop)
 static void
 ipc_print_link(struct autobuf *abuf)
 {
+#ifdef ACTIVATE_VTIME_TXTINFO
   struct ipaddr_str buf1, buf2;
   struct lqtextbuffer lqbuffer1, lqbuffer2;
+#endif /* ACTIVATE_VTIME_TXTINFO */
 
   struct link_entry *my_link = NULL;
 
@@ -390,10 +412,14 @@ ipc_print_link(struct autobuf *abuf)
               get_link_entry_text(my_link, '\t', &lqbuffer1),
               get_linkcost_text(my_link->linkcost, false, &lqbuffer2));
 #else /* ACTIVATE_VTIME_TXTINFO */
-    abuf_appendf(abuf, "%s\t%s\t0.00\t%s\t%s\t\n", olsr_ip_to_string(&buf1, &my_link->local_iface_addr),
-              olsr_ip_to_string(&buf2, &my_link->neighbor_iface_addr),
-              get_link_entry_text(my_link, '\t', &lqbuffer1),
-              get_linkcost_text(my_link->linkcost, false, &lqbuffer2));
+    abuf_append_ip(abuf, &my_link->local_iface_addr);
+    abuf_putc(abuf, '\t');
+    abuf_append_ip(abuf, &my_link->neighbor_iface_addr);
+    abuf_puts(abuf, "\t0.00\t");
+    append_link_entry_text(abuf, my_link, '\t');
+    abuf_putc(abuf, '\t');
+    append_linkcost_text(abuf, my_link->linkcost, false);
+    abuf_puts(abuf, "\t\n");
 #endif /* ACTIVATE_VTIME_TXTINFO */
   } OLSR_FOR_ALL_LINK_ENTRIES_END(my_link);
 
@@ -403,18 +429,22 @@ ipc_print_link(struct autobuf *abuf)
 static void
 ipc_print_routes(struct autobuf *abuf)
 {
-  struct ipaddr_str buf1, buf2;
   struct rt_entry *rt;
-  struct lqtextbuffer lqbuffer;
 
   abuf_puts(abuf, "Table: Routes\nDestination\tGateway IP\tMetric\tETX\tInterface\n");
 
   /* Walk the route table */
   OLSR_FOR_ALL_RT_ENTRIES(rt) {
-    abuf_appendf(abuf, "%s/%d\t%s\t%d\t%s\t%s\t\n", olsr_ip_to_string(&buf1, &rt->rt_dst.prefix), rt->rt_dst.prefix_len,
-              olsr_ip_to_string(&buf2, &rt->rt_best->rtp_nexthop.gateway), rt->rt_best->rtp_metric.hops,
-              get_linkcost_text(rt->rt_best->rtp_metric.cost, true, &lqbuffer),
-              if_ifwithindex_name(rt->rt_best->rtp_nexthop.iif_index));
+    abuf_append_ip_prefix(abuf, &rt->rt_dst);
+    abuf_putc(abuf, '\t');
+    abuf_append_ip(abuf, &rt->rt_best->rtp_nexthop.gateway);
+    abuf_putc(abuf, '\t');
+    abuf_append_int(abuf, rt->rt_best->rtp_metric.hops);
+    abuf_putc(abuf, '\t');
+    append_linkcost_text(abuf, rt->rt_best->rtp_metric.cost, true);
+    abuf_putc(abuf, '\t');
+    abuf_puts(abuf, if_ifwithindex_name(rt->rt_best->rtp_nexthop.iif_index));
+    abuf_puts(abuf, "\t\n");
   } OLSR_FOR_ALL_RT_ENTRIES_END(rt);
 
   abuf_puts(abuf, "\n");
@@ -437,20 +467,21 @@ ipc_print_topology(struct autobuf *abuf)
     struct tc_edge_entry *tc_edge;
     OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
       if (tc_edge->edge_inv) {
-        struct ipaddr_str dstbuf, addrbuf;
-        struct lqtextbuffer lqbuffer1, lqbuffer2;
+        abuf_append_ip(abuf, tc_edge_dest_addr(tc_edge));
+        abuf_putc(abuf, '\t');
+        abuf_append_ip(abuf, &tc->addr);
+        abuf_putc(abuf, '\t');
+        append_tc_edge_entry_text(abuf, tc_edge, '\t');
+        abuf_putc(abuf, '\t');
+        append_linkcost_text(abuf, tc_edge->cost, false);
 #ifdef ACTIVATE_VTIME_TXTINFO
-        uint32_t vt = tc->validity_timer != NULL ? (tc->validity_timer->timer_clock - now_times) : 0;
-        int diff = (int)(vt);
-        abuf_appendf(abuf, "%s\t%s\t%s\t%s\t%d.%03d\n", olsr_ip_to_string(&dstbuf, &tc_edge->T_dest_addr),
-            olsr_ip_to_string(&addrbuf, &tc->addr),
-            get_tc_edge_entry_text(tc_edge, '\t', &lqbuffer1),
-            get_linkcost_text(tc_edge->cost, false, &lqbuffer2),
-            diff/1000, diff%1000);
-#else /* ACTIVATE_VTIME_TXTINFO */
-        abuf_appendf(abuf, "%s\t%s\t%s\t%s\n", olsr_ip_to_string(&dstbuf, &tc_edge->T_dest_addr), olsr_ip_to_string(&addrbuf, &tc->addr),
-                  get_tc_edge_entry_text(tc_edge, '\t', &lqbuffer1), get_linkcost_text(tc_edge->cost, false, &lqbuffer2));
+        {
+          uint32_t vt = tc->validity_timer != NULL ? (tc->validity_timer->timer_clock - now_times) : 0;
+          abuf_putc(abuf, '\t');
+          abuf_append_fixed(abuf, (int)vt, 3);
+        }
 #endif /* ACTIVATE_VTIME_TXTINFO */
+        abuf_putc(abuf, '\n');
       }
     } OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
   } OLSR_FOR_ALL_TC_ENTRIES_END(tc);
@@ -497,8 +528,10 @@ ipc_print_hna(struct autobuf *abuf)
           tmp_net->hna_prefix.prefix_len, olsr_ip_to_string(&mainaddrbuf, &tmp_hna->A_gateway_addr),
           diff/1000, abs(diff%1000));
 #else /* ACTIVATE_VTIME_TXTINFO */
-      abuf_appendf(abuf, "%s/%d\t%s\n", olsr_ip_to_string(&buf, &tmp_net->hna_prefix.prefix),
-          tmp_net->hna_prefix.prefix_len, olsr_ip_to_string(&mainaddrbuf, &tmp_hna->A_gateway_addr));
+      abuf_append_ip_prefix(abuf, &tmp_net->hna_prefix);
+      abuf_putc(abuf, '\t');
+      abuf_append_ip(abuf, &tmp_hna->A_gateway_addr);
+      abuf_putc(abuf, '\n');
 #endif /* ACTIVATE_VTIME_TXTINFO */
     }
   }
@@ -630,7 +663,7 @@ static void
 ipc_print_interface(struct autobuf *abuf)
 {
   const struct olsr_if *ifs;
-  abuf_puts(abuf, "Table: Interfaces\nName\tState\tMTU\tWLAN\tSrc-Adress\tMask\tDst-Adress\n");
+  abuf_puts(abuf, "Table: Interfaces\nName\tState\tMTU\tWLAN\tSrc-Adress\tMask\tDst-Adress\tFwdQueue\tFwdMax\tFwdSent\tFwdDropFull\tFwdDropRate\n");
   for (ifs = olsr_cnf->interfaces; ifs != NULL; ifs = ifs->next) {
     const struct interface *const rifs = ifs->interf;
     abuf_appendf(abuf, "%s\t", ifs->name);
@@ -643,18 +676,83 @@ ipc_print_interface(struct autobuf *abuf)
  
     if (olsr_cnf->ip_version == AF_INET) {
       struct ipaddr_str addrbuf, maskbuf, bcastbuf;
-      abuf_appendf(abuf, "%s\t%s\t%s\n",
+      abuf_appendf(abuf, "%s\t%s\t%s\t",
                  ip4_to_string(&addrbuf, rifs->int_addr.sin_addr), ip4_to_string(&maskbuf, rifs->int_netmask.sin_addr),
                  ip4_to_string(&bcastbuf, rifs->int_broadaddr.sin_addr));
     } else {
        struct ipaddr_str addrbuf, maskbuf;
-      abuf_appendf(abuf, "%s\t\t%s\n",
+      abuf_appendf(abuf, "%s\t\t%s\t",
                  ip6_to_string(&addrbuf, &rifs->int6_addr.sin6_addr), ip6_to_string(&maskbuf, &rifs->int6_multaddr.sin6_addr));
     }
+    abuf_appendf(abuf, "%d\t%u\t%u\t%u\t%u\n",
+               rifs->fwdq.count, rifs->fwdq.max_count, rifs->fwdq.sent, rifs->fwdq.dropped_full, rifs->fwdq.dropped_rate);
   }
   abuf_puts(abuf, "\n");
 }
 
+static void
+ipc_print_histogram(void *ctx, enum olsr_prof_group group, const char *name, const struct olsr_histogram *hist)
+{
+  static const char *const groups[] = { "core", "timer", "message", "socket" };
+  struct autobuf *abuf = ctx;
+
+  if (hist->count == 0) {
+    return;
+  }
+  abuf_appendf(abuf, "%s\t%s\t%llu\t%.3f\t%.3f\t%.3f\t%.3f\t%.3f\n", groups[group], name, (unsigned long long)hist->count,
+               hist->sum / 1000.0 / hist->count, olsr_hist_percentile(hist, 500) / 1000.0, olsr_hist_percentile(hist, 900) / 1000.0,
+               olsr_hist_percentile(hist, 990) / 1000.0, hist->max / 1000.0);
+}
+
+static void
+ipc_print_profile(struct autobuf *abuf)
+{
+  abuf_puts(abuf, "Table: Profile\nGroup\tName\tCount\tAvg(us)\tP50(us)\tP90(us)\tP99(us)\tMax(us)\n");
+  olsr_prof_walk(ipc_print_histogram, abuf);
+  abuf_puts(abuf, "\n");
+}
+
+static void
+ipc_print_admit_bucket(void *ctx, enum olsr_admit_table table, const struct olsr_admit_bucket *bucket)
+{
+  struct autobuf *abuf = ctx;
+  struct ipaddr_str buf;
+
+  abuf_appendf(abuf, "%s\t%s\t%.3f\t%u\t%u\n", table == OLSR_ADMIT_SENDER ? "sender" : "originator",
+               olsr_ip_to_string(&buf, &bucket->addr), bucket->tokens / 1000.0, bucket->admitted, bucket->dropped);
+}
+
+static void
+ipc_print_admission(struct autobuf *abuf)
+{
+  abuf_appendf(abuf, "Table: Admission\nAdmitted\tDuplicates\tSender drops\tOriginator drops\n%u\t%u\t%u\t%u\n\n",
+               olsr_admit_stats.admitted, olsr_admit_stats.dropped_duplicate, olsr_admit_stats.dropped_sender,
+               olsr_admit_stats.dropped_originator);
+  abuf_puts(abuf, "Table: Admission buckets\nType\tIP address\tTokens\tAdmitted\tDropped\n");
+  olsr_admit_walk(ipc_print_admit_bucket, abuf);
+  abuf_puts(abuf, "\n");
+}
+
+static void
+ipc_print_cookie(void *ctx, const struct olsr_cookie_info *ci)
+{
+  struct autobuf *abuf = ctx;
+  size_t block_size = olsr_cookie_block_size(ci);
+
+  if (ci->ci_type != OLSR_COOKIE_TYPE_MEMORY) {
+    return;
+  }
+  abuf_appendf(abuf, "%s\t%lu\t%u\t%u\t%lu\n", ci->ci_name ? ci->ci_name : "", (unsigned long)block_size, ci->ci_usage,
+               ci->ci_free_list_usage, (unsigned long)(block_size * (ci->ci_usage + ci->ci_free_list_usage)));
+}
+
+static void
+ipc_print_memory(struct autobuf *abuf)
+{
+  abuf_puts(abuf, "Table: Memory\nCookie\tBlock size\tUsed\tFree list\tBytes\n");
+  olsr_cookie_walk(ipc_print_cookie, abuf);
+  abuf_appendf(abuf, "\nInterned nodes: %u\n\n", olsr_node_id_count());
+}
 
 static void
 txtinfo_write_data(void *foo __attribute__ ((unused))) {
@@ -743,6 +841,12 @@ send_info(unsigned int send_what, int the_socket)
   if ((send_what & SIW_2HOP) == SIW_2HOP) ipc_print_neigh(&abuf,true);
   /* version */
   if ((send_what & SIW_VERSION) == SIW_VERSION) ipc_print_version(&abuf);
+  /* latency histograms */
+  if ((send_what & SIW_PROFILE) == SIW_PROFILE) ipc_print_profile(&abuf);
+  /* admission control */
+  if ((send_what & SIW_ADMISSION) == SIW_ADMISSION) ipc_print_admission(&abuf);
+  /* memory usage by cookie */
+  if ((send_what & SIW_MEMORY) == SIW_MEMORY) ipc_print_memory(&abuf);
 
   assert(outbuffer_count < MAX_CLIENTS);
 
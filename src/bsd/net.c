@@ -655,6 +655,40 @@ olsr_sendto(int s, const void *buf, size_t len, int flags __attribute__ ((unused
 #endif /* SPOOF */
 }
 
+/**
+ * Wrapper for sendmsg(2) with a scatter/gather list
+ */
+ssize_t
+olsr_sendmsg(int s, struct iovec *iov, int iovcnt, int flags, struct sockaddr *to, socklen_t tolen)
+{
+#ifdef SPOOF
+  /* the libnet path needs the packet in one piece */
+  uint8_t buf[MAXMESSAGESIZE];
+  size_t len = 0;
+  int i;
+
+  for (i = 0; i < iovcnt; i++) {
+    if (len + iov[i].iov_len > sizeof(buf)) {
+      errno = EMSGSIZE;
+      return -1;
+    }
+    memcpy(buf + len, iov[i].iov_base, iov[i].iov_len);
+    len += iov[i].iov_len;
+  }
+  return olsr_sendto(s, buf, len, flags, to, tolen);
+#else /* SPOOF */
+  struct msghdr msg;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = to;
+  msg.msg_namelen = tolen;
+  msg.msg_iov = iov;
+  msg.msg_iovlen = iovcnt;
+
+  return sendmsg(s, &msg, flags);
+#endif /* SPOOF */
+}
+
 /**
  * Wrapper for recvfrom(2)
  */
@@ -329,6 +329,53 @@ void olsrd_write_cnf_autobuf(struct autobuf *out, struct olsrd_config *cnf) {
   abuf_appendf(out, "%sNicChgsPollInt  %.1f\n",
       cnf->nic_chgs_pollrate == (float)DEF_NICCHGPOLLRT ? "# " : "",
       (double)cnf->nic_chgs_pollrate);
+  abuf_puts(out,
+    "\n"
+    "# Run the route calculation (SPF) in a separate thread on a snapshot\n"
+    "# of the topology, so large topologies do not delay packet processing.\n"
+    "# Not available on Windows.\n"
+    "# (Default is no)\n"
+    "\n");
+  abuf_appendf(out, "%sSpfThread  %s\n",
+      cnf->spf_thread == DEF_SPF_THREAD ? "# " : "",
+      cnf->spf_thread ? "yes" : "no");
+  abuf_puts(out,
+    "\n"
+    "# Read the OLSR sockets in a separate thread, which queues HELLOs\n"
+    "# ahead of all other packets, so packets are not lost and links stay\n"
+    "# up while the main loop is busy with route calculation or updates.\n"
+    "# Only available on Linux.\n"
+    "# (Default is no)\n"
+    "\n");
+  abuf_appendf(out, "%sRxThread  %s\n",
+      cnf->rx_thread == DEF_RX_THREAD ? "# " : "",
+      cnf->rx_thread ? "yes" : "no");
+  abuf_puts(out,
+    "\n"
+    "# Limits the forwarded traffic per interface (bytes per second).\n"
+    "# Forwarded messages are sent behind HELLOs and the other local\n"
+    "# messages, messages over the limit are dropped. 0 disables the\n"
+    "# limit.\n"
+    "# (Default is 0)\n"
+    "\n");
+  abuf_appendf(out, "%sFwdRateLimit  %d\n",
+      cnf->fwd_rate_limit == DEF_FWD_RATE_LIMIT ? "# " : "",
+      cnf->fwd_rate_limit);
+  abuf_puts(out,
+    "\n"
+    "# Received messages are only parsed while the neighbor which sent\n"
+    "# them and their originator are within their budget, in weight units\n"
+    "# per second. A HELLO, MID or HNA weighs 1, a TC 2 and a plugin\n"
+    "# message 4. Duplicates are dropped for free, and part of the sender\n"
+    "# budget is kept for HELLOs. 0 disables a budget.\n"
+    "# (Default is 1000 for senders and 100 for originators)\n"
+    "\n");
+  abuf_appendf(out, "%sInputSenderBudget  %d\n",
+      cnf->input_sender_budget == DEF_INPUT_SENDER_BUDGET ? "# " : "",
+      cnf->input_sender_budget);
+  abuf_appendf(out, "%sInputOriginatorBudget  %d\n",
+      cnf->input_orig_budget == DEF_INPUT_ORIG_BUDGET ? "# " : "",
+      cnf->input_orig_budget);
   abuf_puts(out,
     "\n"
     "# TOS(type of service) value for the IP header of control traffic.\n"
@@ -493,6 +493,23 @@ olsrd_sanity_check_cnf(struct olsrd_config *cnf)
   }
 
   /* MPR coverage */
+  if (cnf->fwd_rate_limit < 0) {
+    fprintf(stderr, "Forwarding rate limit %d is not allowed\n", cnf->fwd_rate_limit);
+    return -1;
+  }
+
+  if (cnf->input_sender_budget != 0
+      && (cnf->input_sender_budget < MIN_INPUT_BUDGET || cnf->input_sender_budget > MAX_INPUT_BUDGET)) {
+    fprintf(stderr, "Input sender budget %d is not allowed\n", cnf->input_sender_budget);
+    return -1;
+  }
+
+  if (cnf->input_orig_budget != 0
+      && (cnf->input_orig_budget < MIN_INPUT_BUDGET || cnf->input_orig_budget > MAX_INPUT_BUDGET)) {
+    fprintf(stderr, "Input originator budget %d is not allowed\n", cnf->input_orig_budget);
+    return -1;
+  }
+
   if (cnf->mpr_coverage < MIN_MPR_COVERAGE || cnf->mpr_coverage > MAX_MPR_COVERAGE) {
     fprintf(stderr, "MPR coverage %d is not allowed\n", cnf->mpr_coverage);
     return -1;
@@ -883,6 +900,11 @@ set_default_cnf(struct olsrd_config *cnf)
   cnf->lq_algorithm = NULL;
   cnf->lq_nat_thresh = DEF_LQ_NAT_THRESH;
   cnf->clear_screen = DEF_CLEAR_SCREEN;
+  cnf->spf_thread = DEF_SPF_THREAD;
+  cnf->rx_thread = DEF_RX_THREAD;
+  cnf->fwd_rate_limit = DEF_FWD_RATE_LIMIT;
+  cnf->input_sender_budget = DEF_INPUT_SENDER_BUDGET;
+  cnf->input_orig_budget = DEF_INPUT_ORIG_BUDGET;
 
   cnf->del_gws = false;
   cnf->will_int = 10 * HELLO_INTERVAL;
@@ -1027,6 +1049,16 @@ olsrd_print_cnf(struct olsrd_config *cnf)
 
   printf("Clear screen     : %s\n", cnf->clear_screen ? "yes" : "no");
 
+  printf("SPF thread       : %s\n", cnf->spf_thread ? "yes" : "no");
+
+  printf("RX thread        : %s\n", cnf->rx_thread ? "yes" : "no");
+
+  printf("Fwd rate limit   : %d\n", cnf->fwd_rate_limit);
+
+  printf("Sender budget    : %d\n", cnf->input_sender_budget);
+
+  printf("Originator budget: %d\n", cnf->input_orig_budget);
+
   printf("Use niit         : %s\n", cnf->use_niit ? "yes" : "no");
 
   printf("Smart Gateway    : %s\n", cnf->smart_gw_active ? "yes" : "no");
@@ -202,6 +202,11 @@ static int add_ipv6_addr(YYSTYPE ipaddr_arg, YYSTYPE prefixlen_arg)
 %token TOK_HYSTLOWER
 %token TOK_POLLRATE
 %token TOK_NICCHGSPOLLRT
+%token TOK_SPF_THREAD
+%token TOK_RX_THREAD
+%token TOK_FWD_RATE_LIMIT
+%token TOK_INPUT_SENDER_BUDGET
+%token TOK_INPUT_ORIG_BUDGET
 %token TOK_TCREDUNDANCY
 %token TOK_MPRCOVERAGE
 %token TOK_LQ_LEVEL
@@ -297,6 +302,11 @@ stmt:       idebug
           | fhystlower
           | fpollrate
           | fnicchgspollrt
+          | bspf_thread
+          | brx_thread
+          | afwd_rate_limit
+          | ainput_sender_budget
+          | ainput_orig_budget
           | atcredundancy
           | amprcoverage
           | alq_level
@@ -1224,6 +1234,46 @@ fnicchgspollrt: TOK_NICCHGSPOLLRT TOK_FLOAT
 }
 ;
 
+bspf_thread: TOK_SPF_THREAD TOK_BOOLEAN
+{
+  PARSER_DEBUG_PRINTF("SPF thread %s\n", $2->boolean ? "enabled" : "disabled");
+  olsr_cnf->spf_thread = $2->boolean;
+  free($2);
+}
+;
+
+brx_thread: TOK_RX_THREAD TOK_BOOLEAN
+{
+  PARSER_DEBUG_PRINTF("RX thread %s\n", $2->boolean ? "enabled" : "disabled");
+  olsr_cnf->rx_thread = $2->boolean;
+  free($2);
+}
+;
+
+afwd_rate_limit: TOK_FWD_RATE_LIMIT TOK_INTEGER
+{
+  PARSER_DEBUG_PRINTF("Forwarding rate limit %d\n", $2->integer);
+  olsr_cnf->fwd_rate_limit = $2->integer;
+  free($2);
+}
+;
+
+ainput_sender_budget: TOK_INPUT_SENDER_BUDGET TOK_INTEGER
+{
+  PARSER_DEBUG_PRINTF("Input sender budget %d\n", $2->integer);
+  olsr_cnf->input_sender_budget = $2->integer;
+  free($2);
+}
+;
+
+ainput_orig_budget: TOK_INPUT_ORIG_BUDGET TOK_INTEGER
+{
+  PARSER_DEBUG_PRINTF("Input originator budget %d\n", $2->integer);
+  olsr_cnf->input_orig_budget = $2->integer;
+  free($2);
+}
+;
+
 atcredundancy: TOK_TCREDUNDANCY TOK_INTEGER
 {
   PARSER_DEBUG_PRINTF("TC redundancy %d\n", $2->integer);
@@ -215,6 +215,266 @@ abuf_pull(struct autobuf * autobuf, int len) {
   autobuf->size = newsize;
   return 0;
 }
+
+/* longest text of a number or address written by the functions below */
+#define ABUF_MAX_TEXT 48
+
+static const char abuf_hexdigits[] = "0123456789abcdef";
+
+static int
+abuf_format_uint(char *dst, unsigned long value)
+{
+  char tmp[24];
+  int len = 0, i;
+
+  do {
+    tmp[len++] = '0' + (value % 10);
+    value /= 10;
+  } while (value != 0);
+
+  for (i = 0; i < len; i++) {
+    dst[i] = tmp[len - 1 - i];
+  }
+  return len;
+}
+
+static int
+abuf_format_ipv4(char *dst, const uint8_t *src)
+{
+  char *p = dst;
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    uint8_t b = src[i];
+
+    if (i != 0) {
+      *p++ = '.';
+    }
+    if (b >= 100) {
+      *p++ = '0' + b / 100;
+      b %= 100;
+      *p++ = '0' + b / 10;
+    } else if (b >= 10) {
+      *p++ = '0' + b / 10;
+    }
+    *p++ = '0' + b % 10;
+  }
+  return p - dst;
+}
+
+/* produces the same text as the inet_ntop() of glibc and BIND */
+static int
+abuf_format_ipv6(char *dst, const uint8_t *src)
+{
+  uint16_t words[8];
+  int best_base = -1, best_len = 0, cur_base = -1, cur_len = 0;
+  char *p = dst;
+  int i;
+
+  for (i = 0; i < 8; i++) {
+    words[i] = (src[2 * i] << 8) | src[2 * i + 1];
+
+    /* find the longest run of zero words */
+    if (words[i] == 0) {
+      if (cur_base == -1) {
+        cur_base = i;
+        cur_len = 0;
+      }
+      cur_len++;
+      if (cur_len > best_len) {
+        best_base = cur_base;
+        best_len = cur_len;
+      }
+    } else {
+      cur_base = -1;
+    }
+  }
+  if (best_len < 2) {
+    best_base = -1;
+  }
+
+  for (i = 0; i < 8; i++) {
+    int shift;
+
+    if (best_base != -1 && i >= best_base && i < best_base + best_len) {
+      if (i == best_base) {
+        *p++ = ':';
+      }
+      continue;
+    }
+    if (i != 0) {
+      *p++ = ':';
+    }
+
+    /* IPv4 compatible or mapped address */
+    if (i == 6 && best_base == 0 && (best_len == 6 || (best_len == 5 && words[5] == 0xffff))) {
+      p += abuf_format_ipv4(p, src + 12);
+      return p - dst;
+    }
+
+    for (shift = 12; shift > 0 && (words[i] >> shift) == 0; shift -= 4);
+    for (; shift >= 0; shift -= 4) {
+      *p++ = abuf_hexdigits[(words[i] >> shift) & 0x0f];
+    }
+  }
+  if (best_base != -1 && best_base + best_len == 8) {
+    *p++ = ':';
+  }
+  return p - dst;
+}
+
+/* make room for up to 'len' more characters and the terminating zero */
+static char *
+abuf_reserve(struct autobuf *autobuf, int len)
+{
+  if (autobuf_enlarge(autobuf, autobuf->len + len) < 0) {
+    return NULL;
+  }
+  return autobuf->buf + autobuf->len;
+}
+
+static int
+abuf_commit(struct autobuf *autobuf, int len)
+{
+  autobuf->len += len;
+  autobuf->buf[autobuf->len] = '\0';
+  return len;
+}
+
+int
+abuf_putc(struct autobuf *autobuf, char c)
+{
+  char *p = abuf_reserve(autobuf, 1);
+
+  if (p == NULL) {
+    return -1;
+  }
+  *p = c;
+  return abuf_commit(autobuf, 1);
+}
+
+int
+abuf_append_uint(struct autobuf *autobuf, unsigned long value)
+{
+  char *p = abuf_reserve(autobuf, ABUF_MAX_TEXT);
+
+  if (p == NULL) {
+    return -1;
+  }
+  return abuf_commit(autobuf, abuf_format_uint(p, value));
+}
+
+int
+abuf_append_int(struct autobuf *autobuf, long value)
+{
+  char *p = abuf_reserve(autobuf, ABUF_MAX_TEXT);
+  int len = 0;
+
+  if (p == NULL) {
+    return -1;
+  }
+  if (value < 0) {
+    p[len++] = '-';
+    /* no overflow for LONG_MIN */
+    return abuf_commit(autobuf, len + abuf_format_uint(p + len, 0UL - (unsigned long)value));
+  }
+  return abuf_commit(autobuf, abuf_format_uint(p, value));
+}
+
+/**
+ * Append a fixed point number, e.g. 1234 with 3 decimals as "1.234"
+ * (the same as printf("%d.%03d", value / 1000, value % 1000) does
+ * for positive values).
+ */
+int
+abuf_append_fixed(struct autobuf *autobuf, long value, unsigned int decimals)
+{
+  char *p = abuf_reserve(autobuf, ABUF_MAX_TEXT);
+  unsigned long v, scale = 1;
+  unsigned int i;
+  int len = 0;
+
+  if (p == NULL) {
+    return -1;
+  }
+  if (decimals > 9) {
+    decimals = 9;
+  }
+  for (i = 0; i < decimals; i++) {
+    scale *= 10;
+  }
+
+  v = (unsigned long)value;
+  if (value < 0) {
+    p[len++] = '-';
+    v = 0UL - v;
+  }
+  len += abuf_format_uint(p + len, v / scale);
+  if (decimals > 0) {
+    v %= scale;
+    p[len++] = '.';
+    for (i = decimals; i > 0; i--) {
+      p[len + i - 1] = '0' + (v % 10);
+      v /= 10;
+    }
+    len += decimals;
+  }
+  return abuf_commit(autobuf, len);
+}
+
+int
+abuf_append_ipv4(struct autobuf *autobuf, const void *addr)
+{
+  char *p = abuf_reserve(autobuf, ABUF_MAX_TEXT);
+
+  if (p == NULL) {
+    return -1;
+  }
+  return abuf_commit(autobuf, abuf_format_ipv4(p, addr));
+}
+
+int
+abuf_append_ipv6(struct autobuf *autobuf, const void *addr)
+{
+  char *p = abuf_reserve(autobuf, ABUF_MAX_TEXT);
+
+  if (p == NULL) {
+    return -1;
+  }
+  return abuf_commit(autobuf, abuf_format_ipv6(p, addr));
+}
+
+int
+abuf_append_ip(struct autobuf *autobuf, const union olsr_ip_addr *addr)
+{
+  if (olsr_cnf->ip_version == AF_INET) {
+    return abuf_append_ipv4(autobuf, &addr->v4);
+  }
+  return abuf_append_ipv6(autobuf, &addr->v6);
+}
+
+/**
+ * Append a prefix as "address/length"
+ */
+int
+abuf_append_ip_prefix(struct autobuf *autobuf, const struct olsr_ip_prefix *prefix)
+{
+  char *p = abuf_reserve(autobuf, ABUF_MAX_TEXT + 4);
+  int len;
+
+  if (p == NULL) {
+    return -1;
+  }
+  if (olsr_cnf->ip_version == AF_INET) {
+    len = abuf_format_ipv4(p, (const uint8_t *)&prefix->prefix.v4);
+  } else {
+    len = abuf_format_ipv6(p, (const uint8_t *)&prefix->prefix.v6);
+  }
+  p[len++] = '/';
+  len += abuf_format_uint(p + len, prefix->prefix_len);
+  return abuf_commit(autobuf, len);
+}
+
 /*
  * Local Variables:
  * mode: c
@@ -66,6 +66,20 @@ int abuf_strftime (struct autobuf * autobuf, const char *format, const struct tm
 int abuf_memcpy (struct autobuf * autobuf, const void *p, const unsigned int len);
 int abuf_memcpy_prefix (struct autobuf *autobuf, const void *p, const unsigned int len);
 int abuf_pull (struct autobuf * autobuf, int len);
+
+/*
+ * Specialized appenders for the hot paths of the info plugins, they
+ * do not go through the printf machinery. All of them return the
+ * number of characters appended or -1 if the buffer could not grow.
+ */
+int abuf_putc (struct autobuf * autobuf, char c);
+int abuf_append_uint (struct autobuf * autobuf, unsigned long value);
+int abuf_append_int (struct autobuf * autobuf, long value);
+int abuf_append_fixed (struct autobuf * autobuf, long value, unsigned int decimals);
+int abuf_append_ipv4 (struct autobuf * autobuf, const void *addr);
+int abuf_append_ipv6 (struct autobuf * autobuf, const void *addr);
+int abuf_append_ip (struct autobuf * autobuf, const union olsr_ip_addr *addr);
+int abuf_append_ip_prefix (struct autobuf * autobuf, const struct olsr_ip_prefix *prefix);
 #endif /* _COMMON_AUTOBUF_H */
 
 /*
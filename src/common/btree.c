@@ -0,0 +1,540 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <arpa/inet.h>
+
+#include "common/btree.h"
+#include "defs.h"
+#include "olsr.h"
+
+/* enough for 16^12 keys */
+#define BTREE_MAX_DEPTH 12
+
+/* an IPv6 address as two integers, they sort like memcmp() sorts the address */
+struct btree_key6 {
+  uint64_t hi;
+  uint64_t lo;
+};
+
+union btree_key {
+  uint32_t v4;
+  struct btree_key6 v6;
+};
+
+/*
+ * A block holds up to BTREE_BLOCK_KEYS - 1 keys, it overflows into the
+ * last slot right before it is split. The pointers of a leaf are the
+ * btree_nodes of its keys. An inner block with n keys has n + 1
+ * children; child i holds the keys from key i - 1 up to, but not
+ * including, key i.
+ */
+struct btree_block {
+  unsigned int count;
+  void *ptr[BTREE_BLOCK_KEYS + 1];
+  union {
+    uint32_t v4[BTREE_BLOCK_KEYS];
+    struct btree_key6 v6[BTREE_BLOCK_KEYS];
+  } key;
+};
+
+/* the way from the root to a leaf */
+struct btree_path {
+  struct btree_block *block[BTREE_MAX_DEPTH];
+  unsigned int idx[BTREE_MAX_DEPTH];
+};
+
+/*
+ * The IPv4 keys are compared as they are stored, like the avl tree
+ * does, so walks give the same order.
+ */
+static INLINE uint32_t
+btree_load4(const void *key)
+{
+  uint32_t k;
+
+  memcpy(&k, key, sizeof(k));
+  return k;
+}
+
+static INLINE struct btree_key6
+btree_load6(const void *key)
+{
+  struct btree_key6 k;
+  uint32_t w[4];
+
+  memcpy(w, key, sizeof(w));
+  k.hi = (uint64_t)ntohl(w[0]) << 32 | ntohl(w[1]);
+  k.lo = (uint64_t)ntohl(w[2]) << 32 | ntohl(w[3]);
+  return k;
+}
+
+static INLINE int
+btree_lt6(const struct btree_key6 *a, const struct btree_key6 *b)
+{
+  return a->hi < b->hi || (a->hi == b->hi && a->lo < b->lo);
+}
+
+static INLINE int
+btree_eq6(const struct btree_key6 *a, const struct btree_key6 *b)
+{
+  return a->hi == b->hi && a->lo == b->lo;
+}
+
+/*
+ * Position of a key in a block: the child to descend into in an inner
+ * block (the number of keys not greater than the key), the first key
+ * not less than the key in a leaf.
+ */
+static INLINE unsigned int
+btree_pos4(const struct btree_block *block, uint32_t k, int inner)
+{
+  unsigned int i;
+
+  for (i = 0; i < block->count; i++) {
+    if (inner ? k < block->key.v4[i] : k <= block->key.v4[i]) {
+      break;
+    }
+  }
+  return i;
+}
+
+static INLINE unsigned int
+btree_pos6(const struct btree_block *block, const struct btree_key6 *k, int inner)
+{
+  unsigned int i;
+
+  for (i = 0; i < block->count; i++) {
+    if (inner ? btree_lt6(k, &block->key.v6[i]) : !btree_lt6(&block->key.v6[i], k)) {
+      break;
+    }
+  }
+  return i;
+}
+
+/*
+ * The helpers below take the key type as an argument. They are always
+ * inlined, and btree4_* and btree6_* pass a constant, so each key type
+ * gets its own copy of find, insert and delete without any branch on
+ * the key type left inside.
+ */
+static INLINE unsigned int
+btree_pos(enum btree_key_type type, const struct btree_block *block, const union btree_key *k, int inner)
+{
+  return type == BTREE_KEY_IPV4 ? btree_pos4(block, k->v4, inner) : btree_pos6(block, &k->v6, inner);
+}
+
+static INLINE int
+btree_key_equal(enum btree_key_type type, const struct btree_block *block, unsigned int i, const union btree_key *k)
+{
+  return type == BTREE_KEY_IPV4 ? block->key.v4[i] == k->v4 : btree_eq6(&block->key.v6[i], &k->v6);
+}
+
+static INLINE void
+btree_load(enum btree_key_type type, union btree_key *k, const void *key)
+{
+  if (type == BTREE_KEY_IPV4) {
+    k->v4 = btree_load4(key);
+  } else {
+    k->v6 = btree_load6(key);
+  }
+}
+
+/* copy count keys inside or between blocks */
+static INLINE void
+btree_move_keys(enum btree_key_type type, struct btree_block *dst, unsigned int to, const struct btree_block *src,
+                unsigned int from, unsigned int count)
+{
+  if (type == BTREE_KEY_IPV4) {
+    memmove(&dst->key.v4[to], &src->key.v4[from], count * sizeof(dst->key.v4[0]));
+  } else {
+    memmove(&dst->key.v6[to], &src->key.v6[from], count * sizeof(dst->key.v6[0]));
+  }
+}
+
+static INLINE void
+btree_set_key(enum btree_key_type type, struct btree_block *block, unsigned int i, const union btree_key *k)
+{
+  if (type == BTREE_KEY_IPV4) {
+    block->key.v4[i] = k->v4;
+  } else {
+    block->key.v6[i] = k->v6;
+  }
+}
+
+static INLINE void
+btree_get_key(enum btree_key_type type, const struct btree_block *block, unsigned int i, union btree_key *k)
+{
+  if (type == BTREE_KEY_IPV4) {
+    k->v4 = block->key.v4[i];
+  } else {
+    k->v6 = block->key.v6[i];
+  }
+}
+
+static INLINE struct btree_block *
+btree_alloc_block(enum btree_key_type type)
+{
+  /* IPv4 blocks do not need the room of the IPv6 keys */
+  size_t size = type == BTREE_KEY_IPV4
+    ? offsetof(struct btree_block, key) + BTREE_BLOCK_KEYS * sizeof(uint32_t) : sizeof(struct btree_block);
+
+  return olsr_malloc(size, "btree block");
+}
+
+/* insert a key and the pointer to its right into a block */
+static INLINE void
+btree_block_insert(enum btree_key_type type, struct btree_block *block, unsigned int i, const union btree_key *k,
+                   void *ptr, int inner)
+{
+  btree_move_keys(type, block, i + 1, block, i, block->count - i);
+  btree_set_key(type, block, i, k);
+
+  /* the pointer of a leaf belongs to its key, in an inner block it is the right child */
+  i += inner;
+  memmove(&block->ptr[i + 1], &block->ptr[i], (block->count + inner - i) * sizeof(block->ptr[0]));
+  block->ptr[i] = ptr;
+  block->count++;
+}
+
+void
+btree_init(struct btree *tree, enum btree_key_type type)
+{
+  tree->root = NULL;
+  tree->first = NULL;
+  tree->last = NULL;
+  tree->count = 0;
+  tree->depth = 0;
+  tree->type = type;
+}
+
+static INLINE struct btree_node *
+btree_find_type(const struct btree *tree, const void *key, enum btree_key_type type)
+{
+  const struct btree_block *block = tree->root;
+  union btree_key k;
+  unsigned int d, i;
+
+  if (block == NULL) {
+    return NULL;
+  }
+
+  btree_load(type, &k, key);
+  for (d = 1; d < tree->depth; d++) {
+    block = block->ptr[btree_pos(type, block, &k, 1)];
+  }
+  i = btree_pos(type, block, &k, 0);
+  return i < block->count && btree_key_equal(type, block, i, &k) ? block->ptr[i] : NULL;
+}
+
+/* walk down to the leaf of a key, return the position in the leaf */
+static INLINE unsigned int
+btree_descend(const struct btree *tree, const union btree_key *k, struct btree_path *path, enum btree_key_type type)
+{
+  struct btree_block *block = tree->root;
+  unsigned int d;
+
+  for (d = 0; d + 1 < tree->depth; d++) {
+    path->block[d] = block;
+    path->idx[d] = btree_pos(type, block, k, 1);
+    block = block->ptr[path->idx[d]];
+  }
+  path->block[d] = block;
+  path->idx[d] = btree_pos(type, block, k, 0);
+  return path->idx[d];
+}
+
+static INLINE int
+btree_insert_type(struct btree *tree, struct btree_node *new, enum btree_key_type type)
+{
+  struct btree_path path;
+  struct btree_block *block, *right;
+  union btree_key k;
+  unsigned int pos, d, half;
+  int inner;
+
+  btree_load(type, &k, new->key);
+
+  if (tree->root == NULL) {
+    block = btree_alloc_block(type);
+    btree_set_key(type, block, 0, &k);
+    block->ptr[0] = new;
+    block->count = 1;
+
+    tree->root = block;
+    tree->depth = 1;
+    tree->first = tree->last = new;
+    new->next = new->prev = NULL;
+    tree->count = 1;
+    return 0;
+  }
+
+  pos = btree_descend(tree, &k, &path, type);
+  d = tree->depth - 1;
+  block = path.block[d];
+  if (pos < block->count && btree_key_equal(type, block, pos, &k)) {
+    return -1;
+  }
+
+  /* leaves are never empty, so a neighbour of the new node is in this one */
+  if (pos < block->count) {
+    struct btree_node *succ = block->ptr[pos];
+
+    new->next = succ;
+    new->prev = succ->prev;
+    succ->prev = new;
+  } else {
+    struct btree_node *pred = block->ptr[pos - 1];
+
+    new->prev = pred;
+    new->next = pred->next;
+    pred->next = new;
+  }
+  if (new->prev != NULL) {
+    new->prev->next = new;
+  } else {
+    tree->first = new;
+  }
+  if (new->next != NULL) {
+    new->next->prev = new;
+  } else {
+    tree->last = new;
+  }
+  tree->count++;
+
+  btree_block_insert(type, block, pos, &k, new, 0);
+
+  /* split full blocks on the way up */
+  for (inner = 0; block->count == BTREE_BLOCK_KEYS; inner = 1) {
+    half = block->count / 2;
+    right = btree_alloc_block(type);
+
+    if (inner) {
+      /* the middle key moves up */
+      btree_get_key(type, block, half, &k);
+      right->count = block->count - half - 1;
+      btree_move_keys(type, right, 0, block, half + 1, right->count);
+      memcpy(right->ptr, &block->ptr[half + 1], (right->count + 1) * sizeof(right->ptr[0]));
+    } else {
+      /* the first key of the right leaf is copied up */
+      right->count = block->count - half;
+      btree_move_keys(type, right, 0, block, half, right->count);
+      memcpy(right->ptr, &block->ptr[half], right->count * sizeof(right->ptr[0]));
+      btree_get_key(type, right, 0, &k);
+    }
+    block->count = half;
+
+    if (d == 0) {
+      struct btree_block *root = btree_alloc_block(type);
+
+      assert(tree->depth < BTREE_MAX_DEPTH);
+      btree_set_key(type, root, 0, &k);
+      root->ptr[0] = block;
+      root->ptr[1] = right;
+      root->count = 1;
+      tree->root = root;
+      tree->depth++;
+      break;
+    }
+
+    d--;
+    block = path.block[d];
+    btree_block_insert(type, block, path.idx[d], &k, right, 1);
+  }
+  return 0;
+}
+
+static INLINE void
+btree_delete_type(struct btree *tree, struct btree_node *node, enum btree_key_type type)
+{
+  struct btree_path path;
+  struct btree_block *block;
+  union btree_key k;
+  unsigned int pos, d;
+
+  btree_load(type, &k, node->key);
+  pos = btree_descend(tree, &k, &path, type);
+  d = tree->depth - 1;
+  block = path.block[d];
+  assert(pos < block->count && block->ptr[pos] == node);
+
+  if (node->prev != NULL) {
+    node->prev->next = node->next;
+  } else {
+    tree->first = node->next;
+  }
+  if (node->next != NULL) {
+    node->next->prev = node->prev;
+  } else {
+    tree->last = node->prev;
+  }
+  tree->count--;
+
+  block->count--;
+  btree_move_keys(type, block, pos, block, pos + 1, block->count - pos);
+  memmove(&block->ptr[pos], &block->ptr[pos + 1], (block->count - pos) * sizeof(block->ptr[0]));
+
+  /*
+   * Blocks are not merged, only empty ones are removed. The separator
+   * keys in the inner blocks stay valid bounds when keys go away.
+   */
+  while (block->count == 0 && d > 0) {
+    free(block);
+
+    d--;
+    block = path.block[d];
+    pos = path.idx[d];
+    if (block->count == 0) {
+      /* that was the only child, so this block is empty as well */
+      continue;
+    }
+
+    /* drop the child and the key which separated it from a neighbour */
+    btree_move_keys(type, block, pos ? pos - 1 : 0, block, pos ? pos : 1, block->count - (pos ? pos : 1));
+    memmove(&block->ptr[pos], &block->ptr[pos + 1], (block->count - pos) * sizeof(block->ptr[0]));
+    block->count--;
+    break;
+  }
+
+  if (tree->count == 0) {
+    free(tree->root);
+    tree->root = NULL;
+    tree->depth = 0;
+    return;
+  }
+
+  /* a root with a single child is not needed */
+  while (tree->depth > 1 && tree->root->count == 0) {
+    block = tree->root;
+    tree->root = block->ptr[0];
+    free(block);
+    tree->depth--;
+  }
+}
+
+struct btree_node *
+btree4_find(const struct btree *tree, const void *key)
+{
+  return btree_find_type(tree, key, BTREE_KEY_IPV4);
+}
+
+int
+btree4_insert(struct btree *tree, struct btree_node *new)
+{
+  return btree_insert_type(tree, new, BTREE_KEY_IPV4);
+}
+
+void
+btree4_delete(struct btree *tree, struct btree_node *node)
+{
+  btree_delete_type(tree, node, BTREE_KEY_IPV4);
+}
+
+struct btree_node *
+btree6_find(const struct btree *tree, const void *key)
+{
+  return btree_find_type(tree, key, BTREE_KEY_IPV6);
+}
+
+int
+btree6_insert(struct btree *tree, struct btree_node *new)
+{
+  return btree_insert_type(tree, new, BTREE_KEY_IPV6);
+}
+
+void
+btree6_delete(struct btree *tree, struct btree_node *node)
+{
+  btree_delete_type(tree, node, BTREE_KEY_IPV6);
+}
+
+/**
+ * Find the node of a key
+ *
+ * @param tree the tree
+ * @param key the key
+ * @return the node or NULL if the key is not in the tree
+ */
+struct btree_node *
+btree_find(const struct btree *tree, const void *key)
+{
+  return tree->type == BTREE_KEY_IPV4 ? btree4_find(tree, key) : btree6_find(tree, key);
+}
+
+/**
+ * Insert a node into a tree
+ *
+ * @param tree the tree
+ * @param new the node, with its key set
+ * @return 0 on success, -1 if the key is in the tree already
+ */
+int
+btree_insert(struct btree *tree, struct btree_node *new)
+{
+  return tree->type == BTREE_KEY_IPV4 ? btree4_insert(tree, new) : btree6_insert(tree, new);
+}
+
+/**
+ * Remove a node from a tree
+ *
+ * @param tree the tree
+ * @param node the node, which must be in the tree
+ */
+void
+btree_delete(struct btree *tree, struct btree_node *node)
+{
+  if (tree->type == BTREE_KEY_IPV4) {
+    btree4_delete(tree, node);
+  } else {
+    btree6_delete(tree, node);
+  }
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,166 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _BTREE_H
+#define _BTREE_H
+
+#include <stddef.h>
+
+#include "common/avl.h"
+
+/*
+ * A B+-tree with the address keys stored in the tree blocks, for the
+ * databases which are keyed by an IPv4 or IPv6 address. A lookup
+ * compares integers in a few contiguous arrays instead of following a
+ * pointer and calling a compare function per level.
+ *
+ * Like with the avl tree, the btree_node is embedded in the structure
+ * which is stored and points to its key, and all nodes are linked in
+ * key order, so walking the tree does not touch the tree blocks at all.
+ * Keys must be unique.
+ */
+
+/* keys per block, 16 IPv4 keys are one cache line */
+#define BTREE_BLOCK_KEYS 16
+
+enum btree_key_type {
+  BTREE_KEY_IPV4,
+  BTREE_KEY_IPV6
+};
+
+struct btree_node {
+  struct btree_node *next;
+  struct btree_node *prev;
+  void *key;
+};
+
+struct btree_block;
+
+struct btree {
+  struct btree_block *root;
+  struct btree_node *first;
+  struct btree_node *last;
+  unsigned int count;
+  unsigned int depth;                  /* 0 if empty, 1 if the root is a leaf */
+  enum btree_key_type type;
+};
+
+void btree_init(struct btree *, enum btree_key_type);
+struct btree_node *btree_find(const struct btree *, const void *);
+int btree_insert(struct btree *, struct btree_node *);
+void btree_delete(struct btree *, struct btree_node *);
+
+/*
+ * The same, compiled for one key type each. btree_find() and friends
+ * only pick one of them by the type of the tree; a caller which knows
+ * the type may call them directly.
+ */
+struct btree_node *btree4_find(const struct btree *, const void *);
+int btree4_insert(struct btree *, struct btree_node *);
+void btree4_delete(struct btree *, struct btree_node *);
+struct btree_node *btree6_find(const struct btree *, const void *);
+int btree6_insert(struct btree *, struct btree_node *);
+void btree6_delete(struct btree *, struct btree_node *);
+
+static INLINE struct btree_node *
+btree_walk_first(struct btree *tree)
+{
+  return tree->first;
+}
+static INLINE struct btree_node *
+btree_walk_last(struct btree *tree)
+{
+  return tree->last;
+}
+static INLINE struct btree_node *
+btree_walk_next(struct btree_node *node)
+{
+  return node->next;
+}
+static INLINE struct btree_node *
+btree_walk_prev(struct btree_node *node)
+{
+  return node->prev;
+}
+
+/* and const versions*/
+static INLINE const struct btree_node *
+btree_walk_first_c(const struct btree *tree)
+{
+  return tree->first;
+}
+static INLINE const struct btree_node *
+btree_walk_last_c(const struct btree *tree)
+{
+  return tree->last;
+}
+static INLINE const struct btree_node *
+btree_walk_next_c(const struct btree_node *node)
+{
+  return node->next;
+}
+static INLINE const struct btree_node *
+btree_walk_prev_c(const struct btree_node *node)
+{
+  return node->prev;
+}
+
+/*
+ * Macro to define an inline function to map from a btree_node offset back to the
+ * base of the datastructure.
+ */
+#define BTREENODE2STRUCT(funcname, structname, btreenodename) \
+static inline structname * funcname (struct btree_node *ptr)\
+{\
+  return( \
+    ptr ? \
+      (structname *) (((size_t) ptr) - offsetof(structname, btreenodename)) : \
+      NULL); \
+}
+
+#endif /* _BTREE_H */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
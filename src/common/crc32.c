@@ -0,0 +1,243 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#include <stdbool.h>
+
+#include "common/crc32.h"
+
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || defined __clang__)
+#define CRC32_PCLMUL 1
+#include <immintrin.h>
+#endif /* x86 */
+
+#define CRC32_POLYNOMIAL 0xedb88320UL /* bit-inverse of 0x04c11db7UL */
+
+/* tables for slicing-by-8, table[0] is the classic byte-at-a-time table */
+static uint32_t crc32_table[8][256];
+
+static bool crc32_initialized = false;
+
+#ifdef CRC32_PCLMUL
+static bool crc32_use_pclmul = false;
+
+/*
+ * Fold 16 bytes at a time with carry-less multiplications, as described
+ * in Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+ * Instruction". The length must be a multiple of 16 and at least 64.
+ * Works on the bit-inverted crc, like the table kernel.
+ */
+__attribute__ ((target("pclmul,sse4.1")))
+static uint32_t
+crc32_fold_pclmul(uint32_t crc, const unsigned char *buf, size_t len)
+{
+  /* the constants for the reflected IEEE polynomial */
+  static const uint64_t k1k2[2] __attribute__ ((aligned(16))) = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+  static const uint64_t k3k4[2] __attribute__ ((aligned(16))) = { 0x01751997d0ULL, 0x00ccaa009eULL };
+  static const uint64_t k5k0[2] __attribute__ ((aligned(16))) = { 0x0163cd6124ULL, 0x0000000000ULL };
+  static const uint64_t poly[2] __attribute__ ((aligned(16))) = { 0x01db710641ULL, 0x01f7011641ULL };
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+  x1 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+  x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+  x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+  x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+  x0 = _mm_load_si128((const __m128i *)k1k2);
+  buf += 64;
+  len -= 64;
+
+  /* fold four blocks in parallel */
+  while (len >= 64) {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)(buf + 0x00)));
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(buf + 0x10)));
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(buf + 0x20)));
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(buf + 0x30)));
+    buf += 64;
+    len -= 64;
+  }
+
+  /* fold the four blocks into one */
+  x0 = _mm_load_si128((const __m128i *)k3k4);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+  /* fold the remaining single blocks */
+  while (len >= 16) {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)buf)), x5);
+    buf += 16;
+    len -= 16;
+  }
+
+  /* fold 128 bits to 64 bits */
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  x1 = _mm_srli_si128(x1, 8);
+  x1 = _mm_xor_si128(x1, x2);
+
+  x0 = _mm_loadl_epi64((const __m128i *)k5k0);
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, x3);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  /* Barrett reduction to 32 bits */
+  x0 = _mm_load_si128((const __m128i *)poly);
+  x2 = _mm_and_si128(x1, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+#endif /* CRC32_PCLMUL */
+
+/*
+ * Table driven kernel, eight bytes per step. The bytes are combined
+ * one by one, so it does not depend on alignment or byte order.
+ */
+static uint32_t
+crc32_slice8(uint32_t crc, const unsigned char *buf, size_t len)
+{
+  while (len >= 8) {
+    crc ^= (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+    crc = crc32_table[7][crc & 0xff] ^ crc32_table[6][(crc >> 8) & 0xff]
+      ^ crc32_table[5][(crc >> 16) & 0xff] ^ crc32_table[4][crc >> 24]
+      ^ crc32_table[3][buf[4]] ^ crc32_table[2][buf[5]]
+      ^ crc32_table[1][buf[6]] ^ crc32_table[0][buf[7]];
+    buf += 8;
+    len -= 8;
+  }
+
+  while (len > 0) {
+    crc = (crc >> 8) ^ crc32_table[0][(crc ^ *buf++) & 0xff];
+    len--;
+  }
+  return crc;
+}
+
+/**
+ * Generate the crc tables and select the fastest kernel
+ */
+void
+crc32_init(void)
+{
+  uint32_t crc;
+  int i, j;
+
+  if (crc32_initialized) {
+    return;
+  }
+
+  for (i = 0; i < 256; i++) {
+    crc = (uint32_t)i;
+    for (j = 0; j < 8; j++) {
+      crc = (crc & 1) ? (crc >> 1) ^ CRC32_POLYNOMIAL : crc >> 1;
+    }
+    crc32_table[0][i] = crc;
+  }
+
+  /* table[j][i] is the crc of byte i followed by j zero bytes */
+  for (i = 0; i < 256; i++) {
+    crc = crc32_table[0][i];
+    for (j = 1; j < 8; j++) {
+      crc = (crc >> 8) ^ crc32_table[0][crc & 0xff];
+      crc32_table[j][i] = crc;
+    }
+  }
+
+#ifdef CRC32_PCLMUL
+  __builtin_cpu_init();
+  crc32_use_pclmul = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif /* CRC32_PCLMUL */
+
+  crc32_initialized = true;
+}
+
+/**
+ * Calculate the CRC-32 of a buffer
+ * @param buf pointer to the data
+ * @param len number of bytes
+ * @return CRC-32 value
+ */
+uint32_t
+crc32_ieee(const void *buf, size_t len)
+{
+  const unsigned char *ptr = buf;
+  uint32_t crc = 0xffffffffUL;
+
+#ifdef CRC32_PCLMUL
+  if (crc32_use_pclmul && len >= 64) {
+    size_t blocks = len & ~(size_t)15;
+
+    crc = crc32_fold_pclmul(crc, ptr, blocks);
+    ptr += blocks;
+    len -= blocks;
+  }
+#endif /* CRC32_PCLMUL */
+
+  return crc32_slice8(crc, ptr, len) ^ 0xffffffffUL;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
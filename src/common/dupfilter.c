@@ -0,0 +1,233 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/dupfilter.h"
+#include "olsr.h"
+#include "scheduler.h"
+
+/* sets are aligned to this, so that a set never straddles two cache lines */
+#define DUPFILTER_ALIGN 64
+
+static inline bool
+dupfilter_slot_live(const struct dupfilter_slot *slot)
+{
+  return slot->timeout != 0 && !olsr_isTimedOut(slot->timeout);
+}
+
+/*
+ * Check a slot and mark it unused if it has expired. The time stamps
+ * wrap after 2^31 milliseconds, an expired slot which kept its stamp
+ * would then look live again.
+ */
+static inline bool
+dupfilter_slot_expire(struct dupfilter_slot *slot)
+{
+  if (dupfilter_slot_live(slot)) {
+    return true;
+  }
+  slot->timeout = 0;
+  return false;
+}
+
+/*
+ * Map a fingerprint to a set. The fingerprint is mixed first, because
+ * the low bits of a CRC are not independent of the packet length.
+ */
+static inline struct dupfilter_set *
+dupfilter_get_set(struct dupfilter *filter, uint32_t fingerprint)
+{
+  return &filter->sets[(uint32_t)(fingerprint * 0x9e3779b1UL) >> (32 - filter->set_bits)];
+}
+
+/**
+ * Initialize a duplicate filter
+ * @param filter the filter
+ * @param capacity the minimum number of fingerprints the filter can
+ *   remember, it is rounded up to a power of two
+ * @param hold_time the time in milliseconds a fingerprint is remembered
+ */
+void
+dupfilter_init(struct dupfilter *filter, uint32_t capacity, uint32_t hold_time)
+{
+  uint32_t sets;
+
+  memset(filter, 0, sizeof(*filter));
+
+  filter->set_bits = 1;
+  while (((uint32_t)DUPFILTER_WAYS << filter->set_bits) < capacity && filter->set_bits < 24) {
+    filter->set_bits++;
+  }
+  sets = 1u << filter->set_bits;
+
+  /* one allocation for the whole lifetime of the filter */
+  filter->mem = olsr_malloc(sets * sizeof(struct dupfilter_set) + DUPFILTER_ALIGN, "dupfilter");
+  filter->sets = (struct dupfilter_set *)(((size_t)filter->mem + DUPFILTER_ALIGN - 1) & ~(size_t)(DUPFILTER_ALIGN - 1));
+  filter->hold_time = hold_time;
+}
+
+/**
+ * Release the memory of a duplicate filter
+ * @param filter the filter
+ */
+void
+dupfilter_free(struct dupfilter *filter)
+{
+  free(filter->mem);
+  filter->mem = NULL;
+  filter->sets = NULL;
+}
+
+/**
+ * Check if a fingerprint was seen recently, then remember that it has
+ * been seen now.
+ * @param filter the filter
+ * @param fingerprint the fingerprint of the packet
+ * @return true if the fingerprint was seen recently
+ */
+bool
+dupfilter_check_and_mark(struct dupfilter *filter, uint32_t fingerprint)
+{
+  struct dupfilter_set *set = dupfilter_get_set(filter, fingerprint);
+  struct dupfilter_slot *victim = NULL;
+  bool victim_live = true;
+  uint32_t timeout;
+  int i;
+
+  filter->lookups++;
+
+  for (i = 0; i < DUPFILTER_WAYS; i++) {
+    struct dupfilter_slot *slot = &set->slot[i];
+
+    if (!dupfilter_slot_expire(slot)) {
+      if (victim_live) {
+        victim = slot;
+        victim_live = false;
+      }
+      continue;
+    }
+
+    if (slot->fingerprint == fingerprint) {
+      /* always mark as "seen recently": refresh time-out */
+      slot->timeout = olsr_getTimestamp(filter->hold_time);
+      if (slot->timeout == 0) {
+        slot->timeout = 1;
+      }
+      filter->duplicates++;
+      return true;
+    }
+
+    /* otherwise evict the live slot that expires first */
+    if (victim_live && (victim == NULL || (int32_t)(slot->timeout - victim->timeout) < 0)) {
+      victim = slot;
+    }
+  }
+
+  if (victim_live) {
+    filter->evictions++;
+  }
+
+  timeout = olsr_getTimestamp(filter->hold_time);
+  victim->fingerprint = fingerprint;
+  victim->timeout = timeout != 0 ? timeout : 1;
+  return false;
+}
+
+/**
+ * Mark all expired slots of a duplicate filter as unused. Lookups only
+ * clean up the set they visit, so this should be called periodically,
+ * well within 24 days.
+ * @param filter the filter
+ */
+void
+dupfilter_expire(struct dupfilter *filter)
+{
+  uint32_t sets = 1u << filter->set_bits;
+  uint32_t s;
+  int i;
+
+  for (s = 0; s < sets; s++) {
+    for (i = 0; i < DUPFILTER_WAYS; i++) {
+      dupfilter_slot_expire(&filter->sets[s].slot[i]);
+    }
+  }
+}
+
+/**
+ * Get the statistics of a duplicate filter. This walks the whole
+ * table, so it should only be called now and then.
+ * @param filter the filter
+ * @param stats pointer to statistics to fill in
+ */
+void
+dupfilter_get_stats(struct dupfilter *filter, struct dupfilter_stats *stats)
+{
+  uint32_t sets = 1u << filter->set_bits;
+  uint32_t s;
+  int i;
+
+  memset(stats, 0, sizeof(*stats));
+  stats->capacity = sets * DUPFILTER_WAYS;
+  stats->lookups = filter->lookups;
+  stats->duplicates = filter->duplicates;
+  stats->evictions = filter->evictions;
+
+  for (s = 0; s < sets; s++) {
+    for (i = 0; i < DUPFILTER_WAYS; i++) {
+      if (dupfilter_slot_expire(&filter->sets[s].slot[i])) {
+        stats->entries++;
+      }
+    }
+  }
+
+  /* a fingerprint collides with one particular live fingerprint
+   * with a chance of 1 in 2^32 */
+  stats->false_positive_rate = (double)stats->entries / 4294967296.0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,109 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _DUPFILTER_H
+#define _DUPFILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * A fixed size filter of recently seen packet fingerprints.
+ *
+ * The filter is a set associative table: a fingerprint maps to one set
+ * of DUPFILTER_WAYS slots which share a cache line. A slot remembers a
+ * fingerprint for hold_time milliseconds after it was last seen. When all
+ * slots of a set are in use the one that expires first is evicted, so the
+ * memory use is bounded and no memory is allocated after initialisation.
+ *
+ * Full fingerprints are stored, so the filter itself does not add false
+ * positives: a packet is only reported as a duplicate if its fingerprint
+ * equals one of the live fingerprints. Evictions can cause a real duplicate
+ * to be missed; they are counted.
+ */
+#define DUPFILTER_WAYS 8
+
+struct dupfilter_slot {
+  uint32_t fingerprint;
+  uint32_t timeout;                    /* 0 means unused, cleared on expiry */
+};
+
+struct dupfilter_set {
+  struct dupfilter_slot slot[DUPFILTER_WAYS];
+};
+
+struct dupfilter {
+  struct dupfilter_set *sets;
+  void *mem;
+  uint32_t set_bits;
+  uint32_t hold_time;
+
+  /* statistics */
+  uint32_t lookups;
+  uint32_t duplicates;
+  uint32_t evictions;
+};
+
+struct dupfilter_stats {
+  uint32_t capacity;
+  uint32_t entries;                    /* live fingerprints */
+  uint32_t lookups;
+  uint32_t duplicates;
+  uint32_t evictions;
+
+  /* chance that a new packet is taken for a duplicate of a live one */
+  double false_positive_rate;
+};
+
+void dupfilter_init(struct dupfilter *, uint32_t capacity, uint32_t hold_time);
+void dupfilter_free(struct dupfilter *);
+bool dupfilter_check_and_mark(struct dupfilter *, uint32_t fingerprint);
+void dupfilter_expire(struct dupfilter *);
+void dupfilter_get_stats(struct dupfilter *, struct dupfilter_stats *);
+
+#endif /* _DUPFILTER_H */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
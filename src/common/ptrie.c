@@ -0,0 +1,424 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/ptrie.h"
+#include "defs.h"
+#include "olsr.h"
+
+/* branching node without an entry of its own */
+struct ptrie_glue {
+  struct ptrie_node node;              /* must be first */
+  struct olsr_ip_prefix prefix;
+};
+
+/*
+ * Return a single bit of an address, bit 0 is the most significant one.
+ * The ipv4 address shares its first four bytes with the ipv6 address
+ * inside the union, so this works for both address families.
+ */
+static inline unsigned int
+ptrie_bit(const union olsr_ip_addr *addr, unsigned int bit)
+{
+  return (addr->v6.s6_addr[bit >> 3] >> (7 - (bit & 7))) & 1;
+}
+
+/*
+ * Return the number of leading bits two prefixes have in common,
+ * limited by the shorter prefix length.
+ */
+static unsigned int
+ptrie_common_len(const struct olsr_ip_prefix *pfx1, const struct olsr_ip_prefix *pfx2)
+{
+  const unsigned int max = MIN(pfx1->prefix_len, pfx2->prefix_len);
+  unsigned int bit;
+
+  for (bit = 0; bit < max; bit += 8) {
+    uint8_t diff = pfx1->prefix.v6.s6_addr[bit >> 3] ^ pfx2->prefix.v6.s6_addr[bit >> 3];
+
+    if (diff) {
+      while (!(diff & 0x80)) {
+        diff <<= 1;
+        bit++;
+      }
+      return MIN(bit, max);
+    }
+  }
+  return max;
+}
+
+static struct ptrie_node *
+ptrie_alloc_glue(const struct olsr_ip_prefix *key, uint8_t prefix_len)
+{
+  struct ptrie_glue *glue = olsr_malloc(sizeof(*glue), "ptrie glue node");
+
+  glue->prefix = *key;
+  glue->prefix.prefix_len = prefix_len;
+  glue->node.key = &glue->prefix;
+  glue->node.flags = PTRIE_FLAG_GLUE;
+
+  return &glue->node;
+}
+
+/*
+ * Return the pointer referencing a node in the trie,
+ * either the root pointer or a child pointer of the parent.
+ */
+static struct ptrie_node **
+ptrie_slot(struct ptrie *trie, struct ptrie_node *node)
+{
+  if (node->parent == NULL) {
+    return &trie->root;
+  }
+  return &node->parent->child[node->parent->child[1] == node];
+}
+
+/*
+ * Put a node into the trie position of another one.
+ */
+static void
+ptrie_substitute(struct ptrie *trie, struct ptrie_node *old, struct ptrie_node *node)
+{
+  int i;
+
+  *ptrie_slot(trie, old) = node;
+  node->parent = old->parent;
+
+  for (i = 0; i < 2; i++) {
+    node->child[i] = old->child[i];
+    if (node->child[i]) {
+      node->child[i]->parent = node;
+    }
+  }
+}
+
+void
+ptrie_init(struct ptrie *trie)
+{
+  trie->root = NULL;
+  trie->count = 0;
+}
+
+/**
+ * Insert a node into the trie. The key pointer of the node
+ * must be set before.
+ *
+ * @param trie the trie
+ * @param node the node to insert
+ * @param allow_duplicates PTRIE_DUP if several entries with the same
+ *   prefix are allowed, PTRIE_DUP_NO otherwise
+ * @return 0 on success, -1 if the prefix is already in the trie
+ *   and duplicates are not allowed
+ */
+int
+ptrie_insert(struct ptrie *trie, struct ptrie_node *node, int allow_duplicates)
+{
+  const struct olsr_ip_prefix *key = node->key;
+  struct ptrie_node **slot = &trie->root;
+  struct ptrie_node *parent = NULL;
+  struct ptrie_node *cur = trie->root;
+  unsigned int common = 0;
+
+  node->parent = NULL;
+  node->child[0] = NULL;
+  node->child[1] = NULL;
+  node->dup = NULL;
+  node->flags = PTRIE_FLAG_LINKED;
+
+  while (cur) {
+    common = ptrie_common_len(key, cur->key);
+    if (common < cur->key->prefix_len) {
+      /* the key leaves the path of the trie above cur */
+      break;
+    }
+
+    if (cur->key->prefix_len == key->prefix_len) {
+      if (cur->flags & PTRIE_FLAG_GLUE) {
+        /* the new entry takes over the branching node */
+        ptrie_substitute(trie, cur, node);
+        free(cur);
+      } else if (allow_duplicates == PTRIE_DUP) {
+        node->flags |= PTRIE_FLAG_DUP;
+        node->parent = cur;
+        node->dup = cur->dup;
+        cur->dup = node;
+      } else {
+        node->flags = 0;
+        return -1;
+      }
+      trie->count++;
+      return 0;
+    }
+
+    parent = cur;
+    slot = &cur->child[ptrie_bit(&key->prefix, cur->key->prefix_len)];
+    cur = *slot;
+  }
+
+  if (cur == NULL) {
+    /* new leaf */
+    node->parent = parent;
+  } else if (common == key->prefix_len) {
+    /* the new entry covers cur */
+    node->child[ptrie_bit(&cur->key->prefix, common)] = cur;
+    node->parent = parent;
+    cur->parent = node;
+  } else {
+    /* the paths diverge, a new branching node is needed */
+    struct ptrie_node *glue = ptrie_alloc_glue(key, common);
+
+    glue->child[ptrie_bit(&key->prefix, common)] = node;
+    glue->child[ptrie_bit(&cur->key->prefix, common)] = cur;
+    glue->parent = parent;
+    node->parent = glue;
+    cur->parent = glue;
+    node = glue;
+  }
+
+  *slot = node;
+  trie->count++;
+  return 0;
+}
+
+/**
+ * Remove a node from the trie.
+ * Nothing is done for a node which is not in the trie,
+ * like one whose ptrie_insert() failed.
+ *
+ * @param trie the trie
+ * @param node the node to remove
+ */
+void
+ptrie_delete(struct ptrie *trie, struct ptrie_node *node)
+{
+  struct ptrie_node *parent, *child;
+
+  if (!(node->flags & PTRIE_FLAG_LINKED)) {
+    return;
+  }
+  node->flags &= ~PTRIE_FLAG_LINKED;
+  trie->count--;
+
+  if (node->flags & PTRIE_FLAG_DUP) {
+    struct ptrie_node *prev;
+
+    /* unlink from the duplicate chain of the owner */
+    for (prev = node->parent; prev->dup != node; prev = prev->dup);
+    prev->dup = node->dup;
+    return;
+  }
+
+  if (node->dup) {
+    struct ptrie_node *heir = node->dup, *dup;
+
+    /* promote the first duplicate into the trie */
+    heir->flags &= ~PTRIE_FLAG_DUP;
+    for (dup = heir->dup; dup; dup = dup->dup) {
+      dup->parent = heir;
+    }
+    ptrie_substitute(trie, node, heir);
+    return;
+  }
+
+  if (node->child[0] && node->child[1]) {
+    /* the node is still needed for branching */
+    ptrie_substitute(trie, node, ptrie_alloc_glue(node->key, node->key->prefix_len));
+    return;
+  }
+
+  parent = node->parent;
+  child = node->child[0] ? node->child[0] : node->child[1];
+
+  *ptrie_slot(trie, node) = child;
+  if (child) {
+    child->parent = parent;
+    return;
+  }
+
+  /* a leaf went away, a branching parent is not needed anymore */
+  if (parent && (parent->flags & PTRIE_FLAG_GLUE)) {
+    child = parent->child[0] ? parent->child[0] : parent->child[1];
+
+    *ptrie_slot(trie, parent) = child;
+    child->parent = parent->parent;
+    free(parent);
+  }
+}
+
+/**
+ * Lookup an exact prefix in the trie.
+ *
+ * @return the first entry with this prefix, NULL if not found
+ */
+struct ptrie_node *
+ptrie_find(struct ptrie *trie, const struct olsr_ip_prefix *key)
+{
+  struct ptrie_node *cur = trie->root;
+
+  while (cur) {
+    if (ptrie_common_len(key, cur->key) < cur->key->prefix_len) {
+      return NULL;
+    }
+    if (cur->key->prefix_len == key->prefix_len) {
+      return (cur->flags & PTRIE_FLAG_GLUE) ? NULL : cur;
+    }
+    cur = cur->child[ptrie_bit(&key->prefix, cur->key->prefix_len)];
+  }
+  return NULL;
+}
+
+/**
+ * Lookup the longest prefix in the trie that covers the given prefix.
+ * Use a host prefix (maxplen) for a plain longest prefix match on an address.
+ *
+ * @return the first entry with the longest matching prefix, NULL if not found
+ */
+struct ptrie_node *
+ptrie_find_longest(struct ptrie *trie, const struct olsr_ip_prefix *key)
+{
+  struct ptrie_node *cur = trie->root;
+  struct ptrie_node *best = NULL;
+
+  while (cur) {
+    if (ptrie_common_len(key, cur->key) < cur->key->prefix_len) {
+      break;
+    }
+    if (!(cur->flags & PTRIE_FLAG_GLUE)) {
+      best = cur;
+    }
+    if (cur->key->prefix_len == key->prefix_len) {
+      break;
+    }
+    cur = cur->child[ptrie_bit(&key->prefix, cur->key->prefix_len)];
+  }
+  return best;
+}
+
+/*
+ * Pre-order successor of a node, restricted to the subtree of nodes
+ * with a prefix length of at least min_len.
+ */
+static struct ptrie_node *
+ptrie_walk_subtree_next(struct ptrie_node *node, unsigned int min_len)
+{
+  if (node->child[0]) {
+    return node->child[0];
+  }
+  if (node->child[1]) {
+    return node->child[1];
+  }
+
+  while (node->parent && node->parent->key->prefix_len >= min_len) {
+    struct ptrie_node *parent = node->parent;
+
+    if (parent->child[0] == node && parent->child[1]) {
+      return parent->child[1];
+    }
+    node = parent;
+  }
+  return NULL;
+}
+
+/**
+ * Get the first entry covered by a prefix.
+ *
+ * @return the entry, NULL if the prefix covers no entry
+ */
+struct ptrie_node *
+ptrie_walk_covered_first(struct ptrie *trie, const struct olsr_ip_prefix *prefix)
+{
+  struct ptrie_node *cur = trie->root;
+
+  while (cur) {
+    unsigned int common = ptrie_common_len(prefix, cur->key);
+
+    if (cur->key->prefix_len >= prefix->prefix_len) {
+      /* all nodes below are covered if cur is covered */
+      if (common < prefix->prefix_len) {
+        return NULL;
+      }
+      if (cur->flags & PTRIE_FLAG_GLUE) {
+        return ptrie_walk_covered_next(cur, prefix);
+      }
+      return cur;
+    }
+
+    if (common < cur->key->prefix_len) {
+      return NULL;
+    }
+    cur = cur->child[ptrie_bit(&prefix->prefix, cur->key->prefix_len)];
+  }
+  return NULL;
+}
+
+/**
+ * Get the next entry covered by a prefix.
+ *
+ * @param node the current entry
+ * @param prefix the prefix used for ptrie_walk_covered_first()
+ * @return the next entry, NULL if there is none
+ */
+struct ptrie_node *
+ptrie_walk_covered_next(struct ptrie_node *node, const struct olsr_ip_prefix *prefix)
+{
+  if (node->dup) {
+    return node->dup;
+  }
+  if (node->flags & PTRIE_FLAG_DUP) {
+    /* end of the duplicate chain, continue at its owner */
+    node = node->parent;
+  }
+
+  do {
+    node = ptrie_walk_subtree_next(node, prefix->prefix_len);
+  } while (node && (node->flags & PTRIE_FLAG_GLUE));
+
+  return node;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,121 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _PTRIE_H
+#define _PTRIE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "olsr_types.h"
+
+/*
+ * A path compressed binary trie keyed by ip prefixes.
+ *
+ * In contrast to the avl tree the ptrie understands the structure of its
+ * keys, so it can answer longest prefix match queries and enumerate all
+ * prefixes covered by a given prefix without walking the whole database.
+ *
+ * Like the avl tree the nodes are embedded in the user datastructure and the
+ * key pointer must point to a struct olsr_ip_prefix in the same struct.
+ * Only the first prefix_len bits of a key are significant.
+ * Branching nodes which do not carry an entry ("glue" nodes) are allocated
+ * and freed internally.
+ */
+struct ptrie_node {
+  struct ptrie_node *parent;           /* parent node, owner for duplicates */
+  struct ptrie_node *child[2];
+  struct ptrie_node *dup;              /* next entry with an identical key */
+  const struct olsr_ip_prefix *key;
+  uint8_t flags;
+};
+
+#define PTRIE_FLAG_GLUE   1
+#define PTRIE_FLAG_DUP    2
+#define PTRIE_FLAG_LINKED 4            /* entry is in a trie */
+
+struct ptrie {
+  struct ptrie_node *root;
+  unsigned int count;
+};
+
+#define PTRIE_DUP    1
+#define PTRIE_DUP_NO 0
+
+void ptrie_init(struct ptrie *);
+int ptrie_insert(struct ptrie *, struct ptrie_node *, int);
+void ptrie_delete(struct ptrie *, struct ptrie_node *);
+
+struct ptrie_node *ptrie_find(struct ptrie *, const struct olsr_ip_prefix *);
+struct ptrie_node *ptrie_find_longest(struct ptrie *, const struct olsr_ip_prefix *);
+
+struct ptrie_node *ptrie_walk_covered_first(struct ptrie *, const struct olsr_ip_prefix *);
+struct ptrie_node *ptrie_walk_covered_next(struct ptrie_node *, const struct olsr_ip_prefix *);
+
+/*
+ * Iterate over all entries (including duplicates) whose prefix is covered
+ * by the given prefix, shortest prefixes first.
+ * Entries must not be added or removed while iterating.
+ */
+#define OLSR_FOR_ALL_PTRIE_COVERED(trie, prefix, node) \
+  for (node = ptrie_walk_covered_first(trie, prefix); node; node = ptrie_walk_covered_next(node, prefix))
+
+/*
+ * Macro to define an inline function to map from a ptrie_node offset back to
+ * the base of the datastructure.
+ */
+#define PTRIENODE2STRUCT(funcname, structname, ptrienodename) \
+static inline structname * funcname (struct ptrie_node *ptr)\
+{\
+  return( \
+    ptr ? \
+      (structname *) (((size_t) ptr) - offsetof(structname, ptrienodename)) : \
+      NULL); \
+}
+
+#endif /* _PTRIE_H */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,143 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/scratch.h"
+#include "olsr.h"
+
+/* the chunk header is padded, so that the first object is aligned */
+#define SCRATCH_HEADER ((sizeof(struct scratch_chunk) + SCRATCH_ALIGN - 1) & ~(size_t)(SCRATCH_ALIGN - 1))
+
+static void
+scratch_add_chunk(struct scratch_arena *arena, size_t size)
+{
+  struct scratch_chunk *chunk = olsr_malloc(SCRATCH_HEADER + size, "scratch chunk");
+
+  chunk->next = arena->chunk;
+  chunk->size = size;
+  arena->chunk = chunk;
+  arena->used = 0;
+}
+
+/**
+ * Initialize a scratch arena
+ * @param arena the arena
+ * @param size the initial size of the arena in bytes
+ */
+void
+scratch_init(struct scratch_arena *arena, size_t size)
+{
+  memset(arena, 0, sizeof(*arena));
+  scratch_add_chunk(arena, size);
+}
+
+/**
+ * Release all memory of a scratch arena
+ * @param arena the arena
+ */
+void
+scratch_free(struct scratch_arena *arena)
+{
+  struct scratch_chunk *chunk, *next;
+
+  for (chunk = arena->chunk; chunk; chunk = next) {
+    next = chunk->next;
+    free(chunk);
+  }
+  memset(arena, 0, sizeof(*arena));
+}
+
+/**
+ * Allocate memory from a scratch arena. The memory is not cleared and
+ * stays valid until the arena is reset.
+ * @param arena the arena
+ * @param size the number of bytes
+ * @return pointer to the memory, aligned to SCRATCH_ALIGN
+ */
+void *
+scratch_alloc(struct scratch_arena *arena, size_t size)
+{
+  void *ptr;
+
+  size = (size + SCRATCH_ALIGN - 1) & ~(size_t)(SCRATCH_ALIGN - 1);
+
+  if (arena->chunk == NULL || arena->used + size > arena->chunk->size) {
+    size_t chunk_size = arena->chunk ? arena->chunk->size * 2 : size;
+
+    scratch_add_chunk(arena, chunk_size > size ? chunk_size : size);
+  }
+
+  ptr = (char *)arena->chunk + SCRATCH_HEADER + arena->used;
+  arena->used += size;
+  arena->total += size;
+  if (arena->total > arena->high_water) {
+    arena->high_water = arena->total;
+  }
+  return ptr;
+}
+
+/**
+ * Release all objects of a scratch arena at once
+ * @param arena the arena
+ */
+void
+scratch_reset(struct scratch_arena *arena)
+{
+  if (arena->chunk != NULL && arena->chunk->next != NULL) {
+    /* the arena overflowed: replace the chain by one chunk that fits it all */
+    size_t size = arena->high_water;
+
+    scratch_free(arena);
+    arena->high_water = size;
+    scratch_add_chunk(arena, size);
+  }
+  arena->used = 0;
+  arena->total = 0;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,82 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _SCRATCH_H
+#define _SCRATCH_H
+
+#include <stddef.h>
+
+/*
+ * A bump pointer arena for short lived objects.
+ *
+ * Allocating is advancing a pointer, and all objects are released at once
+ * by resetting the arena. The arena starts with one chunk; when that runs
+ * out, further chunks are chained in. The next reset folds them back into
+ * a single chunk big enough for all of them, so after a few rounds the
+ * arena allocates nothing at all.
+ */
+#define SCRATCH_ALIGN 16
+
+struct scratch_chunk {
+  struct scratch_chunk *next;
+  size_t size;
+};
+
+struct scratch_arena {
+  struct scratch_chunk *chunk;         /* the chunk that is allocated from */
+  size_t used;                         /* bytes used in that chunk */
+  size_t total;                        /* bytes used in all chunks */
+  size_t high_water;                   /* most bytes used between resets */
+};
+
+void scratch_init(struct scratch_arena *, size_t size);
+void scratch_free(struct scratch_arena *);
+void *scratch_alloc(struct scratch_arena *, size_t size);
+void scratch_reset(struct scratch_arena *);
+
+#endif /* _SCRATCH_H */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
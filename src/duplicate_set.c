@@ -41,7 +41,7 @@
 
 #include "duplicate_set.h"
 #include "ipcalc.h"
-#include "common/avl.h"
+#include "common/btree.h"
 #include "olsr.h"
 #include "mid_set.h"
 #include "scheduler.h"
@@ -49,13 +49,13 @@
 
 static void olsr_cleanup_duplicate_entry(void *unused);
 
-struct avl_tree duplicate_set;
+struct btree duplicate_set;
 struct timer_entry *duplicate_cleanup_timer;
 
 void
 olsr_init_duplicate_set(void)
 {
-  avl_init(&duplicate_set, olsr_cnf->ip_version == AF_INET ? &avl_comp_ipv4 : &avl_comp_ipv6);
+  btree_init(&duplicate_set, olsr_cnf->ip_version == AF_INET ? BTREE_KEY_IPV4 : BTREE_KEY_IPV6);
 
   olsr_set_timer(&duplicate_cleanup_timer, DUPLICATE_CLEANUP_INTERVAL, DUPLICATE_CLEANUP_JITTER, OLSR_TIMER_PERIODIC,
                  &olsr_cleanup_duplicate_entry, NULL, 0);
@@ -64,7 +64,7 @@ olsr_init_duplicate_set(void)
 void olsr_cleanup_duplicates(union olsr_ip_addr *orig) {
   struct dup_entry *entry;
 
-  entry = (struct dup_entry *)avl_find(&duplicate_set, orig);
+  entry = duptree2dupentry(btree_find(&duplicate_set, orig));
   if (entry != NULL) {
     entry->too_low_counter = DUP_MAX_TOO_LOW - 2;
   }
@@ -79,7 +79,7 @@ olsr_create_duplicate_entry(void *ip, uint16_t seqnr)
     memcpy(&entry->ip, ip, olsr_cnf->ip_version == AF_INET ? sizeof(entry->ip.v4) : sizeof(entry->ip.v6));
     entry->seqnr = seqnr;
     entry->too_low_counter = 0;
-    entry->avl.key = &entry->ip;
+    entry->node.key = &entry->ip;
     entry->array = 0;
   }
   return entry;
@@ -92,7 +92,7 @@ olsr_cleanup_duplicate_entry(void __attribute__ ((unused)) * unused)
 
   OLSR_FOR_ALL_DUP_ENTRIES(entry) {
     if (TIMED_OUT(entry->valid_until)) {
-      avl_delete(&duplicate_set, &entry->avl);
+      btree_delete(&duplicate_set, &entry->node);
       free(entry);
     }
   }
@@ -139,11 +139,11 @@ olsr_message_is_duplicate(union olsr_message *m)
 
   valid_until = GET_TIMESTAMP(DUPLICATE_VTIME);
 
-  entry = (struct dup_entry *)avl_find(&duplicate_set, ip);
+  entry = duptree2dupentry(btree_find(&duplicate_set, ip));
   if (entry == NULL) {
     entry = olsr_create_duplicate_entry(ip, seqnr);
     if (entry != NULL) {
-      avl_insert(&duplicate_set, &entry->avl, 0);
+      btree_insert(&duplicate_set, &entry->node);
       entry->valid_until = valid_until;
     }
     return false;               // okay, we process this package
@@ -192,6 +192,43 @@ olsr_message_is_duplicate(union olsr_message *m)
   return false;                 /* no duplicate */
 }
 
+/**
+ * Check if a message has been recorded by olsr_message_is_duplicate()
+ * before, without recording it. This is a single lookup, so messages
+ * which are known anyway can be dropped before they are parsed.
+ *
+ * @param m the message
+ * @return true if the message is a known duplicate
+ */
+bool
+olsr_message_is_known(const union olsr_message *m)
+{
+  const struct dup_entry *entry;
+  uint16_t seqnr;
+  const void *ip;
+  int diff;
+
+  if (olsr_cnf->ip_version == AF_INET) {
+    seqnr = ntohs(m->v4.seqno);
+    ip = &m->v4.originator;
+  } else {
+    seqnr = ntohs(m->v6.seqno);
+    ip = &m->v6.originator;
+  }
+
+  entry = duptree2dupentry(btree_find(&duplicate_set, ip));
+  if (entry == NULL) {
+    return false;
+  }
+
+  /* too old to tell, leave it to olsr_message_is_duplicate() */
+  diff = olsr_seqno_diff(seqnr, entry->seqnr);
+  if (diff > 0 || diff < -31) {
+    return false;
+  }
+  return (entry->array & (1 << ((uint32_t) (-diff)))) != 0;
+}
+
 #ifndef NODEBUG
 void
 olsr_print_duplicate_table(void)
@@ -205,7 +242,7 @@ olsr_print_duplicate_table(void)
               olsr_wallclock_string(), ipwidth, "Node IP", "DupArray", "VTime");
 
   OLSR_FOR_ALL_DUP_ENTRIES(entry) {
-    OLSR_PRINTF(1, "%-*s %08x %s\n", ipwidth, olsr_ip_to_string(&addrbuf, (union olsr_ip_addr *)(entry->avl.key)),
+    OLSR_PRINTF(1, "%-*s %08x %s\n", ipwidth, olsr_ip_to_string(&addrbuf, (union olsr_ip_addr *)(entry->node.key)),
                 entry->array, olsr_clock_string(entry->valid_until));
   } OLSR_FOR_ALL_DUP_ENTRIES_END(entry);
 }
@@ -45,7 +45,7 @@
 #include "defs.h"
 #include "olsr.h"
 #include "mantissa.h"
-#include "common/avl.h"
+#include "common/btree.h"
 
 #define DUPLICATE_CLEANUP_INTERVAL 15000
 #define DUPLICATE_CLEANUP_JITTER 25
@@ -53,7 +53,7 @@
 #define DUP_MAX_TOO_LOW 16
 
 struct dup_entry {
-  struct avl_node avl;
+  struct btree_node node;
   union olsr_ip_addr ip;
   uint16_t seqnr;
   uint16_t too_low_counter;
@@ -61,13 +61,14 @@ struct dup_entry {
   uint32_t valid_until;
 };
 
-AVLNODE2STRUCT(duptree2dupentry, struct dup_entry, avl);
+BTREENODE2STRUCT(duptree2dupentry, struct dup_entry, node);
 
 void olsr_init_duplicate_set(void);
 void olsr_cleanup_duplicates(union olsr_ip_addr *orig);
 struct dup_entry *olsr_create_duplicate_entry(void *ip, uint16_t seqnr);
 int olsr_seqno_diff(uint16_t seqno1, uint16_t seqno2);
 int olsr_message_is_duplicate(union olsr_message *m);
+bool olsr_message_is_known(const union olsr_message *m);
 #ifndef NODEBUG
 void olsr_print_duplicate_table(void);
 #else
@@ -76,10 +77,10 @@ void olsr_print_duplicate_table(void);
 
 #define OLSR_FOR_ALL_DUP_ENTRIES(dup) \
 { \
-  struct avl_node *dup_tree_node, *next_dup_tree_node; \
-  for (dup_tree_node = avl_walk_first(&duplicate_set); \
+  struct btree_node *dup_tree_node, *next_dup_tree_node; \
+  for (dup_tree_node = btree_walk_first(&duplicate_set); \
     dup_tree_node; dup_tree_node = next_dup_tree_node) { \
-    next_dup_tree_node = avl_walk_next(dup_tree_node); \
+    next_dup_tree_node = btree_walk_next(dup_tree_node); \
     dup = duptree2dupentry(dup_tree_node);
 #define OLSR_FOR_ALL_DUP_ENTRIES_END(dup) }}
 
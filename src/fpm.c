@@ -42,6 +42,7 @@
 #include <stdio.h>
 #include <assert.h>
 #include "fpm.h"
+#include "common/autobuf.h"
 
 #if 1 // def USE_FPM
 
@@ -172,6 +173,40 @@ fpmtoa(fpm a)
   return ret[idx];
 }
 
+/**
+ * Append the same text as fpmtoa() to an autobuf, without printf
+ *
+ * @param abuf the autobuf
+ * @param a the value
+ * @return the number of characters appended or -1
+ */
+int
+abuf_append_fpm(struct autobuf *abuf, fpm a)
+{
+  unsigned long milli = (1000 * ((sfpm) (a) & FPM_MSK) + (FPM_NUM / 2)) >> FPM_BIT;
+  char frac[5];
+  int len;
+
+  if ((sfpm) a < 0) {
+    /* fpmtoa() prints the floor and a positive fraction */
+    return abuf_puts(abuf, fpmtoa(a));
+  }
+
+  len = abuf_append_uint(abuf, (sfpm) a >> FPM_BIT);
+  if (len < 0) {
+    return -1;
+  }
+  frac[0] = '.';
+  frac[1] = '0' + milli / 100;
+  frac[2] = '0' + milli / 10 % 10;
+  frac[3] = '0' + milli % 10;
+  frac[4] = '\0';
+  if (abuf_puts(abuf, frac) < 0) {
+    return -1;
+  }
+  return len + 4;
+}
+
 #else /* USE_FPM */
 
 float
@@ -193,6 +228,12 @@ fpmtoa(float a)
   return ret[idx];
 }
 
+int
+abuf_append_fpm(struct autobuf *abuf, float a)
+{
+  return abuf_puts(abuf, fpmtoa(a));
+}
+
 #endif /* USE_FPM */
 
 /*
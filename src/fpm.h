@@ -42,6 +42,8 @@
 #ifndef _FPM_H
 #define _FPM_H
 
+struct autobuf;
+
 #if 1 // def USE_FPM
 
 /*
@@ -120,6 +122,7 @@ fpm fpmidiv(fpm a, int b);
 
 fpm atofpm(const char *);
 const char *fpmtoa(fpm);
+int abuf_append_fpm(struct autobuf *, fpm);
 
 #else /* USE_FPM */
 
@@ -131,6 +134,7 @@ const char *fpmtoa(fpm);
 
 float atofpm(const char *);
 const char *fpmtoa(float);
+int abuf_append_fpm(struct autobuf *, float);
 
 #endif /* USE_FPM */
 
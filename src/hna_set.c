@@ -50,6 +50,7 @@
 #include "duplicate_handler.h"
 
 struct hna_entry hna_set[HASHSIZE];
+struct ptrie hna_net_trie;
 struct olsr_cookie_info *hna_net_timer_cookie = NULL;
 struct olsr_cookie_info *hna_entry_mem_cookie = NULL;
 struct olsr_cookie_info *hna_net_mem_cookie = NULL;
@@ -69,6 +70,8 @@ olsr_init_hna_set(void)
     hna_set[idx].prev = &hna_set[idx];
   }
 
+  ptrie_init(&hna_net_trie);
+
   hna_net_timer_cookie = olsr_alloc_cookie("HNA Network", OLSR_COOKIE_TYPE_TIMER);
 
   hna_net_mem_cookie = olsr_alloc_cookie("hna_net", OLSR_COOKIE_TYPE_MEMORY);
@@ -116,6 +119,25 @@ olsr_lookup_hna_net(const struct hna_net *nets, const union olsr_ip_addr *net, u
   return NULL;
 }
 
+/**
+ * Lookup the most specific announced network covering an address.
+ * If the network is announced by several gateways, one of them is returned.
+ *
+ * @param dst the address to look up
+ *
+ * @return the network entry with the longest matching prefix or NULL if not found
+ */
+struct hna_net *
+olsr_lookup_hna_net_best(const union olsr_ip_addr *dst)
+{
+  struct olsr_ip_prefix prefix;
+
+  prefix.prefix = *dst;
+  prefix.prefix_len = olsr_cnf->maxplen;
+
+  return hna_trie2net(ptrie_find_longest(&hna_net_trie, &prefix));
+}
+
 /**
  * Lookup a gateway entry
  *
@@ -193,6 +215,10 @@ olsr_add_hna_net(struct hna_entry *hna_gw, const union olsr_ip_addr *net, uint8_
   new_net->hna_prefix.prefix = *net;
   new_net->hna_prefix.prefix_len= prefixlen;
 
+  /* Index */
+  new_net->hna_trie_node.key = &new_net->hna_prefix;
+  ptrie_insert(&hna_net_trie, &new_net->hna_trie_node, PTRIE_DUP);
+
   /* Set backpointer */
   new_net->hna_gw = hna_gw;
 
@@ -237,6 +263,7 @@ olsr_delete_hna_net_entry(struct hna_net *net_to_delete) {
       net_to_delete->hna_prefix.prefix_len, &hna_gw->A_gateway_addr);
 
   DEQUEUE_ELEM(net_to_delete);
+  ptrie_delete(&hna_net_trie, &net_to_delete->hna_trie_node);
 
   /* Delete hna_gw if empty */
   if (hna_gw->networks.next == &hna_gw->networks) {
@@ -274,6 +301,12 @@ olsr_update_hna_entry(const union olsr_ip_addr *gw, const union olsr_ip_addr *ne
 {
   struct hna_entry *gw_entry;
   struct hna_net *net_entry;
+  struct olsr_ip_prefix prefix;
+
+  /* the host part of an announced net is not significant */
+  prefix.prefix = *net;
+  prefix.prefix_len = prefixlen;
+  ip_prefix_mask(&prefix);
 
   gw_entry = olsr_lookup_hna_gw(gw);
   if (!gw_entry) {
@@ -282,11 +315,11 @@ olsr_update_hna_entry(const union olsr_ip_addr *gw, const union olsr_ip_addr *ne
     gw_entry = olsr_add_hna_entry(gw);
   }
 
-  net_entry = olsr_lookup_hna_net(&gw_entry->networks, net, prefixlen);
+  net_entry = olsr_lookup_hna_net(&gw_entry->networks, &prefix.prefix, prefixlen);
   if (net_entry == NULL) {
 
     /* Need to add the net */
-    net_entry = olsr_add_hna_net(gw_entry, net, prefixlen);
+    net_entry = olsr_add_hna_net(gw_entry, &prefix.prefix, prefixlen);
     changes_hna = true;
   }
 
@@ -46,6 +46,7 @@
 #include "olsr_types.h"
 #include "olsr_protocol.h"
 #include "mantissa.h"
+#include "common/ptrie.h"
 
 #include <time.h>
 
@@ -53,12 +54,15 @@
 
 struct hna_net {
   struct olsr_ip_prefix hna_prefix;
+  struct ptrie_node hna_trie_node;     /* longest prefix match index */
   struct timer_entry *hna_net_timer;
   struct hna_entry *hna_gw;            /* backpointer to the owning HNA entry */
   struct hna_net *next;
   struct hna_net *prev;
 };
 
+PTRIENODE2STRUCT(hna_trie2net, struct hna_net, hna_trie_node);
+
 #define OLSR_HNA_NET_JITTER 5   /* percent */
 
 struct hna_entry {
@@ -79,13 +83,29 @@ struct hna_entry {
       _next = hna->next;
 #define OLSR_FOR_ALL_HNA_ENTRIES_END(hna) }}}
 
+/*
+ * macro for traversing all announced networks covered by the given
+ * prefix (including the prefix itself). A network announced by several
+ * gateways is visited once per gateway.
+ * The HNA set must not be modified inside the loop.
+ */
+#define OLSR_FOR_ALL_HNA_NETS_COVERED(prefix, net) \
+{ \
+  struct ptrie_node *_trie_node; \
+  OLSR_FOR_ALL_PTRIE_COVERED(&hna_net_trie, prefix, _trie_node) { \
+    net = hna_trie2net(_trie_node);
+#define OLSR_FOR_ALL_HNA_NETS_COVERED_END(net) }}
+
 extern struct hna_entry hna_set[HASHSIZE];
+extern struct ptrie hna_net_trie;
 
 int olsr_init_hna_set(void);
 void olsr_cleanup_hna(union olsr_ip_addr *orig);
 
 struct hna_net *olsr_lookup_hna_net(const struct hna_net *, const union olsr_ip_addr *, uint8_t);
 
+struct hna_net *olsr_lookup_hna_net_best(const union olsr_ip_addr *);
+
 struct hna_entry *olsr_lookup_hna_gw(const union olsr_ip_addr *);
 
 struct hna_entry *olsr_add_hna_entry(const union olsr_ip_addr *);
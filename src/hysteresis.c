@@ -49,6 +49,7 @@
 #include "net_olsr.h"
 #include "ipcalc.h"
 #include "scheduler.h"
+#include "mpr.h"
 
 #define hscaling olsr_cnf->hysteresis_param.scaling
 #define hhigh    olsr_cnf->hysteresis_param.thr_high
@@ -74,14 +75,14 @@ olsr_process_hysteresis(struct link_entry *entry)
     if (entry->L_link_pending == 1) {
       struct ipaddr_str buf;
       OLSR_PRINTF(1, "HYST[%s] link set to NOT pending!\n", olsr_ip_to_string(&buf, &entry->neighbor_iface_addr));
-      changes_neighborhood = true;
+      olsr_mpr_touch_neighbor(entry->neighbor);
     }
 
     /* Pending = false */
     entry->L_link_pending = 0;
 
     if (!TIMED_OUT(entry->L_LOST_LINK_time))
-      changes_neighborhood = true;
+      olsr_mpr_touch_neighbor(entry->neighbor);
 
     /* time = now -1 */
     entry->L_LOST_LINK_time = now_times - 1;
@@ -93,14 +94,14 @@ olsr_process_hysteresis(struct link_entry *entry)
     if (entry->L_link_pending == 0) {
       struct ipaddr_str buf;
       OLSR_PRINTF(1, "HYST[%s] link set to pending!\n", olsr_ip_to_string(&buf, &entry->neighbor_iface_addr));
-      changes_neighborhood = true;
+      olsr_mpr_touch_neighbor(entry->neighbor);
     }
 
     /* Pending = true */
     entry->L_link_pending = 1;
 
     if (TIMED_OUT(entry->L_LOST_LINK_time))
-      changes_neighborhood = true;
+      olsr_mpr_touch_neighbor(entry->neighbor);
 
     /* Timer = min (L_time, current time + NEIGHB_HOLD_TIME) */
     entry->L_LOST_LINK_time = MIN(GET_TIMESTAMP(NEIGHB_HOLD_TIME * MSEC_PER_SEC), entry->link_timer->timer_clock);
@@ -51,6 +51,7 @@
 #include "ipcalc.h"
 #include "log.h"
 #include "parser.h"
+#include "olsr_rx.h"
 
 #ifdef _WIN32
 #include <winbase.h>
@@ -412,10 +413,10 @@ olsr_remove_interface(struct olsr_if * iface)
   iface->interf = NULL;
 
   /* Close olsr socket */
-  remove_olsr_socket(ifp->olsr_socket, &olsr_input, NULL);
+  olsr_rx_remove_socket(ifp->olsr_socket);
   close(ifp->olsr_socket);
 
-  remove_olsr_socket(ifp->send_socket, &olsr_input, NULL);
+  olsr_rx_remove_socket(ifp->send_socket);
   close(ifp->send_socket);
 
   /* Free memory */
@@ -102,6 +102,22 @@ struct vtimes {
   uint8_t hna;
 };
 
+/* A forwarded message, shared by the output buffers of all interfaces it is queued on */
+struct olsr_fwd_msg {
+  int refcount;
+  uint16_t size;
+  uint8_t data[];
+};
+
+/* Part of the pending data: local bytes from the buffer or a forwarded message */
+struct olsr_netbuf_seg {
+  struct olsr_fwd_msg *fwd;            /* NULL for data in buff */
+  int offset;                          /* offset in buff after the packet header */
+  int size;
+};
+
+#define OLSR_NETBUF_SEGMENTS 32
+
 /* Output buffer structure. This should actually be in net_olsr.h but we have circular references then.
  */
 struct olsr_netbuf {
@@ -110,6 +126,28 @@ struct olsr_netbuf {
   int maxsize;                         /* Max bytes of payload that can be added to the buffer */
   int pending;                         /* How much data is currently pending in the buffer */
   int reserved;                        /* Plugins can reserve space in buffers */
+  int buffused;                        /* How much of the pending data is stored in buff */
+  int segcount;                        /* Number of used segments, 0 if all data is in buff */
+  struct olsr_netbuf_seg segs[OLSR_NETBUF_SEGMENTS];
+};
+
+#define OLSR_FWD_QUEUE_LEN 64
+
+/*
+ * Forwarded messages waiting for an output packet. They are sent behind
+ * the locally generated messages, in the space those leave in a packet.
+ */
+struct olsr_fwd_queue {
+  struct olsr_fwd_msg *msgs[OLSR_FWD_QUEUE_LEN];
+  int head;                            /* index of the oldest message */
+  int count;                           /* number of queued messages */
+  int bytes;                           /* size of the queued messages */
+  uint32_t tokens;                     /* bytes the rate limit still lets through */
+  uint32_t last_fill;                  /* now_times of the last token refill */
+  uint32_t max_count;                  /* highest number of queued messages */
+  uint32_t sent;                       /* forwarded messages sent */
+  uint32_t dropped_full;               /* messages dropped because the queue was full */
+  uint32_t dropped_rate;               /* messages dropped by the rate limit */
 };
 
 /**
@@ -167,6 +205,9 @@ struct interface {
   /* the buffer to construct the packet data */
   struct olsr_netbuf netbuf;
 
+  /* forwarded messages not yet put into the buffer */
+  struct olsr_fwd_queue fwdq;
+
   /* Generic interface properties */
   struct if_gen_property *gen_properties;
 
@@ -253,6 +253,23 @@ ip_in_net(const union olsr_ip_addr *ipaddr, const struct olsr_ip_prefix *net)
   return rv;
 }
 
+/* clear the host part of a prefix, so that all spellings of a net are
+ * the same key. Network-byte-order!
+ */
+void
+ip_prefix_mask(struct olsr_ip_prefix *prefix)
+{
+  uint8_t *addr = prefix->prefix.v6.s6_addr;
+  unsigned int byte = prefix->prefix_len / 8;
+
+  if (prefix->prefix_len % 8) {
+    addr[byte++] &= 0xff << (8 - prefix->prefix_len % 8);
+  }
+  for (; byte < olsr_cnf->ipsize; byte++) {
+    addr[byte] = 0;
+  }
+}
+
 bool is_prefix_inetgw(const struct olsr_ip_prefix *prefix) {
   if (olsr_cnf->ip_version == AF_INET && ip_prefix_is_v4_inetgw(prefix)) {
     return true;
@@ -103,6 +103,8 @@ genipcopy(void *dst, const void *src)
 
 int ip_in_net(const union olsr_ip_addr *ipaddr, const struct olsr_ip_prefix *net);
 
+void ip_prefix_mask(struct olsr_ip_prefix *prefix);
+
 int prefix_to_netmask(uint8_t *, int, uint8_t);
 
 static INLINE int
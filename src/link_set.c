@@ -370,6 +370,9 @@ olsr_delete_link_entry(struct link_entry *link)
   }
 
 
+  /* the best link to the neighbor may change */
+  olsr_mpr_touch_neighbor(link->neighbor);
+
   /* Delete neighbor entry */
   if (link->neighbor->linkcount == 1) {
     olsr_delete_neighbor_table(&link->neighbor->neighbor_main_addr);
@@ -390,8 +393,6 @@ olsr_delete_link_entry(struct link_entry *link)
 
   free(link->if_name);
   free(link);
-
-  changes_neighborhood = true;
 }
 
 /**
@@ -450,7 +451,7 @@ olsr_expire_link_sym_timer(void *context)
 
   link->prev_status = lookup_link_status(link);
   update_neighbor_status(link->neighbor, get_neighbor_status(&link->neighbor_iface_addr));
-  changes_neighborhood = true;
+  olsr_mpr_touch_neighbor(link->neighbor);
 }
 
 /**
@@ -46,6 +46,7 @@
 #include "log.h"
 #include "net_os.h"
 #include "ifnet.h"
+#include "olsr_profile.h"
 
 #include <assert.h>
 #include <linux/types.h>
@@ -213,6 +214,7 @@ olsr_netlink_send(struct nlmsghdr *nl_hdr)
   struct nlmsghdr *h;
   struct nlmsgerr *l_err;
   int ret;
+  uint64_t start;
 
   memset(&nladdr, 0, sizeof(nladdr));
   memset(&msg, 0, sizeof(msg));
@@ -226,6 +228,7 @@ olsr_netlink_send(struct nlmsghdr *nl_hdr)
 
   iov.iov_base = nl_hdr;
   iov.iov_len = nl_hdr->nlmsg_len;
+  start = olsr_prof_clock();
   ret = sendmsg(olsr_cnf->rtnl_s, &msg, 0);
   if (ret <= 0) {
     olsr_syslog(OLSR_LOG_ERR, "Cannot send data to netlink socket (%d: %s)", errno, strerror(errno));
@@ -239,6 +242,7 @@ olsr_netlink_send(struct nlmsghdr *nl_hdr)
     olsr_syslog(OLSR_LOG_ERR, "Error while reading answer to netlink message (%d: %s)", errno, strerror(errno));
     return -1;
   }
+  olsr_hist_record(&olsr_prof[OLSR_PROF_NETLINK], olsr_prof_clock() - start);
 
   h = (struct nlmsghdr *)ARM_NOWARN_ALIGN(rcvbuf);
   if (!NLMSG_OK(h, (unsigned int)ret)) {
@@ -112,7 +112,11 @@ struct lq_handler lq_etx_ffeth_nl80211_handler = {
   sizeof(struct lq_ffeth_hello),
   sizeof(struct lq_ffeth),
   4,
-  4
+  4,
+
+  NULL,
+  NULL,
+  NULL
 };
 
 static void
@@ -666,6 +666,23 @@ olsr_sendto(int s, const void *buf, size_t len, int flags, const struct sockaddr
   return sendto(s, buf, len, flags, to, tolen);
 }
 
+/**
+ * Wrapper for sendmsg(2) with a scatter/gather list
+ */
+ssize_t
+olsr_sendmsg(int s, struct iovec *iov, int iovcnt, int flags, struct sockaddr *to, socklen_t tolen)
+{
+  struct msghdr msg;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = to;
+  msg.msg_namelen = tolen;
+  msg.msg_iov = iov;
+  msg.msg_iovlen = iovcnt;
+
+  return sendmsg(s, &msg, flags);
+}
+
 /**
  * Wrapper for recvfrom(2)
  */
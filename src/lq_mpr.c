@@ -44,125 +44,151 @@
 #include "two_hop_neighbor_table.h"
 #include "link_set.h"
 #include "lq_mpr.h"
+#include "mpr.h"
 #include "scheduler.h"
 #include "lq_plugin.h"
 
-void
-olsr_calculate_lq_mpr(void)
+/**
+ * Select the MPRs for a single 2-hop neighbour: the mpr_coverage
+ * 1-hop neighbours with the best path to it, unless the direct
+ * link to it (if it is also a 1-hop neighbour) is better.
+ * Previous selections for this 2-hop neighbour are dropped first.
+ */
+static void
+olsr_calculate_lq_mpr_two_hop(struct neighbor_2_entry *neigh2)
 {
-  struct neighbor_2_entry *neigh2;
-  struct neighbor_list_entry *walker;
-  int i, k;
+  struct neighbor_list_entry *walker, *best_walker;
   struct neighbor_entry *neigh;
   olsr_linkcost best, best_1hop;
-  bool mpr_changes = false;
+  int k;
 
-  OLSR_FOR_ALL_NBR_ENTRIES(neigh) {
+  for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next) {
+    if (walker->mpr_selected) {
+      walker->mpr_selected = false;
+      walker->neighbor->mpr_selected_count--;
+    }
+  }
 
-    /* Memorize previous MPR status. */
+  best_1hop = LINK_COST_BROKEN;
 
-    neigh->was_mpr = neigh->is_mpr;
+  /* check whether this 2-hop neighbour is also a neighbour */
 
-    /* Clear current MPR status. */
+  neigh = olsr_lookup_neighbor_table(&neigh2->neighbor_2_addr);
 
-    neigh->is_mpr = false;
+  /* if it's a neighbour and also symmetric, then examine
+     the link quality */
 
-    /* In this pass we are only interested in WILL_ALWAYS neighbours */
+  if (neigh != NULL && neigh->status == SYM) {
+    /* if the direct link is better than the best route via
+     * an MPR, then prefer the direct link and do not select
+     * an MPR for this 2-hop neighbour */
 
-    if (neigh->status == NOT_SYM || neigh->willingness != WILL_ALWAYS) {
-      continue;
-    }
+    /* determine the link quality of the direct link */
 
-    neigh->is_mpr = true;
+    struct link_entry *lnk = get_best_link_to_neighbor(&neigh->neighbor_main_addr);
 
-    if (neigh->is_mpr != neigh->was_mpr) {
-      mpr_changes = true;
-    }
+    if (!lnk)
+      return;
 
-  }
-  OLSR_FOR_ALL_NBR_ENTRIES_END(neigh);
+    best_1hop = lnk->linkcost;
 
-  for (i = 0; i < HASHSIZE; i++) {
-    /* loop through all 2-hop neighbours */
+    /* see wether we find a better route via an MPR */
 
-    for (neigh2 = two_hop_neighbortable[i].next; neigh2 != &two_hop_neighbortable[i]; neigh2 = neigh2->next) {
-      best_1hop = LINK_COST_BROKEN;
+    for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next)
+      if (walker->path_linkcost < best_1hop)
+        break;
 
-      /* check whether this 2-hop neighbour is also a neighbour */
+    /* we've reached the end of the list, so we haven't found
+     * a better route via an MPR - so, skip MPR selection for
+     * this 1-hop neighbor */
 
-      neigh = olsr_lookup_neighbor_table(&neigh2->neighbor_2_addr);
+    if (walker == &neigh2->neighbor_2_nblist)
+      return;
+  }
 
-      /* if it's a neighbour and also symmetric, then examine
-         the link quality */
+  /* find the connecting 1-hop neighbours with the
+   * best total link qualities */
 
-      if (neigh != NULL && neigh->status == SYM) {
-        /* if the direct link is better than the best route via
-         * an MPR, then prefer the direct link and do not select
-         * an MPR for this 2-hop neighbour */
+  /* mark all 1-hop neighbours as not selected */
 
-        /* determine the link quality of the direct link */
+  for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next)
+    walker->neighbor->skip = false;
 
-        struct link_entry *lnk = get_best_link_to_neighbor(&neigh->neighbor_main_addr);
+  for (k = 0; k < olsr_cnf->mpr_coverage; k++) {
+    /* look for the best 1-hop neighbour that we haven't
+     * yet selected */
 
-        if (!lnk)
-          continue;
+    best_walker = NULL;
+    best = LINK_COST_BROKEN;
 
-        best_1hop = lnk->linkcost;
+    for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next)
+      if (walker->neighbor->status == SYM && !walker->neighbor->skip && walker->path_linkcost < best) {
+        best_walker = walker;
+        best = walker->path_linkcost;
+      }
 
-        /* see wether we find a better route via an MPR */
+    /* Found a 1-hop neighbor that we haven't previously selected.
+     * Use it as MPR only when the 2-hop path through it is better than
+     * any existing 1-hop path. */
+    if ((best_walker != NULL) && (best < best_1hop)) {
+      best_walker->mpr_selected = true;
+      best_walker->neighbor->mpr_selected_count++;
+      best_walker->neighbor->skip = true;
+    }
 
-        for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next)
-          if (walker->path_linkcost < best_1hop)
-            break;
+    /* no neighbour found => the requested MPR coverage cannot
+     * be satisfied => stop */
 
-        /* we've reached the end of the list, so we haven't found
-         * a better route via an MPR - so, skip MPR selection for
-         * this 1-hop neighbor */
+    else
+      break;
+  }
+}
 
-        if (walker == &neigh2->neighbor_2_nblist)
-          continue;
-      }
+void
+olsr_calculate_lq_mpr(void)
+{
+  struct neighbor_2_entry *neigh2;
+  struct neighbor_entry *neigh;
+  bool mpr_changes = false;
 
-      /* find the connecting 1-hop neighbours with the
-       * best total link qualities */
+  if (olsr_mpr_begin_update()) {
+    int i;
 
-      /* mark all 1-hop neighbours as not selected */
+    for (i = 0; i < HASHSIZE; i++) {
+      /* loop through all 2-hop neighbours */
 
-      for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next)
-        walker->neighbor->skip = false;
+      for (neigh2 = two_hop_neighbortable[i].next; neigh2 != &two_hop_neighbortable[i]; neigh2 = neigh2->next) {
+        olsr_calculate_lq_mpr_two_hop(neigh2);
+      }
+    }
+  } else {
+    /* only the 2-hop neighbours affected by the last changes */
 
-      for (k = 0; k < olsr_cnf->mpr_coverage; k++) {
-        /* look for the best 1-hop neighbour that we haven't
-         * yet selected */
+    while ((neigh2 = olsr_mpr_next_dirty()) != NULL) {
+      olsr_calculate_lq_mpr_two_hop(neigh2);
+    }
+  }
 
-        neigh = NULL;
-        best = LINK_COST_BROKEN;
+  OLSR_FOR_ALL_NBR_ENTRIES(neigh) {
 
-        for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next)
-          if (walker->neighbor->status == SYM && !walker->neighbor->skip && walker->path_linkcost < best) {
-            neigh = walker->neighbor;
-            best = walker->path_linkcost;
-          }
+    /* Memorize previous MPR status. */
 
-        /* Found a 1-hop neighbor that we haven't previously selected.
-         * Use it as MPR only when the 2-hop path through it is better than
-         * any existing 1-hop path. */
-        if ((neigh != NULL) && (best < best_1hop)) {
-          neigh->is_mpr = true;
-          neigh->skip = true;
+    neigh->was_mpr = neigh->is_mpr;
+    neigh->mpr_review = false;
 
-          if (neigh->is_mpr != neigh->was_mpr)
-            mpr_changes = true;
-        }
+    /* WILL_ALWAYS neighbours are always MPRs, all others
+     * if they were selected for at least one 2-hop neighbour */
 
-        /* no neighbour found => the requested MPR coverage cannot
-         * be satisfied => stop */
+    neigh->is_mpr = (neigh->status == SYM && neigh->willingness == WILL_ALWAYS) || neigh->mpr_selected_count > 0;
 
-        else
-          break;
-      }
+    if (neigh->is_mpr != neigh->was_mpr) {
+      mpr_changes = true;
     }
+
   }
+  OLSR_FOR_ALL_NBR_ENTRIES_END(neigh);
+
+  olsr_mpr_end_update();
 
   if (mpr_changes && olsr_cnf->tc_redundancy > 0)
     signal_link_changes(true);
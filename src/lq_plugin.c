@@ -46,6 +46,9 @@
 #include "packet.h"
 #include "olsr.h"
 #include "two_hop_neighbor_table.h"
+#include "neighbor_table.h"
+#include "mpr.h"
+#include "parser.h"
 #include "common/avl.h"
 
 #include "lq_plugin_default_float.h"
@@ -330,6 +333,72 @@ get_linkcost_text(olsr_linkcost cost, bool route, struct lqtextbuffer *buffer)
   return active_lq_handler->print_cost(cost, buffer);
 }
 
+/**
+ * append_link_entry_text
+ *
+ * this function appends the text of get_link_entry_text() to an autobuf,
+ * without printf if the lq plugin supports it.
+ *
+ * @param abuf the autobuf
+ * @param entry to link_entry
+ * @param separator separator between LQ and NLQ
+ * @return the number of characters appended or -1
+ */
+int
+append_link_entry_text(struct autobuf *abuf, struct link_entry *entry, char separator)
+{
+  struct lqtextbuffer lqbuffer;
+
+  if (active_lq_handler->append_hello_lq != NULL) {
+    return active_lq_handler->append_hello_lq(abuf, entry->linkquality, separator);
+  }
+  return abuf_puts(abuf, get_link_entry_text(entry, separator, &lqbuffer));
+}
+
+/**
+ * append_tc_edge_entry_text
+ *
+ * this function appends the text of get_tc_edge_entry_text() to an autobuf,
+ * without printf if the lq plugin supports it.
+ *
+ * @param abuf the autobuf
+ * @param entry pointer to tc_edge_entry
+ * @param separator separator between LQ and NLQ
+ * @return the number of characters appended or -1
+ */
+int
+append_tc_edge_entry_text(struct autobuf *abuf, struct tc_edge_entry *entry, char separator)
+{
+  struct lqtextbuffer lqbuffer;
+
+  if (active_lq_handler->append_tc_lq != NULL) {
+    return active_lq_handler->append_tc_lq(abuf, entry->linkquality, separator);
+  }
+  return abuf_puts(abuf, get_tc_edge_entry_text(entry, separator, &lqbuffer));
+}
+
+/**
+ * append_linkcost_text
+ *
+ * this function appends the text of get_linkcost_text() to an autobuf,
+ * without printf if the lq plugin supports it.
+ *
+ * @param abuf the autobuf
+ * @param cost link cost value
+ * @param route true to transform the cost of a route, false for a link
+ * @return the number of characters appended or -1
+ */
+int
+append_linkcost_text(struct autobuf *abuf, olsr_linkcost cost, bool route)
+{
+  struct lqtextbuffer lqbuffer;
+
+  if (active_lq_handler->append_cost == NULL || (route ? cost == ROUTE_COST_BROKEN : cost >= LINK_COST_BROKEN)) {
+    return abuf_puts(abuf, get_linkcost_text(cost, route, &lqbuffer));
+  }
+  return active_lq_handler->append_cost(abuf, cost);
+}
+
 /**
  * olsr_copy_hello_lq
  *
@@ -422,6 +491,27 @@ olsr_malloc_hello_neighbor(const char *id)
   return h;
 }
 
+/**
+ * olsr_parser_alloc_hello_neighbor
+ *
+ * this function allocates memory for an hello_neighbor inclusive
+ * linkquality data from the parser arena. The memory is released
+ * with the next received packet and must not be freed.
+ *
+ * @return pointer to hello_neighbor
+ */
+struct hello_neighbor *
+olsr_parser_alloc_hello_neighbor(void)
+{
+  struct hello_neighbor *h;
+
+  h = olsr_parser_alloc(sizeof(struct hello_neighbor) + active_lq_handler->hello_lq_size);
+
+  assert((const char *)h + sizeof(*h) >= (const char *)h->linkquality);
+  active_lq_handler->clear_hello(h->linkquality);
+  return h;
+}
+
 /**
  * olsr_malloc_tc_mpr_addr
  *
@@ -501,7 +591,20 @@ size_t olsr_sizeof_tc_lqdata(void) {
  * value changed in a relevant way.
  */
 void olsr_relevant_linkcost_change(void) {
-  changes_neighborhood = true;
+  struct link_entry *link;
+
+  /*
+   * the direct link cost is compared against the 2-hop paths
+   * to neighbors which are also 2-hop neighbors
+   */
+  OLSR_FOR_ALL_LINK_ENTRIES(link) {
+    struct neighbor_2_entry *neigh2 = olsr_lookup_two_hop_neighbor_table(&link->neighbor->neighbor_main_addr);
+
+    if (neigh2 != NULL) {
+      olsr_mpr_touch_two_hop(neigh2);
+    }
+  } OLSR_FOR_ALL_LINK_ENTRIES_END(link)
+
   changes_topology = true;
 
   /* XXX - we should check whether we actually announce this neighbour */
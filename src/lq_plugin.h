@@ -48,6 +48,7 @@
 #include "lq_packet.h"
 #include "packet.h"
 #include "common/avl.h"
+#include "common/autobuf.h"
 
 #define LINK_COST_BROKEN (1<<22)
 #define ROUTE_COST_BROKEN (0xffffffff)
@@ -90,6 +91,11 @@ struct lq_handler {
   size_t tc_lq_size;
   size_t hello_lqdata_size;
   size_t tc_lqdata_size;
+
+  /* optional, append the same text as the print functions without printf */
+  int (*append_hello_lq) (struct autobuf * abuf, void *ptr, char separator);
+  int (*append_tc_lq) (struct autobuf * abuf, void *ptr, char separator);
+  int (*append_cost) (struct autobuf * abuf, olsr_linkcost cost);
 };
 
 struct lq_handler_node {
@@ -127,6 +133,9 @@ void olsr_memorize_foreign_hello_lq(struct link_entry *local, struct hello_neigh
 const char *get_link_entry_text(struct link_entry *entry, char separator, struct lqtextbuffer *buffer);
 const char *get_tc_edge_entry_text(struct tc_edge_entry *entry, char separator, struct lqtextbuffer *buffer);
 const char *get_linkcost_text(olsr_linkcost cost, bool route, struct lqtextbuffer *buffer);
+int append_link_entry_text(struct autobuf *abuf, struct link_entry *entry, char separator);
+int append_tc_edge_entry_text(struct autobuf *abuf, struct tc_edge_entry *entry, char separator);
+int append_linkcost_text(struct autobuf *abuf, olsr_linkcost cost, bool route);
 
 void olsr_clear_hello_lq(struct link_entry */*link*/);
 void olsr_copy_hello_lq(struct lq_hello_neighbor *target, struct link_entry *source);
@@ -135,6 +144,7 @@ void olsr_copylq_link_entry_2_tc_edge_entry(struct tc_edge_entry *target, struct
 void olsr_clear_tc_lq(struct tc_mpr_addr *target);
 
 struct hello_neighbor *olsr_malloc_hello_neighbor(const char *id);
+struct hello_neighbor *olsr_parser_alloc_hello_neighbor(void);
 struct tc_mpr_addr *olsr_malloc_tc_mpr_addr(const char *id);
 struct lq_hello_neighbor *olsr_malloc_lq_hello_neighbor(const char *id);
 struct link_entry *olsr_malloc_link_entry(const char *id);
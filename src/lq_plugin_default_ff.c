@@ -73,6 +73,8 @@ static void default_lq_clear_ff_hello(void *target);
 
 static const char *default_lq_print_ff(void *ptr, char separator, struct lqtextbuffer *buffer);
 static const char *default_lq_print_cost_ff(olsr_linkcost cost, struct lqtextbuffer *buffer);
+static int default_lq_append_ff(struct autobuf *abuf, void *ptr, char separator);
+static int default_lq_append_cost_ff(struct autobuf *abuf, olsr_linkcost cost);
 
 /* etx lq plugin (freifunk fpm version) settings */
 struct lq_handler lq_etx_ff_handler = {
@@ -100,7 +102,11 @@ struct lq_handler lq_etx_ff_handler = {
   sizeof(struct default_lq_ff_hello),
   sizeof(struct default_lq_ff),
   4,
-  4
+  4,
+
+  &default_lq_append_ff,
+  &default_lq_append_ff,
+  &default_lq_append_cost_ff
 };
 
 static void
@@ -411,6 +417,26 @@ default_lq_print_cost_ff(olsr_linkcost cost, struct lqtextbuffer *buffer)
   return buffer->buf;
 }
 
+static int
+default_lq_append_ff(struct autobuf *abuf, void *ptr, char separator)
+{
+  struct default_lq_ff *lq = ptr;
+  int lq_len, nlq_len;
+
+  lq_len = abuf_append_fpm(abuf, fpmidiv(itofpm((int)lq->valueLq), 255));
+  if (lq_len < 0 || abuf_putc(abuf, separator) < 0) {
+    return -1;
+  }
+  nlq_len = abuf_append_fpm(abuf, fpmidiv(itofpm((int)lq->valueNlq), 255));
+  return nlq_len < 0 ? -1 : lq_len + 1 + nlq_len;
+}
+
+static int
+default_lq_append_cost_ff(struct autobuf *abuf, olsr_linkcost cost)
+{
+  return abuf_append_fpm(abuf, cost);
+}
+
 /*
  * Local Variables:
  * c-basic-offset: 2
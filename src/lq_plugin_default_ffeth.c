@@ -75,6 +75,8 @@ static void default_lq_clear_ffeth_hello(void *target);
 
 static const char *default_lq_print_ffeth(void *ptr, char separator, struct lqtextbuffer *buffer);
 static const char *default_lq_print_cost_ffeth(olsr_linkcost cost, struct lqtextbuffer *buffer);
+static int default_lq_append_ffeth(struct autobuf *abuf, void *ptr, char separator);
+static int default_lq_append_cost_ffeth(struct autobuf *abuf, olsr_linkcost cost);
 
 /* etx lq plugin (freifunk fpm version) settings */
 struct lq_handler lq_etx_ffeth_handler = {
@@ -102,7 +104,11 @@ struct lq_handler lq_etx_ffeth_handler = {
   sizeof(struct default_lq_ffeth_hello),
   sizeof(struct default_lq_ffeth),
   4,
-  4
+  4,
+
+  &default_lq_append_ffeth,
+  &default_lq_append_ffeth,
+  &default_lq_append_cost_ffeth
 };
 
 static void
@@ -433,24 +439,24 @@ default_lq_clear_ffeth_hello(void *target)
   }
 }
 
-static const char *
-default_lq_print_ffeth(void *ptr, char separator, struct lqtextbuffer *buffer)
+static int
+default_lq_printable_ffeth(uint8_t value)
 {
-  struct default_lq_ffeth *lq = ptr;
-  int lq_int, nlq_int;
+  int v = (int)value;
 
-  lq_int = (int)lq->valueLq;
-  if (lq_int > 0 && lq_int < 255) {
-    lq_int++;
+  if (v > 0 && v < 255) {
+    v++;
   }
+  return v;
+}
 
-  nlq_int = (int)lq->valueNlq;
-  if (nlq_int > 0 && nlq_int < 255) {
-    nlq_int++;
-  }
+static const char *
+default_lq_print_ffeth(void *ptr, char separator, struct lqtextbuffer *buffer)
+{
+  struct default_lq_ffeth *lq = ptr;
 
-  snprintf(buffer->buf, sizeof(buffer->buf), "%s%c%s", fpmtoa(fpmidiv(itofpm(lq_int), 255)), separator,
-           fpmtoa(fpmidiv(itofpm(nlq_int), 255)));
+  snprintf(buffer->buf, sizeof(buffer->buf), "%s%c%s", fpmtoa(fpmidiv(itofpm(default_lq_printable_ffeth(lq->valueLq)), 255)),
+           separator, fpmtoa(fpmidiv(itofpm(default_lq_printable_ffeth(lq->valueNlq)), 255)));
   return buffer->buf;
 }
 
@@ -461,6 +467,26 @@ default_lq_print_cost_ffeth(olsr_linkcost cost, struct lqtextbuffer *buffer)
   return buffer->buf;
 }
 
+static int
+default_lq_append_ffeth(struct autobuf *abuf, void *ptr, char separator)
+{
+  struct default_lq_ffeth *lq = ptr;
+  int lq_len, nlq_len;
+
+  lq_len = abuf_append_fpm(abuf, fpmidiv(itofpm(default_lq_printable_ffeth(lq->valueLq)), 255));
+  if (lq_len < 0 || abuf_putc(abuf, separator) < 0) {
+    return -1;
+  }
+  nlq_len = abuf_append_fpm(abuf, fpmidiv(itofpm(default_lq_printable_ffeth(lq->valueNlq)), 255));
+  return nlq_len < 0 ? -1 : lq_len + 1 + nlq_len;
+}
+
+static int
+default_lq_append_cost_ffeth(struct autobuf *abuf, olsr_linkcost cost)
+{
+  return abuf_append_fpm(abuf, cost);
+}
+
 /*
  * Local Variables:
  * c-basic-offset: 2
@@ -87,7 +87,11 @@ struct lq_handler lq_etx_float_handler = {
   sizeof(struct default_lq_float),
   sizeof(struct default_lq_float),
   4,
-  4
+  4,
+
+  NULL,
+  NULL,
+  NULL
 };
 
 static void
@@ -88,7 +88,11 @@ struct lq_handler lq_etx_fpm_handler = {
   sizeof(struct default_lq_fpm),
   sizeof(struct default_lq_fpm),
   4,
-  4
+  4,
+
+  NULL,
+  NULL,
+  NULL
 };
 
 uint32_t aging_factor_new, aging_factor_old;
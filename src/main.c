@@ -61,6 +61,9 @@
 #include "mpr_selector_set.h"
 #include "gateway.h"
 #include "olsr_niit.h"
+#include "olsr_spf.h"
+#include "olsr_profile.h"
+#include "olsr_rx.h"
 
 #ifdef __linux__
 #include <linux/types.h>
@@ -800,6 +803,12 @@ static void olsr_shutdown(int signo __attribute__ ((unused)))
 
   OLSR_PRINTF(1, "Received signal %d - shutting down\n", (int)signo);
 
+  /* stop the SPF thread, its results are not needed anymore */
+  olsr_shutdown_spf();
+
+  /* and the receive thread */
+  olsr_shutdown_rx();
+
 #ifdef _WIN32
   OLSR_PRINTF(1, "Waiting for the scheduler to stop.\n");
 
@@ -909,6 +918,7 @@ static void olsr_shutdown(int signo __attribute__ ((unused)))
   /* Free cookies and memory pools attached. */
   OLSR_PRINTF(0, "Free all memory...\n");
   olsr_delete_all_cookies();
+  olsr_prof_cleanup();
 
   olsr_syslog(OLSR_LOG_INFO, "%s stopped", olsrd_version);
 
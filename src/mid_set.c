@@ -48,6 +48,7 @@
 #include "rebuild_packet.h"
 #include "scheduler.h"
 #include "neighbor_table.h"
+#include "mpr.h"
 #include "link_set.h"
 #include "tc_set.h"
 #include "packet.h"             /* struct mid_alias */
@@ -222,7 +223,7 @@ insert_mid_tuple(union olsr_ip_addr *m_addr, struct mid_address *alias, olsr_rel
 
       olsr_delete_two_hop_neighbor_table(tmp_2_neighbor);
 
-      changes_neighborhood = true;
+      olsr_mpr_touch_all();
     }
 
     /* Delete a possible neighbor entry */
@@ -239,7 +240,7 @@ insert_mid_tuple(union olsr_ip_addr *m_addr, struct mid_address *alias, olsr_rel
       /* Delete */
       free(tmp_neigh);
 
-      changes_neighborhood = true;
+      olsr_mpr_touch_all();
     }
     tmp_adr = tmp_adr->next_alias;
   }
@@ -311,7 +312,7 @@ insert_mid_alias(union olsr_ip_addr *main_add, const union olsr_ip_addr *alias,
   /*
    *Recalculate topology
    */
-  changes_neighborhood = true;
+  olsr_mpr_touch_all();
   changes_topology = true;
 }
 
@@ -477,7 +478,7 @@ olsr_prune_aliases(struct mid_message *message)
       /*
        *Recalculate topology
        */
-      changes_neighborhood = true;
+      olsr_mpr_touch_all();
       changes_topology = true;
     } else {
       previous_alias = current_alias;
@@ -47,6 +47,18 @@
 #include "neighbor_table.h"
 #include "scheduler.h"
 #include "net_olsr.h"
+#include "link_set.h"
+
+/* 2-hop neighbors whose MPR coverage has to be re-evaluated */
+static struct list_node mpr_dirty_list = { &mpr_dirty_list, &mpr_dirty_list };
+
+/* next MPR calculation has to start from scratch */
+static bool mpr_recalc_all = true;
+
+/* one of the olsr_mpr_touch_*() hooks was called since the last run */
+static bool mpr_touched = false;
+
+LISTNODE2STRUCT(list2neigh2, struct neighbor_2_entry, mpr_dirty_node);
 
 /* Begin:
  * Prototypes for internal functions
@@ -68,6 +80,14 @@ static int olsr_check_mpr_changes(void);
 
 static int olsr_chosen_mpr(struct neighbor_entry *, uint16_t *);
 
+static void olsr_unchosen_mpr(struct neighbor_entry *);
+
+static bool olsr_mpr_is_redundant(struct neighbor_entry *);
+
+static bool olsr_is_two_hop_only(struct neighbor_2_entry *);
+
+static void olsr_update_mpr_incremental(void);
+
 static struct neighbor_2_list_entry *olsr_find_2_hop_neighbors_with_1_link(int);
 
 /* End:
@@ -195,6 +215,43 @@ olsr_chosen_mpr(struct neighbor_entry *one_hop_neighbor, uint16_t * two_hop_cove
 
 }
 
+/**
+ *Deselect a MPR and take back the coverage it
+ *provided to its 2 hop neighbors
+ */
+static void
+olsr_unchosen_mpr(struct neighbor_entry *one_hop_neighbor)
+{
+  struct neighbor_2_list_entry *second_hop_entries;
+  struct ipaddr_str buf;
+
+  OLSR_PRINTF(3, "Removing %s as MPR\n", olsr_ip_to_string(&buf, &one_hop_neighbor->neighbor_main_addr));
+
+  one_hop_neighbor->is_mpr = false;
+
+  for (second_hop_entries = one_hop_neighbor->neighbor_2_list.next; second_hop_entries != &one_hop_neighbor->neighbor_2_list;
+       second_hop_entries = second_hop_entries->next) {
+    if (!olsr_is_two_hop_only(second_hop_entries->neighbor_2)) {
+      continue;
+    }
+    if (second_hop_entries->neighbor_2->mpr_covered_count > 0) {
+      second_hop_entries->neighbor_2->mpr_covered_count--;
+    }
+  }
+}
+
+/**
+ *Check if a 2 hop neighbor is not also a symmetric
+ *1 hop neighbor, and so has to be covered by MPRs
+ */
+static bool
+olsr_is_two_hop_only(struct neighbor_2_entry *neighbor_2)
+{
+  struct neighbor_entry *dup_neighbor = olsr_lookup_neighbor_table(&neighbor_2->neighbor_2_addr);
+
+  return dup_neighbor == NULL || dup_neighbor->status != SYM;
+}
+
 /**
  *Find the neighbor that covers the most 2 hop neighbors
  *with a given willingness
@@ -241,6 +298,8 @@ olsr_clear_mprs(void)
 
   OLSR_FOR_ALL_NBR_ENTRIES(a_neighbor) {
 
+    a_neighbor->mpr_review = false;
+
     /* Clear MPR selection. */
     if (a_neighbor->is_mpr) {
       a_neighbor->was_mpr = true;
@@ -393,6 +452,12 @@ olsr_calculate_mpr(void)
   uint16_t two_hop_count;
   int i;
 
+  if (!olsr_mpr_begin_update()) {
+    olsr_update_mpr_incremental();
+    olsr_mpr_end_update();
+    return;
+  }
+
   OLSR_PRINTF(3, "\n**RECALCULATING MPR**\n\n");
 
   olsr_clear_mprs();
@@ -449,6 +514,7 @@ olsr_calculate_mpr(void)
       signal_link_changes(true);
   }
 
+  olsr_mpr_end_update();
 }
 
 /**
@@ -463,9 +529,8 @@ olsr_calculate_mpr(void)
 static void
 olsr_optimize_mpr_set(void)
 {
-  struct neighbor_entry *a_neighbor, *dup_neighbor;
-  struct neighbor_2_list_entry *two_hop_list;
-  int i, removeit;
+  struct neighbor_entry *a_neighbor;
+  int i;
 
 #if 0
   printf("\n**MPR OPTIMIZING**\n\n");
@@ -479,32 +544,300 @@ olsr_optimize_mpr_set(void)
         continue;
       }
 
-      if (a_neighbor->is_mpr) {
-        removeit = 1;
+      if (a_neighbor->is_mpr && olsr_mpr_is_redundant(a_neighbor)) {
+        struct ipaddr_str buf;
+        OLSR_PRINTF(3, "MPR OPTIMIZE: removiong mpr %s\n\n", olsr_ip_to_string(&buf, &a_neighbor->neighbor_main_addr));
+        olsr_unchosen_mpr(a_neighbor);
+      }
+    } OLSR_FOR_ALL_NBR_ENTRIES_END(a_neighbor);
+  }
+}
+
+/**
+ *Check if all 2 hop neighbors of a MPR are
+ *covered by enough other MPRs
+ *
+ *@param a_neighbor the MPR to check
+ *
+ *@return true if the MPR can be removed
+ */
+static bool
+olsr_mpr_is_redundant(struct neighbor_entry *a_neighbor)
+{
+  struct neighbor_2_list_entry *two_hop_list;
+
+  for (two_hop_list = a_neighbor->neighbor_2_list.next; two_hop_list != &a_neighbor->neighbor_2_list;
+       two_hop_list = two_hop_list->next) {
+
+    if (!olsr_is_two_hop_only(two_hop_list->neighbor_2)) {
+      continue;
+    }
+    //printf("\t[%s] coverage %d\n", olsr_ip_to_string(&buf, &two_hop_list->neighbor_2->neighbor_2_addr), two_hop_list->neighbor_2->mpr_covered_count);
+    /* Do not remove if we find a entry which need this MPR */
+    if (two_hop_list->neighbor_2->mpr_covered_count <= olsr_cnf->mpr_coverage) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ *Find the best additional MPR to cover a 2 hop neighbor:
+ *the one with the highest willingness, preferring the one
+ *that also reaches the most other uncovered 2 hop neighbors
+ *
+ *@param neighbor_2 the 2 hop neighbor to cover
+ *
+ *@return the neighbor to select or NULL if none is left
+ */
+static struct neighbor_entry *
+olsr_find_mpr_candidate(struct neighbor_2_entry *neighbor_2)
+{
+  struct neighbor_list_entry *walker;
+  struct neighbor_entry *candidate = NULL;
+  int best_uncovered = -1;
+
+  for (walker = neighbor_2->neighbor_2_nblist.next; walker != &neighbor_2->neighbor_2_nblist; walker = walker->next) {
+    struct neighbor_entry *a_neighbor = walker->neighbor;
+    struct neighbor_2_list_entry *two_hop_list;
+    int uncovered = 0;
+
+    if (a_neighbor->is_mpr || a_neighbor->status != SYM || a_neighbor->willingness == WILL_NEVER) {
+      continue;
+    }
+    if (candidate != NULL && a_neighbor->willingness < candidate->willingness) {
+      continue;
+    }
+
+    for (two_hop_list = a_neighbor->neighbor_2_list.next; two_hop_list != &a_neighbor->neighbor_2_list;
+         two_hop_list = two_hop_list->next) {
+      if (two_hop_list->neighbor_2->mpr_covered_count < olsr_cnf->mpr_coverage) {
+        uncovered++;
+      }
+    }
+
+    if (candidate == NULL || a_neighbor->willingness > candidate->willingness || uncovered > best_uncovered) {
+      candidate = a_neighbor;
+      best_uncovered = uncovered;
+    }
+  }
+  return candidate;
+}
 
-        for (two_hop_list = a_neighbor->neighbor_2_list.next; two_hop_list != &a_neighbor->neighbor_2_list;
-             two_hop_list = two_hop_list->next) {
+/**
+ *Update the MPR set for the 2 hop neighbors queued
+ *by the olsr_mpr_touch_*() hooks only.
+ *
+ *The coverage count of all other 2 hop neighbors is
+ *kept up to date as MPRs are selected and deselected,
+ *so only the queued entries have to be recounted. Any
+ *of them that lost coverage is repaired greedily, and
+ *MPRs next to them are checked for redundancy.
+ */
+static void
+olsr_update_mpr_incremental(void)
+{
+  struct neighbor_entry *a_neighbor;
+  struct neighbor_2_entry *neighbor_2;
+  struct neighbor_list_entry *walker;
+  struct list_node *node;
+  uint16_t covered = 0;
+  int i;
 
-          dup_neighbor = olsr_lookup_neighbor_table(&two_hop_list->neighbor_2->neighbor_2_addr);
+  OLSR_PRINTF(3, "\n**UPDATING MPR**\n\n");
 
-          if ((dup_neighbor != NULL) && (dup_neighbor->status != NOT_SYM)) {
-            continue;
-          }
-          //printf("\t[%s] coverage %d\n", olsr_ip_to_string(&buf, &two_hop_list->neighbor_2->neighbor_2_addr), two_hop_list->neighbor_2->mpr_covered_count);
-          /* Do not remove if we find a entry which need this MPR */
-          if (two_hop_list->neighbor_2->mpr_covered_count <= olsr_cnf->mpr_coverage) {
-            removeit = 0;
-          }
-        }
+  OLSR_FOR_ALL_NBR_ENTRIES(a_neighbor) {
+    a_neighbor->was_mpr = a_neighbor->is_mpr;
 
-        if (removeit) {
-          struct ipaddr_str buf;
-          OLSR_PRINTF(3, "MPR OPTIMIZE: removiong mpr %s\n\n", olsr_ip_to_string(&buf, &a_neighbor->neighbor_main_addr));
-          a_neighbor->is_mpr = false;
-        }
+    if (a_neighbor->status == SYM && a_neighbor->willingness == WILL_ALWAYS) {
+      if (!a_neighbor->is_mpr) {
+        olsr_chosen_mpr(a_neighbor, &covered);
       }
-    } OLSR_FOR_ALL_NBR_ENTRIES_END(a_neighbor);
+    } else if (a_neighbor->is_mpr && (a_neighbor->status != SYM || a_neighbor->willingness == WILL_NEVER)) {
+      /* its 2 hop neighbors are recounted below */
+      a_neighbor->is_mpr = false;
+      olsr_mpr_touch_neighbor(a_neighbor);
+    }
   }
+  OLSR_FOR_ALL_NBR_ENTRIES_END(a_neighbor);
+
+  /* Recount the coverage of all queued 2 hop neighbors */
+  for (node = mpr_dirty_list.next; node != &mpr_dirty_list; node = node->next) {
+    neighbor_2 = list2neigh2(node);
+    neighbor_2->mpr_covered_count = 0;
+
+    for (walker = neighbor_2->neighbor_2_nblist.next; walker != &neighbor_2->neighbor_2_nblist; walker = walker->next) {
+      walker->neighbor->mpr_review = true;
+    }
+
+    if (!olsr_is_two_hop_only(neighbor_2)) {
+      continue;
+    }
+
+    for (walker = neighbor_2->neighbor_2_nblist.next; walker != &neighbor_2->neighbor_2_nblist; walker = walker->next) {
+      if (walker->neighbor->is_mpr && walker->neighbor->status == SYM) {
+        neighbor_2->mpr_covered_count++;
+      }
+    }
+  }
+
+  /* Add MPRs for the ones that are not covered enough */
+  for (node = mpr_dirty_list.next; node != &mpr_dirty_list; node = node->next) {
+    neighbor_2 = list2neigh2(node);
+
+    if (!olsr_is_two_hop_only(neighbor_2)) {
+      continue;
+    }
+
+    while (neighbor_2->mpr_covered_count < olsr_cnf->mpr_coverage) {
+      a_neighbor = olsr_find_mpr_candidate(neighbor_2);
+      if (a_neighbor == NULL) {
+        break;
+      }
+      olsr_chosen_mpr(a_neighbor, &covered);
+      a_neighbor->mpr_review = true;
+    }
+  }
+
+  /* Drop MPRs around the changes that are not needed anymore */
+  for (i = WILL_NEVER + 1; i < WILL_ALWAYS; i++) {
+    OLSR_FOR_ALL_NBR_ENTRIES(a_neighbor) {
+      if (a_neighbor->mpr_review && a_neighbor->is_mpr && a_neighbor->willingness == i && olsr_mpr_is_redundant(a_neighbor)) {
+        olsr_unchosen_mpr(a_neighbor);
+      }
+    }
+    OLSR_FOR_ALL_NBR_ENTRIES_END(a_neighbor);
+  }
+
+  OLSR_FOR_ALL_NBR_ENTRIES(a_neighbor) {
+    a_neighbor->mpr_review = false;
+  }
+  OLSR_FOR_ALL_NBR_ENTRIES_END(a_neighbor);
+
+  if (olsr_check_mpr_changes()) {
+    OLSR_PRINTF(3, "CHANGES IN MPR SET\n");
+    if (olsr_cnf->tc_redundancy > 0)
+      signal_link_changes(true);
+  }
+}
+
+/**
+ *Queue a 2 hop neighbor for re-evaluation by the
+ *next MPR calculation
+ */
+void
+olsr_mpr_touch_two_hop(struct neighbor_2_entry *neighbor_2)
+{
+  if (!list_node_on_list(&neighbor_2->mpr_dirty_node)) {
+    list_add_before(&mpr_dirty_list, &neighbor_2->mpr_dirty_node);
+  }
+  mpr_touched = true;
+  changes_neighborhood = true;
+}
+
+/**
+ *Queue all 2 hop neighbors reached through a neighbor,
+ *and the neighbor itself if it is also a 2 hop neighbor,
+ *for re-evaluation by the next MPR calculation
+ */
+void
+olsr_mpr_touch_neighbor(struct neighbor_entry *neighbor)
+{
+  struct neighbor_2_list_entry *two_hop_list;
+  struct neighbor_2_entry *neighbor_2;
+
+  for (two_hop_list = neighbor->neighbor_2_list.next; two_hop_list != &neighbor->neighbor_2_list;
+       two_hop_list = two_hop_list->next) {
+    olsr_mpr_touch_two_hop(two_hop_list->neighbor_2);
+  }
+
+  neighbor_2 = olsr_lookup_two_hop_neighbor_table(&neighbor->neighbor_main_addr);
+  if (neighbor_2 != NULL) {
+    olsr_mpr_touch_two_hop(neighbor_2);
+  }
+
+  neighbor->mpr_review = true;
+  mpr_touched = true;
+  changes_neighborhood = true;
+}
+
+/**
+ *Note that a neighbor lost one of its 2 hop neighbors,
+ *so it might not be needed as MPR anymore
+ */
+void
+olsr_mpr_review_neighbor(struct neighbor_entry *neighbor)
+{
+  neighbor->mpr_review = true;
+  mpr_touched = true;
+  changes_neighborhood = true;
+}
+
+/**
+ *Must be called before a 2 hop neighbor entry is freed
+ */
+void
+olsr_mpr_forget_two_hop(struct neighbor_2_entry *neighbor_2)
+{
+  if (list_node_on_list(&neighbor_2->mpr_dirty_node)) {
+    list_remove(&neighbor_2->mpr_dirty_node);
+  }
+  mpr_touched = true;
+  changes_neighborhood = true;
+}
+
+/**
+ *Request a full MPR recalculation, for changes that
+ *cannot be tracked per 2 hop neighbor
+ */
+void
+olsr_mpr_touch_all(void)
+{
+  mpr_recalc_all = true;
+  changes_neighborhood = true;
+}
+
+/**
+ *Start a MPR calculation
+ *
+ *@return true if the whole MPR set has to be
+ *recalculated, false if it is enough to process
+ *the queued 2 hop neighbors
+ */
+bool
+olsr_mpr_begin_update(void)
+{
+  return mpr_recalc_all || !mpr_touched;
+}
+
+/**
+ *Dequeue the next 2 hop neighbor to re-evaluate
+ *
+ *@return the 2 hop neighbor or NULL if the queue is empty
+ */
+struct neighbor_2_entry *
+olsr_mpr_next_dirty(void)
+{
+  struct list_node *node;
+
+  if (list_is_empty(&mpr_dirty_list)) {
+    return NULL;
+  }
+  node = mpr_dirty_list.next;
+  list_remove(node);
+  return list2neigh2(node);
+}
+
+/**
+ *Finish a MPR calculation
+ */
+void
+olsr_mpr_end_update(void)
+{
+  while (olsr_mpr_next_dirty() != NULL);
+
+  mpr_recalc_all = false;
+  mpr_touched = false;
 }
 
 #ifndef NODEBUG
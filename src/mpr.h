@@ -42,8 +42,33 @@
 #ifndef _OLSR_MPR
 #define _OLSR_MPR
 
+#include "olsr_types.h"
+
+struct neighbor_entry;
+struct neighbor_2_entry;
+
 void olsr_calculate_mpr(void);
 
+/*
+ * Incremental MPR maintenance.
+ *
+ * Code that modifies the neighborhood reports the 2-hop neighbors
+ * whose coverage may have changed through the olsr_mpr_touch_*()
+ * functions; the next MPR calculation then only revisits those
+ * entries. olsr_mpr_touch_all() forces a full recalculation, which
+ * is also done if changes_neighborhood was set by code that did not
+ * report any details.
+ */
+void olsr_mpr_touch_two_hop(struct neighbor_2_entry *);
+void olsr_mpr_touch_neighbor(struct neighbor_entry *);
+void olsr_mpr_review_neighbor(struct neighbor_entry *);
+void olsr_mpr_forget_two_hop(struct neighbor_2_entry *);
+void olsr_mpr_touch_all(void);
+
+bool olsr_mpr_begin_update(void);
+struct neighbor_2_entry *olsr_mpr_next_dirty(void);
+void olsr_mpr_end_update(void);
+
 #ifndef NODEBUG
 void olsr_print_mpr_set(void);
 #else
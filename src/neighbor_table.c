@@ -75,10 +75,16 @@ olsr_del_nbr2_list(struct neighbor_2_list_entry *nbr2_list)
   nbr2 = nbr2_list->neighbor_2;
 
   if (nbr2->neighbor_2_pointer < 1) {
+    olsr_mpr_forget_two_hop(nbr2);
     DEQUEUE_ELEM(nbr2);
     free(nbr2);
+  } else {
+    olsr_mpr_touch_two_hop(nbr2);
   }
 
+  /* the neighbor may not be needed as MPR anymore */
+  olsr_mpr_review_neighbor(nbr2_list->nbr2_nbr);
+
   /*
    * Kill running timers.
    */
@@ -90,8 +96,7 @@ olsr_del_nbr2_list(struct neighbor_2_list_entry *nbr2_list)
 
   free(nbr2_list);
 
-  /* Set flags to recalculate the MPR set and the routing table */
-  changes_neighborhood = true;
+  /* Set flags to recalculate the routing table */
   changes_topology = true;
 }
 
@@ -158,6 +163,9 @@ olsr_update_neighbor_main_addr(struct neighbor_entry *entry, const union olsr_ip
   /*update main addr*/
   entry->neighbor_main_addr = *new_main_addr;
 
+  /* 2-hop neighbors are matched against the main address */
+  olsr_mpr_touch_all();
+
   /*insert it again*/
   QUEUE_ELEM(neighbortable[olsr_ip_hashing(new_main_addr)], entry);
 
@@ -199,6 +207,8 @@ olsr_delete_neighbor_table(const union olsr_ip_addr *neighbor_addr)
   if (entry == &neighbortable[hash])
     return 0;
 
+  olsr_mpr_touch_neighbor(entry);
+
   two_hop_list = entry->neighbor_2_list.next;
 
   while (two_hop_list != &entry->neighbor_2_list) {
@@ -216,7 +226,6 @@ olsr_delete_neighbor_table(const union olsr_ip_addr *neighbor_addr)
 
   free(entry);
 
-  changes_neighborhood = true;
   return 1;
 
 }
@@ -329,7 +338,7 @@ update_neighbor_status(struct neighbor_entry *entry, int lnk)
         olsr_delete_two_hop_neighbor_table(two_hop_neighbor);
       }
 
-      changes_neighborhood = true;
+      olsr_mpr_touch_neighbor(entry);
       changes_topology = true;
       if (olsr_cnf->tc_redundancy > 1)
         signal_link_changes(true);
@@ -337,7 +346,7 @@ update_neighbor_status(struct neighbor_entry *entry, int lnk)
     entry->status = SYM;
   } else {
     if (entry->status == SYM) {
-      changes_neighborhood = true;
+      olsr_mpr_touch_neighbor(entry);
       changes_topology = true;
       if (olsr_cnf->tc_redundancy > 1)
         signal_link_changes(true);
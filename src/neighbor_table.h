@@ -62,6 +62,8 @@ struct neighbor_entry {
   bool is_mpr;
   bool was_mpr;                        /* Used to detect changes in MPR */
   bool skip;
+  bool mpr_review;                     /* check for redundancy as MPR */
+  uint16_t mpr_selected_count;         /* LQ-MPR: 2-hop neighbors this one was selected for */
   int neighbor_2_nocov;
   int linkcount;
   struct neighbor_2_list_entry neighbor_2_list;
@@ -46,10 +46,14 @@
 #include "net_os.h"
 #include "link_set.h"
 #include "lq_packet.h"
+#include "scheduler.h"
 
 #include <stdlib.h>
 #include <assert.h>
 #include <limits.h>
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif /* _WIN32 */
 
 #ifdef _WIN32
 #define perror(x) WinSockPError(x)
@@ -72,6 +76,17 @@ static struct ptf *ptf_list;
 
 static struct deny_address_entry *deny_entries;
 
+static void net_outbuffer_copy(struct olsr_netbuf *, const void *, const uint16_t);
+static void net_release_segments(struct olsr_netbuf *);
+static void net_flatten_buffer(struct olsr_netbuf *);
+static bool net_fwd_by_reference(void);
+static uint32_t net_fwd_burst(const struct interface *);
+static bool net_fwd_rate_ok(struct interface *, uint16_t);
+static void net_fwd_fill(struct interface *);
+static void net_fwd_discard(struct interface *);
+static int net_output_packet(struct interface *);
+static ssize_t net_send_buffer(struct interface *, struct sockaddr *, socklen_t);
+
 static const char *const deny_ipv4_defaults[] = {
   "0.0.0.0",
   "127.0.0.1",
@@ -134,9 +149,15 @@ net_add_buffer(struct interface *ifp)
   ifp->netbuf.bufsize = ifp->int_mtu;
   ifp->netbuf.maxsize = ifp->int_mtu - OLSR_HEADERSIZE;
 
+  net_release_segments(&ifp->netbuf);
   ifp->netbuf.pending = 0;
+  ifp->netbuf.buffused = 0;
   ifp->netbuf.reserved = 0;
 
+  /* the forwarding rate limit starts with a full bucket */
+  ifp->fwdq.tokens = net_fwd_burst(ifp);
+  ifp->fwdq.last_fill = now_times;
+
   return 0;
 }
 
@@ -155,6 +176,14 @@ net_remove_buffer(struct interface *ifp)
   if (ifp->netbuf.pending)
     net_output(ifp);
 
+  /* and the forwarded messages that did not make up a full packet */
+  while (ifp->fwdq.count > 0 && ifp->netbuf.buff != NULL) {
+    net_fwd_fill(ifp);
+    net_output_packet(ifp);
+  }
+  net_fwd_discard(ifp);
+
+  net_release_segments(&ifp->netbuf);
   free(ifp->netbuf.buff);
   ifp->netbuf.buff = NULL;
 
@@ -218,12 +247,361 @@ net_outbuffer_push(struct interface *ifp, const void *data, const uint16_t size)
   if ((ifp->netbuf.pending + size) > ifp->netbuf.maxsize)
     return 0;
 
-  memcpy(&ifp->netbuf.buff[ifp->netbuf.pending + OLSR_HEADERSIZE], data, size);
-  ifp->netbuf.pending += size;
+  net_outbuffer_copy(&ifp->netbuf, data, size);
 
   return size;
 }
 
+/**
+ * Append local data to the pending data of a buffer.
+ * The caller has checked that there is enough room.
+ */
+static void
+net_outbuffer_copy(struct olsr_netbuf *netbuf, const void *data, const uint16_t size)
+{
+  if (netbuf->segcount == OLSR_NETBUF_SEGMENTS && netbuf->segs[netbuf->segcount - 1].fwd != NULL) {
+    /* out of segments */
+    net_flatten_buffer(netbuf);
+  }
+
+  if (netbuf->segcount > 0) {
+    struct olsr_netbuf_seg *seg = &netbuf->segs[netbuf->segcount - 1];
+
+    if (seg->fwd != NULL) {
+      seg = &netbuf->segs[netbuf->segcount++];
+      seg->fwd = NULL;
+      seg->offset = netbuf->buffused;
+      seg->size = 0;
+    }
+    seg->size += size;
+  }
+
+  memcpy(&netbuf->buff[netbuf->buffused + OLSR_HEADERSIZE], data, size);
+  netbuf->buffused += size;
+  netbuf->pending += size;
+}
+
+/**
+ * Create a shared copy of a message that is going to be
+ * forwarded on several interfaces.
+ *
+ * @param data the message
+ * @param size the size of the message
+ *
+ * @return the shared message with one reference
+ */
+struct olsr_fwd_msg *
+net_fwd_msg_create(const void *data, const uint16_t size)
+{
+  struct olsr_fwd_msg *fwd = olsr_malloc(sizeof(*fwd) + size, "Forwarded message");
+
+  fwd->refcount = 1;
+  fwd->size = size;
+  memcpy(fwd->data, data, size);
+
+  return fwd;
+}
+
+/**
+ * Drop a reference to a shared message
+ */
+void
+net_fwd_msg_release(struct olsr_fwd_msg *fwd)
+{
+  if (--fwd->refcount == 0) {
+    free(fwd);
+  }
+}
+
+/**
+ * Add a shared message to a buffer without copying it. The
+ * message is referenced until the buffer has been sent.
+ *
+ * @param ifp the interface corresponding to the buffer
+ * @param fwd the shared message
+ *
+ * @return 0 if there was not enough room in the buffer
+ *  or the number of bytes added on success
+ */
+int
+net_outbuffer_push_fwd(struct interface *ifp, struct olsr_fwd_msg *fwd)
+{
+  struct olsr_netbuf *netbuf = &ifp->netbuf;
+  struct olsr_netbuf_seg *seg;
+
+  if ((netbuf->pending + fwd->size) > netbuf->maxsize)
+    return 0;
+
+  if (netbuf->segcount == OLSR_NETBUF_SEGMENTS || !net_fwd_by_reference()) {
+    /* out of segments or the packet is needed in one piece, copy it after all */
+    net_outbuffer_copy(netbuf, fwd->data, fwd->size);
+    return fwd->size;
+  }
+
+  if (netbuf->segcount == 0 && netbuf->buffused > 0) {
+    /* describe the data already in the buffer */
+    seg = &netbuf->segs[netbuf->segcount++];
+    seg->fwd = NULL;
+    seg->offset = 0;
+    seg->size = netbuf->buffused;
+  }
+
+  seg = &netbuf->segs[netbuf->segcount++];
+  seg->fwd = fwd;
+  seg->offset = 0;
+  seg->size = fwd->size;
+  fwd->refcount++;
+
+  netbuf->pending += fwd->size;
+  return fwd->size;
+}
+
+/**
+ * Forwarded messages are referenced by the output buffers only if
+ * they can be sent from where they are. Packet transform functions
+ * rewrite the buffer, and the win32 and libnet send paths need the
+ * packet in one piece, so a reference would only add a copy.
+ */
+static bool
+net_fwd_by_reference(void)
+{
+#if defined _WIN32 || defined SPOOF
+  return false;
+#else /* defined _WIN32 || defined SPOOF */
+  return ptf_list == NULL;
+#endif /* defined _WIN32 || defined SPOOF */
+}
+
+/**
+ * Size of the token bucket of the forwarding rate limit: one
+ * second of traffic, but at least one full packet.
+ */
+static uint32_t
+net_fwd_burst(const struct interface *ifp)
+{
+  uint32_t burst = olsr_cnf->fwd_rate_limit;
+
+  if (burst < (uint32_t)ifp->netbuf.bufsize) {
+    burst = ifp->netbuf.bufsize;
+  }
+  return burst;
+}
+
+/**
+ * Queue a shared message for forwarding on an interface. Queued
+ * messages are sent behind the locally generated messages of the
+ * interface, in the room these leave in a packet. A full queue is
+ * sent out first to make room. The message is dropped when the
+ * forwarding rate limit of the interface is exceeded.
+ *
+ * @param ifp the interface to forward on
+ * @param fwd the shared message
+ *
+ * @return the number of bytes queued, 0 if the message was
+ *  dropped or -1 if it is too big for the interface
+ */
+int
+net_fwd_enqueue(struct interface *ifp, struct olsr_fwd_msg *fwd)
+{
+  struct olsr_fwd_queue *q = &ifp->fwdq;
+
+  if (fwd->size > ifp->netbuf.maxsize) {
+    return -1;
+  }
+
+  if (!net_fwd_rate_ok(ifp, fwd->size)) {
+    return 0;
+  }
+
+  /* many small messages fill the queue before they make up a full packet */
+  while (q->count == OLSR_FWD_QUEUE_LEN) {
+    net_fwd_fill(ifp);
+    if (net_output_packet(ifp) <= 0) {
+      break;
+    }
+  }
+  if (q->count == OLSR_FWD_QUEUE_LEN) {
+    q->dropped_full++;
+    return 0;
+  }
+
+  q->msgs[(q->head + q->count) % OLSR_FWD_QUEUE_LEN] = fwd;
+  fwd->refcount++;
+  q->count++;
+  q->bytes += fwd->size;
+  if ((uint32_t)q->count > q->max_count) {
+    q->max_count = q->count;
+  }
+  return fwd->size;
+}
+
+/**
+ * Take the tokens for a forwarded message from the rate limit
+ * of an interface.
+ *
+ * @return false if the message exceeds the rate limit
+ */
+static bool
+net_fwd_rate_ok(struct interface *ifp, uint16_t size)
+{
+  struct olsr_fwd_queue *q = &ifp->fwdq;
+
+  if (olsr_cnf->fwd_rate_limit > 0) {
+    uint64_t fill = (uint64_t)(now_times - q->last_fill) * olsr_cnf->fwd_rate_limit / MSEC_PER_SEC;
+
+    if (fill > 0) {
+      uint32_t burst = net_fwd_burst(ifp);
+
+      q->tokens = q->tokens + fill >= burst ? burst : q->tokens + fill;
+      q->last_fill = now_times;
+    }
+    if (q->tokens < size) {
+      q->dropped_rate++;
+      return false;
+    }
+    q->tokens -= size;
+  }
+  return true;
+}
+
+/**
+ * Forward a message on an interface.
+ *
+ * A message which fits into the packet being built while nothing is
+ * queued is copied straight into the buffer, like a local message. The
+ * same holds when the message goes out on this interface only. A
+ * message shared with other interfaces is referenced by every buffer
+ * instead. A message which has to wait in the queue needs a copy that
+ * outlives the received packet. *fwd is created on first use and shared
+ * by all interfaces the message is forwarded on.
+ *
+ * @param ifp the interface to forward on
+ * @param data the message
+ * @param size the size of the message
+ * @param fwd the shared copy of the message, NULL if there is none yet
+ * @param shared true if the message is forwarded on several interfaces
+ *
+ * @return like net_fwd_enqueue()
+ */
+int
+net_fwd_message(struct interface *ifp, const void *data, uint16_t size, struct olsr_fwd_msg **fwd, bool shared)
+{
+  if (size > ifp->netbuf.maxsize) {
+    return -1;
+  }
+
+  if (ifp->fwdq.count == 0 && ifp->netbuf.pending + size <= ifp->netbuf.maxsize
+      && (!shared || !net_fwd_by_reference())) {
+    if (!net_fwd_rate_ok(ifp, size)) {
+      return 0;
+    }
+    net_outbuffer_copy(&ifp->netbuf, data, size);
+    ifp->fwdq.sent++;
+    return size;
+  }
+
+  if (*fwd == NULL) {
+    *fwd = net_fwd_msg_create(data, size);
+  }
+  return net_fwd_enqueue(ifp, *fwd);
+}
+
+/**
+ * Move queued forwarded messages into the output buffer, oldest
+ * first, as long as they fit.
+ */
+static void
+net_fwd_fill(struct interface *ifp)
+{
+  struct olsr_fwd_queue *q = &ifp->fwdq;
+
+  while (q->count > 0) {
+    struct olsr_fwd_msg *fwd = q->msgs[q->head];
+
+    if (net_outbuffer_push_fwd(ifp, fwd) != fwd->size) {
+      if (ifp->netbuf.pending > 0) {
+        break;
+      }
+      /* does not fit into an empty buffer, space was reserved meanwhile */
+      q->dropped_full++;
+    } else {
+      q->sent++;
+    }
+
+    q->head = (q->head + 1) % OLSR_FWD_QUEUE_LEN;
+    q->count--;
+    q->bytes -= fwd->size;
+    net_fwd_msg_release(fwd);
+  }
+}
+
+/**
+ * Drop all queued forwarded messages of an interface
+ */
+static void
+net_fwd_discard(struct interface *ifp)
+{
+  struct olsr_fwd_queue *q = &ifp->fwdq;
+
+  while (q->count > 0) {
+    net_fwd_msg_release(q->msgs[q->head]);
+    q->head = (q->head + 1) % OLSR_FWD_QUEUE_LEN;
+    q->count--;
+  }
+  q->head = 0;
+  q->bytes = 0;
+}
+
+/**
+ * Drop the references to shared messages of a buffer
+ */
+static void
+net_release_segments(struct olsr_netbuf *netbuf)
+{
+  int i;
+
+  for (i = 0; i < netbuf->segcount; i++) {
+    if (netbuf->segs[i].fwd != NULL) {
+      net_fwd_msg_release(netbuf->segs[i].fwd);
+    }
+  }
+  netbuf->segcount = 0;
+}
+
+/**
+ * Copy all pending data of a buffer into buff in the right order,
+ * for code that needs the packet in one piece.
+ */
+static void
+net_flatten_buffer(struct olsr_netbuf *netbuf)
+{
+  int i, end = 0;
+
+  for (i = 0; i < netbuf->segcount; i++) {
+    end += netbuf->segs[i].size;
+  }
+  netbuf->buffused = end;
+
+  /*
+   * Work from the end, local data only moves towards the end of
+   * the buffer, so it is never overwritten before it is moved.
+   */
+  for (i = netbuf->segcount - 1; i >= 0; i--) {
+    struct olsr_netbuf_seg *seg = &netbuf->segs[i];
+    uint8_t *dst;
+
+    end -= seg->size;
+    dst = &netbuf->buff[end + OLSR_HEADERSIZE];
+    if (seg->fwd != NULL) {
+      memcpy(dst, seg->fwd->data, seg->size);
+    } else if (end != seg->offset) {
+      memmove(dst, &netbuf->buff[seg->offset + OLSR_HEADERSIZE], seg->size);
+    }
+  }
+
+  net_release_segments(netbuf);
+}
+
 /**
  * Add data to the reserved part of a buffer
  *
@@ -241,8 +619,7 @@ net_outbuffer_push_reserved(struct interface *ifp, const void *data, const uint1
   if ((ifp->netbuf.pending + size) > (ifp->netbuf.maxsize + ifp->netbuf.reserved))
     return 0;
 
-  memcpy(&ifp->netbuf.buff[ifp->netbuf.pending + OLSR_HEADERSIZE], data, size);
-  ifp->netbuf.pending += size;
+  net_outbuffer_copy(&ifp->netbuf, data, size);
 
   return size;
 }
@@ -316,7 +693,11 @@ del_ptf(packet_transform_function f)
 }
 
 /**
- *Sends a packet on a given interface.
+ *Sends the pending data of an interface. Locally generated
+ *messages go first, forwarded messages fill up the rest of
+ *the packet. Queued forwarded messages that make up more
+ *than a packet are sent as well, the remainder waits for
+ *the next local message.
  *
  *@param ifp the interface to send on.
  *
@@ -324,6 +705,33 @@ del_ptf(packet_transform_function f)
  */
 int
 net_output(struct interface *ifp)
+{
+  int retval = 0;
+
+  if (ifp->netbuf.pending) {
+    net_fwd_fill(ifp);
+    retval = net_output_packet(ifp);
+  }
+
+  while (ifp->fwdq.bytes > ifp->netbuf.maxsize) {
+    net_fwd_fill(ifp);
+    if (net_output_packet(ifp) < 0) {
+      retval = -1;
+    }
+  }
+
+  return retval;
+}
+
+/**
+ *Sends the packet in the output buffer of an interface.
+ *
+ *@param ifp the interface to send on.
+ *
+ *@return negative on error
+ */
+static int
+net_output_packet(struct interface *ifp)
 {
   struct sockaddr_in *sin = NULL;
   struct sockaddr_in6 *sin6 = NULL;
@@ -364,6 +772,18 @@ net_output(struct interface *ifp)
     sin6 = &dst6;
   }
 
+  /*
+   * Forwarded messages are sent from where they are, unless
+   * the packet transform functions need the whole packet.
+   */
+#ifdef _WIN32
+  if (ifp->netbuf.segcount > 0) {
+#else /* _WIN32 */
+  if (ifp->netbuf.segcount > 0 && ptf_list != NULL) {
+#endif /* _WIN32 */
+    net_flatten_buffer(&ifp->netbuf);
+  }
+
   /*
    *Call possible packet transform functions registered by plugins
    */
@@ -373,8 +793,7 @@ net_output(struct interface *ifp)
 
   if (olsr_cnf->ip_version == AF_INET) {
     /* IP version 4 */
-    if (olsr_sendto(ifp->send_socket, ifp->netbuf.buff, ifp->netbuf.pending, MSG_DONTROUTE, (struct sockaddr *)sin, sizeof(*sin)) <
-        0) {
+    if (net_send_buffer(ifp, (struct sockaddr *)sin, sizeof(*sin)) < 0) {
       perror("sendto(v4)");
 #ifndef _WIN32
       olsr_syslog(OLSR_LOG_ERR, "OLSR: sendto IPv4 %m");
@@ -383,8 +802,7 @@ net_output(struct interface *ifp)
     }
   } else {
     /* IP version 6 */
-    if (olsr_sendto(ifp->send_socket, ifp->netbuf.buff, ifp->netbuf.pending, MSG_DONTROUTE, (struct sockaddr *)sin6, sizeof(*sin6))
-        < 0) {
+    if (net_send_buffer(ifp, (struct sockaddr *)sin6, sizeof(*sin6)) < 0) {
       struct ipaddr_str buf;
       perror("sendto(v6)");
 #ifndef _WIN32
@@ -397,7 +815,9 @@ net_output(struct interface *ifp)
     }
   }
 
+  net_release_segments(&ifp->netbuf);
   ifp->netbuf.pending = 0;
+  ifp->netbuf.buffused = 0;
 
   /*
    * if we've just transmitted a TC message, let Dijkstra use the current
@@ -409,6 +829,34 @@ net_output(struct interface *ifp)
   return retval;
 }
 
+/**
+ * Send the packet in an output buffer, with a scatter/gather
+ * list if it references forwarded messages.
+ */
+static ssize_t
+net_send_buffer(struct interface *ifp, struct sockaddr *to, socklen_t tolen)
+{
+#ifndef _WIN32
+  if (ifp->netbuf.segcount > 0) {
+    struct iovec iov[OLSR_NETBUF_SEGMENTS + 1];
+    int i;
+
+    /* packet header */
+    iov[0].iov_base = ifp->netbuf.buff;
+    iov[0].iov_len = OLSR_HEADERSIZE;
+
+    for (i = 0; i < ifp->netbuf.segcount; i++) {
+      const struct olsr_netbuf_seg *seg = &ifp->netbuf.segs[i];
+
+      iov[i + 1].iov_base = seg->fwd != NULL ? seg->fwd->data : &ifp->netbuf.buff[seg->offset + OLSR_HEADERSIZE];
+      iov[i + 1].iov_len = seg->size;
+    }
+    return olsr_sendmsg(ifp->send_socket, iov, ifp->netbuf.segcount + 1, MSG_DONTROUTE, to, tolen);
+  }
+#endif /* _WIN32 */
+  return olsr_sendto(ifp->send_socket, ifp->netbuf.buff, ifp->netbuf.pending, MSG_DONTROUTE, to, tolen);
+}
+
 /*
  * Adds the given IP-address to the invalid list.
  */
@@ -67,6 +67,16 @@ int net_outbuffer_push(struct interface *, const void *, const uint16_t);
 
 int net_outbuffer_push_reserved(struct interface *, const void *, const uint16_t);
 
+struct olsr_fwd_msg *net_fwd_msg_create(const void *, const uint16_t);
+
+void net_fwd_msg_release(struct olsr_fwd_msg *);
+
+int net_outbuffer_push_fwd(struct interface *, struct olsr_fwd_msg *);
+
+int net_fwd_enqueue(struct interface *, struct olsr_fwd_msg *);
+
+int net_fwd_message(struct interface *, const void *, uint16_t, struct olsr_fwd_msg **, bool);
+
 int net_output(struct interface *);
 
 int net_sendroute(struct rt_entry *, struct sockaddr *);
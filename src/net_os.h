@@ -57,6 +57,11 @@ ssize_t olsr_sendto(int, const void *, size_t, int, const struct sockaddr *, soc
 
 ssize_t olsr_recvfrom(int, void *, size_t, int, struct sockaddr *, socklen_t *);
 
+#ifndef _WIN32
+struct iovec;
+ssize_t olsr_sendmsg(int, struct iovec *, int, int, struct sockaddr *, socklen_t);
+#endif /* _WIN32 */
+
 int olsr_select(int, fd_set *, fd_set *, fd_set *, struct timeval *);
 
 int bind_socket_to_device(int, char *);
@@ -66,6 +66,8 @@
 #include "lq_plugin.h"
 #include "gateway.h"
 #include "duplicate_handler.h"
+#include "olsr_admit.h"
+#include "olsr_node_id.h"
 
 #include <stdarg.h>
 #include <signal.h>
@@ -273,6 +275,9 @@ olsr_init_tables(void)
   /* Initialize duplicate table */
   olsr_init_duplicate_set();
 
+  /* Initialize admission control of received messages */
+  olsr_init_admission();
+
   /* Initialize neighbor table */
   olsr_init_neighbor_table();
 
@@ -282,6 +287,9 @@ olsr_init_tables(void)
   /* Initialize two hop table */
   olsr_init_two_hop_table();
 
+  /* Initialize the interned node addresses of the topology */
+  olsr_init_node_ids();
+
   /* Initialize topology */
   olsr_init_tc();
 
@@ -300,6 +308,24 @@ olsr_init_tables(void)
 #endif /* NO_DUPLICATE_DETECTION_HANDLER */
 }
 
+/**
+ * @return true if a forwarded message goes out on an interface
+ */
+static bool
+olsr_forward_on_interface(const struct interface *ifn, const struct interface *in_if, bool is_ttl_1)
+{
+  /* do not retransmit out through the same interface if it has mode == ether */
+  if (ifn == in_if && ifn->mode == IF_MODE_ETHER) {
+    return false;
+  }
+
+  /* do not forward TTL 1 messages to non-ether interfaces */
+  if (is_ttl_1 && ifn->mode != IF_MODE_ETHER) {
+    return false;
+  }
+  return true;
+}
+
 /**
  *Check if a message is to be forwarded and forward
  *it if necessary.
@@ -317,6 +343,8 @@ olsr_forward_message(union olsr_message *m, struct interface *in_if, union olsr_
   struct neighbor_entry *neighbor;
   int msgsize;
   struct interface *ifn;
+  struct olsr_fwd_msg *fwd = NULL;
+  int ifcount = 0;
   bool is_ttl_1 = false;
 
   /*
@@ -373,39 +401,37 @@ olsr_forward_message(union olsr_message *m, struct interface *in_if, union olsr_
   /* Update packet data */
   msgsize = ntohs(m->v4.olsr_msgsize);
 
+  /* a message going out on several interfaces is shared by their buffers */
+  for (ifn = ifnet; ifn; ifn = ifn->int_next) {
+    if (olsr_forward_on_interface(ifn, in_if, is_ttl_1)) {
+      ifcount++;
+    }
+  }
+
   /* looping trough interfaces */
   for (ifn = ifnet; ifn; ifn = ifn->int_next) {
-    /* do not retransmit out through the same interface if it has mode == ether */
-    if (ifn == in_if && ifn->mode == IF_MODE_ETHER) continue;
-
-    /* do not forward TTL 1 messages to non-ether interfaces */
-    if (is_ttl_1 && ifn->mode != IF_MODE_ETHER) continue;
-
-    if (net_output_pending(ifn)) {
-      /*
-       * Check if message is to big to be piggybacked
-       */
-      if (net_outbuffer_push(ifn, m, msgsize) != msgsize) {
-        /* Send */
-        net_output(ifn);
-        /* Buffer message */
-        set_buffer_timer(ifn);
-
-        if (net_outbuffer_push(ifn, m, msgsize) != msgsize) {
-          OLSR_PRINTF(1, "Received message to big to be forwarded in %s(%d bytes)!", ifn->int_name, msgsize);
-          olsr_syslog(OLSR_LOG_ERR, "Received message to big to be forwarded on %s(%d bytes)!", ifn->int_name, msgsize);
-        }
-      }
-    } else {
+    if (!olsr_forward_on_interface(ifn, in_if, is_ttl_1)) {
+      continue;
+    }
+
+    if (!net_output_pending(ifn) && ifn->fwdq.count == 0) {
       /* No forwarding pending */
       set_buffer_timer(ifn);
+    }
 
-      if (net_outbuffer_push(ifn, m, msgsize) != msgsize) {
-        OLSR_PRINTF(1, "Received message to big to be forwarded in %s(%d bytes)!", ifn->int_name, msgsize);
-        olsr_syslog(OLSR_LOG_ERR, "Received message to big to be forwarded on %s(%d bytes)!", ifn->int_name, msgsize);
-      }
+    if (net_fwd_message(ifn, m, msgsize, &fwd, ifcount > 1) < 0) {
+      OLSR_PRINTF(1, "Received message to big to be forwarded in %s(%d bytes)!", ifn->int_name, msgsize);
+      olsr_syslog(OLSR_LOG_ERR, "Received message to big to be forwarded on %s(%d bytes)!", ifn->int_name, msgsize);
+    } else if (net_output_pending(ifn) + ifn->fwdq.bytes > ifn->netbuf.maxsize) {
+      /* Send what makes up a full packet */
+      net_output(ifn);
+      set_buffer_timer(ifn);
     }
   }
+
+  if (fwd != NULL) {
+    net_fwd_msg_release(fwd);
+  }
   return 1;
 }
 
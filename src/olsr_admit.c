@@ -0,0 +1,271 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Admission control for received messages.
+ *
+ * Every message passes two token buckets before it is parsed: one for
+ * the neighbor which sent the packet and one for the originator of the
+ * message. Both are refilled with InputSenderBudget or
+ * InputOriginatorBudget weight units per second and hold one second of
+ * them. A message costs the weight of its type. The last eighth of a
+ * sender bucket is kept for HELLOs, so a neighbor which floods other
+ * messages does not lose its links. Known duplicates are dropped before
+ * they cost anything. Both budgets are off unless configured, the right
+ * values depend on the size of the mesh.
+ */
+
+#include "olsr_admit.h"
+#include "olsr.h"
+#include "defs.h"
+#include "ipcalc.h"
+#include "hashing.h"
+#include "duplicate_set.h"
+#include "lq_packet.h"
+#include "scheduler.h"
+
+#define OLSR_ADMIT_CLEANUP_INTERVAL 30000
+#define OLSR_ADMIT_IDLE_TIME 60000
+
+/* more buckets would only help somebody who makes up addresses */
+#define OLSR_ADMIT_MAX_BUCKETS 4096
+
+struct olsr_admit_stats olsr_admit_stats;
+
+static struct olsr_admit_bucket *admit_table[2][HASHSIZE];
+static unsigned int admit_count[2];
+static struct timer_entry *admit_cleanup_timer;
+
+static void olsr_admit_cleanup(void *);
+
+void
+olsr_init_admission(void)
+{
+  olsr_set_timer(&admit_cleanup_timer, OLSR_ADMIT_CLEANUP_INTERVAL, 10, OLSR_TIMER_PERIODIC, &olsr_admit_cleanup, NULL, 0);
+}
+
+/**
+ * @param type message type
+ * @return the cost of a message of this type in weight units
+ */
+static uint32_t
+olsr_admit_weight(uint8_t type)
+{
+  switch (type) {
+  case HELLO_MESSAGE:
+  case LQ_HELLO_MESSAGE:
+  case MID_MESSAGE:
+  case HNA_MESSAGE:
+    return 1;
+  case TC_MESSAGE:
+  case LQ_TC_MESSAGE:
+    /* may change the topology and trigger a route calculation */
+    return 2;
+  default:
+    /* plugin messages */
+    return 4;
+  }
+}
+
+/**
+ * Find the bucket of an address, create it with a full budget if
+ * there is none yet.
+ *
+ * @return the bucket, NULL if the table is full
+ */
+static struct olsr_admit_bucket *
+olsr_admit_get_bucket(enum olsr_admit_table table, const union olsr_ip_addr *addr, uint32_t rate)
+{
+  uint32_t hash = olsr_ip_hashing(addr);
+  struct olsr_admit_bucket *bucket;
+
+  for (bucket = admit_table[table][hash]; bucket != NULL; bucket = bucket->next) {
+    if (ipequal(&bucket->addr, addr)) {
+      return bucket;
+    }
+  }
+
+  if (admit_count[table] >= OLSR_ADMIT_MAX_BUCKETS) {
+    return NULL;
+  }
+
+  bucket = olsr_malloc(sizeof(*bucket), "Admission bucket");
+  bucket->addr = *addr;
+  bucket->tokens = rate * 1000;
+  bucket->last_fill = now_times;
+  bucket->next = admit_table[table][hash];
+  admit_table[table][hash] = bucket;
+  admit_count[table]++;
+  return bucket;
+}
+
+/**
+ * Refill a bucket for the time since its last refill.
+ *
+ * @return true if the bucket holds at least cost tokens
+ */
+static bool
+olsr_admit_refill(struct olsr_admit_bucket *bucket, uint32_t rate, uint32_t cost)
+{
+  uint64_t tokens = bucket->tokens + (uint64_t)(now_times - bucket->last_fill) * rate;
+
+  /* one second of traffic at most */
+  bucket->tokens = tokens > rate * 1000 ? rate * 1000 : (uint32_t)tokens;
+  bucket->last_fill = now_times;
+  return bucket->tokens >= cost;
+}
+
+/**
+ * Decide if a received message is parsed. Messages which are not
+ * admitted are neither processed nor forwarded.
+ *
+ * @param m the message
+ * @param from the neighbor interface which sent the packet
+ * @return true if the message should be parsed
+ */
+bool
+olsr_admit_message(const union olsr_message *m, const union olsr_ip_addr *from)
+{
+  uint32_t sender_rate = olsr_cnf->input_sender_budget;
+  uint32_t orig_rate = olsr_cnf->input_orig_budget;
+  struct olsr_admit_bucket *sender = NULL, *orig = NULL;
+  uint32_t cost = olsr_admit_weight(m->v4.olsr_msgtype) * 1000;
+
+  if (olsr_message_is_known(m)) {
+    olsr_admit_stats.dropped_duplicate++;
+    return false;
+  }
+
+  if (sender_rate > 0) {
+    uint32_t need = cost;
+
+    sender = olsr_admit_get_bucket(OLSR_ADMIT_SENDER, from, sender_rate);
+    if (m->v4.olsr_msgtype != HELLO_MESSAGE && m->v4.olsr_msgtype != LQ_HELLO_MESSAGE) {
+      /* keep a reserve for link sensing */
+      need += sender_rate * 1000 / 8;
+    }
+    if (sender != NULL && !olsr_admit_refill(sender, sender_rate, need)) {
+      sender->dropped++;
+      olsr_admit_stats.dropped_sender++;
+      return false;
+    }
+  }
+
+  if (orig_rate > 0) {
+    union olsr_ip_addr originator;
+
+    /* Should be the same for IPv4 and IPv6, copied out of the packed message */
+    memcpy(&originator, &m->v4.originator, olsr_cnf->ipsize);
+    orig = olsr_admit_get_bucket(OLSR_ADMIT_ORIGINATOR, &originator, orig_rate);
+    if (orig != NULL && !olsr_admit_refill(orig, orig_rate, cost)) {
+      orig->dropped++;
+      olsr_admit_stats.dropped_originator++;
+      return false;
+    }
+  }
+
+  if (sender != NULL) {
+    sender->tokens -= cost;
+    sender->admitted++;
+  }
+  if (orig != NULL) {
+    orig->tokens -= cost;
+    orig->admitted++;
+  }
+  olsr_admit_stats.admitted++;
+  return true;
+}
+
+/**
+ * Remove the buckets which were not used for a while
+ */
+static void
+olsr_admit_cleanup(void *unused __attribute__ ((unused)))
+{
+  int table, hash;
+
+  for (table = OLSR_ADMIT_SENDER; table <= OLSR_ADMIT_ORIGINATOR; table++) {
+    for (hash = 0; hash < HASHSIZE; hash++) {
+      struct olsr_admit_bucket **prev = &admit_table[table][hash];
+
+      while (*prev != NULL) {
+        struct olsr_admit_bucket *bucket = *prev;
+
+        if (TIMED_OUT(bucket->last_fill + OLSR_ADMIT_IDLE_TIME)) {
+          *prev = bucket->next;
+          free(bucket);
+          admit_count[table]--;
+        } else {
+          prev = &bucket->next;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Call a function for every bucket
+ *
+ * @param cb the function
+ * @param ctx first argument of the function
+ */
+void
+olsr_admit_walk(olsr_admit_walker cb, void *ctx)
+{
+  int table, hash;
+
+  for (table = OLSR_ADMIT_SENDER; table <= OLSR_ADMIT_ORIGINATOR; table++) {
+    for (hash = 0; hash < HASHSIZE; hash++) {
+      const struct olsr_admit_bucket *bucket;
+
+      for (bucket = admit_table[table][hash]; bucket != NULL; bucket = bucket->next) {
+        cb(ctx, (enum olsr_admit_table)table, bucket);
+      }
+    }
+  }
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
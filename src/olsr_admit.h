@@ -0,0 +1,85 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _OLSR_ADMIT_H
+#define _OLSR_ADMIT_H
+
+#include "olsr_types.h"
+#include "olsr_protocol.h"
+
+/* Token bucket of a sender or an originator */
+struct olsr_admit_bucket {
+  struct olsr_admit_bucket *next;
+  union olsr_ip_addr addr;
+  uint32_t tokens;                     /* 1/1000 of a message weight */
+  uint32_t last_fill;                  /* now_times of the last refill */
+  uint32_t admitted;                   /* messages let through */
+  uint32_t dropped;                    /* messages dropped by this bucket */
+};
+
+struct olsr_admit_stats {
+  uint32_t admitted;
+  uint32_t dropped_duplicate;
+  uint32_t dropped_sender;
+  uint32_t dropped_originator;
+};
+
+enum olsr_admit_table {
+  OLSR_ADMIT_SENDER,
+  OLSR_ADMIT_ORIGINATOR
+};
+
+typedef void (*olsr_admit_walker) (void *, enum olsr_admit_table, const struct olsr_admit_bucket *);
+
+extern struct olsr_admit_stats olsr_admit_stats;
+
+void olsr_init_admission(void);
+bool olsr_admit_message(const union olsr_message *, const union olsr_ip_addr *);
+void olsr_admit_walk(olsr_admit_walker, void *);
+
+#endif /* _OLSR_ADMIT_H */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
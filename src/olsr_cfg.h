@@ -80,6 +80,13 @@
 #define DEF_RT_AUTO          0
 #define DEF_MIN_TC_VTIME     0.0
 #define DEF_USE_NIIT         true
+#define DEF_SPF_THREAD       false
+#define DEF_RX_THREAD        false
+#define DEF_FWD_RATE_LIMIT   0
+#define DEF_INPUT_SENDER_BUDGET 0
+#define DEF_INPUT_ORIG_BUDGET 0
+#define MIN_INPUT_BUDGET     8
+#define MAX_INPUT_BUDGET     1000000
 #define DEF_SMART_GW         false
 #define DEF_SMART_GW_ALWAYS_REMOVE_SERVER_TUNNEL  false
 #define DEF_GW_USE_COUNT     1
@@ -278,6 +285,11 @@ struct olsrd_config {
   float pollrate;
   float nic_chgs_pollrate;
   bool clear_screen;
+  bool spf_thread;
+  bool rx_thread;
+  int fwd_rate_limit;
+  int input_sender_budget;
+  int input_orig_budget;
   uint8_t tc_redundancy;
   uint8_t mpr_coverage;
   uint8_t lq_level;
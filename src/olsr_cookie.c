@@ -323,6 +323,35 @@ olsr_cookie_free(struct olsr_cookie_info *ci, void *ptr)
 
 }
 
+/*
+ * Return the memory a block of a memory cookie takes,
+ * including the brand.
+ */
+size_t
+olsr_cookie_block_size(const struct olsr_cookie_info *ci)
+{
+  if (ci->ci_type != OLSR_COOKIE_TYPE_MEMORY) {
+    return 0;
+  }
+  return ci->ci_size + sizeof(struct olsr_cookie_mem_brand);
+}
+
+/*
+ * Call a function for every cookie in the system,
+ * used for exporting the resource usage.
+ */
+void
+olsr_cookie_walk(olsr_cookie_walker walker, void *ctx)
+{
+  int ci_index;
+
+  for (ci_index = 1; ci_index < COOKIE_ID_MAX; ci_index++) {
+    if (cookies[ci_index]) {
+      walker(ctx, cookies[ci_index]);
+    }
+  }
+}
+
 /*
  * Local Variables:
  * c-basic-offset: 2
@@ -80,6 +80,9 @@ struct olsr_cookie_mem_brand {
   olsr_cookie_t cmb_id;
 };
 
+/* Callback of olsr_cookie_walk() */
+typedef void (*olsr_cookie_walker) (void *, const struct olsr_cookie_info *);
+
 /* Externals. */
 extern struct olsr_cookie_info *olsr_alloc_cookie(const char *, olsr_cookie_type);
 extern void olsr_free_cookie(struct olsr_cookie_info *);
@@ -91,6 +94,8 @@ extern void olsr_cookie_usage_decr(olsr_cookie_t);
 
 extern void *olsr_cookie_malloc(struct olsr_cookie_info *);
 extern void olsr_cookie_free(struct olsr_cookie_info *, void *);
+extern size_t olsr_cookie_block_size(const struct olsr_cookie_info *);
+extern void olsr_cookie_walk(olsr_cookie_walker, void *);
 
 #endif /* _OLSR_COOKIE_H */
 
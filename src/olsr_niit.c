@@ -90,14 +90,15 @@ static void refresh_niit4to6_routes(bool set) {
     return;
   }
 
-  OLSR_FOR_ALL_RT_ENTRIES(rt) {
+  /* only the routes inside the mapped ipv4 range */
+  OLSR_FOR_ALL_RT_ENTRIES_COVERED(&ipv6_mappedv4_route, rt) {
     if (is_prefix_niit_ipv6(&rt->rt_dst)) {
       struct olsr_ip_prefix dst_v4;
 
       prefix_mappedv4_to_v4(&dst_v4, &rt->rt_dst);
       olsr_os_niit_4to6_route(&dst_v4, set);
     }
-  } OLSR_FOR_ALL_RT_ENTRIES_END(rt)
+  } OLSR_FOR_ALL_RT_ENTRIES_COVERED_END(rt)
 }
 
 static void handle_niit_ifchange (int if_index, struct interface *iface __attribute__ ((unused)),
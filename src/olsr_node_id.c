@@ -0,0 +1,170 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Interned node addresses, kept in a hash over the addresses.
+ */
+
+#include "olsr_node_id.h"
+#include "olsr.h"
+#include "ipcalc.h"
+#include "olsr_cookie.h"
+
+#include <assert.h>
+
+/* large enough to keep the chains short in a mesh of some thousand nodes */
+#define OLSR_NODE_ID_HASHSIZE 1024
+#define OLSR_NODE_ID_HASHMASK (OLSR_NODE_ID_HASHSIZE - 1)
+
+static struct olsr_node_id *node_id_hash[OLSR_NODE_ID_HASHSIZE];
+
+static uint32_t node_id_used;
+
+static struct olsr_cookie_info *node_id_mem_cookie = NULL;
+
+/**
+ * @return the hash bucket of an address
+ */
+static uint32_t
+olsr_node_id_hash(const union olsr_ip_addr *addr)
+{
+  const uint8_t *p = (const uint8_t *)addr;
+  uint32_t hash = 0;
+  unsigned int i;
+
+  for (i = 0; i < olsr_cnf->ipsize; i++) {
+    hash = hash * 31 + p[i];
+  }
+  return (hash ^ (hash >> 10)) & OLSR_NODE_ID_HASHMASK;
+}
+
+void
+olsr_init_node_ids(void)
+{
+  node_id_mem_cookie = olsr_alloc_cookie("node_id", OLSR_COOKIE_TYPE_MEMORY);
+  olsr_cookie_set_memory_size(node_id_mem_cookie, sizeof(struct olsr_node_id));
+}
+
+/**
+ * @param addr the address
+ * @return the interned node of the address, NULL if there is none
+ */
+struct olsr_node_id *
+olsr_lookup_node_id(const union olsr_ip_addr *addr)
+{
+  struct olsr_node_id *node;
+
+  for (node = node_id_hash[olsr_node_id_hash(addr)]; node != NULL; node = node->next) {
+    if (ipequal(&node->addr, addr)) {
+      return node;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Intern an address and take a reference on it.
+ *
+ * @param addr the address
+ * @return the interned node, release it with olsr_put_node_id()
+ */
+struct olsr_node_id *
+olsr_get_node_id(const union olsr_ip_addr *addr)
+{
+  struct olsr_node_id *node;
+  uint32_t hash;
+
+  node = olsr_lookup_node_id(addr);
+  if (node) {
+    node->refcount++;
+    return node;
+  }
+
+  node = olsr_cookie_malloc(node_id_mem_cookie);
+  node->addr = *addr;
+  node->refcount = 1;
+  node_id_used++;
+
+  hash = olsr_node_id_hash(addr);
+  node->next = node_id_hash[hash];
+  node_id_hash[hash] = node;
+
+  return node;
+}
+
+/**
+ * Drop a reference, free the node with the last one.
+ *
+ * @param node the interned node
+ */
+void
+olsr_put_node_id(struct olsr_node_id *node)
+{
+  struct olsr_node_id **prev;
+
+  assert(node->refcount);
+  if (--node->refcount) {
+    return;
+  }
+
+  for (prev = &node_id_hash[olsr_node_id_hash(&node->addr)]; *prev != node; prev = &(*prev)->next);
+  *prev = node->next;
+
+  node_id_used--;
+
+  olsr_cookie_free(node_id_mem_cookie, node);
+}
+
+/**
+ * @return the number of interned nodes
+ */
+uint32_t
+olsr_node_id_count(void)
+{
+  return node_id_used;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
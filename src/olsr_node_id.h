@@ -0,0 +1,84 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _OLSR_NODE_ID_H
+#define _OLSR_NODE_ID_H
+
+#include <stddef.h>
+
+#include "olsr_types.h"
+#include "defs.h"
+
+/*
+ * An interned node address. Every address which is referenced by many
+ * records (like the destination of the edges in the link state
+ * database) is stored only once and shared by reference.
+ */
+struct olsr_node_id {
+  struct olsr_node_id *next;           /* hash chain */
+  union olsr_ip_addr addr;             /* the shared address */
+  uint32_t refcount;                   /* reference counter */
+};
+
+/**
+ * @param addr an address returned by olsr_get_node_id()->addr
+ * @return the interned node which holds the address
+ */
+static INLINE struct olsr_node_id *
+addr2node_id(union olsr_ip_addr *addr)
+{
+  return (struct olsr_node_id *)(void *)((char *)addr - offsetof(struct olsr_node_id, addr));
+}
+
+void olsr_init_node_ids(void);
+struct olsr_node_id *olsr_lookup_node_id(const union olsr_ip_addr *);
+struct olsr_node_id *olsr_get_node_id(const union olsr_ip_addr *);
+void olsr_put_node_id(struct olsr_node_id *);
+uint32_t olsr_node_id_count(void);
+
+#endif /* _OLSR_NODE_ID_H */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,229 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#include "olsr_profile.h"
+#include "olsr.h"
+#include "defs.h"
+#include "olsr_protocol.h"
+#include "lq_packet.h"
+#include "scheduler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+struct olsr_histogram olsr_prof[OLSR_PROF_POINTS];
+
+static const char *const olsr_prof_names[OLSR_PROF_POINTS] = {
+  "tick_lag",
+  "tick",
+  "spf",
+  "spf_run",
+  "kernel_routes",
+  "netlink",
+  "rx_queue"
+};
+
+/* allocated when the first sample comes in */
+static struct olsr_histogram *timer_hist[COOKIE_ID_MAX];
+static struct olsr_histogram *message_hist[256];
+
+/**
+ * @param idx index of a bucket
+ * @return the first sample value which is beyond the bucket
+ */
+uint64_t
+olsr_hist_bucket_limit(unsigned int idx)
+{
+  unsigned int exp, sub;
+
+  if (idx < (1 << OLSR_HIST_SUB_BITS)) {
+    return idx + 1;
+  }
+  exp = (idx >> OLSR_HIST_SUB_BITS) + OLSR_HIST_SUB_BITS - 1;
+  sub = idx & ((1 << OLSR_HIST_SUB_BITS) - 1);
+  return (uint64_t)((1 << OLSR_HIST_SUB_BITS) + sub + 1) << (exp - OLSR_HIST_SUB_BITS);
+}
+
+/**
+ * Estimate a percentile from the buckets. The result is
+ * the upper end of the bucket holding the percentile, but
+ * never more than the largest sample.
+ *
+ * @param hist the histogram
+ * @param permille the percentile in 1/1000
+ * @return the estimate in nanoseconds
+ */
+uint64_t
+olsr_hist_percentile(const struct olsr_histogram *hist, unsigned int permille)
+{
+  uint64_t rank, seen = 0;
+  unsigned int i;
+
+  if (hist->count == 0) {
+    return 0;
+  }
+
+  rank = (hist->count * permille + 999) / 1000;
+  if (rank == 0) {
+    rank = 1;
+  }
+  for (i = 0; i < OLSR_HIST_BUCKETS; i++) {
+    seen += hist->bucket[i];
+    if (seen >= rank) {
+      uint64_t limit = olsr_hist_bucket_limit(i);
+
+      return limit < hist->max ? limit : hist->max;
+    }
+  }
+  return hist->max;
+}
+
+static struct olsr_histogram *
+olsr_prof_slot(struct olsr_histogram **slot)
+{
+  if (*slot == NULL) {
+    *slot = olsr_malloc(sizeof(**slot), "Profile histogram");
+  }
+  return *slot;
+}
+
+/**
+ * Record the run time of a timer callback.
+ *
+ * @param ci the cookie of the timer
+ * @param ns the run time
+ */
+void
+olsr_prof_timer(const struct olsr_cookie_info *ci, uint64_t ns)
+{
+  if (ci->ci_id >= COOKIE_ID_MAX) {
+    return;
+  }
+  olsr_hist_record(olsr_prof_slot(&timer_hist[ci->ci_id]), ns);
+}
+
+/**
+ * Record the time all parsers took for a message.
+ *
+ * @param type the message type
+ * @param ns the parse time
+ */
+void
+olsr_prof_message(uint8_t type, uint64_t ns)
+{
+  olsr_hist_record(olsr_prof_slot(&message_hist[type]), ns);
+}
+
+static const char *
+olsr_prof_message_name(uint8_t type, char *buf, size_t len)
+{
+  switch (type) {
+  case HELLO_MESSAGE:
+    return "HELLO";
+  case TC_MESSAGE:
+    return "TC";
+  case MID_MESSAGE:
+    return "MID";
+  case HNA_MESSAGE:
+    return "HNA";
+  case LQ_HELLO_MESSAGE:
+    return "LQ_HELLO";
+  case LQ_TC_MESSAGE:
+    return "LQ_TC";
+  default:
+    snprintf(buf, len, "%u", type);
+    return buf;
+  }
+}
+
+/**
+ * Call a function for every histogram which has samples.
+ * This is the interface for the info plugins.
+ *
+ * @param cb the callback
+ * @param ctx passed to the callback
+ */
+void
+olsr_prof_walk(olsr_prof_walk_cb cb, void *ctx)
+{
+  char buf[8];
+  unsigned int i;
+
+  for (i = 0; i < OLSR_PROF_POINTS; i++) {
+    cb(ctx, OLSR_PROF_GROUP_CORE, olsr_prof_names[i], &olsr_prof[i]);
+  }
+  for (i = 0; i < COOKIE_ID_MAX; i++) {
+    if (timer_hist[i]) {
+      cb(ctx, OLSR_PROF_GROUP_TIMER, olsr_cookie_name(i), timer_hist[i]);
+    }
+  }
+  for (i = 0; i < 256; i++) {
+    if (message_hist[i]) {
+      cb(ctx, OLSR_PROF_GROUP_MESSAGE, olsr_prof_message_name(i, buf, sizeof(buf)), message_hist[i]);
+    }
+  }
+  olsr_walk_socket_profiles(cb, ctx);
+}
+
+/**
+ * Free the histograms at shutdown.
+ */
+void
+olsr_prof_cleanup(void)
+{
+  unsigned int i;
+
+  for (i = 0; i < COOKIE_ID_MAX; i++) {
+    free(timer_hist[i]);
+    timer_hist[i] = NULL;
+  }
+  for (i = 0; i < 256; i++) {
+    free(message_hist[i]);
+    message_hist[i] = NULL;
+  }
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
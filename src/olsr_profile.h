@@ -0,0 +1,166 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _OLSR_PROFILE_H
+#define _OLSR_PROFILE_H
+
+#include "olsr_types.h"
+#include "olsr_cookie.h"
+
+#include <time.h>
+#include <sys/time.h>
+
+/*
+ * Latency histograms which are cheap enough to be always on.
+ *
+ * Samples are nanoseconds. The buckets are log-linear: every power
+ * of two is split into four linear buckets, so a bucket is never wider
+ * than a quarter of its value. Recording is a clock read, a count
+ * leading zeros and three additions.
+ */
+#define OLSR_HIST_SUB_BITS 2
+#define OLSR_HIST_MAX_EXP  38         /* 2^39 ns, about 9 minutes */
+#define OLSR_HIST_BUCKETS  ((OLSR_HIST_MAX_EXP) << OLSR_HIST_SUB_BITS)
+
+struct olsr_histogram {
+  uint64_t count;
+  uint64_t sum;                        /* ns */
+  uint64_t max;                        /* ns */
+  uint32_t bucket[OLSR_HIST_BUCKETS];
+};
+
+/* the fixed measurement points of the core */
+enum olsr_prof_point {
+  OLSR_PROF_TICK_LAG,                  /* how late the scheduler started a tick */
+  OLSR_PROF_TICK,                      /* sockets, timers and changes of a tick */
+  OLSR_PROF_SPF,                       /* route calculation, from the start to updated routes */
+  OLSR_PROF_SPF_RUN,                   /* the dijkstra run alone */
+  OLSR_PROF_KERNEL,                    /* moving the route changes into the kernel */
+  OLSR_PROF_NETLINK,                   /* a netlink request until its ack */
+  OLSR_PROF_RX_QUEUE,                  /* packets waiting in the queues of the receive thread */
+  OLSR_PROF_POINTS
+};
+
+/* the group of a histogram, passed to olsr_prof_walk() callbacks */
+enum olsr_prof_group {
+  OLSR_PROF_GROUP_CORE,
+  OLSR_PROF_GROUP_TIMER,
+  OLSR_PROF_GROUP_MESSAGE,
+  OLSR_PROF_GROUP_SOCKET
+};
+
+typedef void (*olsr_prof_walk_cb) (void *ctx, enum olsr_prof_group group, const char *name, const struct olsr_histogram *);
+
+extern struct olsr_histogram olsr_prof[OLSR_PROF_POINTS];
+
+/**
+ * @return a monotonic timestamp in nanoseconds
+ */
+static inline uint64_t
+olsr_prof_clock(void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#else /* CLOCK_MONOTONIC */
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (uint64_t)tv.tv_sec * 1000000000 + (uint64_t)tv.tv_usec * 1000;
+#endif /* CLOCK_MONOTONIC */
+}
+
+/**
+ * @param ns a sample
+ * @return the index of the bucket the sample falls into
+ */
+static inline unsigned int
+olsr_hist_bucket(uint64_t ns)
+{
+  unsigned int exp;
+
+  if (ns < (1 << OLSR_HIST_SUB_BITS)) {
+    return (unsigned int)ns;
+  }
+  exp = 63 - (unsigned int)__builtin_clzll(ns);
+  if (exp > OLSR_HIST_MAX_EXP) {
+    return OLSR_HIST_BUCKETS - 1;
+  }
+  return ((exp - OLSR_HIST_SUB_BITS + 1) << OLSR_HIST_SUB_BITS)
+    + (unsigned int)((ns >> (exp - OLSR_HIST_SUB_BITS)) & ((1 << OLSR_HIST_SUB_BITS) - 1));
+}
+
+/**
+ * Add a sample to a histogram.
+ *
+ * @param hist the histogram
+ * @param ns the sample in nanoseconds
+ */
+static inline void
+olsr_hist_record(struct olsr_histogram *hist, uint64_t ns)
+{
+  hist->count++;
+  hist->sum += ns;
+  if (ns > hist->max) {
+    hist->max = ns;
+  }
+  hist->bucket[olsr_hist_bucket(ns)]++;
+}
+
+uint64_t olsr_hist_bucket_limit(unsigned int);
+uint64_t olsr_hist_percentile(const struct olsr_histogram *, unsigned int);
+
+void olsr_prof_timer(const struct olsr_cookie_info *, uint64_t);
+void olsr_prof_message(uint8_t, uint64_t);
+
+void olsr_prof_walk(olsr_prof_walk_cb, void *);
+void olsr_prof_cleanup(void);
+
+#endif /* _OLSR_PROFILE_H */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,514 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2004, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Receiving OLSR packets in a separate thread.
+ *
+ * Normally the interface sockets are read by the scheduler, so a long
+ * SPF run or slow route updates leave packets in the socket buffers,
+ * where they get dropped if the load keeps up. With RxThread enabled a
+ * thread reads the sockets as soon as packets arrive, stamps them and
+ * queues them in two single producer / single consumer rings: one for
+ * packets carrying a HELLO and one for everything else. The scheduler
+ * empties the HELLO ring first, so link sensing does not suffer when a
+ * flood of TCs is forwarded.
+ */
+
+#include "olsr_rx.h"
+#include "defs.h"
+#include "olsr.h"
+#include "parser.h"
+#include "scheduler.h"
+#include "olsr_profile.h"
+#include "lq_packet.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define RX_RING_HELLO 64               /* slots of the HELLO ring */
+#define RX_RING_OTHER 256              /* slots of the ring for all other packets */
+#define RX_BURST      32               /* packets read from a socket in one go */
+
+struct rx_slot {
+  int fd;
+  int len;
+  socklen_t fromlen;
+  uint64_t stamp;
+  struct sockaddr_storage from;
+  uint32_t data[MAXMESSAGESIZE / sizeof(uint32_t) + 1];
+};
+
+struct rx_ring {
+  struct rx_slot *slot;
+  uint32_t mask;
+  volatile uint32_t head;              /* written by the receive thread only */
+  volatile uint32_t tail;              /* written by the main thread only */
+  volatile uint32_t drops;             /* written by the receive thread only */
+};
+
+static struct rx_ring rx_hello, rx_other;
+static uint32_t rx_drops_reported;
+
+static pthread_t rx_thread;
+static pthread_mutex_t rx_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rx_cond = PTHREAD_COND_INITIALIZER;
+static int *rx_fds;                    /* protected by rx_mutex */
+static unsigned int rx_fd_count, rx_fd_size;   /* protected by rx_mutex */
+static uint32_t rx_generation, rx_seen_generation;     /* protected by rx_mutex */
+static bool rx_thread_stop;            /* protected by rx_mutex */
+static bool rx_thread_running;
+
+static int rx_wake_pipe[2] = { -1, -1 };       /* main thread -> receive thread */
+static int rx_notify_pipe[2] = { -1, -1 };     /* receive thread -> main thread */
+
+/**
+ * @return true if one of the messages in the packet is a HELLO
+ */
+static bool
+rx_has_hello(const uint8_t *packet, int len)
+{
+  int off = 4;                         /* packet header */
+
+  while (off + 4 <= len) {
+    uint16_t size = (uint16_t)(packet[off + 2] << 8 | packet[off + 3]);
+
+    if (packet[off] == HELLO_MESSAGE || packet[off] == LQ_HELLO_MESSAGE) {
+      return true;
+    }
+    if (size < 4) {
+      break;
+    }
+    off += size;
+  }
+  return false;
+}
+
+static void
+rx_ring_init(struct rx_ring *ring, uint32_t size)
+{
+  ring->slot = olsr_malloc(sizeof(*ring->slot) * size, "RX ring");
+  ring->mask = size - 1;
+  ring->head = 0;
+  ring->tail = 0;
+  ring->drops = 0;
+}
+
+/* receive thread side */
+static void
+rx_ring_push(struct rx_ring *ring, int fd, const void *data, int len, const struct sockaddr_storage *from, socklen_t fromlen,
+             uint64_t stamp)
+{
+  struct rx_slot *slot;
+  uint32_t head = ring->head;
+
+  if (head - ring->tail > ring->mask) {
+    ring->drops++;
+    return;
+  }
+
+  slot = &ring->slot[head & ring->mask];
+  slot->fd = fd;
+  slot->len = len;
+  slot->fromlen = fromlen;
+  slot->stamp = stamp;
+  memcpy(&slot->from, from, fromlen);
+  memcpy(slot->data, data, len);
+
+  /* the slot must be complete before the main thread can see it */
+  __sync_synchronize();
+  ring->head = head + 1;
+}
+
+/**
+ * Read what is waiting on a socket and queue it.
+ *
+ * @return true if packets were queued
+ */
+static bool
+rx_read_socket(int fd)
+{
+  uint32_t buf[MAXMESSAGESIZE / sizeof(uint32_t) + 1];
+  bool queued = false;
+  int i;
+
+  for (i = 0; i < RX_BURST; i++) {
+    struct sockaddr_storage from;
+    socklen_t fromlen = sizeof(from);
+    int cc = recvfrom(fd, buf, sizeof(buf), MSG_DONTWAIT, (struct sockaddr *)&from, &fromlen);
+
+    if (cc <= 0) {
+      break;
+    }
+    rx_ring_push(rx_has_hello((const uint8_t *)buf, cc) ? &rx_hello : &rx_other, fd, buf, cc, &from, fromlen, olsr_prof_clock());
+    queued = true;
+  }
+  return queued;
+}
+
+static void *
+rx_thread_main(void *context __attribute__ ((unused)))
+{
+  sigset_t blocked;
+  struct pollfd *pfds = NULL;
+  unsigned int count = 0, size = 0, i;
+
+  /* signals are handled by the main thread */
+  sigfillset(&blocked);
+  pthread_sigmask(SIG_BLOCK, &blocked, NULL);
+
+  for (;;) {
+    bool queued = false;
+
+    pthread_mutex_lock(&rx_mutex);
+    if (rx_thread_stop) {
+      pthread_mutex_unlock(&rx_mutex);
+      break;
+    }
+    if (!pfds || rx_seen_generation != rx_generation) {
+      /* first round or the set of sockets has changed */
+      if (size < rx_fd_count + 1) {
+        size = rx_fd_size + 1;
+        pfds = realloc(pfds, sizeof(*pfds) * size);
+        if (!pfds) {
+          /* a thread cannot bail out with olsr_exit() */
+          abort();
+        }
+      }
+      pfds[0].fd = rx_wake_pipe[0];
+      pfds[0].events = POLLIN;
+      for (i = 0; i < rx_fd_count; i++) {
+        pfds[i + 1].fd = rx_fds[i];
+        pfds[i + 1].events = POLLIN;
+      }
+      count = rx_fd_count + 1;
+      rx_seen_generation = rx_generation;
+      pthread_cond_broadcast(&rx_cond);
+    }
+    pthread_mutex_unlock(&rx_mutex);
+
+    if (poll(pfds, count, -1) < 0) {
+      continue;
+    }
+
+    if (pfds[0].revents) {
+      char tmp[16];
+
+      while (read(rx_wake_pipe[0], tmp, sizeof(tmp)) > 0);
+      continue;
+    }
+
+    for (i = 1; i < count; i++) {
+      if (pfds[i].revents & POLLIN) {
+        queued |= rx_read_socket(pfds[i].fd);
+      }
+    }
+
+    /* one wake up for the whole batch, a full pipe is fine */
+    if (queued) {
+      char c = 0;
+
+      if (write(rx_notify_pipe[1], &c, 1) < 0) {
+        continue;
+      }
+    }
+  }
+  free(pfds);
+  return NULL;
+}
+
+/**
+ * Handle the oldest packet of a ring.
+ *
+ * @return false if the ring was empty
+ */
+static bool
+rx_ring_pop(struct rx_ring *ring)
+{
+  struct rx_slot *slot;
+  uint32_t tail = ring->tail;
+
+  if (tail == ring->head) {
+    return false;
+  }
+  /* pairs with the barrier in rx_ring_push() */
+  __sync_synchronize();
+
+  slot = &ring->slot[tail & ring->mask];
+  olsr_hist_record(&olsr_prof[OLSR_PROF_RX_QUEUE], olsr_prof_clock() - slot->stamp);
+
+  /* packets of sockets removed in the meantime are dropped silently */
+  if (if_ifwithsock(slot->fd)) {
+    olsr_input_packet(slot->fd, (char *)slot->data, slot->len, &slot->from, slot->fromlen);
+  }
+
+  /* the slot may be reused only after we are done with it */
+  __sync_synchronize();
+  ring->tail = tail + 1;
+  return true;
+}
+
+/**
+ * Socket handler for the notification pipe of the receive thread.
+ */
+static void
+rx_drain(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+  char tmp[64];
+  uint64_t start = olsr_prof_clock();
+  uint32_t drops;
+
+  while (read(fd, tmp, sizeof(tmp)) > 0);
+
+  /* all HELLOs before every other packet */
+  while (rx_ring_pop(&rx_hello) || rx_ring_pop(&rx_other)) {
+    if (olsr_prof_clock() - start > OLSR_INPUT_TIME_BUDGET) {
+      char c = 0;
+
+      /* leave the rest to the next round */
+      OLSR_PRINTF(1, "CPU overload detected, ending rx_drain() loop\n");
+      if (write(rx_notify_pipe[1], &c, 1) < 0) {
+        /* a full pipe wakes us up as well */
+      }
+      break;
+    }
+  }
+
+  drops = rx_hello.drops + rx_other.drops;
+  if (drops != rx_drops_reported) {
+    OLSR_PRINTF(1, "RX: receive queues full, %u packets dropped so far\n", drops);
+    rx_drops_reported = drops;
+  }
+}
+
+static bool
+rx_set_nonblocking(int fd)
+{
+  int flags = fcntl(fd, F_GETFL);
+
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) >= 0;
+}
+
+/*
+ * olsr_rx_init_thread
+ *
+ * Start the receive thread. Returns false if this is not possible,
+ * so the caller should fall back to reading in the scheduler.
+ */
+static bool
+olsr_rx_init_thread(void)
+{
+  if (pipe(rx_wake_pipe) < 0) {
+    OLSR_PRINTF(1, "RX: cannot create pipe (%s), falling back to the scheduler\n", strerror(errno));
+    olsr_cnf->rx_thread = false;
+    return false;
+  }
+  if (pipe(rx_notify_pipe) < 0) {
+    OLSR_PRINTF(1, "RX: cannot create pipe (%s), falling back to the scheduler\n", strerror(errno));
+    close(rx_wake_pipe[0]);
+    close(rx_wake_pipe[1]);
+    olsr_cnf->rx_thread = false;
+    return false;
+  }
+  rx_set_nonblocking(rx_wake_pipe[0]);
+  rx_set_nonblocking(rx_wake_pipe[1]);
+  rx_set_nonblocking(rx_notify_pipe[0]);
+  rx_set_nonblocking(rx_notify_pipe[1]);
+
+  rx_ring_init(&rx_hello, RX_RING_HELLO);
+  rx_ring_init(&rx_other, RX_RING_OTHER);
+
+  if (pthread_create(&rx_thread, NULL, &rx_thread_main, NULL) != 0) {
+    OLSR_PRINTF(1, "RX: cannot create thread, falling back to the scheduler\n");
+    close(rx_wake_pipe[0]);
+    close(rx_wake_pipe[1]);
+    close(rx_notify_pipe[0]);
+    close(rx_notify_pipe[1]);
+    free(rx_hello.slot);
+    free(rx_other.slot);
+    olsr_cnf->rx_thread = false;
+    return false;
+  }
+
+  add_olsr_socket(rx_notify_pipe[0], &rx_drain, NULL, NULL, SP_PR_READ);
+  rx_thread_running = true;
+  return true;
+}
+
+static void
+rx_wake_thread(void)
+{
+  char c = 0;
+
+  if (write(rx_wake_pipe[1], &c, 1) < 0) {
+    /* the pipe is full, so the thread wakes up anyway */
+  }
+}
+
+/**
+ * Register an interface socket for receiving OLSR packets,
+ * either with the receive thread or with the scheduler.
+ *
+ * @param fd the socket
+ */
+void
+olsr_rx_add_socket(int fd)
+{
+  if (!olsr_cnf->rx_thread || (!rx_thread_running && !olsr_rx_init_thread())) {
+    add_olsr_socket(fd, &olsr_input, NULL, NULL, SP_PR_READ);
+    return;
+  }
+
+  pthread_mutex_lock(&rx_mutex);
+  if (rx_fd_count == rx_fd_size) {
+    int *fds = realloc(rx_fds, sizeof(*rx_fds) * (rx_fd_size ? 2 * rx_fd_size : 8));
+
+    if (!fds) {
+      olsr_exit("RX sockets: out of memory", EXIT_FAILURE);
+    }
+    rx_fds = fds;
+    rx_fd_size = rx_fd_size ? 2 * rx_fd_size : 8;
+  }
+  rx_fds[rx_fd_count++] = fd;
+  rx_generation++;
+  pthread_mutex_unlock(&rx_mutex);
+
+  rx_wake_thread();
+}
+
+/**
+ * Unregister an interface socket. When this returns,
+ * the receive thread does not touch the socket anymore,
+ * so it can be closed.
+ *
+ * @param fd the socket
+ */
+void
+olsr_rx_remove_socket(int fd)
+{
+  unsigned int i;
+
+  if (!rx_thread_running) {
+    remove_olsr_socket(fd, &olsr_input, NULL);
+    return;
+  }
+
+  pthread_mutex_lock(&rx_mutex);
+  for (i = 0; i < rx_fd_count; i++) {
+    if (rx_fds[i] == fd) {
+      rx_fds[i] = rx_fds[--rx_fd_count];
+      break;
+    }
+  }
+  rx_generation++;
+  rx_wake_thread();
+  while (rx_seen_generation != rx_generation) {
+    pthread_cond_wait(&rx_cond, &rx_mutex);
+  }
+  pthread_mutex_unlock(&rx_mutex);
+}
+
+/**
+ * Stop the receive thread, queued packets are discarded.
+ */
+void
+olsr_shutdown_rx(void)
+{
+  if (!rx_thread_running) {
+    return;
+  }
+
+  pthread_mutex_lock(&rx_mutex);
+  rx_thread_stop = true;
+  pthread_mutex_unlock(&rx_mutex);
+  rx_wake_thread();
+  pthread_join(rx_thread, NULL);
+
+  remove_olsr_socket(rx_notify_pipe[0], &rx_drain, NULL);
+  close(rx_wake_pipe[0]);
+  close(rx_wake_pipe[1]);
+  close(rx_notify_pipe[0]);
+  close(rx_notify_pipe[1]);
+  free(rx_hello.slot);
+  free(rx_other.slot);
+  free(rx_fds);
+  rx_fds = NULL;
+  rx_fd_count = rx_fd_size = 0;
+  rx_thread_running = false;
+}
+
+#else /* __linux__ */
+
+/*
+ * The receive thread relies on a thread safe recvfrom(), which
+ * olsr_recvfrom() is not on BSD, and on pthreads. Elsewhere the
+ * scheduler reads the sockets as usual.
+ */
+void
+olsr_rx_add_socket(int fd)
+{
+  add_olsr_socket(fd, &olsr_input, NULL, NULL, SP_PR_READ);
+}
+
+void
+olsr_rx_remove_socket(int fd)
+{
+  remove_olsr_socket(fd, &olsr_input, NULL);
+}
+
+void
+olsr_shutdown_rx(void)
+{
+}
+
+#endif /* __linux__ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -67,6 +67,17 @@
 #include "net_olsr.h"
 #include "lq_plugin.h"
 #include "gateway.h"
+#include "scheduler.h"
+#include "olsr_profile.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#endif /* _WIN32 */
 
 struct timer_entry *spf_backoff_timer = NULL;
 
@@ -208,7 +219,7 @@ olsr_spf_relax(struct avl_tree *cand_tree, struct tc_entry *tc)
      */
     if (!tc_edge->edge_inv) {
 #ifdef DEBUG
-      OLSR_PRINTF(2, "SPF:   ignoring edge %s\n", olsr_ip_to_string(&buf, &tc_edge->T_dest_addr));
+      OLSR_PRINTF(2, "SPF:   ignoring edge %s\n", olsr_ip_to_string(&buf, tc_edge_dest_addr(tc_edge)));
       if (!tc_edge->edge_inv) {
         OLSR_PRINTF(2, "SPF:     no inverse edge\n");
       }
@@ -218,7 +229,7 @@ olsr_spf_relax(struct avl_tree *cand_tree, struct tc_entry *tc)
 
     if (tc_edge->cost == LINK_COST_BROKEN) {
 #ifdef DEBUG
-      OLSR_PRINTF(2, "SPF:   ignore edge %s (broken)\n", olsr_ip_to_string(&buf, &tc_edge->T_dest_addr));
+      OLSR_PRINTF(2, "SPF:   ignore edge %s (broken)\n", olsr_ip_to_string(&buf, tc_edge_dest_addr(tc_edge)));
 #endif /* DEBUG */
       continue;
     }
@@ -229,7 +240,7 @@ olsr_spf_relax(struct avl_tree *cand_tree, struct tc_entry *tc)
     new_cost = tc->path_cost + tc_edge->cost;
 
 #ifdef DEBUG
-    OLSR_PRINTF(2, "SPF:   exploring edge %s, cost %s\n", olsr_ip_to_string(&buf, &tc_edge->T_dest_addr),
+    OLSR_PRINTF(2, "SPF:   exploring edge %s, cost %s\n", olsr_ip_to_string(&buf, tc_edge_dest_addr(tc_edge)),
                 get_linkcost_text(new_cost, true, &lqbuffer));
 #endif /* DEBUG */
 
@@ -308,52 +319,66 @@ olsr_expire_spf_backoff(void *context __attribute__ ((unused)))
   spf_backoff_timer = NULL;
 }
 
-void
-olsr_calculate_routing_table(bool force)
+/*
+ * olsr_spf_reset_vertices
+ *
+ * Reset the SPF results of all vertices in the lsdb.
+ */
+static void
+olsr_spf_reset_vertices(void)
 {
-#ifdef SPF_PROFILING
-  struct timeval t1, t2, t3, t4, t5, spf_init, spf_run, route, kernel, total;
-#endif /* SPF_PROFILING */
-  struct avl_tree cand_tree;
-  struct avl_node *rtp_tree_node;
-  struct list_node path_list;          /* head of the path_list */
   struct tc_entry *tc;
-  struct rt_path *rtp;
-  struct tc_edge_entry *tc_edge;
-  struct neighbor_entry *neigh;
-  struct link_entry *link;
-  int path_count = 0;
-
-  /* We are done if our backoff timer is running */
-  if (!force) {
-    if (spf_backoff_timer) {
-      return;
-    }
 
-    /* start new backoff timer */
-    spf_backoff_timer = olsr_start_timer(1000, 5, OLSR_TIMER_ONESHOT, &olsr_expire_spf_backoff, NULL, 0);
-  }
-
-#ifdef SPF_PROFILING
-  gettimeofday(&t1, NULL);
-#endif /* SPF_PROFILING */
-
-  /*
-   * Prepare the candidate tree and result list.
-   */
-  avl_init(&cand_tree, avl_comp_etx);
-  list_head_init(&path_list);
-  olsr_bump_routingtree_version();
-
-  /*
-   * Initialize vertices in the lsdb.
-   */
   OLSR_FOR_ALL_TC_ENTRIES(tc) {
     tc->next_hop = NULL;
     tc->path_cost = ROUTE_COST_BROKEN;
     tc->hops = 0;
   }
   OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+}
+
+/*
+ * olsr_spf_first_hop_link
+ *
+ * Return the link to the neighbour at the end of one of our
+ * own edges, or NULL if it is no usable first hop.
+ */
+static struct link_entry *
+olsr_spf_first_hop_link(struct tc_edge_entry *tc_edge)
+{
+  struct neighbor_entry *neigh;
+  struct link_entry *link;
+
+  if (!tc_edge->edge_inv) {
+    return NULL;
+  }
+
+  neigh = olsr_lookup_neighbor_table(tc_edge_dest_addr(tc_edge));
+  if (!neigh || neigh->status != SYM) {
+    return NULL;
+  }
+
+  link = get_best_link_to_neighbor(&neigh->neighbor_main_addr);
+  if (!link || lookup_link_status(link) == LOST_LINK) {
+    return NULL;
+  }
+  return link;
+}
+
+/*
+ * olsr_spf_sync_neighbors
+ *
+ * Synchronize the edges to and from our neighbours with the
+ * link set. The SPF results of the vertices are not touched.
+ *
+ * returns false if there is no main IP address.
+ */
+static bool
+olsr_spf_sync_neighbors(void)
+{
+  struct tc_edge_entry *tc_edge;
+  struct neighbor_entry *neigh;
+  struct link_entry *link;
 
   /*
    * Check if there was a change in the main IP address.
@@ -361,21 +386,9 @@ olsr_calculate_routing_table(bool force)
    */
   olsr_change_myself_tc();
   if (!tc_myself) {
-
-    /*
-     * All gone now. Flush all routes.
-     */
-    olsr_update_rib_routes();
-    olsr_update_kernel_routes();
-    return;
+    return false;
   }
 
-  /*
-   * zero ourselves and add us to the candidate tree.
-   */
-  tc_myself->path_cost = ZERO_ROUTE_COST;
-  olsr_spf_add_cand_tree(&cand_tree, tc_myself);
-
   /*
    * add edges to and from our neighbours.
    */
@@ -422,16 +435,626 @@ olsr_calculate_routing_table(bool force)
         olsr_copylq_link_entry_2_tc_edge_entry(tc_edge, link);
         olsr_calc_tc_edge_entry_etx(tc_edge);
       }
-      if (tc_edge->edge_inv) {
-        tc_edge->edge_inv->tc->next_hop = link;
-      }
     }
   }
   OLSR_FOR_ALL_NBR_ENTRIES_END(neigh);
 
-#ifdef SPF_PROFILING
-  gettimeofday(&t2, NULL);
-#endif /* SPF_PROFILING */
+  return true;
+}
+
+/*
+ * olsr_spf_init_vertices
+ *
+ * Reset all vertices in the lsdb, synchronize the edges
+ * to and from our neighbours with the link set and set
+ * the next-hops of our neighbours.
+ *
+ * returns false if there is no main IP address.
+ */
+static bool
+olsr_spf_init_vertices(void)
+{
+  struct tc_edge_entry *tc_edge;
+  struct link_entry *link;
+
+  olsr_spf_reset_vertices();
+
+  if (!olsr_spf_sync_neighbors()) {
+    return false;
+  }
+
+  OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc_myself, tc_edge) {
+    if ((link = olsr_spf_first_hop_link(tc_edge)) != NULL) {
+      tc_edge->edge_inv->tc->next_hop = link;
+    }
+  }
+  OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc_myself, tc_edge);
+
+  return true;
+}
+
+/*
+ * olsr_spf_add_routes
+ *
+ * Walk all prefixes advertised by a reachable node.
+ * Insert the prefix into the global RIB.
+ * If the prefix is already in the RIB, refresh the entry such
+ * that olsr_delete_outdated_routes() does not purge it off.
+ */
+static void
+olsr_spf_add_routes(struct tc_entry *tc)
+{
+  struct avl_node *rtp_tree_node;
+  struct rt_path *rtp;
+
+  for (rtp_tree_node = avl_walk_first(&tc->prefix_tree); rtp_tree_node; rtp_tree_node = avl_walk_next(rtp_tree_node)) {
+
+    rtp = rtp_prefix_tree2rtp(rtp_tree_node);
+
+    if (rtp->rtp_rt) {
+
+      /*
+       * If there is a route entry, the prefix is already in the global RIB.
+       */
+      olsr_update_rt_path(rtp, tc, tc->next_hop);
+
+    } else {
+
+      /*
+       * The prefix is reachable and not yet in the global RIB.
+       * Build a rt_entry for it.
+       */
+      olsr_insert_rt_path(rtp, tc, tc->next_hop);
+    }
+  }
+}
+
+/*
+ * olsr_spf_update_routes
+ *
+ * Update the RIB based on the new SPF results
+ * and move the route changes into the kernel.
+ */
+static void
+olsr_spf_update_routes(void)
+{
+#ifdef __linux__
+  /* check gateway tunnels */
+  olsr_trigger_gatewayloss_check();
+#endif /* __linux__ */
+
+  olsr_update_rib_routes();
+  olsr_update_kernel_routes();
+}
+
+#ifndef _WIN32
+
+/*
+ * Threaded SPF.
+ *
+ * The main thread takes a snapshot of the lsdb, which is a compact
+ * array representation of all vertices and usable edges, and hands it
+ * over to the SPF thread. The SPF thread runs Dijkstra on the snapshot
+ * only, it never touches the lsdb. The result is passed back through a
+ * pipe which is serviced by the scheduler, so the new routes are applied
+ * on the main thread.
+ *
+ * While a calculation is in flight further requests are coalesced into
+ * a single follow-up calculation which is started as soon as the result
+ * of the running one has been applied.
+ */
+struct spf_snapshot {
+  uint32_t generation;
+  uint32_t vertex_count;
+  uint32_t source;
+  struct tc_entry **vertex;            /* locked, only used by the main thread */
+  uint32_t *edge_start;                /* edges of vertex i are [edge_start[i], edge_start[i+1]) */
+  uint32_t *edge_dest;
+  olsr_linkcost *edge_cost;
+  int32_t *first_hop;                  /* vertex of the 1st hop neighbor, -1 for none */
+  olsr_linkcost *path_cost;
+  uint8_t *hops;
+  uint32_t *heap;                      /* scratch space for the SPF thread */
+  int32_t *heap_pos;
+  uint64_t start;                      /* when the main thread started the job */
+  uint64_t run_time;                   /* set by the SPF thread */
+};
+
+static pthread_t spf_thread;
+static pthread_mutex_t spf_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t spf_cond = PTHREAD_COND_INITIALIZER;
+static struct spf_snapshot *spf_job;   /* protected by spf_mutex */
+static bool spf_thread_stop;           /* protected by spf_mutex */
+static bool spf_thread_running;
+static int spf_result_pipe[2] = { -1, -1 };
+
+static uint32_t spf_generation;
+static bool spf_in_flight;
+static bool spf_pending;
+
+static void
+olsr_spf_heap_swap(struct spf_snapshot *snap, uint32_t i, uint32_t j)
+{
+  uint32_t tmp = snap->heap[i];
+
+  snap->heap[i] = snap->heap[j];
+  snap->heap[j] = tmp;
+  snap->heap_pos[snap->heap[i]] = i;
+  snap->heap_pos[snap->heap[j]] = j;
+}
+
+static void
+olsr_spf_heap_up(struct spf_snapshot *snap, uint32_t i)
+{
+  while (i > 0) {
+    uint32_t parent = (i - 1) / 2;
+
+    if (snap->path_cost[snap->heap[parent]] <= snap->path_cost[snap->heap[i]]) {
+      break;
+    }
+    olsr_spf_heap_swap(snap, i, parent);
+    i = parent;
+  }
+}
+
+static void
+olsr_spf_heap_down(struct spf_snapshot *snap, uint32_t i, uint32_t size)
+{
+  for (;;) {
+    uint32_t smallest = i;
+    uint32_t left = 2 * i + 1;
+    uint32_t right = left + 1;
+
+    if (left < size && snap->path_cost[snap->heap[left]] < snap->path_cost[snap->heap[smallest]]) {
+      smallest = left;
+    }
+    if (right < size && snap->path_cost[snap->heap[right]] < snap->path_cost[snap->heap[smallest]]) {
+      smallest = right;
+    }
+    if (smallest == i) {
+      break;
+    }
+    olsr_spf_heap_swap(snap, i, smallest);
+    i = smallest;
+  }
+}
+
+/*
+ * olsr_spf_run_snapshot
+ *
+ * Run the Dijkstra algorithm on a snapshot with a binary heap.
+ * This is called by the SPF thread and must not touch anything
+ * but the snapshot.
+ */
+static void
+olsr_spf_run_snapshot(struct spf_snapshot *snap)
+{
+  uint32_t heap_size = 0;
+  uint32_t i;
+
+  for (i = 0; i < snap->vertex_count; i++) {
+    snap->path_cost[i] = ROUTE_COST_BROKEN;
+    snap->hops[i] = 0;
+    snap->heap_pos[i] = -1;
+  }
+
+  snap->path_cost[snap->source] = ZERO_ROUTE_COST;
+  snap->heap[heap_size] = snap->source;
+  snap->heap_pos[snap->source] = heap_size++;
+
+  while (heap_size) {
+    uint32_t vertex = snap->heap[0];
+    uint32_t edge;
+
+    /* extract the best candidate */
+    olsr_spf_heap_swap(snap, 0, --heap_size);
+    olsr_spf_heap_down(snap, 0, heap_size);
+
+    /* relax */
+    for (edge = snap->edge_start[vertex]; edge < snap->edge_start[vertex + 1]; edge++) {
+      uint32_t dest = snap->edge_dest[edge];
+      olsr_linkcost new_cost = snap->path_cost[vertex] + snap->edge_cost[edge];
+
+      if (new_cost >= snap->path_cost[dest]) {
+        continue;
+      }
+
+      snap->path_cost[dest] = new_cost;
+
+      /* pull-up the next-hop and bump the hop count */
+      if (snap->first_hop[vertex] >= 0) {
+        snap->first_hop[dest] = snap->first_hop[vertex];
+      }
+      snap->hops[dest] = snap->hops[vertex] + 1;
+
+      if (snap->heap_pos[dest] < 0) {
+        snap->heap[heap_size] = dest;
+        snap->heap_pos[dest] = heap_size++;
+      }
+      olsr_spf_heap_up(snap, snap->heap_pos[dest]);
+    }
+  }
+}
+
+static void *
+olsr_spf_thread_main(void *context __attribute__ ((unused)))
+{
+  sigset_t blocked;
+  struct spf_snapshot *snap;
+  uint64_t start;
+
+  /* signals are handled by the main thread */
+  sigfillset(&blocked);
+  pthread_sigmask(SIG_BLOCK, &blocked, NULL);
+
+  for (;;) {
+    pthread_mutex_lock(&spf_mutex);
+    while (!spf_job && !spf_thread_stop) {
+      pthread_cond_wait(&spf_cond, &spf_mutex);
+    }
+    if (spf_thread_stop) {
+      pthread_mutex_unlock(&spf_mutex);
+      break;
+    }
+    snap = spf_job;
+    spf_job = NULL;
+    pthread_mutex_unlock(&spf_mutex);
+
+    start = olsr_prof_clock();
+    olsr_spf_run_snapshot(snap);
+    snap->run_time = olsr_prof_clock() - start;
+
+    /* hand the result back to the main thread */
+    while (write(spf_result_pipe[1], &snap, sizeof(snap)) < 0 && errno == EINTR);
+  }
+  return NULL;
+}
+
+static void
+olsr_spf_free_snapshot(struct spf_snapshot *snap)
+{
+  uint32_t i;
+
+  for (i = 0; i < snap->vertex_count; i++) {
+    olsr_unlock_tc_entry(snap->vertex[i]);
+  }
+
+  free(snap->vertex);
+  free(snap->edge_start);
+  free(snap->edge_dest);
+  free(snap->edge_cost);
+  free(snap->first_hop);
+  free(snap->path_cost);
+  free(snap->hops);
+  free(snap->heap);
+  free(snap->heap_pos);
+  free(snap);
+}
+
+/*
+ * olsr_spf_take_snapshot
+ *
+ * Copy the vertices and all usable edges of the lsdb
+ * into a new snapshot. Must be called after olsr_spf_sync_neighbors().
+ * The SPF results in the lsdb are left alone, readers on the main
+ * thread keep seeing the previous results until the snapshot is applied.
+ */
+static struct spf_snapshot *
+olsr_spf_take_snapshot(void)
+{
+  struct spf_snapshot *snap;
+  struct tc_entry *tc;
+  struct tc_edge_entry *tc_edge;
+  uint32_t vertex_count = tc_tree.count;
+  uint32_t edge_count = 0, idx = 0;
+
+  OLSR_FOR_ALL_TC_ENTRIES(tc) {
+    edge_count += tc->edge_tree.count;
+  }
+  OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+
+  snap = olsr_malloc(sizeof(*snap), "SPF snapshot");
+  snap->generation = spf_generation;
+  snap->vertex_count = vertex_count;
+  snap->vertex = olsr_malloc(sizeof(*snap->vertex) * vertex_count, "SPF snapshot");
+  snap->edge_start = olsr_malloc(sizeof(*snap->edge_start) * (vertex_count + 1), "SPF snapshot");
+  snap->edge_dest = olsr_malloc(sizeof(*snap->edge_dest) * (edge_count + 1), "SPF snapshot");
+  snap->edge_cost = olsr_malloc(sizeof(*snap->edge_cost) * (edge_count + 1), "SPF snapshot");
+  snap->first_hop = olsr_malloc(sizeof(*snap->first_hop) * vertex_count, "SPF snapshot");
+  snap->path_cost = olsr_malloc(sizeof(*snap->path_cost) * vertex_count, "SPF snapshot");
+  snap->hops = olsr_malloc(sizeof(*snap->hops) * vertex_count, "SPF snapshot");
+  snap->heap = olsr_malloc(sizeof(*snap->heap) * vertex_count, "SPF snapshot");
+  snap->heap_pos = olsr_malloc(sizeof(*snap->heap_pos) * vertex_count, "SPF snapshot");
+
+  /* number the vertices */
+  OLSR_FOR_ALL_TC_ENTRIES(tc) {
+    tc->spf_index = idx;
+    snap->vertex[idx] = tc;
+    snap->first_hop[idx] = -1;
+    olsr_lock_tc_entry(tc);
+    idx++;
+  }
+  OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+
+  snap->source = tc_myself->spf_index;
+
+  /* our neighbours are their own 1st hop */
+  OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc_myself, tc_edge) {
+    if (olsr_spf_first_hop_link(tc_edge)) {
+      idx = tc_edge->edge_inv->tc->spf_index;
+      snap->first_hop[idx] = idx;
+    }
+  }
+  OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc_myself, tc_edge);
+
+  /* copy the edges, we are not interested in dead-end and broken ones */
+  edge_count = 0;
+  for (idx = 0; idx < vertex_count; idx++) {
+    tc = snap->vertex[idx];
+    snap->edge_start[idx] = edge_count;
+
+    OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
+      if (!tc_edge->edge_inv || tc_edge->cost == LINK_COST_BROKEN) {
+        continue;
+      }
+      snap->edge_dest[edge_count] = tc_edge->edge_inv->tc->spf_index;
+      snap->edge_cost[edge_count] = tc_edge->cost;
+      edge_count++;
+    }
+    OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
+  }
+  snap->edge_start[vertex_count] = edge_count;
+
+  return snap;
+}
+
+/*
+ * olsr_spf_apply_snapshot
+ *
+ * Move the results of a finished SPF calculation into the lsdb
+ * and update the RIB. Vertices which are gone in the meantime have
+ * an empty prefix tree, vertices which are new have no route yet
+ * and will be picked up by the follow-up calculation.
+ */
+static void
+olsr_spf_apply_snapshot(struct spf_snapshot *snap)
+{
+  struct tc_entry *tc;
+  uint32_t idx;
+
+  olsr_bump_routingtree_version();
+  olsr_spf_reset_vertices();
+
+  for (idx = 0; idx < snap->vertex_count; idx++) {
+    struct link_entry *link;
+
+    if (snap->path_cost[idx] == ROUTE_COST_BROKEN || snap->first_hop[idx] < 0) {
+      continue;
+    }
+
+    tc = snap->vertex[idx];
+    tc->path_cost = snap->path_cost[idx];
+    tc->hops = snap->hops[idx];
+
+    /* the link to the 1st hop might have changed while the SPF thread was running */
+    link = get_best_link_to_neighbor(&snap->vertex[snap->first_hop[idx]]->addr);
+    if (!link || !link->inter || lookup_link_status(link) == LOST_LINK) {
+      continue;
+    }
+
+    tc->next_hop = link;
+    olsr_spf_add_routes(tc);
+  }
+
+  olsr_spf_update_routes();
+}
+
+static void olsr_spf_start_thread_job(void);
+
+/**
+ * Socket handler for results of the SPF thread.
+ */
+static void
+olsr_spf_thread_result(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+  struct spf_snapshot *snap;
+
+  if (read(fd, &snap, sizeof(snap)) != sizeof(snap)) {
+    return;
+  }
+
+  spf_in_flight = false;
+  olsr_hist_record(&olsr_prof[OLSR_PROF_SPF_RUN], snap->run_time);
+
+  /* discard outdated results */
+  if (snap->generation == spf_generation) {
+    OLSR_PRINTF(2, "\n--- %s ------------------------------------------------- DIJKSTRA (thread)\n\n", olsr_wallclock_string());
+    olsr_spf_apply_snapshot(snap);
+    olsr_hist_record(&olsr_prof[OLSR_PROF_SPF], olsr_prof_clock() - snap->start);
+  }
+  olsr_spf_free_snapshot(snap);
+
+  /* coalesced requests */
+  if (spf_pending) {
+    spf_pending = false;
+    olsr_spf_start_thread_job();
+  }
+}
+
+/*
+ * olsr_spf_start_thread_job
+ *
+ * Prepare the lsdb, take a snapshot and
+ * hand it over to the SPF thread.
+ */
+static void
+olsr_spf_start_thread_job(void)
+{
+  struct spf_snapshot *snap;
+  uint64_t start = olsr_prof_clock();
+
+  if (!olsr_spf_sync_neighbors()) {
+
+    /*
+     * All gone now. Flush all routes.
+     */
+    spf_generation++;
+    olsr_spf_reset_vertices();
+    olsr_bump_routingtree_version();
+    olsr_update_rib_routes();
+    olsr_update_kernel_routes();
+    return;
+  }
+
+  snap = olsr_spf_take_snapshot();
+  snap->start = start;
+
+  pthread_mutex_lock(&spf_mutex);
+  spf_job = snap;
+  pthread_cond_signal(&spf_cond);
+  pthread_mutex_unlock(&spf_mutex);
+
+  spf_in_flight = true;
+}
+
+/*
+ * olsr_spf_init_thread
+ *
+ * Start the SPF thread. Returns false if this is not possible,
+ * so the caller should fall back to the synchronous calculation.
+ */
+static bool
+olsr_spf_init_thread(void)
+{
+  if (pipe(spf_result_pipe) < 0) {
+    OLSR_PRINTF(1, "SPF: cannot create result pipe (%s), falling back to synchronous SPF\n", strerror(errno));
+    olsr_cnf->spf_thread = false;
+    return false;
+  }
+
+  if (pthread_create(&spf_thread, NULL, &olsr_spf_thread_main, NULL) != 0) {
+    OLSR_PRINTF(1, "SPF: cannot create thread, falling back to synchronous SPF\n");
+    close(spf_result_pipe[0]);
+    close(spf_result_pipe[1]);
+    olsr_cnf->spf_thread = false;
+    return false;
+  }
+
+  add_olsr_socket(spf_result_pipe[0], &olsr_spf_thread_result, NULL, NULL, SP_PR_READ);
+  spf_thread_running = true;
+  return true;
+}
+
+/**
+ * Stop the SPF thread, a calculation in flight is discarded.
+ */
+void
+olsr_shutdown_spf(void)
+{
+  struct spf_snapshot *snap;
+
+  if (!spf_thread_running) {
+    return;
+  }
+
+  pthread_mutex_lock(&spf_mutex);
+  spf_thread_stop = true;
+  pthread_cond_signal(&spf_cond);
+  pthread_mutex_unlock(&spf_mutex);
+  pthread_join(spf_thread, NULL);
+
+  /* a job the thread did not pick up any more */
+  if (spf_job) {
+    olsr_spf_free_snapshot(spf_job);
+    spf_job = NULL;
+  }
+
+  /* and results it wrote but nobody read yet */
+  if (fcntl(spf_result_pipe[0], F_SETFL, fcntl(spf_result_pipe[0], F_GETFL) | O_NONBLOCK) == 0) {
+    while (read(spf_result_pipe[0], &snap, sizeof(snap)) == sizeof(snap)) {
+      olsr_spf_free_snapshot(snap);
+    }
+  }
+  spf_in_flight = false;
+  spf_pending = false;
+
+  remove_olsr_socket(spf_result_pipe[0], &olsr_spf_thread_result, NULL);
+  close(spf_result_pipe[0]);
+  close(spf_result_pipe[1]);
+  spf_thread_running = false;
+}
+
+#else /* _WIN32 */
+
+void
+olsr_shutdown_spf(void)
+{
+}
+
+#endif /* _WIN32 */
+
+void
+olsr_calculate_routing_table(bool force)
+{
+  uint64_t t1, t2, t3, t5;
+  struct avl_tree cand_tree;
+  struct list_node path_list;          /* head of the path_list */
+  struct tc_entry *tc;
+  int path_count = 0;
+
+#ifndef _WIN32
+  if (olsr_cnf->spf_thread && (spf_thread_running || olsr_spf_init_thread())) {
+    if (force) {
+      /* a result in flight is outdated by the synchronous run below */
+      spf_generation++;
+    } else {
+      /* coalesce with the calculation in flight */
+      if (spf_in_flight) {
+        spf_pending = true;
+      } else {
+        olsr_spf_start_thread_job();
+      }
+      return;
+    }
+  }
+#endif /* _WIN32 */
+
+  /* We are done if our backoff timer is running */
+  if (!force) {
+    if (spf_backoff_timer) {
+      return;
+    }
+
+    /* start new backoff timer */
+    spf_backoff_timer = olsr_start_timer(1000, 5, OLSR_TIMER_ONESHOT, &olsr_expire_spf_backoff, NULL, 0);
+  }
+
+  t1 = olsr_prof_clock();
+
+  /*
+   * Prepare the candidate tree and result list.
+   */
+  avl_init(&cand_tree, avl_comp_etx);
+  list_head_init(&path_list);
+  olsr_bump_routingtree_version();
+
+  if (!olsr_spf_init_vertices()) {
+
+    /*
+     * All gone now. Flush all routes.
+     */
+    olsr_update_rib_routes();
+    olsr_update_kernel_routes();
+    return;
+  }
+
+  /*
+   * zero ourselves and add us to the candidate tree.
+   */
+  tc_myself->path_cost = ZERO_ROUTE_COST;
+  olsr_spf_add_cand_tree(&cand_tree, tc_myself);
+
+  t2 = olsr_prof_clock();
 
   /*
    * Run the SPF calculation.
@@ -440,9 +1063,7 @@ olsr_calculate_routing_table(bool force)
 
   OLSR_PRINTF(2, "\n--- %s ------------------------------------------------- DIJKSTRA\n\n", olsr_wallclock_string());
 
-#ifdef SPF_PROFILING
-  gettimeofday(&t3, NULL);
-#endif /* SPF_PROFILING */
+  t3 = olsr_prof_clock();
 
   /*
    * In the path list we have all the reachable nodes in our topology.
@@ -450,9 +1071,8 @@ olsr_calculate_routing_table(bool force)
   for (; !list_is_empty(&path_list); list_remove(path_list.next)) {
 
     tc = pathlist2tc(path_list.next);
-    link = tc->next_hop;
 
-    if (!link) {
+    if (!tc->next_hop) {
 #ifdef DEBUG
       /*
        * Supress the error msg when our own tc_entry
@@ -467,62 +1087,22 @@ olsr_calculate_routing_table(bool force)
     }
 
     /*
-     * Now walk all prefixes advertised by that node.
-     * Since the node is reachable, insert the prefix into the global RIB.
-     * If the prefix is already in the RIB, refresh the entry such
-     * that olsr_delete_outdated_routes() does not purge it off.
+     * Since the node is reachable, insert its prefixes into the global RIB.
      */
-    for (rtp_tree_node = avl_walk_first(&tc->prefix_tree); rtp_tree_node; rtp_tree_node = avl_walk_next(rtp_tree_node)) {
-
-      rtp = rtp_prefix_tree2rtp(rtp_tree_node);
-
-      if (rtp->rtp_rt) {
-
-        /*
-         * If there is a route entry, the prefix is already in the global RIB.
-         */
-        olsr_update_rt_path(rtp, tc, link);
-
-      } else {
-
-        /*
-         * The prefix is reachable and not yet in the global RIB.
-         * Build a rt_entry for it.
-         */
-        olsr_insert_rt_path(rtp, tc, link);
-      }
-    }
+    olsr_spf_add_routes(tc);
   }
-#ifdef __linux__
-  /* check gateway tunnels */
-  olsr_trigger_gatewayloss_check();
-#endif /* __linux__ */
-
-  /* Update the RIB based on the new SPF results */
-
-  olsr_update_rib_routes();
 
-#ifdef SPF_PROFILING
-  gettimeofday(&t4, NULL);
-#endif /* SPF_PROFILING */
-
-  /* move the route changes into the kernel */
+  olsr_spf_update_routes();
 
-  olsr_update_kernel_routes();
+  t5 = olsr_prof_clock();
 
-#ifdef SPF_PROFILING
-  gettimeofday(&t5, NULL);
-#endif /* SPF_PROFILING */
+  olsr_hist_record(&olsr_prof[OLSR_PROF_SPF], t5 - t1);
+  olsr_hist_record(&olsr_prof[OLSR_PROF_SPF_RUN], t3 - t2);
 
 #ifdef SPF_PROFILING
-  timersub(&t2, &t1, &spf_init);
-  timersub(&t3, &t2, &spf_run);
-  timersub(&t4, &t3, &route);
-  timersub(&t5, &t4, &kernel);
-  timersub(&t5, &t1, &total);
-  OLSR_PRINTF(1, "\n--- SPF-stats for %d nodes, %d routes (total/init/run/route/kern): " "%d, %d, %d, %d, %d\n", path_count,
-              routingtree.count, (int)total.tv_usec, (int)spf_init.tv_usec, (int)spf_run.tv_usec, (int)route.tv_usec,
-              (int)kernel.tv_usec);
+  OLSR_PRINTF(1, "\n--- SPF-stats for %d nodes, %d routes (total/init/run/routes): " "%d, %d, %d, %d\n", path_count,
+              routingtree.count, (int)((t5 - t1) / 1000), (int)((t2 - t1) / 1000), (int)((t3 - t2) / 1000),
+              (int)((t5 - t3) / 1000));
 #endif /* SPF_PROFILING */
 }
 
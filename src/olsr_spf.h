@@ -43,6 +43,7 @@
 #define _OLSR_SPF_H
 
 void olsr_calculate_routing_table(bool force);
+void olsr_shutdown_spf(void);
 
 #endif /* _OLSR_SPF_H */
 
@@ -61,14 +61,22 @@ static const struct ohs_command ohs_commands[] = {
    "List all connected clients or links",
    "This command will list all the clients or all the links registered by olsr_switch. By default clients are listed.",
    ohs_cmd_list},
-  {"link", "link <bi> [srcIP|*] [dstIP|*] [0-100]",
+  {"link", "link <bi> [srcIP|*] [dstIP|*] [0-100] | link default [0-100]",
    "Manipulate links",
-   "This command is used for manipulating olsr links. The link quality is a number between 0-100 representing the chance in percentage for a packet to be forwarded on the link.\nTo make the link between 10.0.0.1 and 10.0.0.2 have 50% packet loss do:\nlink 10.0.0.1 10.0.0.2 50\nNote that this will only effect the unidirectional link 10.0.0.1 -> 10.0.0.2.\nTo make the changes affect traffic in both directions do:\nlink bi 10.0.0.1 10.0.0.2 50\nTo completely block a link do:\nlink 10.0.0.1 10.0.0.2 0\nTo make all traffic pass(delete the entry) do:\nlink 10.0.0.1 10.0.0.2 100\nNote that \"bi\" can be used in all these examples.\nWildcard source and/or destinations are also supported.\nTo block all traffic from a node do:\nlink 10.0.0.1 * 0\nTo set 50% packet loss on all links to 10.0.0.2 do:\nlink * 10.0.0.2 50\nTo delete all links do:\nlink * * 100\nWildcards can also be used in combination with 'bi'.\nTo list all manipulated links use 'list links'.\n",
+   "This command is used for manipulating olsr links. The link quality is a number between 0-100 representing the chance in percentage for a packet to be forwarded on the link.\nTo make the link between 10.0.0.1 and 10.0.0.2 have 50% packet loss do:\nlink 10.0.0.1 10.0.0.2 50\nNote that this will only effect the unidirectional link 10.0.0.1 -> 10.0.0.2.\nTo make the changes affect traffic in both directions do:\nlink bi 10.0.0.1 10.0.0.2 50\nTo completely block a link do:\nlink 10.0.0.1 10.0.0.2 0\nTo make all traffic pass(delete the entry) do:\nlink 10.0.0.1 10.0.0.2 100\nNote that \"bi\" can be used in all these examples.\nWildcard source and/or destinations are also supported.\nTo block all traffic from a node do:\nlink 10.0.0.1 * 0\nTo set 50% packet loss on all links to 10.0.0.2 do:\nlink * 10.0.0.2 50\nTo delete all links do:\nlink * * 100\nWildcards can also be used in combination with 'bi'.\nTo list all manipulated links use 'list links'.\nLinks without an entry have the default quality, 100 unless changed with:\nlink default 0\nSetting a link to the default quality deletes its entry.\n",
    ohs_cmd_link},
   {"olsrd", "olsrd [start|stop|show|setb|seta] [IP|path|args]",
    "Start or stop local olsrd processes. Also used to set the olsrd binary path and arguments",
    "This command is used for managing local olsrd instances from within olsr_switch.\nThe command can be configured in runtime using the setb and seta sub-commands.\nTo show the current olsrd command-configuration do:\nolsrd show\nTo set the olsrd binary path do:\nolsrd setb /full/path/to/olsrd\nTo start a olsrd instance with a IP address of 10.0.0.1, do:\nolsrd start 10.0.0.1\nTo stop that same instance do:\nolsrd stop 10.0.0.1\nseta would set arguments but is currently not implemented\n",
    ohs_cmd_olsrd},
+  {"topology", "topology [grid|random|scalefree] nodes firstIP [degree|m] [seed] | topology [show|start|clear]",
+   "Set up a synthetic topology",
+   "This command generates a topology over a range of consecutive addresses and makes it the only set of open links.\nTo arrange 100 nodes starting at 10.0.0.1 on a square grid do:\ntopology grid 100 10.0.0.1\nRandom geometric graphs take the average degree (default 6), scale-free graphs the number of links every new node makes (default 2), both take a random seed:\ntopology random 5000 10.0.0.1 8 42\ntopology scalefree 5000 10.0.0.1 2\nClients of the topology get their links when they connect. To start olsrd for every node that is not connected yet do:\ntopology start\nTo open all links again do:\ntopology clear\n",
+   ohs_cmd_topology},
+  {"stats", "stats",
+   "Show traffic, convergence and olsrd resource statistics",
+   "This command shows the control traffic passed through the switch, how many new ANSNs were seen and when the last one was seen, and the CPU time and memory of the olsrd processes started by the switch (Linux only).\nOnce no new ANSN shows up any more, the topology has settled.\n",
+   ohs_cmd_stats},
   {NULL, NULL,
    NULL,
    NULL,
@@ -47,34 +47,47 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-int
-ohs_check_link(struct ohs_connection *oc, union olsr_ip_addr *dst)
-{
-  struct ohs_ip_link *links;
-  for (links = oc->links; links != NULL; links = links->next) {
-    int r;
-    if (!ipequal(&links->dst, dst)) {
-      continue;
-    }
-    if (links->quality == 0) {
-      if (logbits & LOG_LINK) {
-        struct ipaddr_str addrstr, dststr;
-        printf("%s -> %s Q: %d\n", olsr_ip_to_string(&addrstr, &oc->ip_addr), olsr_ip_to_string(&dststr, dst), links->quality);
-      }
-      return 0;
-    }
+/* quality of links without an entry */
+int ohs_link_default = 100;
 
-    r = 1 + (int)(100.0 / (RAND_MAX + 1.0) * rand());
+static int
+ohs_roll_link(struct ohs_connection *oc, union olsr_ip_addr *dst, int quality)
+{
+  int r;
 
+  if (quality == 0) {
     if (logbits & LOG_LINK) {
       struct ipaddr_str addrstr, dststr;
-      printf("%s -> %s Q: %d R: %d\n", olsr_ip_to_string(&addrstr, &oc->ip_addr), olsr_ip_to_string(&dststr, dst), links->quality,
-             r);
+      printf("%s -> %s Q: %d\n", olsr_ip_to_string(&addrstr, &oc->ip_addr), olsr_ip_to_string(&dststr, dst), quality);
     }
-    /* Random - based on quality */
-    return links->quality > r ? 0 : 1;
+    return 0;
+  }
+  if (quality == 100) {
+    return 1;
+  }
+
+  r = 1 + (int)(100.0 / (RAND_MAX + 1.0) * rand());
+
+  if (logbits & LOG_LINK) {
+    struct ipaddr_str addrstr, dststr;
+    printf("%s -> %s Q: %d R: %d\n", olsr_ip_to_string(&addrstr, &oc->ip_addr), olsr_ip_to_string(&dststr, dst), quality, r);
   }
-  return 1;
+  /* Random - quality is the chance in percent to get through */
+  return r <= quality ? 1 : 0;
+}
+
+int
+ohs_check_link(struct ohs_connection *oc, union olsr_ip_addr *dst)
+{
+  struct ohs_ip_link *link = get_link(oc, dst);
+
+  return ohs_roll_link(oc, dst, link ? link->quality : ohs_link_default);
+}
+
+int
+ohs_check_link_entry(struct ohs_connection *oc, struct ohs_ip_link *link)
+{
+  return ohs_roll_link(oc, &link->dst, link->quality);
 }
 
 int
@@ -99,7 +112,7 @@ ohs_delete_all_related_links(struct ohs_connection *oc)
 }
 
 struct ohs_ip_link *
-add_link(struct ohs_connection *src, struct ohs_connection *dst)
+add_link(struct ohs_connection *src, const union olsr_ip_addr *dst)
 {
   struct ohs_ip_link *link;
 
@@ -110,7 +123,7 @@ add_link(struct ohs_connection *src, struct ohs_connection *dst)
   /* Queue */
   link->next = src->links;
   src->links = link;
-  link->dst = dst->ip_addr;
+  link->dst = *dst;
   src->linkcnt++;
 
   return link;
@@ -141,7 +154,7 @@ remove_link(struct ohs_connection *oc, struct ohs_ip_link *lnk)
 }
 
 struct ohs_ip_link *
-get_link(struct ohs_connection *oc, union olsr_ip_addr *dst)
+get_link(struct ohs_connection *oc, const union olsr_ip_addr *dst)
 {
   struct ohs_ip_link *links;
   for (links = oc->links; links != NULL; links = links->next) {
@@ -44,11 +44,15 @@
 
 #include "olsr_types.h"
 #include "olsr_host_switch.h"
+extern int ohs_link_default;
+
 int ohs_check_link(struct ohs_connection *, union olsr_ip_addr *);
 
-struct ohs_ip_link *get_link(struct ohs_connection *, union olsr_ip_addr *);
+int ohs_check_link_entry(struct ohs_connection *, struct ohs_ip_link *);
+
+struct ohs_ip_link *get_link(struct ohs_connection *, const union olsr_ip_addr *);
 
-struct ohs_ip_link *add_link(struct ohs_connection *, struct ohs_connection *);
+struct ohs_ip_link *add_link(struct ohs_connection *, const union olsr_ip_addr *);
 
 int remove_link(struct ohs_connection *, struct ohs_ip_link *);
 
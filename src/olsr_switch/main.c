@@ -44,6 +44,7 @@
 #include "olsr_host_switch.h"
 #include "link_rules.h"
 #include "ohs_cmd.h"
+#include "topology.h"
 #include "ipcalc.h"
 
 #include <sys/types.h>
@@ -66,6 +67,8 @@
 #define close(x) closesocket(x)
 #else /* _WIN32 */
 #include <sys/wait.h>
+#include <poll.h>
+#include <fcntl.h>
 #endif /* _WIN32 */
 
 static int srv_socket;
@@ -73,7 +76,16 @@ static int srv_socket;
 #define OHS_BUFSIZE 1500
 static uint8_t data_buffer[OHS_BUFSIZE];
 
+/* message types carrying an ANSN */
+#define OHS_TC_MESSAGE    2
+#define OHS_LQ_TC_MESSAGE 202
+
 struct ohs_connection *ohs_conns;
+static struct ohs_connection *ohs_conn_hash[OHS_HASHSIZE];
+uint32_t ohs_conn_count;
+
+/* when any node last advertised a new topology */
+struct timeval ohs_last_ansn_change;
 
 //static int ip_version;
 //int ipsize;
@@ -112,11 +124,24 @@ ohs_close(int signo __attribute__ ((unused)))
   exit(0);
 }
 
+static uint32_t
+ohs_hash(const union olsr_ip_addr *adr)
+{
+  const uint8_t *p = (const uint8_t *)adr;
+  uint32_t hash = 0;
+  size_t i;
+
+  for (i = 0; i < olsr_cnf->ipsize; i++) {
+    hash = hash * 31 + p[i];
+  }
+  return hash & (OHS_HASHSIZE - 1);
+}
+
 struct ohs_connection *
 get_client_by_addr(const union olsr_ip_addr *adr)
 {
   struct ohs_connection *oc;
-  for (oc = ohs_conns; oc != NULL; oc = oc->next) {
+  for (oc = ohs_conn_hash[ohs_hash(adr)]; oc != NULL; oc = oc->hash_next) {
     if (ipequal(adr, &oc->ip_addr)) {
       return oc;
     }
@@ -190,6 +215,12 @@ ohs_init_new_connection(int s)
   /* Queue */
   oc->next = ohs_conns;
   ohs_conns = oc;
+  oc->hash_next = ohs_conn_hash[ohs_hash(&oc->ip_addr)];
+  ohs_conn_hash[ohs_hash(&oc->ip_addr)] = oc;
+  ohs_conn_count++;
+
+  /* links of a configured topology */
+  ohs_topology_attach(oc);
   return 1;
 }
 
@@ -207,6 +238,16 @@ ohs_delete_connection(struct ohs_connection *oc)
     printf("Removing entry %s\n", olsr_ip_to_string(&addrstr, &oc->ip_addr));
   }
   /* De-queue */
+  {
+    struct ohs_connection **hp = &ohs_conn_hash[ohs_hash(&oc->ip_addr)];
+
+    while (*hp != oc) {
+      hp = &(*hp)->hash_next;
+    }
+    *hp = oc->hash_next;
+  }
+  ohs_conn_count--;
+
   if (oc == ohs_conns) {
     ohs_conns = ohs_conns->next;
   } else {
@@ -228,44 +269,115 @@ ohs_delete_connection(struct ohs_connection *oc)
   return 0;
 }
 
+/*
+ * Remember the ANSN of every TC passing the switch; once no node
+ * advertises a new one the topology has settled.
+ */
+static void
+ohs_track_ansn(ssize_t len)
+{
+  ssize_t off = 4;                     /* packet header, IPv4 messages follow */
+
+  while (off + 12 <= len) {
+    uint8_t type = data_buffer[off];
+    uint16_t size = (uint16_t)(data_buffer[off + 2] << 8 | data_buffer[off + 3]);
+
+    if (size < 12 || off + size > len) {
+      break;
+    }
+    if ((type == OHS_TC_MESSAGE || type == OHS_LQ_TC_MESSAGE) && size >= 14) {
+      union olsr_ip_addr orig;
+      struct ohs_connection *oc;
+      uint16_t ansn = (uint16_t)(data_buffer[off + 12] << 8 | data_buffer[off + 13]);
+
+      memset(&orig, 0, sizeof(orig));
+      memcpy(&orig, &data_buffer[off + 4], sizeof(orig.v4));
+      oc = get_client_by_addr(&orig);
+      if (oc && (!oc->ansn_valid || oc->ansn != ansn)) {
+        oc->ansn = ansn;
+        oc->ansn_valid = true;
+        oc->ansn_changes++;
+        gettimeofday(&ohs_last_ansn_change, NULL);
+      }
+    }
+    off += size;
+  }
+}
+
+static void
+ohs_forward(struct ohs_connection *oc, struct ohs_connection *ohs_cs, ssize_t len)
+{
+  ssize_t sent;
+
+  /* Send link addr */
+  if (send(ohs_cs->socket, (const void *)&oc->ip_addr, olsr_cnf->ipsize, 0) != (int)olsr_cnf->ipsize) {
+    printf("Error sending link address!\n");
+  }
+  /* Send data */
+  if (logbits & LOG_FORWARD) {
+    struct ipaddr_str addrstr, addrstr2;
+    printf("Sending %d bytes %s=>%s\n", (int)len, olsr_ip_to_string(&addrstr, &oc->ip_addr),
+           olsr_ip_to_string(&addrstr2, &ohs_cs->ip_addr));
+  }
+
+  sent = send(ohs_cs->socket, (void*)data_buffer, len, 0);
+  if (sent != len) {
+    printf("Error sending(buf %d != sent %d)\n", (int)len, (int)sent);
+  }
+  ohs_cs->rx++;
+  ohs_cs->rx_bytes += len;
+}
+
 static int
 ohs_route_data(struct ohs_connection *oc)
 {
   struct ohs_connection *ohs_cs;
   ssize_t len;
+  uint16_t pcklen;
   int cnt = 0;
 
-  oc->tx++;
-  /* Read data */
-  if ((len = recv(oc->socket, (void *)data_buffer, OHS_BUFSIZE, 0)) <= 0)
+  /* Read exactly one OLSR packet, its length leads the header */
+  if ((len = recv(oc->socket, (void *)&pcklen, 2, MSG_PEEK)) <= 0)
+    return -1;
+  if (len != 2)
+    return 0;
+  pcklen = ntohs(pcklen);
+  if (pcklen < 4 || pcklen > OHS_BUFSIZE) {
+    printf("Bad packet length %u from client\n", pcklen);
+    return -1;
+  }
+  if ((len = recv(oc->socket, (void *)data_buffer, pcklen, MSG_WAITALL)) != pcklen)
     return -1;
 
+  oc->tx++;
+  oc->tx_bytes += len;
+
   if (logbits & LOG_FORWARD) {
     struct ipaddr_str addrstr;
     printf("Received %ld bytes from %s\n", (long)len, olsr_ip_to_string(&addrstr, &oc->ip_addr));
   }
+
+  ohs_track_ansn(len);
+
+  if (ohs_link_default == 0) {
+    struct ohs_ip_link *link;
+
+    /* Only the listed links are open: no need to look at everybody */
+    for (link = oc->links; link; link = link->next) {
+      ohs_cs = get_client_by_addr(&link->dst);
+      if (ohs_cs && ohs_cs != oc && ohs_check_link_entry(oc, link)) {
+        ohs_forward(oc, ohs_cs, len);
+        cnt++;
+      }
+    }
+    return cnt;
+  }
+
   /* Loop trough clients */
   for (ohs_cs = ohs_conns; ohs_cs; ohs_cs = ohs_cs->next) {
     /* Check that the link is active open */
     if (ohs_check_link(oc, &ohs_cs->ip_addr) && oc->socket != ohs_cs->socket) {
-      ssize_t sent;
-
-      /* Send link addr */
-      if (send(ohs_cs->socket, (const void *)&oc->ip_addr, olsr_cnf->ipsize, 0) != (int)olsr_cnf->ipsize) {
-        printf("Error sending link address!\n");
-      }
-      /* Send data */
-      if (logbits & LOG_FORWARD) {
-        struct ipaddr_str addrstr, addrstr2;
-        printf("Sending %d bytes %s=>%s\n", (int)len, olsr_ip_to_string(&addrstr, &oc->ip_addr),
-               olsr_ip_to_string(&addrstr2, &ohs_cs->ip_addr));
-      }
-
-      sent = send(ohs_cs->socket, (void*)data_buffer, len, 0);
-      if (sent != len) {
-        printf("Error sending(buf %d != sent %d)\n", (int)len, (int)sent);
-      }
-      ohs_cs->rx++;
+      ohs_forward(oc, ohs_cs, len);
       cnt++;
     }
   }
@@ -284,6 +396,10 @@ ohs_init_connect_sockets(void)
     printf("Could not initialize socket(%d): %s\n", srv_socket, strerror(errno));
     exit(0);
   }
+#ifndef _WIN32
+  /* keep the olsrd instances we fork from inheriting the sockets */
+  fcntl(srv_socket, F_SETFD, FD_CLOEXEC);
+#endif /* _WIN32 */
 
   if (setsockopt(srv_socket, SOL_SOCKET, SO_REUSEADDR, (char *)&yes, sizeof(yes)) < 0) {
     printf("SO_REUSEADDR failed for socket: %s\n", strerror(errno));
@@ -305,7 +421,7 @@ ohs_init_connect_sockets(void)
   }
 
   /* show that we are willing to listen */
-  if (listen(srv_socket, 5) == -1) {
+  if (listen(srv_socket, SOMAXCONN) == -1) {
     printf("listen failed for socket: %s\n", strerror(errno));
     close(srv_socket);
     exit(0);
@@ -332,6 +448,9 @@ accept_handler(void)
   if ((s = accept(srv_socket, (struct sockaddr *)&pin, &addrlen)) < 0) {
     printf("accept failed socket: %s\n", strerror(errno));
   } else {
+#ifndef _WIN32
+    fcntl(s, F_SETFD, FD_CLOEXEC);
+#endif /* _WIN32 */
     /* Create new node */
     ohs_init_new_connection(s);
   }
@@ -354,37 +473,42 @@ static void
 ohs_listen_loop(void)
 {
 #if !defined _WIN32
-  int n;
-  fd_set ibits;
+  /* poll(), select() cannot handle a few thousand clients */
+  struct pollfd *pfds = NULL;
+  struct ohs_connection **pconns = NULL;
+  uint32_t pfd_size = 0;
   int fn_stdin = fileno(stdin);
 
   while (1) {
-    int high;
-
     struct ohs_connection *ohs_cs;
+    uint32_t i, nfds;
+    int n;
+
+    if (pfd_size < ohs_conn_count + 2) {
+      pfd_size = 2 * ohs_conn_count + 2;
+      pfds = realloc(pfds, pfd_size * sizeof(*pfds));
+      pconns = realloc(pconns, pfd_size * sizeof(*pconns));
+      if (!pfds || !pconns)
+        OHS_OUT_OF_MEMORY("Poll set");
+    }
 
-    high = 0;
-    FD_ZERO(&ibits);
-
-    /* Add server socket */
-    high = srv_socket;
-    FD_SET(srv_socket, &ibits);
-
-    if (fn_stdin > high)
-      high = fn_stdin;
-
-    FD_SET(fn_stdin, &ibits);
+    /* Add server socket and stdin */
+    pfds[0].fd = srv_socket;
+    pfds[0].events = POLLIN;
+    pfds[1].fd = fn_stdin;
+    pfds[1].events = POLLIN;
+    nfds = 2;
 
     /* Add clients */
     for (ohs_cs = ohs_conns; ohs_cs; ohs_cs = ohs_cs->next) {
-      if (ohs_cs->socket > high)
-        high = ohs_cs->socket;
-
-      FD_SET(ohs_cs->socket, &ibits);
+      pfds[nfds].fd = ohs_cs->socket;
+      pfds[nfds].events = POLLIN;
+      pconns[nfds] = ohs_cs;
+      nfds++;
     }
 
     /* block */
-    n = select(high + 1, &ibits, 0, 0, NULL);
+    n = poll(pfds, nfds, -1);
 
     if (n == 0)
       continue;
@@ -394,25 +518,21 @@ ohs_listen_loop(void)
       if (errno == EINTR)
         continue;
 
-      printf("Error select: %s", strerror(errno));
+      printf("Error poll: %s", strerror(errno));
       continue;
     }
 
     /* Check server socket */
-    if (FD_ISSET(srv_socket, &ibits))
+    if (pfds[0].revents & POLLIN)
       accept_handler();
 
-    /* Loop trough clients */
-    ohs_cs = ohs_conns;
-    while (ohs_cs) {
-      struct ohs_connection *ohs_tmp = ohs_cs;
-      ohs_cs = ohs_cs->next;
-
-      if (FD_ISSET(ohs_tmp->socket, &ibits))
-        read_handler(ohs_tmp);
+    /* Loop trough clients, a handler only ever removes its own */
+    for (i = 2; i < nfds; i++) {
+      if (pfds[i].revents & (POLLIN | POLLHUP | POLLERR))
+        read_handler(pconns[i]);
     }
 
-    if (FD_ISSET(fn_stdin, &ibits))
+    if (pfds[1].revents & (POLLIN | POLLHUP))
       stdin_handler();
 
   }
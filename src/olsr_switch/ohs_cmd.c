@@ -43,6 +43,7 @@
 #include "olsr_types.h"
 #include "commands.h"
 #include "link_rules.h"
+#include "topology.h"
 #include "ipcalc.h"
 
 #include <string.h>
@@ -54,6 +55,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
+#include <sys/time.h>
 
 #define TOK_BUF_SIZE 500
 static char tok_buf[TOK_BUF_SIZE];
@@ -92,6 +94,65 @@ ohs_set_olsrd_path(const char *path)
   return 0;
 }
 
+#ifndef _WIN32
+/**
+ * Fork and exec an olsrd instance in host emulation mode.
+ *
+ * @param ip the address of the instance
+ * @return the process id, -1 on error
+ */
+static int
+ohs_start_olsrd(const char *ip)
+{
+  const char *olsrd_args[MAX_OLSRD_ARGS];
+  struct ohs_topology_node *node;
+  struct in_addr iaddr;
+  int argc = 0, i;
+  pid_t pid;
+
+  olsrd_args[argc++] = olsrd_path;
+
+  if (1) {                      /* config file is set */
+    olsrd_args[argc++] = "-f";
+    olsrd_args[argc++] = "./olsrd.emu.conf";
+  }
+  olsrd_args[argc++] = "-hemu";
+  olsrd_args[argc++] = ip;
+
+  olsrd_args[argc++] = "-d";
+  olsrd_args[argc++] = "0";
+  olsrd_args[argc++] = "-nofork";
+  olsrd_args[argc] = NULL;
+
+  printf("Executing: %s", olsrd_path);
+  for (i = 0; i < argc; i++)
+    printf(" %s", olsrd_args[i]);
+  printf("\n");
+  fflush(stdout);
+
+  pid = fork();
+  if (pid < 0) {
+    printf("Error forking olsrd: %s\n", strerror(errno));
+    return -1;
+  }
+  if (pid == 0) {
+    if (execve(olsrd_path, (char *const *)olsrd_args, NULL) < 0) {
+      printf("Error executing olsrd: %s\n", strerror(errno));
+      exit(1);
+    }
+  }
+
+  /* remember the process for the statistics */
+  if (inet_aton(ip, &iaddr)) {
+    node = ohs_topology_lookup((union olsr_ip_addr *)&iaddr.s_addr);
+    if (node) {
+      node->pid = pid;
+    }
+  }
+  return pid;
+}
+#endif /* _WIN32 */
+
 #ifdef _WIN32
 int
 ohs_cmd_olsrd(const char *args __attribute__ ((unused)))
@@ -103,7 +164,6 @@ ohs_cmd_olsrd(const char *args __attribute__ ((unused)))
 int
 ohs_cmd_olsrd(const char *args)
 {
-  const char *olsrd_args[MAX_OLSRD_ARGS];
   struct in_addr iaddr;
 
   args += get_next_token(args, tok_buf, TOK_BUF_SIZE);
@@ -113,7 +173,6 @@ ohs_cmd_olsrd(const char *args)
 
   /* Start olsrd instance */
   if (!strncmp(tok_buf, "start", strlen("start"))) {
-    int argc = 0, i = 0;
 
     args += get_next_token(args, tok_buf, TOK_BUF_SIZE);
 
@@ -125,32 +184,8 @@ ohs_cmd_olsrd(const char *args)
       goto print_usage;
     }
 
-    olsrd_args[argc++] = olsrd_path;
-
-    if (1) {                    /* config file is set */
-      olsrd_args[argc++] = "-f";
-      olsrd_args[argc++] = "./olsrd.emu.conf";
-    }
-    olsrd_args[argc++] = "-hemu";
-    olsrd_args[argc++] = tok_buf;
-
-    olsrd_args[argc++] = "-d";
-    olsrd_args[argc++] = "0";
-    olsrd_args[argc++] = "-nofork";
-    olsrd_args[argc] = NULL;
-
-    printf("Executing: %s", olsrd_path);
-    for (i = 0; i < argc; i++)
-      printf(" %s", olsrd_args[i]);
-    printf("\n");
-
-    if (fork())
-      return 1;
-
-    if (execve(olsrd_path, (char *const *)olsrd_args, NULL) < 0) {
-      printf("Error executing olsrd: %s\n", strerror(errno));
-      exit(1);
-    }
+    ohs_start_olsrd(tok_buf);
+    return 1;
   }
   /* Stop olsrd instance */
   else if (!strncmp(tok_buf, "stop", strlen("stop"))) {
@@ -232,6 +267,20 @@ ohs_cmd_link(const char *args)
   if (!strlen(tok_buf)) {
     goto print_usage;
   }
+  if (!strncmp(tok_buf, "default", strlen("default"))) {
+    args += get_next_token(args, tok_buf, TOK_BUF_SIZE);
+
+    if (strlen(tok_buf)) {
+      qual = atoi(tok_buf);
+      if (qual < 0 || qual > 100) {
+        printf("Link quality out of range(0-100)\n");
+        return -1;
+      }
+      ohs_link_default = qual;
+    }
+    printf("Default link quality %d\n", ohs_link_default);
+    return 1;
+  }
   if (!strncmp(tok_buf, "bi", strlen("bi"))) {
     bi = 1;
     args += get_next_token(args, tok_buf, TOK_BUF_SIZE);
@@ -305,8 +354,8 @@ ohs_cmd_link(const char *args)
       if (src != dst) {
         my_link = get_link(src, &dst->ip_addr);
         inv_link = bi ? get_link(dst, &src->ip_addr) : NULL;
-        if (qual == 100) {
-          /* Remove link entry */
+        if (qual == ohs_link_default) {
+          /* Remove link entry, the default applies */
           if (my_link) {
             remove_link(src, my_link);
           }
@@ -316,7 +365,7 @@ ohs_cmd_link(const char *args)
         } else {
           if (!my_link) {
             /* Create new link */
-            my_link = add_link(src, dst);
+            my_link = add_link(src, &dst->ip_addr);
           }
 
           my_link->quality = qual;
@@ -324,12 +373,12 @@ ohs_cmd_link(const char *args)
           if (bi) {
             if (!inv_link) {
               /* Create new link */
-              inv_link = add_link(dst, src);
+              inv_link = add_link(dst, &src->ip_addr);
             }
             inv_link->quality = qual;
           }
         }
-        printf("%s %sdirectional link(s) %s %c=> %s quality %d\n", (qual == 100) ? "Removing" : "Setting", bi ? "bi" : "uni",
+        printf("%s %sdirectional link(s) %s %c=> %s quality %d\n", (qual == ohs_link_default) ? "Removing" : "Setting", bi ? "bi" : "uni",
                olsr_ip_to_string(&srcaddrstr, &src->ip_addr), bi ? '<' : '=', olsr_ip_to_string(&dstaddrstr, &dst->ip_addr), qual);
       }
       if (wildc_dst) {
@@ -344,10 +393,216 @@ ohs_cmd_link(const char *args)
 
   return 1;
 print_usage:
-  printf("link <bi> srcIP dstIP [0-100]");
+  printf("link <bi> srcIP dstIP [0-100]\nlink default [0-100]\n");
+  return -1;
+}
+
+static double
+ohs_seconds_since(const struct timeval *then)
+{
+  struct timeval now;
+
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - then->tv_sec) + (now.tv_usec - then->tv_usec) / 1e6;
+}
+
+int
+ohs_cmd_topology(const char *args)
+{
+  enum ohs_topology_type type;
+  union olsr_ip_addr first;
+  struct in_addr iaddr;
+  uint32_t i, count, max_degree = 0, connected = 0;
+  int param, links;
+  unsigned int seed;
+
+  args += get_next_token(args, tok_buf, TOK_BUF_SIZE);
+
+  if (!strlen(tok_buf) || !strncmp(tok_buf, "show", strlen("show"))) {
+    for (i = 0; i < ohs_topo.node_count; i++) {
+      if (ohs_topo.nodes[i].edge_count > max_degree)
+        max_degree = ohs_topo.nodes[i].edge_count;
+      if (get_client_by_addr(&ohs_topo.nodes[i].addr))
+        connected++;
+    }
+    printf("Topology: %u nodes (%u connected), %u links, average degree %.2f, max degree %u\n", ohs_topo.node_count, connected,
+           ohs_topo.edge_count, ohs_topo.node_count ? 2.0 * ohs_topo.edge_count / ohs_topo.node_count : 0.0, max_degree);
+    return 1;
+  }
+
+  if (!strncmp(tok_buf, "clear", strlen("clear"))) {
+    struct ohs_connection *oc;
+
+    ohs_topology_clear();
+    ohs_link_default = 100;
+    for (oc = ohs_conns; oc != NULL; oc = oc->next) {
+      ohs_delete_all_related_links(oc);
+      oc->links = NULL;
+      oc->linkcnt = 0;
+    }
+    printf("Topology cleared, all links open\n");
+    return 1;
+  }
+
+  if (!strncmp(tok_buf, "start", strlen("start"))) {
+#ifdef _WIN32
+    printf("olsrd command not available in windows version\nStart instances manually\n");
+    return 0;
+#else /* _WIN32 */
+    int started = 0;
+
+    for (i = 0; i < ohs_topo.node_count; i++) {
+      struct ipaddr_str addrstr;
+
+      if (get_client_by_addr(&ohs_topo.nodes[i].addr) || ohs_topo.nodes[i].pid > 0)
+        continue;
+      if (ohs_start_olsrd(olsr_ip_to_string(&addrstr, &ohs_topo.nodes[i].addr)) > 0)
+        started++;
+    }
+    printf("Started %d olsrd instances\n", started);
+    return 1;
+#endif /* _WIN32 */
+  }
+
+  if (!strncmp(tok_buf, "grid", strlen("grid")))
+    type = OHS_TOPO_GRID;
+  else if (!strncmp(tok_buf, "random", strlen("random")))
+    type = OHS_TOPO_RANDOM;
+  else if (!strncmp(tok_buf, "scalefree", strlen("scalefree")))
+    type = OHS_TOPO_SCALEFREE;
+  else
+    goto print_usage;
+
+  args += get_next_token(args, tok_buf, TOK_BUF_SIZE);
+  if (!strlen(tok_buf) || atoi(tok_buf) <= 0)
+    goto print_usage;
+  count = (uint32_t)atoi(tok_buf);
+
+  args += get_next_token(args, tok_buf, TOK_BUF_SIZE);
+  if (!strlen(tok_buf) || !inet_aton(tok_buf, &iaddr)) {
+    printf("Invalid IP %s\n", tok_buf);
+    goto print_usage;
+  }
+  memset(&first, 0, sizeof(first));
+  first.v4 = iaddr;
+
+  param = type == OHS_TOPO_SCALEFREE ? 2 : 6;
+  args += get_next_token(args, tok_buf, TOK_BUF_SIZE);
+  if (strlen(tok_buf))
+    param = atoi(tok_buf);
+
+  seed = 1;
+  args += get_next_token(args, tok_buf, TOK_BUF_SIZE);
+  if (strlen(tok_buf))
+    seed = (unsigned int)strtoul(tok_buf, NULL, 0);
+
+  links = ohs_topology_generate(type, count, &first, param, seed);
+  if (links < 0)
+    goto print_usage;
+
+  printf("Topology with %u nodes and %d links, average degree %.2f\n", count, links, 2.0 * links / count);
+  return 1;
+
+print_usage:
+  printf("Usage: topology [grid|random|scalefree] nodes firstIP [degree|m] [seed]\n       topology [show|start|clear]\n");
   return -1;
 }
 
+#ifdef __linux__
+/* cpu time (ms) and resident size (kB) of a process */
+static bool
+ohs_proc_usage(int pid, unsigned long *cpu_ms, unsigned long *rss_kb)
+{
+  char path[64], buf[1024], *p;
+  unsigned long utime, stime;
+  long rss;
+  FILE *f;
+  size_t len;
+
+  snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+  f = fopen(path, "r");
+  if (!f)
+    return false;
+  len = fread(buf, 1, sizeof(buf) - 1, f);
+  fclose(f);
+  buf[len] = 0;
+
+  /* the command name may contain anything, skip to its end */
+  p = strrchr(buf, ')');
+  if (!p || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu %*d %*d %*d %*d %*d %*d %*u %*u %ld", &utime,
+                   &stime, &rss) != 3)
+    return false;
+
+  *cpu_ms = (utime + stime) * 1000 / (unsigned long)sysconf(_SC_CLK_TCK);
+  *rss_kb = (unsigned long)rss * ((unsigned long)sysconf(_SC_PAGESIZE) / 1024);
+  return true;
+}
+#endif /* __linux__ */
+
+int
+ohs_cmd_stats(const char *args __attribute__ ((unused)))
+{
+  struct ohs_connection *oc;
+  uint64_t tx = 0, rx = 0, tx_bytes = 0, rx_bytes = 0;
+  uint32_t ansn_changes = 0;
+#ifdef __linux__
+  unsigned long cpu_total = 0, cpu_max = 0, rss_total = 0, rss_max = 0;
+  uint32_t procs = 0;
+#endif /* __linux__ */
+
+  for (oc = ohs_conns; oc != NULL; oc = oc->next) {
+    tx += oc->tx;
+    rx += oc->rx;
+    tx_bytes += oc->tx_bytes;
+    rx_bytes += oc->rx_bytes;
+    ansn_changes += oc->ansn_changes;
+#ifdef __linux__
+    {
+      unsigned long cpu_ms, rss_kb;
+
+      if (oc->pid > 0 && ohs_proc_usage(oc->pid, &cpu_ms, &rss_kb)) {
+        procs++;
+        cpu_total += cpu_ms;
+        rss_total += rss_kb;
+        if (cpu_ms > cpu_max)
+          cpu_max = cpu_ms;
+        if (rss_kb > rss_max)
+          rss_max = rss_kb;
+      }
+    }
+#endif /* __linux__ */
+  }
+
+  printf("Clients: %u\n", ohs_conn_count);
+  printf("Traffic: %llu packets / %llu bytes sent by clients, %llu packets / %llu bytes delivered\n", (unsigned long long)tx,
+         (unsigned long long)tx_bytes, (unsigned long long)rx, (unsigned long long)rx_bytes);
+
+  if (ohs_topo.node_count && ohs_conn_count) {
+    double age = ohs_seconds_since(&ohs_topo.created);
+
+    printf("Control traffic: %.1f bytes/s per node since the topology was set up %.1f s ago\n",
+           age > 0 ? tx_bytes / age / ohs_conn_count : 0.0, age);
+  }
+
+  printf("Topology changes: %u new ANSNs", ansn_changes);
+  if (ansn_changes) {
+    printf(", the last one %.1f s ago", ohs_seconds_since(&ohs_last_ansn_change));
+    if (ohs_topo.node_count && timercmp(&ohs_last_ansn_change, &ohs_topo.created, >)) {
+      printf(" (%.1f s after the topology was set up)",
+             ohs_seconds_since(&ohs_topo.created) - ohs_seconds_since(&ohs_last_ansn_change));
+    }
+  }
+  printf("\n");
+
+#ifdef __linux__
+  if (procs) {
+    printf("olsrd CPU: %lu ms total, %lu ms average, %lu ms max over %u processes\n", cpu_total, cpu_total / procs, cpu_max, procs);
+    printf("olsrd RSS: %lu kB average, %lu kB max\n", rss_total / procs, rss_max);
+  }
+#endif /* __linux__ */
+  return 1;
+}
+
 int
 ohs_cmd_list(const char *args)
 {
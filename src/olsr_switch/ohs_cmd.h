@@ -68,6 +68,10 @@ int ohs_cmd_log(const char *);
 
 int ohs_cmd_link(const char *);
 
+int ohs_cmd_topology(const char *);
+
+int ohs_cmd_stats(const char *);
+
 #endif /* _OHS_CMD */
 
 /*
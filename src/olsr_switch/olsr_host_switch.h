@@ -44,6 +44,8 @@
 
 #include "olsr_types.h"
 
+#include <sys/time.h>
+
 #define OHS_TCP_PORT 10150
 
 #define OHS_VERSION "0.1"
@@ -68,17 +70,31 @@ struct ohs_ip_link {
 struct ohs_connection {
   union olsr_ip_addr ip_addr;
   int socket;
+  int pid;                             /* olsrd started by us, 0 if unknown */
   uint32_t rx;
   uint32_t tx;
+  uint64_t rx_bytes;
+  uint64_t tx_bytes;
   uint32_t linkcnt;
   struct ohs_ip_link *links;
+  uint16_t ansn;                       /* last ANSN seen in a TC of this node */
+  bool ansn_valid;
+  uint32_t ansn_changes;
   struct ohs_connection *next;
+  struct ohs_connection *hash_next;
 };
 
+/* connections hashed by address */
+#define OHS_HASHSIZE 1024
+
 extern uint32_t logbits;
 
 extern struct ohs_connection *ohs_conns;
 
+extern uint32_t ohs_conn_count;
+
+extern struct timeval ohs_last_ansn_change;
+
 #define LOG_DEFAULT 0x0
 #define LOG_FORWARD 0x1
 #define LOG_CONNECT 0x2
@@ -0,0 +1,307 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2005, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Synthetic topologies for the host switch. A topology names a
+ * range of consecutive addresses and the links between them;
+ * once one is set up the switch only forwards along those links.
+ */
+
+#include "topology.h"
+#include "link_rules.h"
+#include "ipcalc.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <arpa/inet.h>
+
+struct ohs_topology ohs_topo;
+
+static void
+ohs_topology_add_half_edge(struct ohs_topology_node *node, uint32_t to)
+{
+  if (node->edge_count == node->edge_size) {
+    node->edge_size = node->edge_size ? node->edge_size * 2 : 4;
+    node->edges = realloc(node->edges, node->edge_size * sizeof(*node->edges));
+    if (!node->edges)
+      OHS_OUT_OF_MEMORY("Topology edges");
+  }
+  node->edges[node->edge_count++] = to;
+}
+
+static bool
+ohs_topology_has_edge(const struct ohs_topology_node *node, uint32_t to)
+{
+  uint32_t i;
+
+  for (i = 0; i < node->edge_count; i++) {
+    if (node->edges[i] == to) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void
+ohs_topology_add_edge(uint32_t a, uint32_t b)
+{
+  if (a == b || ohs_topology_has_edge(&ohs_topo.nodes[a], b)) {
+    return;
+  }
+  ohs_topology_add_half_edge(&ohs_topo.nodes[a], b);
+  ohs_topology_add_half_edge(&ohs_topo.nodes[b], a);
+  ohs_topo.edge_count++;
+}
+
+/* nodes on a square lattice, linked to their four neighbours */
+static void
+ohs_topology_grid(void)
+{
+  uint32_t side, i;
+
+  side = 1;
+  while (side * side < ohs_topo.node_count) {
+    side++;
+  }
+
+  for (i = 0; i < ohs_topo.node_count; i++) {
+    if ((i + 1) % side != 0 && i + 1 < ohs_topo.node_count) {
+      ohs_topology_add_edge(i, i + 1);
+    }
+    if (i + side < ohs_topo.node_count) {
+      ohs_topology_add_edge(i, i + side);
+    }
+  }
+}
+
+/*
+ * nodes placed at random in the unit square, linked when closer
+ * than the radius that gives the requested average degree
+ */
+static void
+ohs_topology_random(int degree)
+{
+  double *x, *y, r2;
+  uint32_t i, j;
+
+  x = malloc(ohs_topo.node_count * sizeof(*x));
+  y = malloc(ohs_topo.node_count * sizeof(*y));
+  if (!x || !y)
+    OHS_OUT_OF_MEMORY("Topology positions");
+
+  for (i = 0; i < ohs_topo.node_count; i++) {
+    x[i] = rand() / (RAND_MAX + 1.0);
+    y[i] = rand() / (RAND_MAX + 1.0);
+  }
+
+  r2 = degree / (3.14159265358979 * ohs_topo.node_count);
+
+  for (i = 0; i < ohs_topo.node_count; i++) {
+    for (j = i + 1; j < ohs_topo.node_count; j++) {
+      double dx = x[i] - x[j], dy = y[i] - y[j];
+
+      if (dx * dx + dy * dy < r2) {
+        ohs_topology_add_edge(i, j);
+      }
+    }
+  }
+
+  free(x);
+  free(y);
+}
+
+/*
+ * Barabasi-Albert preferential attachment: every new node links
+ * to m existing nodes, chosen with a probability proportional to
+ * their degree by picking random edge endpoints
+ */
+static void
+ohs_topology_scalefree(int m)
+{
+  uint32_t *ends, ends_used = 0, i, j;
+
+  ends = malloc(2 * (size_t)m * ohs_topo.node_count * sizeof(*ends));
+  if (!ends)
+    OHS_OUT_OF_MEMORY("Topology endpoints");
+
+  /* fully linked seed */
+  for (i = 0; i <= (uint32_t)m && i < ohs_topo.node_count; i++) {
+    for (j = 0; j < i; j++) {
+      ohs_topology_add_edge(i, j);
+      ends[ends_used++] = i;
+      ends[ends_used++] = j;
+    }
+  }
+
+  for (; i < ohs_topo.node_count; i++) {
+    uint32_t linked = 0;
+
+    while (linked < (uint32_t)m) {
+      uint32_t to = ends[(uint32_t)(rand() / (RAND_MAX + 1.0) * ends_used)];
+
+      if (ohs_topology_has_edge(&ohs_topo.nodes[i], to)) {
+        continue;
+      }
+      ohs_topology_add_edge(i, to);
+      ends[ends_used++] = i;
+      ends[ends_used++] = to;
+      linked++;
+    }
+  }
+
+  free(ends);
+}
+
+void
+ohs_topology_clear(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < ohs_topo.node_count; i++) {
+    free(ohs_topo.nodes[i].edges);
+  }
+  free(ohs_topo.nodes);
+  memset(&ohs_topo, 0, sizeof(ohs_topo));
+}
+
+/**
+ * Replace the current topology by a generated one and apply it
+ * to all connected clients. Links outside the topology are closed.
+ *
+ * @param type the kind of graph
+ * @param count number of nodes
+ * @param first address of the first node, the others follow it
+ * @param param average degree (random) or links per new node (scalefree)
+ * @param seed seed for the random generator
+ * @return number of links, -1 on error
+ */
+int
+ohs_topology_generate(enum ohs_topology_type type, uint32_t count, const union olsr_ip_addr *first, int param,
+                      unsigned int seed)
+{
+  struct ohs_connection *oc;
+  uint32_t i;
+
+  if (count == 0 || param < 1) {
+    return -1;
+  }
+
+  ohs_topology_clear();
+
+  ohs_topo.nodes = calloc(count, sizeof(*ohs_topo.nodes));
+  if (!ohs_topo.nodes)
+    OHS_OUT_OF_MEMORY("Topology nodes");
+
+  ohs_topo.node_count = count;
+  ohs_topo.first = ntohl(first->v4.s_addr);
+  for (i = 0; i < count; i++) {
+    ohs_topo.nodes[i].addr.v4.s_addr = htonl(ohs_topo.first + i);
+  }
+
+  srand(seed);
+
+  switch (type) {
+  case OHS_TOPO_GRID:
+    ohs_topology_grid();
+    break;
+  case OHS_TOPO_RANDOM:
+    ohs_topology_random(param);
+    break;
+  case OHS_TOPO_SCALEFREE:
+  default:
+    ohs_topology_scalefree(param);
+    break;
+  }
+
+  gettimeofday(&ohs_topo.created, NULL);
+
+  /* the topology replaces all link rules */
+  ohs_link_default = 0;
+  for (oc = ohs_conns; oc != NULL; oc = oc->next) {
+    ohs_delete_all_related_links(oc);
+    oc->links = NULL;
+    oc->linkcnt = 0;
+    ohs_topology_attach(oc);
+  }
+
+  return (int)ohs_topo.edge_count;
+}
+
+struct ohs_topology_node *
+ohs_topology_lookup(const union olsr_ip_addr *addr)
+{
+  uint32_t idx = ntohl(addr->v4.s_addr) - ohs_topo.first;
+
+  return idx < ohs_topo.node_count ? &ohs_topo.nodes[idx] : NULL;
+}
+
+/**
+ * Install the links of a topology node on its connection.
+ *
+ * @param oc the newly connected client
+ */
+void
+ohs_topology_attach(struct ohs_connection *oc)
+{
+  struct ohs_topology_node *node = ohs_topology_lookup(&oc->ip_addr);
+  uint32_t i;
+
+  if (!node) {
+    return;
+  }
+
+  oc->pid = node->pid;
+  for (i = 0; i < node->edge_count; i++) {
+    const union olsr_ip_addr *dst = &ohs_topo.nodes[node->edges[i]].addr;
+
+    if (!get_link(oc, dst)) {
+      add_link(oc, dst)->quality = 100;
+    }
+  }
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,89 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon(olsrd)
+ * Copyright (c) 2005, Andreas Tonnesen(andreto@olsr.org)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _OLSR_SWITCH_TOPOLOGY
+#define _OLSR_SWITCH_TOPOLOGY
+
+#include "olsr_types.h"
+#include "olsr_host_switch.h"
+
+#include <sys/time.h>
+
+enum ohs_topology_type {
+  OHS_TOPO_GRID,
+  OHS_TOPO_RANDOM,
+  OHS_TOPO_SCALEFREE
+};
+
+struct ohs_topology_node {
+  union olsr_ip_addr addr;
+  int pid;                             /* olsrd started for this node */
+  uint32_t edge_count;
+  uint32_t edge_size;
+  uint32_t *edges;                     /* indices of the neighbours */
+};
+
+struct ohs_topology {
+  uint32_t node_count;
+  uint32_t edge_count;
+  uint32_t first;                      /* first address, host byte order */
+  struct ohs_topology_node *nodes;
+  struct timeval created;
+};
+
+extern struct ohs_topology ohs_topo;
+
+int ohs_topology_generate(enum ohs_topology_type, uint32_t, const union olsr_ip_addr *, int, unsigned int);
+
+void ohs_topology_clear(void);
+
+struct ohs_topology_node *ohs_topology_lookup(const union olsr_ip_addr *);
+
+void ohs_topology_attach(struct ohs_connection *);
+
+#endif /* _OLSR_SWITCH_TOPOLOGY */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
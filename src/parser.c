@@ -53,6 +53,9 @@
 #include "log.h"
 #include "net_olsr.h"
 #include "duplicate_handler.h"
+#include "common/scratch.h"
+#include "olsr_profile.h"
+#include "olsr_admit.h"
 
 #ifdef _WIN32
 #undef EWOULDBLOCK
@@ -64,14 +67,6 @@ char *StrError(unsigned int ErrNo);
 #define strerror(x) StrError(x)
 #endif /* _WIN32 */
 
-    /* Sven-Ola: On very slow devices used in huge networks
- * the amount of lq_tc messages is so high, that the
- * recv() loop never ends. This is a small hack to end
- * the loop in this cases
- */
-
-unsigned int cpu_overload_exit = 0;
-
 struct parse_function_entry *parse_functions;
 struct preprocessor_function_entry *preprocessor_functions;
 struct packetparser_function_entry *packetparser_functions;
@@ -79,6 +74,12 @@ struct packetparser_function_entry *packetparser_functions;
 static uint32_t inbuf_aligned[MAXMESSAGESIZE/sizeof(uint32_t) + 1];
 static char *inbuf = (char *)inbuf_aligned;
 
+/* initial size of the arena for deserialized messages, grows on demand */
+#define PARSER_SCRATCH_SIZE 4096
+
+/* memory for deserialized messages, released for every received packet */
+static struct scratch_arena parser_scratch;
+
 /**
  *Initialize the parser.
  *
@@ -89,6 +90,8 @@ olsr_init_parser(void)
 {
   OLSR_PRINTF(3, "Initializing parser...\n");
 
+  scratch_init(&parser_scratch, PARSER_SCRATCH_SIZE);
+
   /* Initialize the packet functions */
   olsr_init_package_process();
 
@@ -112,6 +115,21 @@ olsr_destroy_parser(void) {
     pae_next = pae->next;
     free(pae);
   }
+  scratch_free(&parser_scratch);
+}
+
+/**
+ * Allocate memory for deserializing a message. The memory is not
+ * cleared and stays valid until the next packet is parsed, so message
+ * handlers must copy whatever they want to keep.
+ *
+ * @param size the number of bytes
+ * @return pointer to the memory
+ */
+void *
+olsr_parser_alloc(size_t size)
+{
+  return scratch_alloc(&parser_scratch, size);
 }
 
 void
@@ -270,6 +288,9 @@ parse_packet(struct olsr *olsr, int size, struct interface *in_if, union olsr_ip
   struct parse_function_entry *entry;
   struct packetparser_function_entry *packetparser;
 
+  /* the messages of the previous packet are done with */
+  scratch_reset(&parser_scratch);
+
   count = size - ((char *)m - (char *)olsr);
 
   /* minimum packet size is 4 */
@@ -312,6 +333,7 @@ parse_packet(struct olsr *olsr, int size, struct interface *in_if, union olsr_ip
   for (; count > 0; m = (union olsr_message *)((char *)m + (msgsize))) {
     bool forward = true;
     bool validated;
+    uint64_t parse_start;
 
     /* minimum message size is 8 + ipsize */
     if (count < 8 + olsr_cnf->ipsize)
@@ -389,6 +411,12 @@ parse_packet(struct olsr *olsr, int size, struct interface *in_if, union olsr_ip
       continue;
     }
 
+    /* cheap checks against flooding before the real work */
+    if (!olsr_admit_message(m, from_addr)) {
+      continue;
+    }
+
+    parse_start = olsr_prof_clock();
     entry = parse_functions;
     while (entry) {
       /* Should be the same for IPv4 and IPv6 */
@@ -400,6 +428,7 @@ parse_packet(struct olsr *olsr, int size, struct interface *in_if, union olsr_ip
       }
       entry = entry->next;
     }
+    olsr_prof_message(m->v4.olsr_msgtype, olsr_prof_clock() - parse_start);
 
     if (forward) {
       olsr_forward_message(m, in_if, from_addr);
@@ -407,6 +436,77 @@ parse_packet(struct olsr *olsr, int size, struct interface *in_if, union olsr_ip
   }                             /* for olsr_msg */
 }
 
+/**
+ * Pass a packet read from an interface socket through
+ * the preprocessors to parse_packet().
+ *
+ *@param fd the socket the packet was read from
+ *@param packet the packet
+ *@param cc the length of the packet
+ *@param from the sender
+ *@param fromlen the length of the sender address
+ *@return false if the packet was not accepted and the
+ * socket should not be read any further for now
+ */
+bool
+olsr_input_packet(int fd, char *packet, int cc, const struct sockaddr_storage *from, socklen_t fromlen)
+{
+  struct interface *olsr_in_if;
+  union olsr_ip_addr from_addr;
+  struct preprocessor_function_entry *entry;
+  struct ipaddr_str buf;
+
+  if (olsr_cnf->ip_version == AF_INET) {
+    /* IPv4 sender address */
+    const void * src = &((const struct sockaddr_in *)from)->sin_addr;
+    memcpy(&from_addr.v4, src, sizeof(from_addr.v4));
+  } else {
+    /* IPv6 sender address */
+    const void * src = &((const struct sockaddr_in6 *)from)->sin6_addr;
+    memcpy(&from_addr.v6, src, sizeof(from_addr.v6));
+  }
+
+#ifdef DEBUG
+  OLSR_PRINTF(5, "Received a packet from %s\n",
+      olsr_ip_to_string(&buf, &from_addr));
+#endif /* DEBUG */
+
+  if ((olsr_cnf->ip_version == AF_INET) && (fromlen != sizeof(struct sockaddr_in)))
+    return false;
+  else if ((olsr_cnf->ip_version == AF_INET6) && (fromlen != sizeof(struct sockaddr_in6)))
+    return false;
+
+  /* are we talking to ourselves? */
+  if (if_ifwithaddr(&from_addr) != NULL)
+    return false;
+
+  if ((olsr_in_if = if_ifwithsock(fd)) == NULL) {
+    OLSR_PRINTF(1, "Could not find input interface for message from %s size %d\n", olsr_ip_to_string(&buf, &from_addr), cc);
+    olsr_syslog(OLSR_LOG_ERR, "Could not find input interface for message from %s size %d\n", olsr_ip_to_string(&buf, &from_addr),
+                cc);
+    return false;
+  }
+  // call preprocessors
+  entry = preprocessor_functions;
+
+  while (entry) {
+    packet = entry->function(packet, olsr_in_if, &from_addr, &cc);
+    // discard package ?
+    if (packet == NULL) {
+      return false;
+    }
+    entry = entry->next;
+  }
+
+  /*
+   * &from - sender
+   * &inbuf.olsr
+   * cc - bytes read
+   */
+  parse_packet((struct olsr *)packet, cc, olsr_in_if, &from_addr);
+  return true;
+}
+
 /**
  *Processing OLSR data from socket. Reading data, setting
  *wich interface received the message, Sends IPC(if used)
@@ -419,21 +519,15 @@ parse_packet(struct olsr *olsr, int size, struct interface *in_if, union olsr_ip
 void
 olsr_input(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
 {
-  struct interface *olsr_in_if;
-  union olsr_ip_addr from_addr;
-  struct preprocessor_function_entry *entry;
-  char *packet;
-
-  cpu_overload_exit = 0;
+  uint64_t start = olsr_prof_clock();
 
   for (;;) {
-    struct ipaddr_str buf;
     /* sockaddr_in6 is bigger than sockaddr !!!! */
     struct sockaddr_storage from;
     socklen_t fromlen;
     int cc;
 
-    if (32 < ++cpu_overload_exit) {
+    if (olsr_prof_clock() - start > OLSR_INPUT_TIME_BUDGET) {
       OLSR_PRINTF(1, "CPU overload detected, ending olsr_input() loop\n");
       break;
     }
@@ -450,56 +544,10 @@ olsr_input(int fd, void *data __attribute__ ((unused)), unsigned int flags __att
       }
       break;
     }
-    if (olsr_cnf->ip_version == AF_INET) {
-      /* IPv4 sender address */
-      void * src = &((struct sockaddr_in *)&from)->sin_addr;
-      memcpy(&from_addr.v4, src, sizeof(from_addr.v4));
-    } else {
-      /* IPv6 sender address */
-      void * src = &((struct sockaddr_in6 *)&from)->sin6_addr;
-      memcpy(&from_addr.v6, src, sizeof(from_addr.v6));
-    }
-
-#ifdef DEBUG
-    OLSR_PRINTF(5, "Received a packet from %s\n",
-        olsr_ip_to_string(&buf, &from_addr));
-#endif /* DEBUG */
 
-    if ((olsr_cnf->ip_version == AF_INET) && (fromlen != sizeof(struct sockaddr_in)))
-      break;
-    else if ((olsr_cnf->ip_version == AF_INET6) && (fromlen != sizeof(struct sockaddr_in6)))
+    if (!olsr_input_packet(fd, inbuf, cc, &from, fromlen)) {
       break;
-
-    /* are we talking to ourselves? */
-    if (if_ifwithaddr(&from_addr) != NULL)
-      return;
-
-    if ((olsr_in_if = if_ifwithsock(fd)) == NULL) {
-      OLSR_PRINTF(1, "Could not find input interface for message from %s size %d\n", olsr_ip_to_string(&buf, &from_addr), cc);
-      olsr_syslog(OLSR_LOG_ERR, "Could not find input interface for message from %s size %d\n", olsr_ip_to_string(&buf, &from_addr),
-                  cc);
-      return;
-    }
-    // call preprocessors
-    entry = preprocessor_functions;
-    packet = &inbuf[0];
-
-    while (entry) {
-      packet = entry->function(packet, olsr_in_if, &from_addr, &cc);
-      // discard package ?
-      if (packet == NULL) {
-        return;
-      }
-      entry = entry->next;
     }
-
-    /*
-     * &from - sender
-     * &inbuf.olsr
-     * cc - bytes read
-     */
-    parse_packet((struct olsr *)packet, cc, olsr_in_if, &from_addr);
-
   }
 }
 
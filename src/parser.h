@@ -47,6 +47,16 @@
 
 #define PROMISCUOUS 0xffffffff
 
+/*
+ * On very slow devices used in huge networks the amount of
+ * lq_tc messages is so high, that the recv() loop never ends.
+ * olsr_input() and rx_drain() stop reading after this much time
+ * and leave the rest to the next round. Packets which are dropped
+ * by the admission control cost next to nothing, so many more of
+ * them fit in.
+ */
+#define OLSR_INPUT_TIME_BUDGET (20 * 1000 * 1000)
+
 /* Function returns false if the message should not be forwarded */
 typedef bool parse_function(union olsr_message *, struct interface *, union olsr_ip_addr *);
 
@@ -74,6 +84,10 @@ void olsr_init_parser(void);
 
 void olsr_destroy_parser(void);
 
+void *olsr_parser_alloc(size_t);
+
+bool olsr_input_packet(int, char *, int, const struct sockaddr_storage *, socklen_t);
+
 void olsr_input(int fd, void *, unsigned int);
 
 void olsr_input_hostemu(int fd, void *, unsigned int);
@@ -47,6 +47,7 @@
 #include "two_hop_neighbor_table.h"
 #include "tc_set.h"
 #include "mpr_selector_set.h"
+#include "mpr.h"
 #include "mid_set.h"
 #include "olsr.h"
 #include "parser.h"
@@ -133,7 +134,6 @@ process_message_neighbors(struct neighbor_entry *neighbor, const struct hello_me
       } else {
         two_hop_neighbor = olsr_lookup_two_hop_neighbor_table(&message_neighbors->address);
         if (two_hop_neighbor == NULL) {
-          changes_neighborhood = true;
           changes_topology = true;
 
           two_hop_neighbor = olsr_malloc(sizeof(struct neighbor_2_entry), "Process HELLO");
@@ -149,14 +149,15 @@ process_message_neighbors(struct neighbor_entry *neighbor, const struct hello_me
           olsr_insert_two_hop_neighbor_table(two_hop_neighbor);
 
           linking_this_2_entries(neighbor, two_hop_neighbor, message->vtime);
+          olsr_mpr_touch_two_hop(two_hop_neighbor);
         } else {
           /*
              linking to this two_hop_neighbor entry
            */
-          changes_neighborhood = true;
           changes_topology = true;
 
           linking_this_2_entries(neighbor, two_hop_neighbor, message->vtime);
+          olsr_mpr_touch_two_hop(two_hop_neighbor);
         }
       }
     }
@@ -169,8 +170,11 @@ process_message_neighbors(struct neighbor_entry *neighbor, const struct hello_me
     olsr_linkcost first_hop_pathcost;
     struct link_entry *lnk = get_best_link_to_neighbor(&neighbor->neighbor_main_addr);
 
-    if (!lnk)
+    if (!lnk) {
+      /* the path costs were reset above */
+      olsr_mpr_touch_neighbor(neighbor);
       return;
+    }
 
     /* calculate first hop path quality */
     first_hop_pathcost = lnk->linkcost;
@@ -228,11 +232,15 @@ process_message_neighbors(struct neighbor_entry *neighbor, const struct hello_me
             if (new_path_linkcost < walker->path_linkcost) {
               walker->second_hop_linkcost = new_second_hop_linkcost;
               walker->path_linkcost = new_path_linkcost;
+              changes_topology = true;
 
-              walker->saved_path_linkcost = new_path_linkcost;
+              // the path cost was reset in the first pass, so only
+              // a different value than last time matters for the MPRs
+              if (new_path_linkcost != walker->saved_path_linkcost) {
+                walker->saved_path_linkcost = new_path_linkcost;
 
-              changes_neighborhood = true;
-              changes_topology = true;
+                olsr_mpr_touch_two_hop(two_hop_neighbor);
+              }
             }
           }
         }
@@ -352,7 +360,7 @@ deserialize_hello(struct hello_message *hello, const void *ser)
 
     limit2 += size2;
     while (curr < limit2) {
-      struct hello_neighbor *neigh = olsr_malloc_hello_neighbor("HELLO deserialization");
+      struct hello_neighbor *neigh = olsr_parser_alloc_hello_neighbor();
       pkt_get_ipaddress(&curr, &neigh->address);
       if (type == LQ_HELLO_MESSAGE) {
         olsr_deserialize_hello_lq_pair(&curr, neigh);
@@ -485,7 +493,7 @@ olsr_hello_tap(struct hello_message *message, struct interface *in_if, const uni
      *If willingness changed - recalculate
      */
     neighbor->willingness = message->willingness;
-    changes_neighborhood = true;
+    olsr_mpr_touch_neighbor(neighbor);
     changes_topology = true;
   }
 
@@ -496,8 +504,7 @@ olsr_hello_tap(struct hello_message *message, struct interface *in_if, const uni
   /* Process changes immedeatly in case of MPR updates */
   olsr_process_changes();
 
-  olsr_free_hello_packet(message);
-
+  /* the neighbors live in the parser arena, nothing to free */
   return;
 }
 
@@ -53,6 +53,7 @@
 #include "tc_set.h"
 #include "olsr_cookie.h"
 #include "olsr_niit.h"
+#include "olsr_profile.h"
 
 #ifdef _WIN32
 char *StrError(unsigned int ErrNo);
@@ -339,7 +340,7 @@ olsr_update_rib_routes(void)
   
       if (olsr_delete_kernel_route(rt) == 0) {
         /*only remove if deletion was successful*/
-        avl_delete(&routingtree, &rt->rt_tree_node);
+        olsr_unlink_rt_entry(rt);
         olsr_cookie_free(rt_mem_cookie, rt);
       }
 
@@ -395,7 +396,7 @@ olsr_delete_interface_routes(int if_index) {
     if (mightTrigger) {
       if (!rt->rt_path_tree.count) {
         /* oops, all routes are gone - flush the route head */
-        avl_delete(&routingtree, rt_tree_node);
+        olsr_unlink_rt_entry(rt);
 
         /* do not dequeue route because they are already gone */
       }
@@ -416,8 +417,11 @@ olsr_delete_interface_routes(int if_index) {
 void
 olsr_update_kernel_routes(void)
 {
+  uint64_t start = olsr_prof_clock();
+
   /* route changes */
   olsr_chg_kernel_routes(&chg_kernel_list);
+  olsr_hist_record(&olsr_prof[OLSR_PROF_KERNEL], olsr_prof_clock() - start);
 
 #if defined DEBUG && DEBUG
   olsr_print_routing_table(&routingtree);
@@ -71,6 +71,9 @@ static struct rt_path *current_inetgw = NULL;
 /* Root of our RIB */
 struct avl_tree routingtree;
 
+/* Longest prefix match index over the RIB */
+struct ptrie routingtrie;
+
 /*
  * Keep a version number for detecting outdated elements
  * in the per rt_entry rt_path subtree.
@@ -171,6 +174,7 @@ olsr_init_routing_table(void)
 
   /* the routing tree */
   avl_init(&routingtree, avl_comp_prefix_default);
+  ptrie_init(&routingtrie);
   routingtree_version = 0;
 
   /*
@@ -205,6 +209,36 @@ olsr_lookup_routing_table(const union olsr_ip_addr *dst)
   return rt_tree_node ? rt_tree2rt(rt_tree_node) : NULL;
 }
 
+/**
+ * Look up the most specific route entry covering an address.
+ *
+ * @param dst the address to look up
+ *
+ * @return a pointer to the rt_entry struct with the
+ * longest matching prefix, NULL if there is no route.
+ */
+struct rt_entry *
+olsr_lookup_routing_table_best(const union olsr_ip_addr *dst)
+{
+  struct olsr_ip_prefix prefix;
+
+  prefix.prefix = *dst;
+  prefix.prefix_len = olsr_cnf->maxplen;
+
+  return rt_trie2rt(ptrie_find_longest(&routingtrie, &prefix));
+}
+
+/**
+ * Unlink a route entry from the RIB tree and its
+ * longest prefix match index.
+ */
+void
+olsr_unlink_rt_entry(struct rt_entry *rt)
+{
+  avl_delete(&routingtree, &rt->rt_tree_node);
+  ptrie_delete(&routingtrie, &rt->rt_trie_node);
+}
+
 /**
  * Update gateway/interface/etx/hopcount and the version for a route path.
  */
@@ -245,6 +279,13 @@ olsr_alloc_rt_entry(struct olsr_ip_prefix *prefix)
   rt->rt_dst = *prefix;
 
   rt->rt_tree_node.key = &rt->rt_dst;
+  rt->rt_trie_node.key = &rt->rt_dst;
+
+  /* both indexes must agree, the prefix is masked by the caller */
+  if (ptrie_insert(&routingtrie, &rt->rt_trie_node, PTRIE_DUP_NO) < 0) {
+    olsr_cookie_free(rt_mem_cookie, rt);
+    return NULL;
+  }
   avl_insert(&routingtree, &rt->rt_tree_node, AVL_DUP_NO);
 
   /* init the originator subtree */
@@ -327,11 +368,12 @@ olsr_insert_rt_path(struct rt_path *rtp, struct tc_entry *tc, struct link_entry
     rt = rt_tree2rt(node);
   }
 
-  /* Now insert the rt_path to the owning rt_entry tree */
-  rtp->rtp_originator = tc->addr;
-
-  /* set key and backpointer prior to tree insertion */
-  rtp->rtp_tree_node.key = &rtp->rtp_originator;
+  /*
+   * Now insert the rt_path to the owning rt_entry tree.
+   * The originator is the tc entry the rt_path holds a reference on,
+   * so its address is used as key instead of a copy.
+   */
+  rtp->rtp_tree_node.key = &rtp->rtp_tc->addr;
 
   /* insert to the route entry originator tree */
   avl_insert(&rt->rt_path_tree, &rtp->rtp_tree_node, AVL_DUP_NO);
@@ -459,7 +501,7 @@ olsr_cmp_rtp(const struct rt_path *rtp1, const struct rt_path *rtp2, const struc
   }
 
   /* originator (which is guaranteed to be unique) is final tie breaker */
-  if (memcmp(&rtp1->rtp_originator, &rtp2->rtp_originator, olsr_cnf->ipsize) < 0) {
+  if (memcmp(&rtp1->rtp_tc->addr, &rtp2->rtp_tc->addr, olsr_cnf->ipsize) < 0) {
     return true;
   }
 
@@ -551,6 +593,7 @@ olsr_insert_routing_table(union olsr_ip_addr *dst, int plen, union olsr_ip_addr
    */
   prefix.prefix = *dst;
   prefix.prefix_len = plen;
+  ip_prefix_mask(&prefix);
 
   node = avl_find(&tc->prefix_tree, &prefix);
 
@@ -609,6 +652,7 @@ olsr_delete_routing_table(union olsr_ip_addr *dst, int plen, union olsr_ip_addr
    */
   prefix.prefix = *dst;
   prefix.prefix_len = plen;
+  ip_prefix_mask(&prefix);
 
   node = avl_find(&tc->prefix_tree, &prefix);
 
@@ -654,7 +698,7 @@ olsr_rtp_to_string(const struct rt_path *rtp)
 
   snprintf(buff, sizeof(buff), "%s/%u from %s via %s, " "cost %s, metric %u, v %u",
            olsr_ip_to_string(&prefixstr, &rt->rt_dst.prefix), rt->rt_dst.prefix_len, olsr_ip_to_string(&origstr,
-                                                                                                       &rtp->rtp_originator),
+                                                                                                       &rtp->rtp_tc->addr),
            olsr_ip_to_string(&gwstr, &rtp->rtp_nexthop.gateway), get_linkcost_text(rtp->rtp_metric.cost, true, &lqbuffer),
            rtp->rtp_metric.hops, rtp->rtp_version);
 
@@ -682,12 +726,12 @@ olsr_print_routing_table(struct avl_tree *tree)
 
     /* first the route entry */
     OLSR_PRINTF(6, "%s/%u, via %s, best-originator %s\n", olsr_ip_to_string(&prefixstr, &rt->rt_dst.prefix), rt->rt_dst.prefix_len,
-                olsr_ip_to_string(&origstr, &rt->rt_nexthop.gateway), olsr_ip_to_string(&gwstr, &rt->rt_best->rtp_originator));
+                olsr_ip_to_string(&origstr, &rt->rt_nexthop.gateway), olsr_ip_to_string(&gwstr, &rt->rt_best->rtp_tc->addr));
 
     /* walk the per-originator path tree of routes */
     for (rtp_tree_node = avl_walk_first(&rt->rt_path_tree); rtp_tree_node != NULL; rtp_tree_node = avl_walk_next(rtp_tree_node)) {
       struct rt_path *rtp = rtp_tree2rtp(rtp_tree_node);
-      OLSR_PRINTF(6, "\tfrom %s, cost %s, metric %u, via %s, %s, v %u\n", olsr_ip_to_string(&origstr, &rtp->rtp_originator),
+      OLSR_PRINTF(6, "\tfrom %s, cost %s, metric %u, via %s, %s, v %u\n", olsr_ip_to_string(&origstr, &rtp->rtp_tc->addr),
                   get_linkcost_text(rtp->rtp_metric.cost, true, &lqbuffer), rtp->rtp_metric.hops, olsr_ip_to_string(&gwstr,
                                                                                                                     &rtp->
                                                                                                                     rtp_nexthop.
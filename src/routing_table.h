@@ -53,6 +53,7 @@
 #include "olsr_cookie.h"
 #include "common/avl.h"
 #include "common/list.h"
+#include "common/ptrie.h"
 
 #define NETMASK_HOST 0xffffffff
 #define NETMASK_DEFAULT 0x0
@@ -85,6 +86,7 @@ struct rt_nexthop {
 struct rt_entry {
   struct olsr_ip_prefix rt_dst;
   struct avl_node rt_tree_node;
+  struct ptrie_node rt_trie_node;      /* longest prefix match index */
   struct rt_path *rt_best;             /* shortcut to the best path */
   struct rt_nexthop rt_nexthop;        /* nexthop of FIB route */
   struct rt_metric rt_metric;          /* metric of FIB route */
@@ -93,6 +95,7 @@ struct rt_entry {
 };
 
 AVLNODE2STRUCT(rt_tree2rt, struct rt_entry, rt_tree_node);
+PTRIENODE2STRUCT(rt_trie2rt, struct rt_entry, rt_trie_node);
 LISTNODE2STRUCT(changelist2rt, struct rt_entry, rt_change_node);
 
 /*
@@ -108,8 +111,7 @@ struct rt_path {
   struct tc_entry *rtp_tc;             /* backpointer to owning tc entry */
   struct rt_nexthop rtp_nexthop;
   struct rt_metric rtp_metric;
-  struct avl_node rtp_tree_node;       /* global rtp node */
-  union olsr_ip_addr rtp_originator;   /* originator of the route */
+  struct avl_node rtp_tree_node;       /* global rtp node, keyed by rtp_tc->addr */
   struct avl_node rtp_prefix_tree_node; /* tc entry rtp node */
   struct olsr_ip_prefix rtp_dst;       /* the prefix */
   uint32_t rtp_version;                /* for detection of outdated rt_paths */
@@ -176,6 +178,22 @@ enum olsr_rt_origin {
       continue;
 #define OLSR_FOR_ALL_HNA_RT_ENTRIES_END(rt) }}
 
+/*
+ * OLSR_FOR_ALL_RT_ENTRIES_COVERED
+ *
+ * macro for traversing all route entries whose prefix is covered
+ * by the given prefix (including the prefix itself), without
+ * walking the entire routing table.
+ *
+ * the routing table must not be modified inside the loop.
+ */
+#define OLSR_FOR_ALL_RT_ENTRIES_COVERED(prefix, rt) \
+{ \
+  struct ptrie_node *rt_trie_node; \
+  OLSR_FOR_ALL_PTRIE_COVERED(&routingtrie, prefix, rt_trie_node) { \
+    rt = rt_trie2rt(rt_trie_node);
+#define OLSR_FOR_ALL_RT_ENTRIES_COVERED_END(rt) }}
+
 /**
  * IPv4 <-> IPv6 wrapper
  */
@@ -194,6 +212,7 @@ union olsr_kernel_route {
 };
 
 extern struct avl_tree routingtree;
+extern struct ptrie routingtrie;
 extern unsigned int routingtree_version;
 extern struct olsr_cookie_info *rt_mem_cookie;
 
@@ -228,6 +247,8 @@ void olsr_update_rt_path(struct rt_path *, struct tc_entry *, struct link_entry
 void olsr_delete_rt_path(struct rt_path *);
 
 struct rt_entry *olsr_lookup_routing_table(const union olsr_ip_addr *);
+struct rt_entry *olsr_lookup_routing_table_best(const union olsr_ip_addr *);
+void olsr_unlink_rt_entry(struct rt_entry *);
 
 #endif /* _OLSR_ROUTING_TABLE */
 
@@ -271,6 +271,28 @@ olsr_flush_sockets(void)
   } OLSR_FOR_ALL_SOCKETS_END(entry);
 }
 
+/**
+ * Pass the handler run times of all sockets to a callback.
+ *
+ * @param cb the callback
+ * @param ctx passed to the callback
+ */
+void
+olsr_walk_socket_profiles(olsr_prof_walk_cb cb, void *ctx)
+{
+  struct olsr_socket_entry *entry;
+  char name[16];
+
+  OLSR_FOR_ALL_SOCKETS(entry) {
+    if (entry->process_immediate == NULL && entry->process_pollrate == NULL) {
+      continue;
+    }
+    snprintf(name, sizeof(name), "fd %d", entry->fd);
+    cb(ctx, OLSR_PROF_GROUP_SOCKET, name, &entry->prof);
+  }
+  OLSR_FOR_ALL_SOCKETS_END(entry);
+}
+
 static void
 poll_sockets(void)
 {
@@ -337,7 +359,10 @@ poll_sockets(void)
       flags |= SP_PR_WRITE;
     }
     if (flags != 0) {
+      uint64_t start = olsr_prof_clock();
+
       entry->process_pollrate(entry->fd, entry->data, flags);
+      olsr_hist_record(&entry->prof, olsr_prof_clock() - start);
     }
   }
   OLSR_FOR_ALL_SOCKETS_END(entry);
@@ -426,7 +451,10 @@ handle_fds(uint32_t next_interval)
         flags |= SP_IMM_WRITE;
       }
       if (flags != 0) {
+        uint64_t start = olsr_prof_clock();
+
         entry->process_immediate(entry->fd, entry->data, flags);
+        olsr_hist_record(&entry->prof, olsr_prof_clock() - start);
       }
     }
     OLSR_FOR_ALL_SOCKETS_END(entry);
@@ -463,11 +491,20 @@ handle_fds(uint32_t next_interval)
 void __attribute__ ((noreturn))
 olsr_scheduler(void)
 {
+  uint64_t tick_due = 0;
+
   OLSR_PRINTF(1, "Scheduler started - polling every %d ms\n", (int)(olsr_cnf->pollrate*1000));
 
   /* Main scheduler loop */
   while (true) {
     uint32_t next_interval;
+    uint64_t tick_start = olsr_prof_clock();
+
+    /* how late are we for this tick? */
+    if (tick_due) {
+      olsr_hist_record(&olsr_prof[OLSR_PROF_TICK_LAG], tick_start > tick_due ? tick_start - tick_due : 0);
+    }
+    tick_due = tick_start + (uint64_t)(olsr_cnf->pollrate * 1000000000);
 
     /*
      * Update the global timestamp. We are using a non-wallclock timer here
@@ -491,6 +528,7 @@ olsr_scheduler(void)
       OLSR_PRINTF(3, "ANSN UPDATED %d\n\n", get_local_ansn());
       link_changes = false;
     }
+    olsr_hist_record(&olsr_prof[OLSR_PROF_TICK], olsr_prof_clock() - tick_start);
 
     /* Read incoming data and handle it immediiately */
     handle_fds(next_interval);
@@ -503,6 +541,22 @@ olsr_scheduler(void)
   }
 }
 
+/**
+ * Move the scheduler clock to a caller supplied time and fire
+ * all timers that became due, without polling any socket.
+ * This lets offline tools drive the timer wheel from a virtual
+ * clock instead of olsr_times().
+ *
+ * @param now the new relative time in milliseconds
+ */
+void
+olsr_scheduler_advance(uint32_t now)
+{
+  now_times = now;
+
+  walk_timers(&timer_last_run);
+}
+
 /**
  * Decrement a relative timer by a random number range.
  *
@@ -616,7 +670,13 @@ walk_timers(uint32_t * last_run)
                    timer, timer->timer_cb_context, (unsigned int)*last_run, olsr_wallclock_string());
 
         /* This timer is expired, call into the provided callback function */
-        timer->timer_cb(timer->timer_cb_context);
+        {
+          const struct olsr_cookie_info *ci = timer->timer_cookie;
+          uint64_t start = olsr_prof_clock();
+
+          timer->timer_cb(timer->timer_cb_context);
+          olsr_prof_timer(ci, olsr_prof_clock() - start);
+        }
 
         /* Only act on actually running timers */
         if (timer->timer_flags & OLSR_TIMER_RUNNING) {
@@ -46,6 +46,7 @@
 #include "common/list.h"
 
 #include "olsr_types.h"
+#include "olsr_profile.h"
 
 #include <time.h>
 
@@ -106,6 +107,9 @@ const char *olsr_wallclock_string(void);
 /* Main scheduler loop */
 void olsr_scheduler(void);
 
+/* Drive the timers from a virtual clock (replay tools) */
+void olsr_scheduler_advance(uint32_t);
+
 /*
  * Provides a timestamp s1 milliseconds in the future
  */
@@ -138,6 +142,7 @@ struct olsr_socket_entry {
   void *data;
   unsigned int flags;
   struct list_node socket_node;
+  struct olsr_histogram prof;          /* run time of the handlers */
 };
 
 LISTNODE2STRUCT(list2socket, struct olsr_socket_entry, socket_node);
@@ -160,6 +165,7 @@ bool olsr_isTimedOut (uint32_t s);
 void add_olsr_socket (int fd, socket_handler_func pf_pr, socket_handler_func pf_imm, void *data, unsigned int flags);
 int remove_olsr_socket (int fd, socket_handler_func pf_pr, socket_handler_func pf_imm);
 void olsr_flush_sockets(void);
+void olsr_walk_socket_profiles(olsr_prof_walk_cb, void *);
 void enable_olsr_socket (int fd, socket_handler_func pf_pr, socket_handler_func pf_imm, unsigned int flags);
 void disable_olsr_socket (int fd, socket_handler_func pf_pr, socket_handler_func pf_imm, unsigned int flags);
 
@@ -52,13 +52,16 @@
 #include "net_olsr.h"
 #include "lq_plugin.h"
 #include "olsr_cookie.h"
+#include "olsr_node_id.h"
 #include "duplicate_set.h"
 #include "gateway.h"
+#include "parser.h"
 
 #include <assert.h>
+#include <stdlib.h>
 
 /* Root of the link state database */
-struct avl_tree tc_tree;
+struct btree tc_tree;
 struct tc_entry *tc_myself;            /* Shortcut to ourselves */
 
 /* Some cookies for stats keeping */
@@ -161,7 +164,7 @@ olsr_add_tc_entry(union olsr_ip_addr *adr)
   /*
    * Insert into the global tc tree.
    */
-  avl_insert(&tc_tree, &tc->vertex_node, AVL_DUP_NO);
+  btree_insert(&tc_tree, &tc->vertex_node);
   olsr_lock_tc_entry(tc);
 
   /*
@@ -187,7 +190,7 @@ olsr_init_tc(void)
 {
   OLSR_PRINTF(5, "TC: init topo\n");
 
-  avl_init(&tc_tree, avl_comp_default);
+  btree_init(&tc_tree, olsr_cnf->ip_version == AF_INET ? BTREE_KEY_IPV4 : BTREE_KEY_IPV6);
 
   /*
    * Get some cookies for getting stats to ease troubleshooting.
@@ -304,7 +307,7 @@ olsr_delete_tc_entry(struct tc_entry *tc)
   olsr_stop_timer(tc->validity_timer);
   tc->validity_timer = NULL;
 
-  avl_delete(&tc_tree, &tc->vertex_node);
+  btree_delete(&tc_tree, &tc->vertex_node);
   olsr_unlock_tc_entry(tc);
 }
 
@@ -317,9 +320,9 @@ olsr_delete_tc_entry(struct tc_entry *tc)
 struct tc_entry *
 olsr_lookup_tc_entry(union olsr_ip_addr *adr)
 {
-  struct avl_node *node;
+  struct btree_node *node;
 
-  node = avl_find(&tc_tree, adr);
+  node = btree_find(&tc_tree, adr);
 
   return (node ? vertex_tree2tc(node) : NULL);
 }
@@ -350,7 +353,7 @@ olsr_tc_edge_to_string(struct tc_edge_entry *tc_edge)
   struct lqtextbuffer lqbuffer1, lqbuffer2;
 
   snprintf(buf, sizeof(buf), "%s > %s, cost (%6s) %s", olsr_ip_to_string(&addrbuf, &tc->addr),
-           olsr_ip_to_string(&dstbuf, &tc_edge->T_dest_addr), get_tc_edge_entry_text(tc_edge, '/', &lqbuffer1),
+           olsr_ip_to_string(&dstbuf, tc_edge_dest_addr(tc_edge)), get_tc_edge_entry_text(tc_edge, '/', &lqbuffer1),
            get_linkcost_text(tc_edge->cost, false, &lqbuffer2));
 
   return buf;
@@ -442,15 +445,18 @@ olsr_add_tc_edge_entry(struct tc_entry *tc, union olsr_ip_addr *addr, uint16_t a
     return NULL;
   }
 
-  /* Fill entry */
-  tc_edge->T_dest_addr = *addr;
+  /* Fill entry, the key is the interned destination address */
   tc_edge->ansn = ansn;
-  tc_edge->edge_node.key = &tc_edge->T_dest_addr;
+  tc_edge->edge_node.key = &olsr_get_node_id(addr)->addr;
 
   /*
-   * Insert into the edge tree.
+   * Insert into the edge tree, there must be only one edge per destination.
    */
-  avl_insert(&tc->edge_tree, &tc_edge->edge_node, AVL_DUP_NO);
+  if (avl_insert(&tc->edge_tree, &tc_edge->edge_node, AVL_DUP_NO) < 0) {
+    olsr_put_node_id(addr2node_id(tc_edge_dest_addr(tc_edge)));
+    olsr_cookie_free(tc_edge_mem_cookie, tc_edge);
+    return NULL;
+  }
   olsr_lock_tc_entry(tc);
 
   /*
@@ -462,7 +468,7 @@ olsr_add_tc_edge_entry(struct tc_entry *tc, union olsr_ip_addr *addr, uint16_t a
    * Check if the neighboring router and the inverse edge is in the lsdb.
    * Create short cuts to the inverse edge for faster SPF execution.
    */
-  tc_neighbor = olsr_lookup_tc_entry(&tc_edge->T_dest_addr);
+  tc_neighbor = olsr_lookup_tc_entry(tc_edge_dest_addr(tc_edge));
   if (tc_neighbor) {
 #ifdef DEBUG
     OLSR_PRINTF(1, "TC:   found neighbor tc_entry %s\n", olsr_ip_to_string(&buf, &tc_neighbor->addr));
@@ -471,7 +477,7 @@ olsr_add_tc_edge_entry(struct tc_entry *tc, union olsr_ip_addr *addr, uint16_t a
     tc_edge_inv = olsr_lookup_tc_edge(tc_neighbor, &tc->addr);
     if (tc_edge_inv) {
 #ifdef DEBUG
-      OLSR_PRINTF(1, "TC:   found inverse edge for %s\n", olsr_ip_to_string(&buf, &tc_edge_inv->T_dest_addr));
+      OLSR_PRINTF(1, "TC:   found inverse edge for %s\n", olsr_ip_to_string(&buf, tc_edge_dest_addr(tc_edge_inv)));
 #endif /* DEBUG */
 
       /*
@@ -513,6 +519,7 @@ olsr_delete_tc_edge_entry(struct tc_edge_entry *tc_edge)
   tc = tc_edge->tc;
   avl_delete(&tc->edge_tree, &tc_edge->edge_node);
   olsr_unlock_tc_entry(tc);
+  olsr_put_node_id(addr2node_id(tc_edge_dest_addr(tc_edge)));
 
   /*
    * Clear the backpointer of our inverse edge.
@@ -568,7 +575,7 @@ olsr_delete_revoked_tc_edges(struct tc_entry *tc, uint16_t ansn, union olsr_ip_a
 
   OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
     if (!passedLowerBorder) {
-      if (avl_comp_default(lower_border, &tc_edge->T_dest_addr) <= 0) {
+      if (avl_comp_default(lower_border, tc_edge_dest_addr(tc_edge)) <= 0) {
         passedLowerBorder = true;
       } else {
         continue;
@@ -576,7 +583,7 @@ olsr_delete_revoked_tc_edges(struct tc_entry *tc, uint16_t ansn, union olsr_ip_a
     }
 
     if (passedLowerBorder) {
-      if (avl_comp_default(upper_border, &tc_edge->T_dest_addr) <= 0) {
+      if (avl_comp_default(upper_border, tc_edge_dest_addr(tc_edge)) <= 0) {
         break;
       }
     }
@@ -666,6 +673,172 @@ olsr_tc_update_edge(struct tc_entry *tc, uint16_t ansn, const unsigned char **cu
   return edge_change;
 }
 
+/*
+ * A neighbor advertised in a TC message. The link quality is left in
+ * the packet until the neighbor is matched with its edge.
+ */
+struct tc_advertised {
+  union olsr_ip_addr addr;
+  const unsigned char *lq;
+  unsigned int index;                  /* position in the message */
+};
+
+/* What a TC message changed in the edges of its originator */
+struct tc_edge_changes {
+  unsigned int added;
+  unsigned int updated;                /* edges whose cost changed */
+  unsigned int revoked;
+};
+
+static int
+olsr_tc_advertised_cmp(const void *a, const void *b)
+{
+  const struct tc_advertised *adv_a = a, *adv_b = b;
+  int diff = avl_comp_default(&adv_a->addr, &adv_b->addr);
+
+  /* keep the message order for duplicates, the last one wins */
+  if (diff == 0) {
+    diff = adv_a->index < adv_b->index ? -1 : 1;
+  }
+  return diff;
+}
+
+/**
+ * Read the advertised neighbors of a TC message and sort them into the
+ * order of the edge tree. Senders advertise in tree order, so usually
+ * the sort is a single check.
+ *
+ * @param curr pointer to the packet, at the first advertised neighbor
+ * @param limit end of the message
+ * @param advertised set to the array of advertised neighbors, which
+ *   lives in the parser arena
+ * @param first set to the first advertised address in message order
+ * @param last set to the last advertised address in message order
+ * @return the number of advertised neighbors
+ */
+static unsigned int
+olsr_tc_read_advertised(const unsigned char **curr, const unsigned char *limit, struct tc_advertised **advertised,
+                        union olsr_ip_addr *first, union olsr_ip_addr *last)
+{
+  size_t stride = olsr_cnf->ipsize + olsr_sizeof_tc_lqdata();
+  struct tc_advertised *adv;
+  unsigned int count = 0, i, j;
+  bool sorted = true;
+
+  if (*curr >= limit) {
+    *advertised = NULL;
+    return 0;
+  }
+
+  adv = olsr_parser_alloc(((limit - *curr + stride - 1) / stride) * sizeof(*adv));
+  while (*curr < limit) {
+    pkt_get_ipaddress(curr, &adv[count].addr);
+    adv[count].lq = *curr;
+    adv[count].index = count;
+    *curr += olsr_sizeof_tc_lqdata();
+    count++;
+  }
+
+  *first = adv[0].addr;
+  *last = adv[count - 1].addr;
+
+  for (i = 1; i < count && sorted; i++) {
+    sorted = avl_comp_default(&adv[i - 1].addr, &adv[i].addr) < 0;
+  }
+  if (!sorted) {
+    qsort(adv, count, sizeof(*adv), &olsr_tc_advertised_cmp);
+
+    /*
+     * A neighbor advertised twice must be merged only once,
+     * collapse the duplicates and keep the last one.
+     */
+    for (i = 1, j = 0; i < count; i++) {
+      if (avl_comp_default(&adv[j].addr, &adv[i].addr) != 0) {
+        j++;
+      }
+      adv[j] = adv[i];
+    }
+    count = j + 1;
+  }
+
+  *advertised = adv;
+  return count;
+}
+
+/**
+ * Merge the sorted advertised neighbors of a TC message into the edge
+ * tree of its originator in a single ordered walk: edges that are
+ * advertised are updated, unknown neighbors get a new edge and edges
+ * inside the borders that were not refreshed with this ansn are
+ * revoked.
+ *
+ * @param tc the TC entry of the originator
+ * @param ansn the ansn of the message
+ * @param adv the sorted advertised neighbors
+ * @param count the number of advertised neighbors
+ * @param lower_border the lower border, NULL if no edges are revoked
+ * @param upper_border the upper border
+ * @param changes the counters of the changes done
+ */
+static void
+olsr_tc_merge_edges(struct tc_entry *tc, uint16_t ansn, struct tc_advertised *adv, unsigned int count,
+                    union olsr_ip_addr *lower_border, union olsr_ip_addr *upper_border, struct tc_edge_changes *changes)
+{
+  struct avl_node *node = avl_walk_first(&tc->edge_tree);
+  unsigned int i = 0;
+
+  while (node || i < count) {
+    struct tc_edge_entry *tc_edge = node ? edge_tree2tc_edge(node) : NULL;
+    const unsigned char *lq;
+    int diff;
+
+    if (!tc_edge) {
+      diff = 1;
+    } else if (i == count) {
+      diff = -1;
+    } else {
+      diff = avl_comp_default(tc_edge_dest_addr(tc_edge), &adv[i].addr);
+    }
+
+    if (diff < 0) {
+      /* an edge that is not advertised */
+      node = avl_walk_next(node);
+
+      if (lower_border && avl_comp_default(lower_border, tc_edge_dest_addr(tc_edge)) <= 0
+          && avl_comp_default(upper_border, tc_edge_dest_addr(tc_edge)) > 0 && SEQNO_GREATER_THAN(ansn, tc_edge->ansn)) {
+        olsr_delete_tc_edge_entry(tc_edge);
+        changes->revoked++;
+      }
+      continue;
+    }
+
+    lq = adv[i].lq;
+    if (diff == 0) {
+      /* a known edge */
+      olsr_linkcost cost = tc_edge->cost;
+
+      tc_edge->ansn = ansn;
+      olsr_deserialize_tc_lq_pair(&lq, tc_edge);
+      olsr_calc_tc_edge_entry_etx(tc_edge);
+      if (tc_edge->cost != cost) {
+        changes->updated++;
+      }
+#if defined DEBUG && DEBUG
+      OLSR_PRINTF(1, "TC:   chg edge entry %s\n", olsr_tc_edge_to_string(tc_edge));
+#endif /* defined DEBUG && DEBUG */
+    } else if (olsr_validate_address(&adv[i].addr)) {
+      /* yet unknown, the new node sorts before the current one */
+      tc_edge = olsr_add_tc_edge_entry(tc, &adv[i].addr, ansn);
+      if (tc_edge) {
+        olsr_deserialize_tc_lq_pair(&lq, tc_edge);
+        olsr_calc_tc_edge_entry_etx(tc_edge);
+        changes->added++;
+      }
+    }
+    i++;
+  }
+}
+
 /**
  * Lookup an edge hanging off a TC entry.
  *
@@ -704,7 +877,7 @@ olsr_print_tc_table(void)
       struct lqtextbuffer lqbuffer1, lqbuffer2;
 
       OLSR_PRINTF(1, "%-*s %-*s %-14s %s\n", ipwidth, olsr_ip_to_string(&addrbuf, &tc->addr), ipwidth,
-                  olsr_ip_to_string(&dstaddrbuf, &tc_edge->T_dest_addr), get_tc_edge_entry_text(tc_edge, '/', &lqbuffer1),
+                  olsr_ip_to_string(&dstaddrbuf, tc_edge_dest_addr(tc_edge)), get_tc_edge_entry_text(tc_edge, '/', &lqbuffer1),
                   get_linkcost_text(tc_edge->cost, false, &lqbuffer2));
 
     } OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
@@ -874,29 +1047,78 @@ olsr_input_tc(union olsr_message * msg, struct interface * input_if __attribute_
 
   OLSR_PRINTF(1, "Processing TC from %s, seq 0x%04x\n", olsr_ip_to_string(&buf, &originator), tc->msg_seq);
 
-  /*
-   * Now walk the edge advertisements contained in the packet.
-   */
-
   limit = (unsigned char *)msg + size;
   borderSet = 0;
   emptyTC = curr >= limit;
-  while (curr < limit) {
-    if (olsr_tc_update_edge(tc, ansn, &curr, &upper_border_ip)) {
+
+  if (olsr_cnf->lq_level > 0) {
+    struct tc_advertised *adv;
+    struct tc_edge_changes changes;
+    unsigned int count;
+
+    /*
+     * Sort the edge advertisements contained in the packet, then
+     * merge them into the edge tree.
+     */
+    count = olsr_tc_read_advertised(&curr, limit, &adv, &lower_border_ip, &upper_border_ip);
+    if (count > 0) {
+      borderSet = olsr_calculate_tc_border(lower_border, &lower_border_ip, upper_border, &upper_border_ip);
+    }
+
+    if (emptyTC && lower_border == 0xff && upper_border == 0xff) {
+      /* handle empty TC with border flags 0xff */
+      memset(&lower_border_ip, 0x00, sizeof(lower_border_ip));
+      memset(&upper_border_ip, 0xff, sizeof(upper_border_ip));
+      borderSet = 1;
+    }
+
+    memset(&changes, 0, sizeof(changes));
+    olsr_tc_merge_edges(tc, ansn, adv, count, borderSet ? &lower_border_ip : NULL, &upper_border_ip, &changes);
+
+    if (changes.added || changes.updated || changes.revoked) {
+      OLSR_PRINTF(3, "TC: %s edges %u added, %u changed, %u revoked\n", olsr_ip_to_string(&buf, &originator),
+                  changes.added, changes.updated, changes.revoked);
       changes_topology = true;
     }
+  } else {
+
+    /*
+     * Now walk the edge advertisements contained in the packet.
+     * Without link quality a known edge carries no lq data, so the
+     * entries cannot be read ahead of the edge lookup.
+     */
+    while (curr < limit) {
+      if (olsr_tc_update_edge(tc, ansn, &curr, &upper_border_ip)) {
+        changes_topology = true;
+      }
+
+      if (!borderSet) {
+        borderSet = 1;
+        memcpy(&lower_border_ip, &upper_border_ip, sizeof(lower_border_ip));
+      }
+    }
 
-    if (!borderSet) {
+    /*
+     * Calculate real border IPs.
+     */
+    if (borderSet) {
+      borderSet = olsr_calculate_tc_border(lower_border, &lower_border_ip, upper_border, &upper_border_ip);
+    }
+
+    if (emptyTC && lower_border == 0xff && upper_border == 0xff) {
+      /* handle empty TC with border flags 0xff */
+      memset(&lower_border_ip, 0x00, sizeof(lower_border_ip));
+      memset(&upper_border_ip, 0xff, sizeof(upper_border_ip));
       borderSet = 1;
-      memcpy(&lower_border_ip, &upper_border_ip, sizeof(lower_border_ip));
     }
-  }
 
-  /*
-   * Calculate real border IPs.
-   */
-  if (borderSet) {
-    borderSet = olsr_calculate_tc_border(lower_border, &lower_border_ip, upper_border, &upper_border_ip);
+    if (borderSet) {
+
+      /*
+       * Delete all old tc edges within borders.
+       */
+      olsr_delete_revoked_tc_edges(tc, ansn, &lower_border_ip, &upper_border_ip);
+    }
   }
 
   /*
@@ -905,20 +1127,7 @@ olsr_input_tc(union olsr_message * msg, struct interface * input_if __attribute_
   olsr_set_timer(&tc->validity_timer, vtime, OLSR_TC_VTIME_JITTER, OLSR_TIMER_ONESHOT, &olsr_expire_tc_entry, tc,
                  tc_validity_timer_cookie);
 
-  if (emptyTC && lower_border == 0xff && upper_border == 0xff) {
-    /* handle empty TC with border flags 0xff */
-    memset(&lower_border_ip, 0x00, sizeof(lower_border_ip));
-    memset(&upper_border_ip, 0xff, sizeof(upper_border_ip));
-    borderSet = 1;
-  }
-
-  if (borderSet) {
-
-    /*
-     * Delete all old tc edges within borders.
-     */
-    olsr_delete_revoked_tc_edges(tc, ansn, &lower_border_ip, &upper_border_ip);
-  } else {
+  if (!borderSet) {
 
     /*
      * Kick the the edge garbage collection timer. In the meantime hopefully
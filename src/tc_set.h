@@ -46,6 +46,7 @@
 #include "defs.h"
 #include "packet.h"
 #include "common/avl.h"
+#include "common/btree.h"
 #include "common/list.h"
 #include "scheduler.h"
 
@@ -56,9 +57,13 @@
  * The SPF calculation operates on these datasets.
  */
 
+/*
+ * The destination address of an edge is not copied into the edge. It is
+ * interned (see olsr_node_id.h) and shared by all edges towards the same
+ * node, the edge_node key points to it.
+ */
 struct tc_edge_entry {
-  struct avl_node edge_node;           /* edge_tree node in tc_entry */
-  union olsr_ip_addr T_dest_addr;      /* edge_node key */
+  struct avl_node edge_node;           /* edge_tree node in tc_entry, keyed by the interned destination */
   struct tc_edge_entry *edge_inv;      /* shortcut, used during SPF calculation */
   struct tc_entry *tc;                 /* backpointer to owning tc entry */
   olsr_linkcost cost;                  /* metric used for SPF calculation */
@@ -68,8 +73,18 @@ struct tc_edge_entry {
 
 AVLNODE2STRUCT(edge_tree2tc_edge, struct tc_edge_entry, edge_node);
 
+/**
+ * @param tc_edge the edge
+ * @return the destination address of the edge
+ */
+static INLINE union olsr_ip_addr *
+tc_edge_dest_addr(const struct tc_edge_entry *tc_edge)
+{
+  return tc_edge->edge_node.key;
+}
+
 struct tc_entry {
-  struct avl_node vertex_node;         /* node keyed by ip address */
+  struct btree_node vertex_node;       /* node keyed by ip address */
   union olsr_ip_addr addr;             /* vertex_node key */
   struct avl_node cand_tree_node;      /* SPF candidate heap, node keyed by path_etx */
   olsr_linkcost path_cost;             /* SPF calculated distance, cand_tree_node key */
@@ -77,6 +92,7 @@ struct tc_entry {
   struct avl_tree edge_tree;           /* subtree for edges */
   struct avl_tree prefix_tree;         /* subtree for prefixes */
   struct link_entry *next_hop;         /* SPF calculated link to the 1st hop neighbor */
+  uint32_t spf_index;                  /* vertex number in the SPF thread snapshot */
   struct timer_entry *edge_gc_timer;   /* used for edge garbage collection */
   struct timer_entry *validity_timer;  /* tc validity time */
   uint32_t refcount;                   /* reference counter */
@@ -99,7 +115,7 @@ struct tc_entry {
 
 #define OLSR_TC_VTIME_JITTER 5          /* percent */
 
-AVLNODE2STRUCT(vertex_tree2tc, struct tc_entry, vertex_node);
+BTREENODE2STRUCT(vertex_tree2tc, struct tc_entry, vertex_node);
 AVLNODE2STRUCT(cand_tree2tc, struct tc_entry, cand_tree_node);
 LISTNODE2STRUCT(pathlist2tc, struct tc_entry, path_list_node);
 
@@ -113,10 +129,10 @@ LISTNODE2STRUCT(pathlist2tc, struct tc_entry, path_list_node);
  */
 #define OLSR_FOR_ALL_TC_ENTRIES(tc) \
 { \
-  struct avl_node *tc_tree_node, *next_tc_tree_node; \
-  for (tc_tree_node = avl_walk_first(&tc_tree); \
+  struct btree_node *tc_tree_node, *next_tc_tree_node; \
+  for (tc_tree_node = btree_walk_first(&tc_tree); \
     tc_tree_node; tc_tree_node = next_tc_tree_node) { \
-    next_tc_tree_node = avl_walk_next(tc_tree_node); \
+    next_tc_tree_node = btree_walk_next(tc_tree_node); \
     tc = vertex_tree2tc(tc_tree_node);
 #define OLSR_FOR_ALL_TC_ENTRIES_END(tc) }}
 
@@ -138,7 +154,7 @@ LISTNODE2STRUCT(pathlist2tc, struct tc_entry, path_list_node);
     rtp = rtp_prefix_tree2rtp(rtp_node);
 #define OLSR_FOR_ALL_PREFIX_ENTRIES_END(tc, rtp) }}
 
-extern struct avl_tree tc_tree;
+extern struct btree tc_tree;
 extern struct tc_entry *tc_myself;
 
 void olsr_init_tc(void);
@@ -46,6 +46,7 @@
 #include "neighbor_table.h"
 #include "net_olsr.h"
 #include "scheduler.h"
+#include "mpr.h"
 
 struct neighbor_2_entry two_hop_neighbortable[HASHSIZE];
 
@@ -82,10 +83,16 @@ olsr_delete_neighbor_pointer(struct neighbor_2_entry *two_hop_entry, struct neig
       struct neighbor_list_entry *entry_to_delete = entry;
       entry = entry->next;
 
+      if (entry_to_delete->mpr_selected) {
+        neigh->mpr_selected_count--;
+      }
+
       /* dequeue */
       DEQUEUE_ELEM(entry_to_delete);
 
       free(entry_to_delete);
+
+      olsr_mpr_touch_two_hop(two_hop_entry);
     } else {
       entry = entry->next;
     }
@@ -111,12 +118,18 @@ olsr_delete_two_hop_neighbor_table(struct neighbor_2_entry *two_hop_neighbor)
     struct neighbor_entry *one_hop_entry = one_hop_list->neighbor;
     struct neighbor_list_entry *entry_to_delete = one_hop_list;
 
+    if (entry_to_delete->mpr_selected) {
+      one_hop_entry->mpr_selected_count--;
+    }
+
     olsr_delete_neighbor_2_pointer(one_hop_entry, two_hop_neighbor);
     one_hop_list = one_hop_list->next;
     /* no need to dequeue */
     free(entry_to_delete);
   }
 
+  olsr_mpr_forget_two_hop(two_hop_neighbor);
+
   /* dequeue */
   DEQUEUE_ELEM(two_hop_neighbor);
   free(two_hop_neighbor);
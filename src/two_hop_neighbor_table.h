@@ -45,6 +45,7 @@
 #include "defs.h"
 #include "hashing.h"
 #include "lq_plugin.h"
+#include "common/list.h"
 
 #define	NB2S_COVERED 	0x1     /* node has been covered by a MPR */
 
@@ -53,6 +54,7 @@ struct neighbor_list_entry {
   olsr_linkcost second_hop_linkcost;
   olsr_linkcost path_linkcost;
   olsr_linkcost saved_path_linkcost;
+  bool mpr_selected;                   /* LQ-MPR: selected to cover this 2-hop neighbor */
   struct neighbor_list_entry *next;
   struct neighbor_list_entry *prev;
 };
@@ -63,6 +65,7 @@ struct neighbor_2_entry {
   uint8_t processed;                   /*used in mpr calculation */
   int16_t neighbor_2_pointer;          /* Neighbor count */
   struct neighbor_list_entry neighbor_2_nblist;
+  struct list_node mpr_dirty_node;     /* queued for MPR re-evaluation */
   struct neighbor_2_entry *prev;
   struct neighbor_2_entry *next;
 };
@@ -57,6 +57,7 @@
 #include "lq_packet.h"
 #include "log.h"
 #include "link_set.h"
+#include "olsr_rx.h"
 
 #include <assert.h>
 #include <signal.h>
@@ -773,8 +774,8 @@ chk_if_up(struct olsr_if *iface, int debuglvl __attribute__ ((unused)))
   set_buffer_timer(ifp);
 
   /* Register socket */
-  add_olsr_socket(ifp->olsr_socket, &olsr_input, NULL, NULL, SP_PR_READ);
-  add_olsr_socket(ifp->send_socket, &olsr_input, NULL, NULL, SP_PR_READ);
+  olsr_rx_add_socket(ifp->olsr_socket);
+  olsr_rx_add_socket(ifp->send_socket);
 
 #ifdef __linux__
   /* Set TOS */